@@ -29,6 +29,8 @@
 #include "ardour/session.h"
 
 #include "gtkmm2ext/utils.h"
+
+#include "canvas/tile_cache.h"
 #include "waveview/wave_view.h"
 
 #include "audio_clock.h"
@@ -500,6 +502,9 @@ ARDOUR_UI::parameter_changed (std::string p)
 	} else if (p == "waveform-cache-size") {
 		/* GUI option has units of megabytes; image cache uses units of bytes */
 		ArdourWaveView::WaveView::set_image_cache_size (UIConfiguration::instance().get_waveform_cache_size() * 1048576);
+	} else if (p == "canvas-tile-cache-size") {
+		/* GUI option has units of megabytes; tile cache uses units of bytes */
+		ArdourCanvas::TileCache::set_memory_budget (UIConfiguration::instance().get_canvas_tile_cache_size() * 1048576);
 	} else if (p == "use-wm-visibility") {
 		VisibilityTracker::set_use_window_manager_visibility (UIConfiguration::instance().get_use_wm_visibility());
 	} else if (p == "action-table-columns") {
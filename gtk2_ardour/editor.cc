@@ -79,6 +79,7 @@
 #include "ardour/vca.h"
 
 #include "canvas/debug.h"
+#include "canvas/scroll_group.h"
 #include "canvas/text.h"
 
 #include "widgets/ardour_spacer.h"
@@ -4660,15 +4661,15 @@ Editor::visual_changer (const VisualChange& vc)
 		update_tempo_based_rulers ();
 	}
 
-	if (!(vc.pending & VisualChange::ZoomLevel)) {
-		/**
-		 * If the canvas is not being zoomed then the canvas items will not change
-		 * and cause Item::prepare_for_render to be called so do it here manually.
-		 *
-		 * Not ideal, but I can't think of a better solution atm.
-		 */
-		_track_canvas->prepare_for_render();
-	}
+	/**
+	 * If the canvas is not being zoomed then the canvas items will not change
+	 * and cause Item::prepare_for_render to be called so do it here manually.
+	 * When zooming, the changed items have already been prepared for the
+	 * visible area, this also prepares the items just outside of it.
+	 *
+	 * Not ideal, but I can't think of a better solution atm.
+	 */
+	_track_canvas->prepare_for_render();
 
 	// If we are only scrolling vertically there is no need to update these
 	if (vc.pending != VisualChange::YOrigin) {
@@ -6193,6 +6194,10 @@ Editor::ui_parameter_changed (string parameter)
 		if (_verbose_cursor) {
 			playhead_cursor->set_sensitive (UIConfiguration::instance().get_draggable_playhead());
 		}
+	} else if (parameter == "canvas-tile-cache-size") {
+		if (hv_scroll_group) {
+			hv_scroll_group->set_tile_cache (UIConfiguration::instance().get_canvas_tile_cache_size() > 0);
+		}
 	}
 }
 
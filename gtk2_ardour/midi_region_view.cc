@@ -271,6 +271,9 @@ MidiRegionView::init (bool wfd)
 	_enable_display = false;
 	fill_color_name = "midi sample base";
 
+	/* regions may hold many thousands of notes */
+	_note_group->set_spatial_index (true);
+
 	RegionView::init (false);
 
 	//set_height (trackview.current_height());
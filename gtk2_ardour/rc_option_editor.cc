@@ -2158,8 +2158,45 @@ RCOptionEditor::RCOptionEditor ()
 		procs->set_note (string_compose (_("This setting will only take effect when %1 is restarted."), PROGRAM_NAME));
 
 		add_option (_("General"), procs);
+
+		ComboOption<uint32_t>* peak_threads = new ComboOption<uint32_t> (
+				"peak-building-threads",
+				_("Waveform building uses"),
+				sigc::mem_fun (*_rc_config, &RCConfiguration::get_peak_building_threads),
+				sigc::mem_fun (*_rc_config, &RCConfiguration::set_peak_building_threads)
+				);
+
+		peak_threads->add (0, _("all available processors"));
+
+		for (uint32_t i = 1; i <= hwcpus; ++i) {
+			peak_threads->add (i, string_compose (P_("%1 processor", "%1 processors", i), i));
+		}
+
+		peak_threads->set_note (string_compose (_("This setting will only take effect when %1 is restarted."), PROGRAM_NAME));
+
+		add_option (_("General"), peak_threads);
+
+		bo = new BoolOption (
+				"graph-work-stealing",
+				_("Use per-thread work queues for signal processing"),
+				sigc::mem_fun (*_rc_config, &RCConfiguration::get_graph_work_stealing),
+				sigc::mem_fun (*_rc_config, &RCConfiguration::set_graph_work_stealing)
+				);
+		Gtkmm2ext::UI::instance()->set_tip (bo->tip_widget(),
+				_("When enabled, every DSP thread has its own queue of tracks and busses that are ready to be processed, and idle threads take work from busy ones. A track or bus tends to be processed by the same thread every cycle. This can reduce overhead on systems with many processors and large sessions."));
+		add_option (_("General"), bo);
 	}
 
+	bo = new BoolOption (
+			"collect-dsp-timing",
+			_("Collect per track and per plugin DSP timing statistics"),
+			sigc::mem_fun (*_rc_config, &RCConfiguration::get_collect_dsp_timing),
+			sigc::mem_fun (*_rc_config, &RCConfiguration::set_collect_dsp_timing)
+			);
+	Gtkmm2ext::UI::instance()->set_tip (bo->tip_widget(),
+			_("When enabled, the time spent processing every track, bus and plugin is measured. The statistics are available to Lua scripts and OSC. This adds a small overhead to signal processing."));
+	add_option (_("General"), bo);
+
 	/* Image cache size */
 	add_option (_("General"), new OptionEditorHeading (_("Memory Usage")));
 
@@ -2175,6 +2212,18 @@ RCOptionEditor::RCOptionEditor ()
 		 _("Increasing the cache size uses more memory to store waveform images, which can improve graphical performance."));
 	add_option (_("General"), sics);
 
+	HSliderOption *ctcs = new HSliderOption ("canvas-tile-cache-size",
+			_("Editor canvas tile cache size (megabytes)"),
+			sigc::mem_fun (UIConfiguration::instance(), &UIConfiguration::get_canvas_tile_cache_size),
+			sigc::mem_fun (UIConfiguration::instance(), &UIConfiguration::set_canvas_tile_cache_size),
+			0, 512, 8 /* off to 512MB in steps of 8MB */
+			);
+	ctcs->scale().set_digits (0);
+	Gtkmm2ext::UI::instance()->set_tip (
+			ctcs->tip_widget(),
+		 _("When non-zero, the contents of the editor canvas are kept as pre-rendered tiles of up to this size in total, so that scrolling and small changes only redraw what is new. Zero disables the cache."));
+	add_option (_("General"), ctcs);
+
 	add_option (_("General"), new OptionEditorHeading (_("Engine")));
 
 	add_option (_("General"),
@@ -2205,6 +2254,17 @@ RCOptionEditor::RCOptionEditor ()
 		     1, 1000, 1, 20
 		     ));
 
+	SpinOption<uint32_t>* paq = new SpinOption<uint32_t> (
+		"plugin-automation-quantum",
+		_("Plugin automation resolution (samples, 0 for sample-accurate)"),
+		sigc::mem_fun (*_rc_config, &RCConfiguration::get_plugin_automation_quantum),
+		sigc::mem_fun (*_rc_config, &RCConfiguration::set_plugin_automation_quantum),
+		0, 1024, 16, 64
+		);
+	Gtkmm2ext::UI::instance()->set_tip (paq->tip_widget(),
+			_("Plugins are run in separate pieces for every automation event in a process cycle. When this is set, automation events within the same number of samples are applied together, which bounds the number of pieces and saves CPU with dense automation, at the expense of timing accuracy."));
+	add_option (_("General"), paq);
+
 	add_option (_("General"), new OptionEditorHeading (_("Tempo")));
 
 	bo = new BoolOption (
@@ -2240,6 +2300,17 @@ RCOptionEditor::RCOptionEditor ()
 
 	add_option (_("General/Session"), new UndoOptions (_rc_config));
 
+	SpinOption<uint32_t>* hmb = new SpinOption<uint32_t> (
+		"history-memory-budget",
+		_("Memory for undo history (megabytes, 0 for no limit)"),
+		sigc::mem_fun (*_rc_config, &RCConfiguration::get_history_memory_budget),
+		sigc::mem_fun (*_rc_config, &RCConfiguration::set_history_memory_budget),
+		0, 65536, 16, 256
+		);
+	Gtkmm2ext::UI::instance()->set_tip (hmb->tip_widget(),
+			_("When the undo history needs more than this much memory, the states of the oldest commands are moved to a temporary file and read back from there if they are needed again."));
+	add_option (_("General/Session"), hmb);
+
 	add_option (_("General/Session"),
 	     new BoolOption (
 		     "verify-remove-last-capture",
@@ -2258,6 +2329,22 @@ RCOptionEditor::RCOptionEditor ()
 		     sigc::mem_fun (*_rc_config, &RCConfiguration::set_periodic_safety_backups)
 		     ));
 
+	add_option (_("General/Session"),
+	     new BoolOption (
+		     "save-pending-state-in-background",
+		     _("Write backups and pending capture state in the background"),
+		     sigc::mem_fun (*_rc_config, &RCConfiguration::get_save_pending_state_in_background),
+		     sigc::mem_fun (*_rc_config, &RCConfiguration::set_save_pending_state_in_background)
+		     ));
+
+	add_option (_("General/Session"),
+	     new BoolOption (
+		     "use-state-cache",
+		     _("Keep a binary cache of session files for faster loading"),
+		     sigc::mem_fun (*_rc_config, &RCConfiguration::get_use_state_cache),
+		     sigc::mem_fun (*_rc_config, &RCConfiguration::set_use_state_cache)
+		     ));
+
 	add_option (_("General/Session"),
 	     new BoolOption (
 		     "only-copy-imported-files",
@@ -2711,6 +2798,15 @@ RCOptionEditor::RCOptionEditor ()
 
 	add_option (_("Audio"), new BufferingOptions (_rc_config));
 
+	add_option (_("Audio"),
+	     new SpinOption<uint32_t> (
+		     "butler-threads",
+		     _("Number of disk reading threads"),
+		     sigc::mem_fun (*_rc_config, &RCConfiguration::get_butler_threads),
+		     sigc::mem_fun (*_rc_config, &RCConfiguration::set_butler_threads),
+		     1, 64, 1, 4
+		     ));
+
 	add_option (_("Audio"), new OptionEditorHeading (_("Denormals")));
 
 	add_option (_("Audio"),
@@ -67,6 +67,9 @@ StreamView::StreamView (RouteTimeAxisView& tv, ArdourCanvas::Container* canvas_g
 {
 	CANVAS_DEBUG_NAME (_canvas_group, string_compose ("SV canvas group %1", _trackview.name()));
 
+	/* a long session may put thousands of regions in a track */
+	_canvas_group->set_spatial_index (true);
+
 	/* set_position() will position the group */
 
 	canvas_rect = new ArdourCanvas::Rectangle (_canvas_group);
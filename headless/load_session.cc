@@ -2,9 +2,12 @@
 #include <cstdlib>
 #include <getopt.h>
 
+#include <glib.h>
+
 #include "pbd/failed_constructor.h"
 #include "pbd/error.h"
 #include "pbd/debug.h"
+#include "pbd/compose.h"
 
 #include "ardour/ardour.h"
 #include "ardour/audioengine.h"
@@ -64,6 +67,22 @@ bool just_version = false;
 bool use_vst = true;
 bool try_hw_optimization = true;
 bool no_connect_ports = false;
+bool print_load_times = false;
+
+/** Print how long each phase of loading @a session took
+ *  @param total time taken by load_session(), in microseconds
+ */
+static void
+print_session_load_times (Session* session, gint64 total)
+{
+	Session::LoadTimes const & times (session->load_times ());
+
+	for (Session::LoadTimes::const_iterator t = times.begin(); t != times.end(); ++t) {
+		cout << string_compose ("%1: %2 ms\n", t->first, t->second / 1000.0);
+	}
+
+	cout << string_compose ("total, including engine startup: %1 ms\n", total / 1000.0);
+}
 
 void
 print_help ()
@@ -78,6 +97,7 @@ print_help ()
 	     << "  -D, --debug <options>       Set debug flags. Use \"-D list\" to see available options\n"
 	     << "  -O, --no-hw-optimizations   Disable h/w specific optimizations\n"
 	     << "  -P, --no-connect-ports      Do not connect any ports at startup\n"
+	     << "  -T, --load-times            Print the time taken by each phase of loading the session\n"
 #ifdef WINDOWS_VST_SUPPORT
 	     << "  -V, --novst                 Do not use VST support\n"
 #endif
@@ -86,7 +106,7 @@ print_help ()
 
 int main (int argc, char* argv[])
 {
-	const char *optstring = "vhBdD:c:VOU:P";
+	const char *optstring = "vhBdD:c:VOU:PT";
 
 	const struct option longopts[] = {
 		{ "version", 0, 0, 'v' },
@@ -99,6 +119,7 @@ int main (int argc, char* argv[])
 		{ "no-hw-optimizations", 0, 0, 'O' },
 		{ "uuid", 1, 0, 'U' },
 		{ "no-connect-ports", 0, 0, 'P' },
+		{ "load-times", 0, 0, 'T' },
 		{ 0, 0, 0, 0 }
 	};
 
@@ -151,6 +172,10 @@ int main (int argc, char* argv[])
 			no_connect_ports = true;
 			break;
 
+		case 'T':
+			print_load_times = true;
+			break;
+
 		case 'V':
 #ifdef WINDOWS_VST_SUPPORT
 			use_vst = false;
@@ -178,6 +203,7 @@ int main (int argc, char* argv[])
 	}
 
 	Session* s = 0;
+	const gint64 load_start = g_get_monotonic_time ();
 
 	try {
 		s = load_session (argv[optind], argv[optind+1]);
@@ -195,6 +221,10 @@ int main (int argc, char* argv[])
 		exit (EXIT_FAILURE);
 	}
 
+	if (print_load_times) {
+		print_session_load_times (s, g_get_monotonic_time () - load_start);
+	}
+
 	s->request_transport_speed (1.0);
 
 	sleep (-1);
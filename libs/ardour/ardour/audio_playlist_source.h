@@ -40,6 +40,7 @@ public:
 	std::string construct_peak_filepath (const std::string& audio_path, const bool in_session = false, const bool old_peak_name = false) const;
 	uint32_t   n_channels() const;
 	bool clamped_at_unity () const { return false; }
+	bool cpu_bound () const { return true; }
 
 	samplecnt_t read_unlocked (Sample *dst, samplepos_t start, samplecnt_t cnt) const;
 	samplecnt_t write_unlocked (Sample *src, samplecnt_t cnt);
@@ -23,6 +23,8 @@
 #include <vector>
 #include <list>
 
+#include <glibmm/threads.h>
+
 #include "ardour/ardour.h"
 #include "ardour/playlist.h"
 
@@ -57,6 +59,16 @@ private:
 	bool region_changed (const PBD::PropertyChange&, boost::shared_ptr<Region>);
 	void source_offset_changed (boost::shared_ptr<AudioRegion>);
         void load_legacy_crossfades (const XMLNode&, int version);
+
+	struct ReadPlan;
+
+	boost::shared_ptr<ReadPlan const> read_plan (samplepos_t start, samplepos_t end);
+	boost::shared_ptr<ReadPlan const> build_read_plan (samplepos_t start, samplepos_t end);
+	void region_generation_changed ();
+
+	/** the most recent read plan, shared by all channels and readers */
+	Glib::Threads::Mutex _read_plan_lock;
+	boost::shared_ptr<ReadPlan const> _read_plan;
 };
 
 } /* namespace ARDOUR */
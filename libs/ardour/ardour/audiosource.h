@@ -20,6 +20,9 @@
 #ifndef __ardour_audio_source_h__
 #define __ardour_audio_source_h__
 
+#include <string>
+#include <vector>
+
 #include <boost/shared_ptr.hpp>
 #include <boost/shared_array.hpp>
 #include <boost/enable_shared_from_this.hpp>
@@ -101,6 +104,25 @@ class LIBARDOUR_API AudioSource : virtual public Source,
 	int prepare_for_peakfile_writes ();
 	void done_with_peakfile_writes (bool done = true);
 
+	/* Building a missing peakfile in ranges, which can be computed by
+	 * several threads at the same time (see SourceFactory).
+	 */
+	void set_defer_peak_building (bool yn) { _defer_peak_building = yn; }
+	int  prepare_peak_ranges (samplecnt_t range_size);
+	int  build_peak_range (uint32_t n);
+	double peak_build_progress () const;
+
+	/** Load the coarser peak levels of the complete peakfile, or build them
+	 *  from it (always, if @a rebuild is true). Called by the peak building
+	 *  threads, readers use the peakfile until the levels are ready.
+	 */
+	int  prepare_peak_levels (bool rebuild = false);
+
+	/** @return true if reading this source is limited by the CPU (decoding,
+	 *  mixing) rather than by disk I/O
+	 */
+	virtual bool cpu_bound () const { return false; }
+
 	/** @return true if the each source sample s must be clamped to -1 < s < 1 */
 	virtual bool clamped_at_unity () const = 0;
 
@@ -129,6 +151,7 @@ class LIBARDOUR_API AudioSource : virtual public Source,
 
 	int initialize_peakfile (const std::string& path, const bool in_session = false);
 	int build_peaks_from_scratch ();
+	int compute_peak_range (samplepos_t start, samplecnt_t cnt);
 	int compute_and_write_peaks (Sample* buf, samplecnt_t first_sample, samplecnt_t cnt,
 	bool force, bool intermediate_peaks_ready_signal);
 	void truncate_peakfile();
@@ -147,6 +170,8 @@ class LIBARDOUR_API AudioSource : virtual public Source,
 				     bool force, bool intermediate_peaks_ready_signal,
 				     samplecnt_t samples_per_peak);
 
+	std::string peak_levels_path () const;
+
   private:
 	bool _peaks_built;
 	/** This mutex is used to protect both the _peaks_built
@@ -169,6 +194,40 @@ class LIBARDOUR_API AudioSource : virtual public Source,
 	mutable off_t _last_map_off;
 	mutable size_t  _last_raw_map_length;
 	mutable boost::scoped_array<PeakData> peak_cache;
+
+	bool _defer_peak_building;
+	bool _peak_build_pending;
+	/** protects the state of building the peakfile in ranges */
+	mutable Glib::Threads::Mutex _peak_range_lock;
+	samplecnt_t _peak_range_size;
+	uint32_t    _peak_ranges_remaining;
+	samplecnt_t _peak_range_samples_done;
+	bool        _peak_range_failed;
+
+	/* Coarser levels of the peakfile's data, each with 16 times the
+	 * samples-per-peak of the one before. They are built as the peakfile
+	 * is written (or from it, when first needed), kept in memory and
+	 * saved alongside the peakfile.
+	 */
+	typedef std::vector<PeakData> PeakLevel;
+	mutable Glib::Threads::Mutex _peak_levels_lock;
+	mutable std::vector<PeakLevel> _peak_levels;
+	/** number of peakfile peaks included in _peak_levels, or -1 if they are not known */
+	mutable samplecnt_t _peak_levels_count;
+	/** incremented whenever _peak_levels are reset */
+	mutable uint32_t _peak_levels_generation;
+	/** true if unknown levels have been queued for ::prepare_peak_levels() */
+	mutable bool _peak_levels_queued;
+
+	void reset_peak_levels (bool known) const;
+	void add_to_peak_levels (samplecnt_t first_peak, PeakData const * peaks, samplecnt_t cnt) const;
+	static void add_peaks_to_levels (std::vector<PeakLevel>& levels, samplecnt_t first_peak, PeakData const * peaks, samplecnt_t cnt);
+	bool load_peak_levels (samplecnt_t peakfile_peaks, std::vector<PeakLevel>& levels) const;
+	bool build_peak_levels (samplecnt_t peakfile_peaks, std::vector<PeakLevel>& levels) const;
+	void save_peak_levels (std::vector<PeakLevel> const & levels, samplecnt_t peakfile_peaks) const;
+	int read_peak_level (PeakData *peaks, samplecnt_t npeaks, samplepos_t start, samplecnt_t cnt,
+	                     double samples_per_visual_peak, samplecnt_t fpp) const;
+	bool merge_level_peaks (int32_t l, samplepos_t first, samplepos_t last, PeakData& peak, bool& found) const;
 };
 
 }
@@ -21,12 +21,14 @@
 #define __ardour_butler_h__
 
 #include <pthread.h>
+#include <vector>
 
 #include <glibmm/threads.h>
 
 #include "pbd/crossthread.h"
 #include "pbd/ringbuffer.h"
 #include "pbd/pool.h"
+#include "pbd/semutils.h"
 #include "ardour/libardour_visibility.h"
 #include "ardour/types.h"
 #include "ardour/session_handle.h"
@@ -35,6 +37,8 @@
 
 namespace ARDOUR {
 
+class Track;
+
 /**
  *  One of the Butler's functions is to clean up (ie delete) unused CrossThreadPools.
  *  When a thread with a CrossThreadPool terminates, its CTP is added to pool_trash.
@@ -93,6 +97,36 @@ private:
 
 	bool flush_tracks_to_disk_normal (boost::shared_ptr<RouteList>, uint32_t& errors);
 
+	/* parallel refill */
+
+	bool refill_tracks (RouteList const&);
+	void refill_some (Sample* mixdown_buffer, gain_t* gain_buffer);
+	void start_refill_workers (uint32_t);
+	void stop_refill_workers ();
+
+	static void* _refill_worker (void*);
+	void*         refill_worker ();
+
+	struct RefillJob {
+		RefillJob (boost::shared_ptr<Track> t, float l) : track (t), load (l) {}
+		boost::shared_ptr<Track> track;
+		float load;
+	};
+
+	struct RefillJobSorter {
+		bool operator() (RefillJob const & a, RefillJob const & b) const {
+			return a.load < b.load;
+		}
+	};
+
+	std::vector<RefillJob> _refill_jobs;
+	std::vector<pthread_t> _refill_threads;
+	PBD::Semaphore _refill_start;
+	PBD::Semaphore _refill_done;
+	volatile gint  _refill_next;
+	volatile gint  _refill_outstanding;
+	volatile gint  _refill_quit;
+
 	/**
 	 * Add request to butler thread request queue
 	 */
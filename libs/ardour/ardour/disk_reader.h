@@ -70,6 +70,14 @@ class LIBARDOUR_API DiskReader : public DiskIOProcessor
 		return refill (_mixdown_buffer, _gain_buffer, 0);
 	}
 
+	/** As above, but using caller-owned working buffers of at least
+	 *  working_buffer_samples() each, so that several butler threads can
+	 *  refill different tracks concurrently.
+	 */
+	int do_refill (Sample* mixdown_buffer, gain_t* gain_buffer) {
+		return refill (mixdown_buffer, gain_buffer, 0);
+	}
+
 	/** For non-butler contexts (allocates temporary working buffers)
 	 *
 	 * This accessible method has a default argument; derived classes
@@ -86,6 +94,13 @@ class LIBARDOUR_API DiskReader : public DiskIOProcessor
 	static void allocate_working_buffers();
 	static void free_working_buffers();
 
+	/* with varifill buffer refilling, we compute the read size in bytes (to optimize
+	   for disk i/o bandwidth) and then convert back into samples. These buffers
+	   need to reflect the maximum size we could use, which is 4MB reads, or 2M samples
+	   using 16 bit samples.
+	*/
+	static samplecnt_t working_buffer_samples () { return 2*1048576; }
+
 	void adjust_buffering ();
 
 	int can_internal_playback_seek (samplecnt_t distance);
@@ -42,6 +42,7 @@ namespace AudioGrapher {
 	template <typename T> class SilenceTrimmer;
 	template <typename T> class TmpFile;
 	template <typename T> class Threader;
+	template <typename T> class AsyncQueue;
 	template <typename T> class AllocatingProcessContext;
 }
 
@@ -59,6 +60,7 @@ class LIBARDOUR_API ExportGraphBuilder
 	typedef boost::shared_ptr<AudioGrapher::Sink<Sample> > FloatSinkPtr;
 	typedef boost::shared_ptr<AudioGrapher::IdentityVertex<Sample> > IdentityVertexPtr;
 	typedef boost::shared_ptr<AudioGrapher::Analyser> AnalysisPtr;
+	typedef boost::shared_ptr<AudioGrapher::AsyncQueue<Sample> > AsyncQueuePtr;
 	typedef std::map<ExportChannelPtr,  IdentityVertexPtr> ChannelMap;
 	typedef std::map<std::string, AnalysisPtr> AnalysisMap;
 
@@ -85,6 +87,12 @@ class LIBARDOUR_API ExportGraphBuilder
 		analysis_map.insert (std::make_pair (fn, ap));
 	}
 
+	void add_encode_queue (AsyncQueuePtr q) {
+		encode_queues.push_back (q);
+	}
+
+	void flush_encode_queues ();
+
 	void add_split_config (FileSpec const & config);
 
 	class Encoder {
@@ -138,6 +146,8 @@ class LIBARDOUR_API ExportGraphBuilder
 		boost::ptr_list<Encoder> children;
 		int                data_width;
 
+		AsyncQueuePtr   queue;
+
 		ChunkerPtr      chunker;
 		AnalysisPtr     analyser;
 		bool            _analyse;
@@ -254,6 +264,9 @@ class LIBARDOUR_API ExportGraphBuilder
 	Session const & session;
 	boost::shared_ptr<ExportTimespan> timespan;
 
+	// Runs the SFC chains, declared before them so that it outlives their queues
+	Glib::ThreadPool encode_pool;
+
 	// Roots for export processor trees
 	typedef boost::ptr_list<ChannelConfig> ChannelConfigList;
 	ChannelConfigList channel_configs;
@@ -267,6 +280,8 @@ class LIBARDOUR_API ExportGraphBuilder
 
 	AnalysisMap analysis_map;
 
+	std::list<AsyncQueuePtr> encode_queues;
+
 	bool _realtime;
 
 	Glib::ThreadPool thread_pool;
@@ -24,6 +24,9 @@
 #include <string>
 #include <exception>
 #include <time.h>
+
+#include <glibmm/threads.h>
+
 #include "ardour/source.h"
 
 namespace ARDOUR {
@@ -86,6 +89,19 @@ public:
 
 	static PBD::Signal2<int,std::string,std::vector<std::string> > AmbiguousFileName;
 
+	/* RAII structure to make find() in the calling thread treat a file
+	 * found in more than one place as missing, rather than asking about
+	 * it via AmbiguousFileName (which may need the GUI thread).
+	 */
+	struct NoAmbiguityQueries {
+		NoAmbiguityQueries () {
+			set_query_ambiguous_files_in_this_thread (false);
+		}
+		~NoAmbiguityQueries () {
+			set_query_ambiguous_files_in_this_thread (true);
+		}
+	};
+
 	void existence_check ();
 	virtual void prevent_deletion ();
 
@@ -105,6 +121,9 @@ public:
 
 	virtual int init (const std::string& idstr, bool must_exist);
 
+	static void set_query_ambiguous_files_in_this_thread (bool);
+	static Glib::Threads::Private<bool> _query_ambiguous_files;
+
 	virtual int move_dependents_to_trash() { return 0; }
 	void set_within_session_from_path (const std::string&);
 
@@ -22,6 +22,7 @@
 #define __ardour_graph_h__
 
 #include <list>
+#include <map>
 #include <set>
 #include <vector>
 #include <string>
@@ -56,14 +57,16 @@ class LIBARDOUR_API Graph : public SessionHandleRef
 {
 public:
 	Graph (Session & session);
+	~Graph ();
 
 	void trigger (GraphNode * n);
 	void rechain (boost::shared_ptr<RouteList>, GraphEdges const &);
+	void update_critical_paths ();
 
 	void dump (int chain);
 	void dec_ref();
 
-	void helper_thread();
+	void helper_thread (uint32_t thread_id);
 
 	int process_routes (pframes_t nframes, samplepos_t start_sample, samplepos_t end_sample, int declick,
 	                    bool& need_butler);
@@ -77,6 +80,11 @@ public:
 
 	bool in_process_thread () const;
 
+	/** @return accumulated DSP load of the most expensive chain of
+	 *  nodes in the graph, relative to the duration of a process cycle
+	 */
+	float critical_path_load () const { return _critical_path_load[_current_chain]; }
+
 protected:
 	virtual void session_going_away ();
 
@@ -86,10 +94,17 @@ private:
 	void reset_thread_list ();
 	void drop_threads ();
 	void restart_cycle();
-	bool run_one();
+	bool run_one (uint32_t thread_id);
+	bool run_one_stealing (uint32_t thread_id);
 	void main_thread();
 	void prep();
 
+	void wake_one_sleeper ();
+	GraphNode* steal_work (uint32_t thread_id);
+	void set_thread_id (uint32_t thread_id);
+	void process_node (GraphNode*);
+	float compute_critical_path (GraphNode*, int chain, std::map<GraphNode*, float>&);
+
 	node_list_t _nodes_rt[2];
 
 	node_list_t _init_trigger_list[2];
@@ -99,6 +114,18 @@ private:
 
 	PBD::Semaphore _execution_sem;
 
+	/* work-stealing scheduler: one work-queue per process-thread.
+	 * Only used when Config->get_graph_work_stealing() is set.
+	 */
+	class WorkQueue;
+	std::vector<WorkQueue*> _work_queues;
+	pthread_key_t           _thread_id_key;
+
+	/** true while the current cycle uses the per-thread work-queues.
+	 * Only changes in ::prep() at the start of a cycle.
+	 */
+	volatile bool _work_stealing;
+
 	/** Signalled to start a run of the graph for a process callback */
 	PBD::Semaphore _callback_start_sem;
 	PBD::Semaphore _callback_done_sem;
@@ -109,6 +136,8 @@ private:
 	volatile gint _finished_refcount;
 	/** The initial number of nodes that do not feed any other node (for each chain) */
 	volatile gint _init_finished_refcount[2];
+	/** The load of the longest chain of nodes (for each chain) */
+	float _critical_path_load[2];
 
 	bool _graph_empty;
 
@@ -119,7 +148,11 @@ private:
 	volatile int _pending_chain;
 	volatile int _setup_chain;
 
+	/** when ::update_critical_paths() last compared the loads */
+	int64_t _last_critical_path_update;
+
 	// parameter caches.
+	int64_t    _cycle_duration_us;
 	pframes_t  _process_nframes;
 	samplepos_t _process_start_sample;
 	samplepos_t _process_end_sample;
@@ -27,6 +27,8 @@
 
 #include <boost/shared_ptr.hpp>
 
+#include "ardour/dsp_load_calculator.h"
+
 namespace ARDOUR
 {
 
@@ -50,6 +52,15 @@ class LIBARDOUR_API GraphNode
 
 	virtual void process();
 
+	/** @return DSP load of this node, relative to the duration of a process cycle */
+	float dsp_load () const { return _dsp_load.get_dsp_load_unbound (); }
+
+	/** @return accumulated DSP load of the most expensive chain of nodes
+	 *  starting at this node, as computed by the last Graph::rechain()
+	 *  or Graph::update_critical_paths()
+	 */
+	float critical_path_load () const { return _critical_path_load; }
+
     private:
 	friend class Graph;
 
@@ -61,6 +72,15 @@ class LIBARDOUR_API GraphNode
 	gint _refcount;
 	/** The number of nodes that we directly feed us (one count for each chain) */
 	gint _init_refcount[2];
+
+	/** ID of the process-thread that last ran this node; used by the
+	 *  work-stealing scheduler to keep a node on the same thread.
+	 */
+	volatile gint _affinity;
+
+	/** Measured by the Graph around every call to ::process() */
+	DSPLoadCalculator _dsp_load;
+	float _critical_path_load;
 };
 
 }
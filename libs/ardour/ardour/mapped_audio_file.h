@@ -0,0 +1,96 @@
+/*
+    Copyright (C) 2018 Paul Davis
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+*/
+
+#ifndef __ardour_mapped_audio_file_h__
+#define __ardour_mapped_audio_file_h__
+
+#include <string>
+#include <stdint.h>
+
+#include "ardour/libardour_visibility.h"
+#include "ardour/types.h"
+
+namespace ARDOUR {
+
+/** Read-only memory-mapping of an uncompressed audio file whose samples
+ *  are stored as 32 bit floats in host byte order (WAV, RF64, CAF).
+ *
+ *  Samples are copied directly from the (page-cache backed) mapping,
+ *  bypassing libsndfile's decoding and intermediate buffers.
+ *  Read-ahead is requested from the kernel in the direction in which
+ *  the file is being read.
+ *
+ *  Accessing a mapping beyond the end of a file raises SIGBUS, so reads are
+ *  checked against the size of the file. The size is cached, and only
+ *  looked up again when new read-ahead is requested, when a read goes past
+ *  the cached size, or when update_size() is called. A file that was
+ *  truncated by another process is then no longer read from the mapping.
+ */
+class LIBARDOUR_API MappedAudioFile
+{
+public:
+	MappedAudioFile ();
+	~MappedAudioFile ();
+
+	/** Map the file at @a path.
+	 *  @param channels expected number of channels
+	 *  @param frames expected length in samples (per channel)
+	 *  @return 0 on success, -1 if the file cannot be mapped or
+	 *  its data is not in a suitable format.
+	 */
+	int open (std::string const & path, uint32_t channels, samplecnt_t frames);
+	void close ();
+
+	bool is_open () const { return _data != 0; }
+
+	/** Copy @a cnt samples of @a channel starting at @a start into @a dst,
+	 *  applying @a gain. The range must be within the file.
+	 *  @return number of samples read, or -1 if the file has become too
+	 *  short for the range, in which case the caller should close the
+	 *  mapping and read the file by other means.
+	 */
+	samplecnt_t read (Sample* dst, samplepos_t start, samplecnt_t cnt, uint32_t channel, gain_t gain);
+
+	/** Look up the size of the file again, after it may have changed */
+	void update_size ();
+
+private:
+	int find_wav_data (int fd, int64_t file_size, int64_t& offset, int64_t& length, uint32_t& channels);
+	int find_caf_data (int fd, int64_t file_size, int64_t& offset, int64_t& length, uint32_t& channels);
+	void advise (samplepos_t start, samplecnt_t cnt);
+	bool size_covers (samplepos_t end);
+
+	int          _fd;
+	void*        _map;
+	size_t       _map_length;
+	int64_t      _file_size;
+	int64_t      _data_offset;
+	float const* _data;
+	uint32_t     _channels;
+	samplecnt_t  _frames;
+
+	/* read-ahead state */
+	samplepos_t  _last_read;
+	samplepos_t  _advised_start;
+	samplepos_t  _advised_end;
+};
+
+} // namespace ARDOUR
+
+#endif /* __ardour_mapped_audio_file_h__ */
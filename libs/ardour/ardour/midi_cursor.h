@@ -32,7 +32,12 @@
 namespace ARDOUR {
 
 struct MidiCursor : public boost::noncopyable {
-	MidiCursor() : last_read_end(0) {}
+	MidiCursor()
+		: last_read_end(0)
+		, cache_index(0)
+		, cache_origin(0)
+		, cache_generation(0)
+	{}
 
 	void connect(PBD::Signal1<void, bool>& invalidated) {
 		connections.drop_connections();
@@ -48,6 +53,9 @@ struct MidiCursor : public boost::noncopyable {
 	Evoral::Sequence<Evoral::Beats>::const_iterator        iter;
 	std::set<Evoral::Sequence<Evoral::Beats>::WeakNotePtr> active_notes;
 	samplepos_t                                             last_read_end;
+	size_t                                                  cache_index;      ///< next event in the MidiEventCache
+	samplepos_t                                             cache_origin;     ///< where reading from the cache last started
+	uint32_t                                                cache_generation; ///< MidiEventCache contents that cache_index refers to
 	PBD::ScopedConnectionList                              connections;
 };
 
@@ -0,0 +1,110 @@
+/*
+    Copyright (C) 2017 Paul Davis
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+#ifndef __ardour_midi_event_cache_h__
+#define __ardour_midi_event_cache_h__
+
+#include <set>
+#include <vector>
+
+#include <glib.h>
+
+#include <boost/utility.hpp>
+
+#include "evoral/EventSink.hpp"
+#include "evoral/Parameter.hpp"
+#include "evoral/Range.hpp"
+#include "evoral/types.hpp"
+
+#include "ardour/libardour_visibility.h"
+#include "ardour/types.h"
+
+namespace ARDOUR {
+
+class MidiChannelFilter;
+class MidiModel;
+class MidiStateTracker;
+class TempoMap;
+struct MidiCursor;
+
+/** The events of a MidiRegion's model, timestamped in session samples.
+ *
+ *  Playback reads from this instead of iterating over the model and
+ *  converting every event time with the tempo map, which makes a read a
+ *  search (only when not reading linearly) followed by a copy of the
+ *  events in range.
+ *
+ *  The cache is built and read with the source lock held. invalidate() may
+ *  be called from any thread; the cache is rebuilt on the next read.
+ */
+class LIBARDOUR_API MidiEventCache : public boost::noncopyable
+{
+  public:
+	MidiEventCache ();
+
+	/** Mark the cache as needing to be rebuilt. */
+	void invalidate () { g_atomic_int_set (&_dirty, 1); }
+
+	/** @return true if the cache holds the events of a model positioned
+	 *  so that source beat 0 is at @param start_qn, played in @param mode.
+	 */
+	bool valid_for (double start_qn, NoteMode mode) const;
+
+	/** Rebuild the cache from @param model, which must be read-locked
+	 *  by the caller (i.e. the source lock must be held).
+	 */
+	void build (MidiModel const & model,
+	            TempoMap const & tempo_map,
+	            double start_qn,
+	            std::set<Evoral::Parameter> const & filtered,
+	            NoteMode mode);
+
+	/** Write events in [start, start + cnt) to @param dst, with the same
+	 *  semantics as MidiSource::midi_read().
+	 */
+	void read (Evoral::EventSink<samplepos_t>& dst,
+	           samplepos_t source_start,
+	           samplepos_t start,
+	           samplecnt_t cnt,
+	           Evoral::Range<samplepos_t>* loop_range,
+	           MidiCursor& cursor,
+	           MidiStateTracker* tracker,
+	           MidiChannelFilter* filter) const;
+
+	size_t size () const { return _events.size (); }
+
+  private:
+	struct Event {
+		samplepos_t       time;    ///< session time
+		samplepos_t       on_time; ///< for note offs, the time of the note on
+		Evoral::EventType type;
+		uint32_t          size;
+		size_t            offset;  ///< offset of the event's bytes in _data
+	};
+
+	std::vector<Event>   _events;
+	std::vector<uint8_t> _data;
+	double               _start_qn;
+	NoteMode             _mode;
+	uint32_t             _generation;
+	gint                 _dirty;
+};
+
+} /* namespace ARDOUR */
+
+#endif /* __ardour_midi_event_cache_h__ */
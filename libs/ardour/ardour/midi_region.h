@@ -30,6 +30,7 @@
 
 #include "ardour/ardour.h"
 #include "ardour/midi_cursor.h"
+#include "ardour/midi_event_cache.h"
 #include "ardour/region.h"
 
 class XMLNode;
@@ -162,10 +163,12 @@ class LIBARDOUR_API MidiRegion : public Region
 	void update_after_tempo_map_change (bool send_change = true);
 
 	std::set<Evoral::Parameter> _filtered_parameters; ///< parameters that we ask our source not to return when reading
+	mutable MidiEventCache _event_cache; ///< our model's events in session samples, protected by the source lock
 	PBD::ScopedConnection _model_connection;
 	PBD::ScopedConnection _model_shift_connection;
 	PBD::ScopedConnection _source_connection;
 	PBD::ScopedConnection _model_contents_connection;
+	PBD::ScopedConnection _source_invalidated_connection;
 	bool _ignore_shift;
 };
 
@@ -45,6 +45,30 @@ extern "C" {
 LIBARDOUR_API void  x86_sse_find_peaks                 (const float * buf, uint32_t nsamples, float *min, float *max);
 LIBARDOUR_API void  x86_sse_avx_find_peaks             (const float * buf, uint32_t nsamples, float *min, float *max);
 
+LIBARDOUR_API void  x86_sse_apply_gain_vector            (float * buf, const float * gain, uint32_t nframes);
+LIBARDOUR_API void  x86_sse_mix_buffers_with_gain_vector (float * dst, const float * src, const float * gain, uint32_t nframes);
+LIBARDOUR_API void  x86_sse_crossfade_buffers            (float * dst, const float * src, const float * src_gain, const float * dst_gain, uint32_t nframes);
+
+LIBARDOUR_API void  x86_sse_avx_apply_gain_vector            (float * buf, const float * gain, uint32_t nframes);
+LIBARDOUR_API void  x86_sse_avx_mix_buffers_with_gain_vector (float * dst, const float * src, const float * gain, uint32_t nframes);
+LIBARDOUR_API void  x86_sse_avx_crossfade_buffers            (float * dst, const float * src, const float * src_gain, const float * dst_gain, uint32_t nframes);
+
+/* FMA functions (AVX + FMA3) */
+LIBARDOUR_API void  x86_fma_mix_buffers_with_gain        (float * dst, const float * src, uint32_t nframes, float gain);
+LIBARDOUR_API void  x86_fma_mix_buffers_with_gain_vector (float * dst, const float * src, const float * gain, uint32_t nframes);
+LIBARDOUR_API void  x86_fma_crossfade_buffers            (float * dst, const float * src, const float * src_gain, const float * dst_gain, uint32_t nframes);
+
+/* AVX-512F functions */
+LIBARDOUR_API float x86_avx512f_compute_peak             (const float * buf, uint32_t nsamples, float current);
+LIBARDOUR_API void  x86_avx512f_find_peaks               (const float * buf, uint32_t nsamples, float *min, float *max);
+LIBARDOUR_API void  x86_avx512f_apply_gain_to_buffer     (float * buf, uint32_t nframes, float gain);
+LIBARDOUR_API void  x86_avx512f_mix_buffers_with_gain    (float * dst, const float * src, uint32_t nframes, float gain);
+LIBARDOUR_API void  x86_avx512f_mix_buffers_no_gain      (float * dst, const float * src, uint32_t nframes);
+LIBARDOUR_API void  x86_avx512f_copy_vector              (float * dst, const float * src, uint32_t nframes);
+LIBARDOUR_API void  x86_avx512f_apply_gain_vector        (float * buf, const float * gain, uint32_t nframes);
+LIBARDOUR_API void  x86_avx512f_mix_buffers_with_gain_vector (float * dst, const float * src, const float * gain, uint32_t nframes);
+LIBARDOUR_API void  x86_avx512f_crossfade_buffers        (float * dst, const float * src, const float * src_gain, const float * dst_gain, uint32_t nframes);
+
 /* debug wrappers for SSE functions */
 
 LIBARDOUR_API float debug_compute_peak               (const ARDOUR::Sample * buf, ARDOUR::pframes_t nsamples, float current);
@@ -62,6 +86,9 @@ LIBARDOUR_API void veclib_find_peaks                 (const ARDOUR::Sample * buf
 LIBARDOUR_API void  veclib_apply_gain_to_buffer      (ARDOUR::Sample * buf, ARDOUR::pframes_t nframes, float gain);
 LIBARDOUR_API void  veclib_mix_buffers_with_gain     (ARDOUR::Sample * dst, const ARDOUR::Sample * src, ARDOUR::pframes_t nframes, float gain);
 LIBARDOUR_API void  veclib_mix_buffers_no_gain       (ARDOUR::Sample * dst, const ARDOUR::Sample * src, ARDOUR::pframes_t nframes);
+LIBARDOUR_API void  veclib_apply_gain_vector         (ARDOUR::Sample * buf, const ARDOUR::gain_t * gain, ARDOUR::pframes_t nframes);
+LIBARDOUR_API void  veclib_mix_buffers_with_gain_vector (ARDOUR::Sample * dst, const ARDOUR::Sample * src, const ARDOUR::gain_t * gain, ARDOUR::pframes_t nframes);
+LIBARDOUR_API void  veclib_crossfade_buffers         (ARDOUR::Sample * dst, const ARDOUR::Sample * src, const ARDOUR::gain_t * src_gain, const ARDOUR::gain_t * dst_gain, ARDOUR::pframes_t nframes);
 
 #endif
 
@@ -73,5 +100,8 @@ LIBARDOUR_API void  default_apply_gain_to_buffer      (ARDOUR::Sample * buf, ARD
 LIBARDOUR_API void  default_mix_buffers_with_gain     (ARDOUR::Sample * dst, const ARDOUR::Sample * src, ARDOUR::pframes_t nframes, float gain);
 LIBARDOUR_API void  default_mix_buffers_no_gain       (ARDOUR::Sample * dst, const ARDOUR::Sample * src, ARDOUR::pframes_t nframes);
 LIBARDOUR_API void  default_copy_vector				  (ARDOUR::Sample * dst, const ARDOUR::Sample * src, ARDOUR::pframes_t nframes);
+LIBARDOUR_API void  default_apply_gain_vector         (ARDOUR::Sample * buf, const ARDOUR::gain_t * gain, ARDOUR::pframes_t nframes);
+LIBARDOUR_API void  default_mix_buffers_with_gain_vector (ARDOUR::Sample * dst, const ARDOUR::Sample * src, const ARDOUR::gain_t * gain, ARDOUR::pframes_t nframes);
+LIBARDOUR_API void  default_crossfade_buffers         (ARDOUR::Sample * dst, const ARDOUR::Sample * src, const ARDOUR::gain_t * src_gain, const ARDOUR::gain_t * dst_gain, ARDOUR::pframes_t nframes);
 
 #endif /* __ardour_mix_h__ */
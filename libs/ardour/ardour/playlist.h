@@ -49,6 +49,7 @@ namespace ARDOUR  {
 
 class Session;
 class Playlist;
+class RegionIndex;
 class Crossfade;
 
 namespace Properties {
@@ -253,6 +254,13 @@ public:
 	friend class Session;
 
   protected:
+	gint region_generation () const { return g_atomic_int_get (&_region_generation); }
+
+	/** Called after a region was added, removed or changed, possibly with the
+	 *  region lock held. Derived playlists drop what they cached about regions.
+	 */
+	virtual void region_generation_changed () {}
+
     class RegionReadLock : public Glib::Threads::RWLock::ReaderLock {
     public:
         RegionReadLock (Playlist *pl) : Glib::Threads::RWLock::ReaderLock (pl->region_lock) {}
@@ -265,12 +273,14 @@ public:
                     : Glib::Threads::RWLock::WriterLock (pl->region_lock)
                     , playlist (pl)
                     , block_notify (do_block_notify) {
+                    playlist->invalidate_region_index ();
                     if (block_notify) {
                             playlist->delay_notifications();
                     }
             }
 
         ~RegionWriteLock() {
+                playlist->invalidate_region_index ();
                 Glib::Threads::RWLock::WriterLock::release ();
                 if (block_notify) {
                         playlist->release_notifications ();
@@ -408,6 +418,17 @@ public:
 	friend class RegionWriteLock;
 	mutable Glib::Threads::RWLock region_lock;
 
+	/* index of `regions' for range queries, built on demand */
+	mutable Glib::Threads::Mutex _region_index_lock;
+	mutable boost::shared_ptr<RegionIndex const> _region_index;
+
+	boost::shared_ptr<RegionIndex const> region_index () const;
+	void invalidate_region_index ();
+	void bump_region_generation ();
+
+	/** incremented whenever a region is added, removed or changed in any way */
+	mutable gint _region_generation;
+
   private:
 	void setup_layering_indices (RegionList const &);
 	void coalesce_and_check_crossfades (std::list<Evoral::Range<samplepos_t> >);
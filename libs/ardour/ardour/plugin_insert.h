@@ -25,6 +25,8 @@
 
 #include <boost/weak_ptr.hpp>
 
+#include "pbd/rcu.h"
+
 #include "ardour/ardour.h"
 #include "ardour/libardour_visibility.h"
 #include "ardour/chan_mapping.h"
@@ -343,7 +345,6 @@ class LIBARDOUR_API PluginInsert : public Processor
 	bool _strict_io;
 	bool _custom_cfg;
 	bool _maps_from_state;
-	bool _mapping_changed;
 
 	Match private_can_support_io_configuration (ChanCount const &, ChanCount &) const;
 	Match internal_can_support_io_configuration (ChanCount const &, ChanCount &) const;
@@ -357,10 +358,53 @@ class LIBARDOUR_API PluginInsert : public Processor
 	PinMappings _out_map;
 	ChanMapping _thru_map; // out-idx <=  in-idx
 
+	/** The pin mappings in the form used by the process thread.
+	 *
+	 *  These are compiled from the maps above by update_pin_tables()
+	 *  whenever the maps change, and published via RCU, so that processing
+	 *  never copies the maps (or allocates) and always sees a consistent set.
+	 */
+	struct PinTables {
+		PinTables () : no_inplace (false) {}
+
+		enum OutputFlags {
+			PluginOutput = 0x1, ///< written by a plugin instance
+			ThruOutput   = 0x2, ///< fed from an input by the thru map
+			MidiBypass   = 0x4  ///< passed on by the in-place MIDI bypass
+		};
+
+		bool no_inplace;
+
+		std::vector<ChanMapping> in_map;  ///< per instance, as passed to Plugin::connect_and_run
+		std::vector<ChanMapping> out_map; ///< per instance, as passed to Plugin::connect_and_run
+		ChanMapping natural_in_map;       ///< identity map of the plugin's inputs
+		ChanMapping natural_out_map;      ///< identity map of the plugin's outputs
+		ChanMapping bypass_in_map;        ///< no_sc_input_map ()
+		ChanMapping bypass_out_map;       ///< output_map ()
+
+		/* all of the following are indexed by data type; UINT32_MAX is an unconnected pin */
+		std::vector<uint32_t> split_copy[DataType::num_types]; ///< in-place split: inputs filled from the first one
+		std::vector<uint32_t> in_src[DataType::num_types];     ///< no-inplace: buffer feeding each input of each instance
+		std::vector<uint32_t> thru_src[DataType::num_types];   ///< buffer feeding each output by the thru map
+		std::vector<uint32_t> bypass_src[DataType::num_types]; ///< no-inplace bypass: buffer feeding each output
+		std::vector<uint8_t>  outputs[DataType::num_types];    ///< OutputFlags of each output
+
+		static uint32_t src (std::vector<uint32_t> const & v, uint32_t i) {
+			return i < v.size () ? v[i] : UINT32_MAX;
+		}
+		uint8_t output_flags (DataType t, uint32_t out) const {
+			return out < outputs[t].size () ? outputs[t][out] : 0;
+		}
+	};
+
+	SerializedRCUManager<PinTables> _pin_tables;
+	void update_pin_tables ();
+	void flush_pin_tables ();
+
 	void automate_and_run (BufferSet& bufs, samplepos_t start, samplepos_t end, double speed, pframes_t nframes);
 	void connect_and_run (BufferSet& bufs, samplepos_t start, samplecnt_t end, double speed, pframes_t nframes, samplecnt_t offset, bool with_auto);
 	void bypass (BufferSet& bufs, pframes_t nframes);
-	void inplace_silence_unconnected (BufferSet&, const PinMappings&, samplecnt_t nframes, samplecnt_t offset) const;
+	void inplace_silence_unconnected (BufferSet&, const PinTables&, samplecnt_t nframes, samplecnt_t offset) const;
 
 	void create_automatable_parameters ();
 	void control_list_automation_state_changed (Evoral::Parameter, AutoState);
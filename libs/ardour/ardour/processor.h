@@ -25,6 +25,7 @@
 #include <exception>
 
 #include "pbd/statefuldestructible.h"
+#include "pbd/timing.h"
 
 #include "ardour/ardour.h"
 #include "ardour/buffer_set.h"
@@ -140,6 +141,11 @@ class LIBARDOUR_API Processor : public SessionObject, public Automatable, public
 	virtual void set_owner (SessionObject*);
 	SessionObject* owner() const;
 
+	/** Time spent in ::run() in microseconds, collected by the owning
+	 * Route while Config->get_collect_dsp_timing() is enabled.
+	 */
+	PBD::TimingStats& timing_stats () { return _timing_stats; }
+
 protected:
 	virtual int set_state_2X (const XMLNode&, int version);
 
@@ -157,6 +163,7 @@ protected:
 	SessionObject* _owner;
 	samplecnt_t _input_latency;
 	samplecnt_t _output_latency;
+	PBD::TimingStats _timing_stats;
 };
 
 } // namespace ARDOUR
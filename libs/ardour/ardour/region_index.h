@@ -0,0 +1,96 @@
+/*
+    Copyright (C) 2018 Paul Davis
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+*/
+
+#ifndef __libardour_region_index_h__
+#define __libardour_region_index_h__
+
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+
+#include "ardour/libardour_visibility.h"
+#include "ardour/types.h"
+
+namespace ARDOUR {
+
+class Region;
+
+/** An immutable index of a playlist's regions, to find the regions
+ *  within a given range of the timeline in O(log n + k).
+ *
+ *  Regions are kept in an array sorted by position, which is used as
+ *  an implicit balanced binary tree in which every node is augmented with
+ *  the largest last sample of its subtree (an "augmented interval tree").
+ *
+ *  The index reflects the region bounds at the time it was built; the
+ *  playlist drops it whenever a region is added, removed, moved or
+ *  trimmed and builds a new one on the next query.
+ */
+class LIBARDOUR_API RegionIndex
+{
+public:
+	RegionIndex (RegionList::const_iterator begin, RegionList::const_iterator end);
+
+	size_t size () const { return _entries.size (); }
+
+	/** Append the regions which have some part within [start, end]
+	 *  to @a result, in order of position.
+	 */
+	void touched (samplepos_t start, samplepos_t end, RegionList& result) const;
+
+	/** Append the regions whose first sample is within [start, end]
+	 *  to @a result, in order of position.
+	 */
+	void starting_within (samplepos_t start, samplepos_t end, RegionList& result) const;
+
+	/** @return the first region (in order of position) which starts after @a sample */
+	boost::shared_ptr<Region> next_start_after (samplepos_t sample) const;
+	/** @return the first region (in order of position) among those which start
+	 *  closest before @a sample.
+	 */
+	boost::shared_ptr<Region> previous_start_before (samplepos_t sample) const;
+
+private:
+	struct Entry {
+		Entry (boost::shared_ptr<Region>);
+
+		samplepos_t first;
+		samplepos_t last;
+		boost::shared_ptr<Region> region;
+	};
+
+	struct EntrySorter {
+		bool operator() (Entry const & a, Entry const & b) const {
+			return a.first < b.first;
+		}
+	};
+
+	samplepos_t build (size_t lo, size_t hi);
+	void find (size_t lo, size_t hi, samplepos_t start, samplepos_t end, RegionList&) const;
+	size_t lower_bound (samplepos_t) const;
+	size_t upper_bound (samplepos_t) const;
+
+	std::vector<Entry> _entries;
+	/** for the subtree rooted at _entries[n], the largest last sample */
+	std::vector<samplepos_t> _max_last;
+};
+
+} /* namespace ARDOUR */
+
+#endif /* __libardour_region_index_h__ */
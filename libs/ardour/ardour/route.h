@@ -230,6 +230,16 @@ public:
 	boost::shared_ptr<Processor> nth_plugin (uint32_t n) const;
 	boost::shared_ptr<Processor> nth_send (uint32_t n) const;
 
+	/** Time spent in process_output_buffers() in microseconds,
+	 * collected while Config->get_collect_dsp_timing() is enabled.
+	 * See Processor::timing_stats() for individual processors.
+	 */
+	PBD::TimingStats& timing_stats () { return _timing_stats; }
+
+	/* GraphNode is not known to Lua, so bind these instead of its methods */
+	float dsp_load () const { return GraphNode::dsp_load (); }
+	float critical_path_load () const { return GraphNode::critical_path_load (); }
+
 	bool has_io_processor_named (const std::string&);
 	ChanCount max_processor_streams () const { return processor_max_streams; }
 
@@ -654,6 +664,7 @@ public:
 	gint           _pending_signals; // atomic
 
 	int            _pending_declick;
+	PBD::TimingStats _timing_stats;
 	MeterPoint     _meter_point;
 	MeterPoint     _pending_meter_point;
 	MeterType      _meter_type;
@@ -32,12 +32,27 @@ namespace ARDOUR {
 	typedef void  (*mix_buffers_no_gain_t)		(ARDOUR::Sample *, const ARDOUR::Sample *, pframes_t);
 	typedef void  (*copy_vector_t)			    (ARDOUR::Sample *, const ARDOUR::Sample *, pframes_t);
 
+	/* per-sample gain, for fades and envelopes */
+	typedef void  (*apply_gain_vector_t)            (ARDOUR::Sample *, const ARDOUR::gain_t *, pframes_t);
+	typedef void  (*mix_buffers_with_gain_vector_t) (ARDOUR::Sample *, const ARDOUR::Sample *, const ARDOUR::gain_t *, pframes_t);
+	typedef void  (*crossfade_buffers_t)            (ARDOUR::Sample *, const ARDOUR::Sample *, const ARDOUR::gain_t *, const ARDOUR::gain_t *, pframes_t);
+
 	LIBARDOUR_API extern compute_peak_t		compute_peak;
 	LIBARDOUR_API extern find_peaks_t               find_peaks;
 	LIBARDOUR_API extern apply_gain_to_buffer_t	apply_gain_to_buffer;
 	LIBARDOUR_API extern mix_buffers_with_gain_t	mix_buffers_with_gain;
 	LIBARDOUR_API extern mix_buffers_no_gain_t	mix_buffers_no_gain;
 	LIBARDOUR_API extern copy_vector_t			copy_vector;
+
+	/** buf[n] *= gain[n] */
+	LIBARDOUR_API extern apply_gain_vector_t            apply_gain_vector;
+	/** dst[n] += src[n] * gain[n] */
+	LIBARDOUR_API extern mix_buffers_with_gain_vector_t mix_buffers_with_gain_vector;
+	/** dst[n] = dst[n] * dst_gain[n] + src[n] * src_gain[n], arguments are
+	 *  (dst, src, src_gain, dst_gain, nframes). If dst_gain is 0, 1 - src_gain[n] is
+	 *  used for dst.
+	 */
+	LIBARDOUR_API extern crossfade_buffers_t            crossfade_buffers;
 }
 
 #endif /* __ardour_runtime_functions_h__ */
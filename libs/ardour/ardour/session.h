@@ -77,6 +77,7 @@
 
 class XMLTree;
 class XMLNode;
+class XMLWriter;
 struct _AEffect;
 typedef struct _AEffect AEffect;
 
@@ -202,6 +203,12 @@ class LIBARDOUR_API Session : public PBD::StatefulDestructible, public PBD::Scop
 	static int get_info_from_path (const std::string& xmlpath, float& sample_rate, SampleFormat& data_format, std::string& program_version);
 	static std::string get_snapshot_from_instant (const std::string& session_dir);
 
+	/** The phases of the last load of this session, in order, each with
+	 *  the time it took in microseconds.
+	 */
+	typedef std::vector<std::pair<std::string, gint64> > LoadTimes;
+	LoadTimes const & load_times () const { return _load_times; }
+
 	/** a monotonic counter used for naming user-visible things uniquely
 	 * (curently the sidechain port).
 	 * Use sparingly to keep the numbers low, prefer PBD::ID for all
@@ -307,6 +314,13 @@ class LIBARDOUR_API Session : public PBD::StatefulDestructible, public PBD::Scop
 	uint32_t ntracks () const;
 	uint32_t nbusses () const;
 
+	/** @return DSP load of the most expensive chain of routes in the
+	 * process graph, relative to the cycle duration (0 if the graph is not used)
+	 */
+	float critical_path_load () const;
+	/** re-sort the process graph by measured DSP loads (butler thread) */
+	void update_critical_paths ();
+
 	boost::shared_ptr<BundleList> bundles () {
 		return _bundles.reader ();
 	}
@@ -563,6 +577,8 @@ class LIBARDOUR_API Session : public PBD::StatefulDestructible, public PBD::Scop
 	XMLNode& get_state();
 	int      set_state(const XMLNode& node, int version); // not idempotent
 	XMLNode& get_template();
+	/** Write the full state of the session to @a path as it is generated */
+	bool     write_state (const std::string& path) { return write_state (path, NormalSave); }
 	bool     export_track_state (boost::shared_ptr<RouteList> rl, const std::string& path);
 
 	/// The instant xml file is written to the session directory
@@ -1878,6 +1894,10 @@ class LIBARDOUR_API Session : public PBD::StatefulDestructible, public PBD::Scop
 
 	bool no_questions_about_missing_files;
 
+	LoadTimes _load_times;
+	gint64    _load_phase_start;
+	void load_phase_done (std::string const &);
+
 	std::string get_best_session_directory_for_new_audio ();
 
 	mutable gint _playback_load;
@@ -1910,7 +1930,36 @@ class LIBARDOUR_API Session : public PBD::StatefulDestructible, public PBD::Scop
 		SwitchToSnapshot
 	};
 
+	struct StateSnapshot;
+
 	XMLNode& state(bool, snapshot_t snapshot_type = NormalSave);
+	void capture_state (StateSnapshot&);
+	void state (XMLWriter&, StateSnapshot&);
+	bool write_state (const std::string& path, snapshot_t snapshot_type, std::string const & cache_path = std::string());
+	bool write_state (const std::string& path, StateSnapshot&, std::string const & cache_path = std::string());
+	std::string state_cache_path (std::string const & xml_path) const;
+	int  install_state_file (bool written, std::string const & tmp_path, std::string const & xml_path);
+
+	/* Background saves: pending state is captured and serialized by the
+	 * thread which asks for it, and written by the save thread.  Written saves are
+	 * handed back via _finished_saves, to be deleted by the threads
+	 * which queue or wait for saves, not by the save thread.
+	 */
+	struct BackgroundSave;
+
+	void queue_background_save (BackgroundSave*);
+	void reap_background_saves ();
+	void save_thread_run ();
+	void save_thread_terminate ();
+	void wait_for_background_save ();
+
+	Glib::Threads::Thread* _save_thread;
+	Glib::Threads::Mutex   _save_thread_lock;
+	Glib::Threads::Cond    _save_thread_cond;
+	BackgroundSave*        _queued_save;
+	std::list<BackgroundSave*> _finished_saves;
+	bool                   _save_thread_busy;
+	bool                   _save_thread_run;
 
 	/* click track */
 	typedef std::list<Click*> Clicks;
@@ -30,6 +30,7 @@
 #include "pbd/signals.h"
 
 class XMLNode;
+class XMLWriter;
 
 namespace PBD {
 	class ID;
@@ -73,7 +74,16 @@ private:
 
 	void find_equivalent_playlist_regions (boost::shared_ptr<Region>, std::vector<boost::shared_ptr<Region> >& result);
 	void update_after_tempo_map_change ();
-	void add_state (XMLNode *, bool);
+	/** The playlists whose state is saved with the session, in the order
+	 *  in which they are saved.
+	 */
+	struct StateSnapshot {
+		std::vector<boost::shared_ptr<Playlist> > playlists;
+		std::vector<boost::shared_ptr<Playlist> > unused_playlists;
+	};
+
+	void capture_state (StateSnapshot&) const;
+	static void add_state (XMLWriter&, bool, StateSnapshot const &);
 	bool maybe_delete_unused (boost::function<int(boost::shared_ptr<Playlist>)>);
 	int load (Session &, const XMLNode&);
 	int load_unused (Session &, const XMLNode&);
@@ -24,6 +24,7 @@
 
 #include "ardour/audiofilesource.h"
 #include "ardour/broadcast_info.h"
+#include "ardour/mapped_audio_file.h"
 #include "ardour/progress.h"
 
 namespace ARDOUR {
@@ -71,6 +72,7 @@ class LIBARDOUR_API SndFileSource : public AudioFileSource {
     uint32_t channel_count () const { return _info.channels; }
 
 	bool clamped_at_unity () const;
+	bool cpu_bound () const;
 
 	static void setup_standard_crossfades (Session const &, samplecnt_t sample_rate);
 	static const Source::Flag default_writable_flags;
@@ -92,6 +94,11 @@ class LIBARDOUR_API SndFileSource : public AudioFileSource {
 	SF_INFO _info;
 	BroadcastInfo *_broadcast_info;
 
+	/* read path for non-writable native float files, bypassing libsndfile */
+	mutable MappedAudioFile _mapped_file;
+	mutable bool            _map_attempted;
+	bool use_mapped_file () const;
+
 	void init_sndfile ();
 	int open();
 	int setup_broadcast_info (samplepos_t when, struct tm&, time_t);
@@ -21,6 +21,7 @@
 #define __ardour_source_factory_h__
 
 #include <string>
+#include <vector>
 #include <stdint.h>
 #include <boost/shared_ptr.hpp>
 
@@ -43,6 +44,22 @@ class LIBARDOUR_API SourceFactory {
 	static PBD::Signal1<void,boost::shared_ptr<Source> > SourceCreated;
 
 	static boost::shared_ptr<Source> create (Session&, const XMLNode& node, bool async = false);
+
+	/** Open the files of the plain audio sources described by @a nodes
+	 *  using a pool of threads, without announcing the sources.
+	 *  @param opened filled with one entry per node: the source, or 0 if
+	 *  the node must be handled by create() (because it describes some
+	 *  other kind of source, or its file could not be opened).
+	 */
+	static void open (Session&, const std::vector<XMLNode const *>& nodes,
+	                  std::vector<boost::shared_ptr<Source> >& opened);
+
+	/** Set up the peakfile of a source returned by open() and announce it,
+	 *  as create() would have done.
+	 *  @return 0 on success, non-zero if the peakfile could not be set up.
+	 */
+	static int announce (boost::shared_ptr<Source>, bool async = false);
+
 	static boost::shared_ptr<Source> createSilent (Session&, const XMLNode& node,
 	                                               samplecnt_t nframes, float sample_rate);
 
@@ -66,10 +83,12 @@ class LIBARDOUR_API SourceFactory {
 
         static Glib::Threads::Cond                       PeaksToBuild;
         static Glib::Threads::Mutex                      peak_building_lock;
-	static std::list< boost::weak_ptr<AudioSource> > files_with_peaks;
 
+	/** @return number of sources whose peakfiles are waiting to be set up or being built */
 	static int peak_work_queue_length ();
 	static int setup_peakfile (boost::shared_ptr<Source>, bool async);
+	/** Have the coarser peak levels of @a as loaded or built by a peak building thread */
+	static void prepare_peak_levels (boost::shared_ptr<AudioSource> as);
 };
 
 }
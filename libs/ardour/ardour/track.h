@@ -141,6 +141,7 @@ class LIBARDOUR_API Track : public Route, public Recordable
 	float playback_buffer_load () const;
 	float capture_buffer_load () const;
 	int do_refill ();
+	int do_refill (Sample* mixdown_buffer, gain_t* gain_buffer);
 	int do_flush (RunContext, bool force = false);
 	void set_pending_overwrite (bool);
 	int seek (samplepos_t, bool complete_refill = false);
@@ -157,41 +157,40 @@ struct Segment {
 	Evoral::Range<samplepos_t> range;       ///< range of the region to read, in session samples
 };
 
-/** @param start Start position in session samples.
- *  @param cnt Number of samples to read.
+/** The segments of regions that are audible in some span of the timeline,
+ *  for a given state of the playlist. Consecutive reads (butler refills,
+ *  one per channel) within the span can be satisfied from the plan without
+ *  looking at (or sorting) the regions again.
  */
-ARDOUR::samplecnt_t
-AudioPlaylist::read (Sample *buf, Sample *mixdown_buffer, float *gain_buffer, samplepos_t start,
-		     samplecnt_t cnt, unsigned chan_n)
-{
-	DEBUG_TRACE (DEBUG::AudioPlayback, string_compose ("Playlist %1 read @ %2 for %3, channel %4, regions %5 mixdown @ %6 gain @ %7\n",
-							   name(), start, cnt, chan_n, regions.size(), mixdown_buffer, gain_buffer));
-
-	/* optimizing this memset() away involves a lot of conditionals
-	   that may well cause more of a hit due to cache misses
-	   and related stuff than just doing this here.
+struct AudioPlaylist::ReadPlan {
+	ReadPlan (samplepos_t s, samplepos_t e, gint g) : start (s), end (e), generation (g) {}
 
-	   it would be great if someone could measure this
-	   at some point.
+	samplepos_t start;  ///< first sample covered by the plan
+	samplepos_t end;    ///< last sample covered by the plan
+	gint generation;    ///< Playlist::region_generation() that the plan was made for
 
-	   one way or another, parts of the requested area
-	   that are not written to by Region::region_at()
-	   for all Regions that cover the area need to be
-	   zeroed.
-	*/
+	/** segments to read, lowest layer first */
+	std::vector<Segment> segments;
+};
 
-	memset (buf, 0, sizeof (Sample) * cnt);
+/** Number of read sizes that a newly built read plan spans */
+static const samplecnt_t read_plan_reads = 8;
 
-	/* this function is never called from a realtime thread, so
-	   its OK to block (for short intervals).
+/** Work out which bits of which regions are audible between
+ *  @a start and @a end (inclusive). Caller must hold the region lock.
+ */
+boost::shared_ptr<AudioPlaylist::ReadPlan const>
+AudioPlaylist::build_read_plan (samplepos_t start, samplepos_t end)
+{
+	/* note the generation before looking at the regions, so that
+	   a concurrent change makes this plan stale rather than wrong.
 	*/
-
-	Playlist::RegionReadLock rl (this);
+	boost::shared_ptr<ReadPlan> plan (new ReadPlan (start, end, region_generation ()));
 
 	/* Find all the regions that are involved in the bit we are reading,
 	   and sort them by descending layer and ascending position.
 	*/
-	boost::shared_ptr<RegionList> all = regions_touched_locked (start, start + cnt - 1);
+	boost::shared_ptr<RegionList> all = regions_touched_locked (start, end);
 	all->sort (ReadSorter ());
 
 	/* This will be a list of the bits of our read range that we have
@@ -216,7 +215,7 @@ AudioPlaylist::read (Sample *buf, Sample *mixdown_buffer, float *gain_buffer, sa
 		*/
 		Evoral::Range<samplepos_t> region_range = ar->range ();
 		region_range.from = max (region_range.from, start);
-		region_range.to = min (region_range.to, start + cnt - 1);
+		region_range.to = min (region_range.to, end);
 
 		/* ... and then remove the bits that are already done */
 
@@ -244,13 +243,117 @@ AudioPlaylist::read (Sample *buf, Sample *mixdown_buffer, float *gain_buffer, sa
 		}
 	}
 
-	/* Now go backwards through the to_do list doing the actual reads */
-	for (list<Segment>::reverse_iterator i = to_do.rbegin(); i != to_do.rend(); ++i) {
+	/* the reads are done backwards through the to_do list */
+	plan->segments.assign (to_do.rbegin(), to_do.rend());
+
+	return plan;
+}
+
+/** @return a read plan which covers @a start to @a end (inclusive), re-using
+ *  the previous one if the playlist has not changed since it was made.
+ *  Caller must hold the region lock.
+ */
+boost::shared_ptr<AudioPlaylist::ReadPlan const>
+AudioPlaylist::read_plan (samplepos_t start, samplepos_t end)
+{
+	boost::shared_ptr<ReadPlan const> plan;
+
+	{
+		Glib::Threads::Mutex::Lock lm (_read_plan_lock);
+		plan = _read_plan;
+	}
+
+	if (plan && plan->generation == region_generation () && plan->start <= start && plan->end >= end) {
+		return plan;
+	}
+
+	/* plan ahead in the direction that we are reading in */
+	samplecnt_t const span = (end - start + 1) * read_plan_reads;
+
+	if (plan && end < plan->end && start < plan->start) {
+		plan = build_read_plan (max ((samplepos_t) 0, end - span + 1), end);
+	} else {
+		plan = build_read_plan (start, start + span - 1);
+	}
+
+	Glib::Threads::Mutex::Lock lm (_read_plan_lock);
+	_read_plan = plan;
+
+	return plan;
+}
+
+/** Drop the read plan as soon as the regions change. It holds references
+ *  to the regions it reads from, which would otherwise keep removed regions
+ *  (and their sources) alive until the next read, if there ever is one.
+ */
+void
+AudioPlaylist::region_generation_changed ()
+{
+	boost::shared_ptr<ReadPlan const> stale;
+
+	{
+		Glib::Threads::Mutex::Lock lm (_read_plan_lock);
+		stale.swap (_read_plan);
+	}
+
+	/* stale goes out of scope without the lock held */
+}
+
+/** @param start Start position in session samples.
+ *  @param cnt Number of samples to read.
+ */
+ARDOUR::samplecnt_t
+AudioPlaylist::read (Sample *buf, Sample *mixdown_buffer, float *gain_buffer, samplepos_t start,
+		     samplecnt_t cnt, unsigned chan_n)
+{
+	DEBUG_TRACE (DEBUG::AudioPlayback, string_compose ("Playlist %1 read @ %2 for %3, channel %4, regions %5 mixdown @ %6 gain @ %7\n",
+							   name(), start, cnt, chan_n, regions.size(), mixdown_buffer, gain_buffer));
+
+	/* optimizing this memset() away involves a lot of conditionals
+	   that may well cause more of a hit due to cache misses
+	   and related stuff than just doing this here.
+
+	   it would be great if someone could measure this
+	   at some point.
+
+	   one way or another, parts of the requested area
+	   that are not written to by Region::region_at()
+	   for all Regions that cover the area need to be
+	   zeroed.
+	*/
+
+	memset (buf, 0, sizeof (Sample) * cnt);
+
+	if (cnt <= 0) {
+		return cnt;
+	}
+
+	/* this function is never called from a realtime thread, so
+	   its OK to block (for short intervals).
+	*/
+
+	Playlist::RegionReadLock rl (this);
+
+	samplepos_t const end = start + cnt - 1;
+	boost::shared_ptr<ReadPlan const> plan = read_plan (start, end);
+
+	/* Now go through the plan doing the actual reads for the segments
+	   that fall within the range we are reading.
+	*/
+	for (std::vector<Segment>::const_iterator i = plan->segments.begin(); i != plan->segments.end(); ++i) {
+
+		if (i->range.to < start || i->range.from > end) {
+			continue;
+		}
+
+		samplepos_t const from = max (i->range.from, start);
+		samplepos_t const to = min (i->range.to, end);
+
 		DEBUG_TRACE (DEBUG::AudioPlayback, string_compose ("\tPlaylist %1 read %2 @ %3 for %4, channel %5, buf @ %6 offset %7\n",
-								   name(), i->region->name(), i->range.from,
-								   i->range.to - i->range.from + 1, (int) chan_n,
-								   buf, i->range.from - start));
-		i->region->read_at (buf + i->range.from - start, mixdown_buffer, gain_buffer, i->range.from, i->range.to - i->range.from + 1, chan_n);
+								   name(), i->region->name(), from,
+								   to - from + 1, (int) chan_n,
+								   buf, from - start));
+		i->region->read_at (buf + from - start, mixdown_buffer, gain_buffer, from, to - from + 1, chan_n);
 	}
 
 	return cnt;
@@ -587,14 +587,10 @@ AudioRegion::read_at (Sample *buf, Sample *mixdown_buffer, float *gain_buffer,
 		_envelope->curve().get_vector (internal_offset, internal_offset + to_read, gain_buffer, to_read);
 
 		if (_scale_amplitude != 1.0f) {
-			for (samplecnt_t n = 0; n < to_read; ++n) {
-				mixdown_buffer[n] *= gain_buffer[n] * _scale_amplitude;
-			}
-		} else {
-			for (samplecnt_t n = 0; n < to_read; ++n) {
-				mixdown_buffer[n] *= gain_buffer[n];
-			}
+			apply_gain_to_buffer (gain_buffer, to_read, _scale_amplitude);
 		}
+
+		apply_gain_vector (mixdown_buffer, gain_buffer, to_read);
 	} else if (_scale_amplitude != 1.0f) {
 		apply_gain_to_buffer (mixdown_buffer, to_read, _scale_amplitude);
 	}
@@ -618,33 +614,31 @@ AudioRegion::read_at (Sample *buf, Sample *mixdown_buffer, float *gain_buffer,
 				_inverse_fade_in->curve().get_vector (internal_offset, internal_offset + fade_in_limit, gain_buffer, fade_in_limit);
 
 				/* Fade the data from lower layers out */
-				for (samplecnt_t n = 0; n < fade_in_limit; ++n) {
-					buf[n] *= gain_buffer[n];
-				}
+				apply_gain_vector (buf, gain_buffer, fade_in_limit);
 
 				/* refill gain buffer with the fade in */
 
 				_fade_in->curve().get_vector (internal_offset, internal_offset + fade_in_limit, gain_buffer, fade_in_limit);
 
+				/* Mix our newly-read data in, with the fade */
+				mix_buffers_with_gain_vector (buf, mixdown_buffer, gain_buffer, fade_in_limit);
+
 			} else {
 
 				/* no explicit inverse fade in, so just use (1 - fade
-				 * in) for the fade out of lower layers
+				 * in) for the fade out of lower layers, while mixing
+				 * our newly-read data in with the fade.
 				 */
 
 				_fade_in->curve().get_vector (internal_offset, internal_offset + fade_in_limit, gain_buffer, fade_in_limit);
 
-				for (samplecnt_t n = 0; n < fade_in_limit; ++n) {
-					buf[n] *= 1 - gain_buffer[n];
-				}
+				crossfade_buffers (buf, mixdown_buffer, gain_buffer, 0, fade_in_limit);
 			}
 		} else {
 			_fade_in->curve().get_vector (internal_offset, internal_offset + fade_in_limit, gain_buffer, fade_in_limit);
-		}
 
-		/* Mix our newly-read data in, with the fade */
-		for (samplecnt_t n = 0; n < fade_in_limit; ++n) {
-			buf[n] += mixdown_buffer[n] * gain_buffer[n];
+			/* Mix our newly-read data in, with the fade */
+			mix_buffers_with_gain_vector (buf, mixdown_buffer, gain_buffer, fade_in_limit);
 		}
 	}
 
@@ -658,36 +652,36 @@ AudioRegion::read_at (Sample *buf, Sample *mixdown_buffer, float *gain_buffer,
 				_inverse_fade_out->curve().get_vector (curve_offset, curve_offset + fade_out_limit, gain_buffer, fade_out_limit);
 
 				/* Fade the data from lower levels in */
-				for (samplecnt_t n = 0, m = fade_out_offset; n < fade_out_limit; ++n, ++m) {
-					buf[m] *= gain_buffer[n];
-				}
+				apply_gain_vector (buf + fade_out_offset, gain_buffer, fade_out_limit);
 
 				/* fetch the actual fade out */
 
 				_fade_out->curve().get_vector (curve_offset, curve_offset + fade_out_limit, gain_buffer, fade_out_limit);
 
+				/* Mix our newly-read data with whatever was already there,
+				   with the fade out applied to our data.
+				*/
+				mix_buffers_with_gain_vector (buf + fade_out_offset, mixdown_buffer + fade_out_offset, gain_buffer, fade_out_limit);
+
 			} else {
 
 				/* no explicit inverse fade out (which is
 				 * actually a fade in), so just use (1 - fade
-				 * out) for the fade in of lower layers
+				 * out) for the fade in of lower layers, while
+				 * mixing our data with the fade out applied.
 				 */
 
 				_fade_out->curve().get_vector (curve_offset, curve_offset + fade_out_limit, gain_buffer, fade_out_limit);
 
-				for (samplecnt_t n = 0, m = fade_out_offset; n < fade_out_limit; ++n, ++m) {
-					buf[m] *= 1 - gain_buffer[n];
-				}
+				crossfade_buffers (buf + fade_out_offset, mixdown_buffer + fade_out_offset, gain_buffer, 0, fade_out_limit);
 			}
 		} else {
 			_fade_out->curve().get_vector (curve_offset, curve_offset + fade_out_limit, gain_buffer, fade_out_limit);
-		}
 
-		/* Mix our newly-read data with whatever was already there,
-		   with the fade out applied to our data.
-		*/
-		for (samplecnt_t n = 0, m = fade_out_offset; n < fade_out_limit; ++n, ++m) {
-			buf[m] += mixdown_buffer[m] * gain_buffer[n];
+			/* Mix our newly-read data with whatever was already there,
+			   with the fade out applied to our data.
+			*/
+			mix_buffers_with_gain_vector (buf + fade_out_offset, mixdown_buffer + fade_out_offset, gain_buffer, fade_out_limit);
 		}
 	}
 
@@ -29,6 +29,7 @@
 #include <cerrno>
 #include <ctime>
 #include <cmath>
+#include <cstring>
 #include <iomanip>
 #include <algorithm>
 #include <vector>
@@ -57,6 +58,7 @@
 #include "ardour/rc_configuration.h"
 #include "ardour/runtime_functions.h"
 #include "ardour/session.h"
+#include "ardour/source_factory.h"
 
 #include "pbd/i18n.h"
 
@@ -76,6 +78,30 @@ bool AudioSource::_build_peakfiles = false;
 
 #define _FPP 256
 
+/* The peakfile has one peak per _FPP samples. Coarser levels have
+ * 16 times the samples-per-peak of the one before: 4096, 65536,
+ * 1048576 and 16777216 samples per peak.
+ */
+static const samplecnt_t peak_level_factor = 16;
+static const uint32_t n_peak_levels = 4;
+
+/* file format of the levels, saved next to the peakfile: this header,
+ * then the peaks of each level in turn. The number of peaks per level
+ * follows from the number of peaks in the peakfile.
+ */
+static const char peak_levels_magic[4] = { 'A', 'P', 'K', 'L' };
+static const uint32_t peak_levels_version = 1;
+
+struct PeakLevelsHeader {
+	char     magic[4];
+	uint32_t version;
+	uint32_t samples_per_peak;
+	uint32_t factor;
+	uint32_t n_levels;
+	uint32_t reserved;
+	uint64_t peakfile_peaks;
+};
+
 AudioSource::AudioSource (Session& s, const string& name)
 	: Source (s, DataType::AUDIO, name)
 	, _length (0)
@@ -89,6 +115,15 @@ AudioSource::AudioSource (Session& s, const string& name)
 	, _last_scale (0.0)
 	, _last_map_off (0)
 	, _last_raw_map_length (0)
+	, _defer_peak_building (false)
+	, _peak_build_pending (false)
+	, _peak_range_size (0)
+	, _peak_ranges_remaining (0)
+	, _peak_range_samples_done (0)
+	, _peak_range_failed (false)
+	, _peak_levels_count (-1)
+	, _peak_levels_generation (0)
+	, _peak_levels_queued (false)
 {
 }
 
@@ -105,6 +140,15 @@ AudioSource::AudioSource (Session& s, const XMLNode& node)
 	, _last_scale (0.0)
 	, _last_map_off (0)
 	, _last_raw_map_length (0)
+	, _defer_peak_building (false)
+	, _peak_build_pending (false)
+	, _peak_range_size (0)
+	, _peak_ranges_remaining (0)
+	, _peak_range_samples_done (0)
+	, _peak_range_failed (false)
+	, _peak_levels_count (-1)
+	, _peak_levels_generation (0)
+	, _peak_levels_queued (false)
 {
 	if (set_state (node, Stateful::loading_state_version)) {
 		throw failed_constructor();
@@ -225,8 +269,17 @@ AudioSource::rename_peakfile (string newpath)
 		}
 	}
 
+	const string oldlevels = peak_levels_path ();
+
 	_peakpath = newpath;
 
+	if (Glib::file_test (oldlevels, Glib::FILE_TEST_EXISTS)) {
+		if (g_rename (oldlevels.c_str(), peak_levels_path ().c_str()) != 0) {
+			/* not fatal, they will be rebuilt from the peakfile */
+			::g_unlink (oldlevels.c_str());
+		}
+	}
+
 	return 0;
 }
 
@@ -302,7 +355,13 @@ AudioSource::initialize_peakfile (const string& audio_path, const bool in_sessio
 	}
 
 	if (!empty() && !_peaks_built && _build_missing_peakfiles && _build_peakfiles) {
-		build_peaks_from_scratch ();
+		if (_defer_peak_building) {
+			/* the caller will use ::prepare_peak_ranges() */
+			Glib::Threads::Mutex::Lock lr (_peak_range_lock);
+			_peak_build_pending = true;
+		} else {
+			build_peaks_from_scratch ();
+		}
 	}
 
 	return 0;
@@ -329,7 +388,15 @@ AudioSource::write (Sample *dst, samplecnt_t cnt)
 int
 AudioSource::read_peaks (PeakData *peaks, samplecnt_t npeaks, samplepos_t start, samplecnt_t cnt, double samples_per_visual_peak) const
 {
-	return read_peaks_with_fpp (peaks, npeaks, start, cnt, samples_per_visual_peak, _FPP);
+	/* use the coarsest level that still has at least one peak per visual peak */
+
+	samplecnt_t fpp = _FPP;
+
+	for (uint32_t n = 0; n < n_peak_levels && fpp * peak_level_factor <= samples_per_visual_peak; ++n) {
+		fpp *= peak_level_factor;
+	}
+
+	return read_peaks_with_fpp (peaks, npeaks, start, cnt, samples_per_visual_peak, fpp);
 }
 
 /** @param peaks Buffer to write peak data.
@@ -358,6 +425,14 @@ AudioSource::read_peaks_with_fpp (PeakData *peaks, samplecnt_t npeaks, samplepos
 
 	GStatBuf statbuf;
 
+	if (samples_per_file_peak > _FPP) {
+		if (read_peak_level (peaks, npeaks, start, cnt, samples_per_visual_peak, samples_per_file_peak) == 0) {
+			return 0;
+		}
+		/* level not available, use the peakfile */
+		samples_per_file_peak = _FPP;
+	}
+
 	expected_peaks = (cnt / (double) samples_per_file_peak);
 	if (g_stat (_peakpath.c_str(), &statbuf) != 0) {
 		error << string_compose (_("Cannot open peakfile @ %1 for size check (%2)"), _peakpath, strerror (errno)) << endmsg;
@@ -734,6 +809,12 @@ AudioSource::build_peaks_from_scratch ()
 		samplecnt_t cnt = _length;
 
 		_peaks_built = false;
+
+		{
+			Glib::Threads::Mutex::Lock lm (_peak_levels_lock);
+			reset_peak_levels (true);
+		}
+
 		boost::scoped_array<Sample> buf(new Sample[bufsize]);
 
 		while (cnt) {
@@ -750,7 +831,7 @@ AudioSource::build_peaks_from_scratch ()
 			lp.release(); // allow butler to refill buffers
 
 			if (_session.deletion_in_progress() || _session.peaks_cleanup_in_progres()) {
-				cerr << "peak file creation interrupted: " << _name << endmsg;
+				cerr << "peak file creation interrupted: " << _name << endl;
 				lp.acquire();
 				done_with_peakfile_writes (false);
 				goto out;
@@ -781,11 +862,218 @@ AudioSource::build_peaks_from_scratch ()
 	if (ret) {
 		DEBUG_TRACE (DEBUG::Peaks, string_compose("Could not write peak data, attempting to remove peakfile %1\n", _peakpath));
 		::g_unlink (_peakpath.c_str());
+		::g_unlink (peak_levels_path ().c_str());
+		Glib::Threads::Mutex::Lock lm (_peak_levels_lock);
+		reset_peak_levels (false);
 	}
 
 	return ret;
 }
 
+/** Prepare for building the peakfile in ranges of @a range_size samples, if
+ *  ::initialize_peakfile() found that it needs to be built while peak
+ *  building was deferred.
+ *  @return number of ranges to build with ::build_peak_range(), 0 if there
+ *  is nothing to do or -1 on error.
+ */
+int
+AudioSource::prepare_peak_ranges (samplecnt_t range_size)
+{
+	Glib::Threads::Mutex::Lock lr (_peak_range_lock);
+
+	if (!_peak_build_pending) {
+		return 0;
+	}
+
+	_peak_build_pending = false;
+
+	if (_session.deletion_in_progress() || _session.peaks_cleanup_in_progres()) {
+		return -1;
+	}
+
+	/* every range must start at a peak boundary */
+	range_size = max ((samplecnt_t) _FPP, range_size - (range_size % _FPP));
+
+	const samplecnt_t npeaks = (_length + _FPP - 1) / _FPP;
+
+	/* create the peakfile at its final size, so that the ranges can be
+	 * written in any order.
+	 */
+
+	ScopedFileDescriptor sfd (g_open (_peakpath.c_str(), O_CREAT|O_RDWR, 0664));
+
+	if (sfd < 0) {
+		error << string_compose(_("AudioSource: cannot open _peakpath (c) \\"%1\\" (%2)"), _peakpath, strerror (errno)) << endmsg;
+		return -1;
+	}
+
+	if (ftruncate (sfd, npeaks * sizeof (PeakData))) {
+		error << string_compose (_("could not truncate peakfile %1 to %2 (error: %3)"), _peakpath, npeaks * sizeof (PeakData), errno) << endmsg;
+		return -1;
+	}
+
+	{
+		Glib::Threads::Mutex::Lock lm (_peaks_ready_lock);
+		_peaks_built = false;
+	}
+
+	{
+		Glib::Threads::Mutex::Lock lm (_peak_levels_lock);
+		reset_peak_levels (false);
+	}
+
+	_peak_range_size = range_size;
+	_peak_ranges_remaining = (_length + range_size - 1) / range_size;
+	_peak_range_samples_done = 0;
+	_peak_range_failed = false;
+
+	DEBUG_TRACE (DEBUG::Peaks, string_compose ("Building peakfile %1 in %2 ranges\\n", _peakpath, _peak_ranges_remaining));
+
+	return _peak_ranges_remaining;
+}
+
+/** Compute and write the peaks of range @a n (see ::prepare_peak_ranges()).
+ *  May be called from several threads at the same time for different ranges.
+ *  When the last range is done, the peakfile is complete and PeaksReady is emitted.
+ */
+int
+AudioSource::build_peak_range (uint32_t n)
+{
+	samplepos_t start;
+	bool ok;
+
+	{
+		Glib::Threads::Mutex::Lock lr (_peak_range_lock);
+		start = n * _peak_range_size;
+		ok = !_peak_range_failed;
+	}
+
+	if (ok) {
+		ok = compute_peak_range (start, min (_peak_range_size, _length - start)) == 0;
+	}
+
+	bool failed;
+
+	{
+		Glib::Threads::Mutex::Lock lr (_peak_range_lock);
+		if (!ok) {
+			_peak_range_failed = true;
+		}
+		if (--_peak_ranges_remaining > 0) {
+			return ok ? 0 : -1;
+		}
+		failed = _peak_range_failed;
+	}
+
+	/* that was the last range */
+
+	if (failed) {
+		DEBUG_TRACE (DEBUG::Peaks, string_compose("Could not write peak data, attempting to remove peakfile %1\\n", _peakpath));
+		::g_unlink (_peakpath.c_str());
+		return -1;
+	}
+
+	const samplecnt_t npeaks = (_length + _FPP - 1) / _FPP;
+
+	_peak_byte_max = npeaks * sizeof (PeakData);
+
+	prepare_peak_levels (true);
+
+	Glib::Threads::Mutex::Lock lm (_peaks_ready_lock);
+	_peaks_built = true;
+	PeaksReady (); /* EMIT SIGNAL */
+
+	return 0;
+}
+
+/** Compute the peaks for @a cnt samples from @a start, which must be at a
+ *  peak boundary, and write them to the peakfile. Uses its own file
+ *  descriptor, so that ranges can be computed concurrently.
+ */
+int
+AudioSource::compute_peak_range (samplepos_t start, samplecnt_t cnt)
+{
+	const samplecnt_t bufsize = 65536; // 256kB per disk read for mono data is about ideal
+	boost::scoped_array<Sample> buf (new Sample[bufsize]);
+	boost::scoped_array<PeakData> peakbuf (new PeakData[bufsize / _FPP]);
+
+	ScopedFileDescriptor sfd (g_open (_peakpath.c_str(), O_RDWR, 0664));
+
+	if (sfd < 0) {
+		error << string_compose(_("AudioSource: cannot open _peakpath (c) \\"%1\\" (%2)"), _peakpath, strerror (errno)) << endmsg;
+		return -1;
+	}
+
+	for (samplecnt_t done = 0; done < cnt; ) {
+
+		if (_session.deletion_in_progress() || _session.peaks_cleanup_in_progres()) {
+			cerr << "peak file creation interrupted: " << _name << endl;
+			return -1;
+		}
+
+		const samplecnt_t to_read = min (bufsize, cnt - done);
+
+		{
+			Glib::Threads::Mutex::Lock lp (_lock);
+			if (read_unlocked (buf.get(), start + done, to_read) != to_read) {
+				error << string_compose(_("%1: could not write read raw data for peak computation (%2)"), _name, strerror (errno)) << endmsg;
+				return -1;
+			}
+		}
+
+		samplecnt_t npeaks = 0;
+
+		for (samplecnt_t i = 0; i < to_read; i += _FPP, ++npeaks) {
+			const samplecnt_t this_time = min ((samplecnt_t) _FPP, to_read - i);
+			peakbuf[npeaks].max = buf[i];
+			peakbuf[npeaks].min = buf[i];
+			if (this_time > 1) {
+				ARDOUR::find_peaks (buf.get() + i + 1, this_time - 1, &peakbuf[npeaks].min, &peakbuf[npeaks].max);
+			}
+		}
+
+		const off_t first_peak_byte = ((start + done) / _FPP) * sizeof (PeakData);
+		const ssize_t bytes_to_write = npeaks * sizeof (PeakData);
+
+		if (lseek (sfd, first_peak_byte, SEEK_SET) != first_peak_byte) {
+			error << string_compose(_("%1: could not seek in peak file data (%2)"), _name, strerror (errno)) << endmsg;
+			return -1;
+		}
+
+		if (::write (sfd, peakbuf.get(), bytes_to_write) != bytes_to_write) {
+			error << string_compose(_("%1: could not write peak file data (%2)"), _name, strerror (errno)) << endmsg;
+			return -1;
+		}
+
+		{
+			Glib::Threads::Mutex::Lock lr (_peak_range_lock);
+			_peak_range_samples_done += to_read;
+		}
+
+		{
+			Glib::Threads::Mutex::Lock lm (_peaks_ready_lock);
+			PeakRangeReady (start + done, to_read); /* EMIT SIGNAL */
+		}
+
+		done += to_read;
+	}
+
+	return 0;
+}
+
+/** @return the fraction of the peakfile built so far by ::build_peak_range() */
+double
+AudioSource::peak_build_progress () const
+{
+	Glib::Threads::Mutex::Lock lr (_peak_range_lock);
+
+	if (_peak_range_size == 0 || _length == 0) {
+		return _peaks_built ? 1.0 : 0.0;
+	}
+
+	return min (1.0, _peak_range_samples_done / (double) _length);
+}
+
 int
 AudioSource::close_peakfile ()
 {
@@ -796,8 +1084,13 @@ AudioSource::close_peakfile ()
 	}
 	if (!_peakpath.empty()) {
 		::g_unlink (_peakpath.c_str());
+		::g_unlink (peak_levels_path ().c_str());
 	}
 	_peaks_built = false;
+	{
+		Glib::Threads::Mutex::Lock lm (_peak_levels_lock);
+		reset_peak_levels (false);
+	}
 	return 0;
 }
 
@@ -831,6 +1124,14 @@ AudioSource::done_with_peakfile_writes (bool done)
 	}
 
 	if (done) {
+		std::vector<PeakLevel> levels;
+		samplecnt_t peakfile_peaks;
+		{
+			Glib::Threads::Mutex::Lock lm (_peak_levels_lock);
+			levels = _peak_levels;
+			peakfile_peaks = _peak_levels_count;
+		}
+		save_peak_levels (levels, peakfile_peaks);
 		Glib::Threads::Mutex::Lock lm (_peaks_ready_lock);
 		_peaks_built = true;
 		PeaksReady (); /* EMIT SIGNAL */
@@ -899,6 +1200,11 @@ AudioSource::compute_and_write_peaks (Sample* buf, samplecnt_t first_sample, sam
 
 			_peak_byte_max = max (_peak_byte_max, (off_t) (byte + sizeof(PeakData)));
 
+			if (fpp == _FPP) {
+				Glib::Threads::Mutex::Lock lm (_peak_levels_lock);
+				add_to_peak_levels (peak_leftover_sample / fpp, &x, 1);
+			}
+
 			{
 				Glib::Threads::Mutex::Lock lm (_peaks_ready_lock);
 				PeakRangeReady (peak_leftover_sample, peak_leftover_cnt); /* EMIT SIGNAL */
@@ -1025,6 +1331,11 @@ AudioSource::compute_and_write_peaks (Sample* buf, samplecnt_t first_sample, sam
 
 	_peak_byte_max = max (_peak_byte_max, (off_t) (first_peak_byte + bytes_to_write));
 
+	if (fpp == _FPP) {
+		Glib::Threads::Mutex::Lock lm (_peak_levels_lock);
+		add_to_peak_levels (first_sample / fpp, peakbuf.get(), peaks_computed);
+	}
+
 	if (samples_done) {
 		Glib::Threads::Mutex::Lock lm (_peaks_ready_lock);
 		PeakRangeReady (first_sample, samples_done); /* EMIT SIGNAL */
@@ -1058,6 +1369,464 @@ AudioSource::truncate_peakfile ()
 	}
 }
 
+string
+AudioSource::peak_levels_path () const
+{
+	return _peakpath + X_(".levels");
+}
+
+/** Forget all coarser peak levels. _peak_levels_lock MUST be held by caller.
+ *  @param known true if there is no peak data yet, false if the levels
+ *  need to be loaded or built before they can be used.
+ */
+void
+AudioSource::reset_peak_levels (bool known) const
+{
+	_peak_levels.clear ();
+	++_peak_levels_generation;
+	_peak_levels_queued = false;
+
+	if (known) {
+		_peak_levels.resize (n_peak_levels);
+		_peak_levels_count = 0;
+	} else {
+		_peak_levels_count = -1;
+	}
+}
+
+/** Merge peakfile peaks into the coarser levels. _peak_levels_lock MUST be
+ *  held by caller.
+ *  @param first_peak Index in the peakfile of the first of @a peaks.
+ */
+void
+AudioSource::add_to_peak_levels (samplecnt_t first_peak, PeakData const * peaks, samplecnt_t cnt) const
+{
+	if (_peak_levels_count < 0) {
+		if (first_peak != 0) {
+			return;
+		}
+		/* (re)writing the peakfile from the start */
+		reset_peak_levels (true);
+	}
+
+	if (first_peak != _peak_levels_count) {
+		/* peaks were rewritten or skipped: build the levels from
+		 * the peakfile when they are needed next.
+		 */
+		DEBUG_TRACE (DEBUG::Peaks, string_compose ("Non-sequential peak write at %1 (have %2), dropping peak levels\n", first_peak, _peak_levels_count));
+		reset_peak_levels (false);
+		return;
+	}
+
+	add_peaks_to_levels (_peak_levels, first_peak, peaks, cnt);
+	_peak_levels_count += cnt;
+}
+
+/** Merge peakfile peaks into @a levels, which hold the first @a first_peak peaks.
+ */
+void
+AudioSource::add_peaks_to_levels (std::vector<PeakLevel>& levels, samplecnt_t first_peak, PeakData const * peaks, samplecnt_t cnt)
+{
+	for (samplecnt_t n = 0; n < cnt; ++n) {
+
+		const samplecnt_t p = first_peak + n;
+		samplecnt_t span = 1;
+
+		for (uint32_t l = 0; l < n_peak_levels; ++l) {
+
+			span *= peak_level_factor;
+			PeakLevel& level (levels[l]);
+
+			if (p % span == 0) {
+				level.push_back (peaks[n]);
+			} else {
+				level.back().max = max (level.back().max, peaks[n].max);
+				level.back().min = min (level.back().min, peaks[n].min);
+			}
+		}
+	}
+}
+
+int
+AudioSource::prepare_peak_levels (bool rebuild)
+{
+	uint32_t generation;
+
+	{
+		Glib::Threads::Mutex::Lock lm (_peak_levels_lock);
+		if (_peak_levels_count >= 0 && !rebuild) {
+			return 0;
+		}
+		generation = _peak_levels_generation;
+	}
+
+	{
+		Glib::Threads::Mutex::Lock lr (_peak_range_lock);
+		if (_peak_build_pending || _peak_ranges_remaining > 0) {
+			/* the peakfile is being built, the last range will do this */
+			return 0;
+		}
+	}
+
+	const samplecnt_t peakfile_peaks = _peak_byte_max / sizeof (PeakData);
+
+	if (peakfile_peaks == 0) {
+		return -1;
+	}
+
+	/* the file I/O and building are done without holding
+	 * _peak_levels_lock, so that readers can use the peakfile meanwhile.
+	 */
+
+	std::vector<PeakLevel> levels;
+	bool built = false;
+
+	if (rebuild || !load_peak_levels (peakfile_peaks, levels)) {
+		/* e.g. a peakfile written by an older version */
+		if (!build_peak_levels (peakfile_peaks, levels)) {
+			return -1;
+		}
+		save_peak_levels (levels, peakfile_peaks);
+		built = true;
+	}
+
+	{
+		Glib::Threads::Mutex::Lock lm (_peak_levels_lock);
+
+		if (_peak_levels_generation == generation) {
+			_peak_levels.swap (levels);
+			_peak_levels_count = peakfile_peaks;
+			return 0;
+		}
+	}
+
+	/* the peak data changed meanwhile */
+
+	DEBUG_TRACE (DEBUG::Peaks, string_compose ("Peak data of %1 changed while preparing its levels\n", _peakpath));
+
+	if (built) {
+		::g_unlink (peak_levels_path ().c_str());
+	}
+
+	return -1;
+}
+
+bool
+AudioSource::load_peak_levels (samplecnt_t peakfile_peaks, std::vector<PeakLevel>& levels) const
+{
+	const string path = peak_levels_path ();
+	GStatBuf level_stat;
+	GStatBuf peak_stat;
+
+	if (g_stat (path.c_str(), &level_stat) != 0 || g_stat (_peakpath.c_str(), &peak_stat) != 0) {
+		return false;
+	}
+
+	if (level_stat.st_mtime < peak_stat.st_mtime) {
+		DEBUG_TRACE (DEBUG::Peaks, string_compose ("Peak levels %1 are older than the peakfile\n", path));
+		return false;
+	}
+
+	ScopedFileDescriptor sfd (g_open (path.c_str(), O_RDONLY, 0444));
+
+	if (sfd < 0) {
+		return false;
+	}
+
+	PeakLevelsHeader header;
+
+	if (::read (sfd, &header, sizeof (header)) != sizeof (header) ||
+	    memcmp (header.magic, peak_levels_magic, sizeof (header.magic)) ||
+	    header.version != peak_levels_version ||
+	    header.samples_per_peak != _FPP ||
+	    header.factor != peak_level_factor ||
+	    header.n_levels != n_peak_levels ||
+	    header.peakfile_peaks != (uint64_t) peakfile_peaks) {
+		DEBUG_TRACE (DEBUG::Peaks, string_compose ("Peak levels %1 do not match the peakfile\n", path));
+		return false;
+	}
+
+	levels.clear ();
+	levels.resize (n_peak_levels);
+
+	samplecnt_t n = peakfile_peaks;
+
+	for (uint32_t l = 0; l < n_peak_levels; ++l) {
+
+		n = (n + peak_level_factor - 1) / peak_level_factor;
+		levels[l].resize (n);
+
+		const ssize_t bytes = n * sizeof (PeakData);
+
+		if (::read (sfd, &levels[l][0], bytes) != bytes) {
+			DEBUG_TRACE (DEBUG::Peaks, string_compose ("Peak levels %1 are truncated\n", path));
+			return false;
+		}
+	}
+
+	DEBUG_TRACE (DEBUG::Peaks, string_compose ("Loaded peak levels %1\n", path));
+
+	return true;
+}
+
+bool
+AudioSource::build_peak_levels (samplecnt_t peakfile_peaks, std::vector<PeakLevel>& levels) const
+{
+	ScopedFileDescriptor sfd (g_open (_peakpath.c_str(), O_RDONLY, 0444));
+
+	if (sfd < 0) {
+		error << string_compose (_("Cannot open peakfile @ %1 for reading (%2)"), _peakpath, strerror (errno)) << endmsg;
+		return false;
+	}
+
+	DEBUG_TRACE (DEBUG::Peaks, string_compose ("Building peak levels from %1\n", _peakpath));
+
+	const samplecnt_t chunksize = 65536;
+	boost::scoped_array<PeakData> staging (new PeakData[chunksize]);
+
+	levels.clear ();
+	levels.resize (n_peak_levels);
+
+	for (samplecnt_t done = 0; done < peakfile_peaks; ) {
+
+		const samplecnt_t n = min (chunksize, peakfile_peaks - done);
+		const ssize_t bytes = n * sizeof (PeakData);
+
+		if (::read (sfd, staging.get(), bytes) != bytes) {
+			error << string_compose (_("%1: could not read peak file data (%2)"), _name, strerror (errno)) << endmsg;
+			return false;
+		}
+
+		add_peaks_to_levels (levels, done, staging.get(), n);
+		done += n;
+	}
+
+	return true;
+}
+
+void
+AudioSource::save_peak_levels (std::vector<PeakLevel> const & levels, samplecnt_t peakfile_peaks) const
+{
+	if (peakfile_peaks <= 0 || _peakpath.empty()) {
+		return;
+	}
+
+	const string path = peak_levels_path ();
+	int fd = g_open (path.c_str(), O_CREAT|O_WRONLY|O_TRUNC, 0664);
+
+	if (fd < 0) {
+		/* not fatal, they will be rebuilt from the peakfile */
+		DEBUG_TRACE (DEBUG::Peaks, string_compose ("Cannot open peak levels %1 for writing (%2)\n", path, strerror (errno)));
+		return;
+	}
+
+	PeakLevelsHeader header;
+
+	memcpy (header.magic, peak_levels_magic, sizeof (header.magic));
+	header.version = peak_levels_version;
+	header.samples_per_peak = _FPP;
+	header.factor = peak_level_factor;
+	header.n_levels = n_peak_levels;
+	header.reserved = 0;
+	header.peakfile_peaks = peakfile_peaks;
+
+	bool ok = ::write (fd, &header, sizeof (header)) == sizeof (header);
+
+	for (uint32_t l = 0; ok && l < n_peak_levels; ++l) {
+		const ssize_t bytes = levels[l].size() * sizeof (PeakData);
+		ok = ::write (fd, &levels[l][0], bytes) == bytes;
+	}
+
+	close (fd);
+
+	if (!ok) {
+		DEBUG_TRACE (DEBUG::Peaks, string_compose ("Could not write peak levels %1 (%2)\n", path, strerror (errno)));
+		::g_unlink (path.c_str());
+	}
+}
+
+/** Compute peaks from one of the coarser levels. _lock MUST be held by caller.
+ *  @param fpp samples per peak of the level to use.
+ *  @return 0 on success, -1 if the level is not available.
+ */
+int
+AudioSource::read_peak_level (PeakData *peaks, samplecnt_t npeaks, samplepos_t start, samplecnt_t cnt,
+                              double samples_per_visual_peak, samplecnt_t fpp) const
+{
+	Glib::Threads::Mutex::Lock lm (_peak_levels_lock);
+
+	uint32_t l = 0;
+	samplecnt_t level_fpp = _FPP * peak_level_factor;
+
+	while (level_fpp < fpp && l + 1 < n_peak_levels) {
+		level_fpp *= peak_level_factor;
+		++l;
+	}
+
+	if (level_fpp != fpp) {
+		return -1;
+	}
+
+	if (_peak_levels_count < 0) {
+		/* have them loaded or built by a peak building thread,
+		 * and use the peakfile until then.
+		 */
+		if (!_peak_levels_queued && _peak_byte_max > 0) {
+			_peak_levels_queued = true;
+			lm.release ();
+			SourceFactory::prepare_peak_levels (boost::const_pointer_cast<AudioSource> (shared_from_this ()));
+		}
+		return -1;
+	}
+
+	PeakLevel const & level (_peak_levels[l]);
+	const samplecnt_t available = level.size();
+
+	DEBUG_TRACE (DEBUG::Peaks, string_compose (" ======>RP: npeaks = %1 start = %2 cnt = %3 samples_per_visual_peak = %4 from level with %5 samples per peak\n",
+	                                           npeaks, start, cnt, samples_per_visual_peak, fpp));
+
+	/* fix for near-end-of-file conditions */
+
+	samplecnt_t read_npeaks = npeaks;
+
+	if (cnt > _length - start) {
+		cnt = _length - start;
+		read_npeaks = min ((samplecnt_t) floor (cnt / samples_per_visual_peak), npeaks);
+	}
+
+	const samplepos_t end = start + cnt;
+
+	for (samplecnt_t n = 0; n < read_npeaks; ++n) {
+
+		/* the stored peaks which overlap this visual peak */
+
+		const samplepos_t first_sample = start + (samplepos_t) floor (n * samples_per_visual_peak);
+		const samplepos_t last_sample = min (end, start + (samplepos_t) floor ((n + 1) * samples_per_visual_peak)) - 1;
+
+		if (n == 0 || n == read_npeaks - 1) {
+			/* don't include level peaks which are only partly
+			 * within the requested range (e.g. a region's start or end).
+			 */
+			bool found = false;
+			if (!merge_level_peaks (l, first_sample, last_sample, peaks[n], found) || !found) {
+				peaks[n].max = 0;
+				peaks[n].min = 0;
+			}
+			continue;
+		}
+
+		const samplecnt_t last = min (last_sample / fpp, available - 1);
+		samplecnt_t i = first_sample / fpp;
+
+		if (i > last) {
+			peaks[n].max = 0;
+			peaks[n].min = 0;
+			continue;
+		}
+
+		PeakData::PeakDatum xmax = level[i].max;
+		PeakData::PeakDatum xmin = level[i].min;
+
+		for (++i; i <= last; ++i) {
+			xmax = max (xmax, level[i].max);
+			xmin = min (xmin, level[i].min);
+		}
+
+		peaks[n].max = xmax;
+		peaks[n].min = xmin;
+	}
+
+	if (read_npeaks < npeaks) {
+		memset (&peaks[read_npeaks], 0, sizeof (PeakData) * (npeaks - read_npeaks));
+	}
+
+	return 0;
+}
+
+/** Merge the peaks of samples @a first to @a last (inclusive) into @a peak,
+ *  setting @a found if there were any. Peaks of level @a l which lie within
+ *  the range are used as they are, for those only partly within it the finer
+ *  levels are used, down to the peakfile (@a l < 0).
+ *  _peak_levels_lock MUST be held by caller.
+ *  @return false if the peakfile could not be read.
+ */
+bool
+AudioSource::merge_level_peaks (int32_t l, samplepos_t first, samplepos_t last, PeakData& peak, bool& found) const
+{
+	if (l < 0) {
+		const samplecnt_t peakfile_peaks = _peak_levels_count;
+		const samplecnt_t i = first / _FPP;
+		const samplecnt_t n = min (last / _FPP, peakfile_peaks - 1) - i + 1;
+
+		if (n <= 0) {
+			return true;
+		}
+
+		/* at most 2 * (peak_level_factor - 1) peaks */
+		PeakData buf[2 * peak_level_factor];
+
+		ScopedFileDescriptor sfd (g_open (_peakpath.c_str(), O_RDONLY, 0444));
+		const off_t first_byte = i * sizeof (PeakData);
+		const ssize_t bytes = n * sizeof (PeakData);
+
+		if (sfd < 0 || lseek (sfd, first_byte, SEEK_SET) != first_byte || ::read (sfd, buf, bytes) != bytes) {
+			return false;
+		}
+
+		for (samplecnt_t p = 0; p < n; ++p) {
+			if (found) {
+				peak.max = max (peak.max, buf[p].max);
+				peak.min = min (peak.min, buf[p].min);
+			} else {
+				peak = buf[p];
+				found = true;
+			}
+		}
+
+		return true;
+	}
+
+	PeakLevel const & level (_peak_levels[l]);
+	samplecnt_t fpp = _FPP;
+
+	for (int32_t n = 0; n <= l; ++n) {
+		fpp *= peak_level_factor;
+	}
+
+	samplecnt_t i = first / fpp;
+	samplecnt_t e = last / fpp;
+
+	if (first % fpp) {
+		/* partial peak at the start */
+		if (!merge_level_peaks (l - 1, first, min (last, (i + 1) * fpp - 1), peak, found)) {
+			return false;
+		}
+		++i;
+	}
+
+	if (e >= i && (last + 1) % fpp) {
+		/* partial peak at the end */
+		if (!merge_level_peaks (l - 1, e * fpp, last, peak, found)) {
+			return false;
+		}
+		--e;
+	}
+
+	e = min (e, (samplecnt_t) level.size() - 1);
+
+	for (; i <= e; ++i) {
+		if (found) {
+			peak.max = max (peak.max, level[i].max);
+			peak.min = min (peak.min, level[i].min);
+		} else {
+			peak = level[i];
+			found = true;
+		}
+	}
+
+	return true;
+}
+
 samplecnt_t
 AudioSource::available_peaks (double zoom_factor) const
 {
@@ -413,33 +413,44 @@ AutomationList::deserialize_events (const XMLNode& node)
 
 	XMLNode* content_node = node.children().front();
 
-	if (content_node->content().empty()) {
+	/* a session state cache holds the events as numbers rather than text */
+	std::vector<double> const & numbers (content_node->numbers());
+
+	if (numbers.empty() && content_node->content().empty()) {
 		return -1;
 	}
 
         ControlList::freeze ();
 	clear ();
 
-	stringstream str (content_node->content());
-
-	std::string x_str;
-	std::string y_str;
-	double x;
-	double y;
 	bool ok = true;
 
-	while (str) {
-		str >> x_str;
-		if (!str || !PBD::string_to<double> (x_str, x)) {
-			break;
+	if (!numbers.empty()) {
+		for (size_t n = 0; n + 1 < numbers.size(); n += 2) {
+			const double y = std::min ((double)_desc.upper, std::max ((double)_desc.lower, numbers[n + 1]));
+			fast_simple_add (numbers[n], y);
 		}
-		str >> y_str;
-		if (!str || !PBD::string_to<double> (y_str, y)) {
-			ok = false;
-			break;
+	} else {
+		stringstream str (content_node->content());
+
+		std::string x_str;
+		std::string y_str;
+		double x;
+		double y;
+
+		while (str) {
+			str >> x_str;
+			if (!str || !PBD::string_to<double> (x_str, x)) {
+				break;
+			}
+			str >> y_str;
+			if (!str || !PBD::string_to<double> (y_str, y)) {
+				ok = false;
+				break;
+			}
+			y = std::min ((double)_desc.upper, std::max ((double)_desc.lower, y));
+			fast_simple_add (x, y);
 		}
-		y = std::min ((double)_desc.upper, std::max ((double)_desc.lower, y));
-		fast_simple_add (x, y);
 	}
 
 	if (!ok) {
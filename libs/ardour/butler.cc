@@ -21,6 +21,10 @@
 #include <fcntl.h>
 #include <unistd.h>
 
+#include <algorithm>
+
+#include <boost/scoped_array.hpp>
+
 #ifndef PLATFORM_WINDOWS
 #include <poll.h>
 #endif
@@ -33,6 +37,7 @@
 #include "ardour/disk_io.h"
 #include "ardour/disk_reader.h"
 #include "ardour/io.h"
+#include "ardour/rc_configuration.h"
 #include "ardour/session.h"
 #include "ardour/track.h"
 #include "ardour/auditioner.h"
@@ -52,8 +57,13 @@ Butler::Butler(Session& s)
 	, midi_dstream_buffer_size(0)
 	, pool_trash(16)
 	, _xthread (true)
+	, _refill_start ("butler refill start", 0)
+	, _refill_done ("butler refill done", 0)
 {
 	g_atomic_int_set(&should_do_transport_work, 0);
+	g_atomic_int_set (&_refill_next, 0);
+	g_atomic_int_set (&_refill_outstanding, 0);
+	g_atomic_int_set (&_refill_quit, 0);
 	SessionEvent::pool->set_trash (&pool_trash);
 
         /* catch future changes to parameters */
@@ -151,7 +161,11 @@ Butler::terminate_thread ()
                 DEBUG_TRACE (DEBUG::Butler, string_compose ("%1: ask butler to quit @ %2\n", DEBUG_THREAD_SELF, g_get_monotonic_time()));
 		queue_request (Request::Quit);
 		pthread_join (thread, &status);
+		have_thread = false;
 	}
+
+	/* the butler thread is gone, so nobody else is touching the workers */
+	stop_refill_workers ();
 }
 
 void *
@@ -168,7 +182,6 @@ Butler::thread_work ()
 	uint32_t err = 0;
 
 	bool disk_work_outstanding = false;
-	RouteList::iterator i;
 
 	while (true) {
 		DEBUG_TRACE (DEBUG::Butler, string_compose ("%1 butler main loop, disk work outstanding ? %2 @ %3\n", DEBUG_THREAD_SELF, disk_work_outstanding, g_get_monotonic_time()));
@@ -231,44 +244,7 @@ Butler::thread_work ()
 
 		DEBUG_TRACE (DEBUG::Butler, string_compose ("butler starts refill loop, twr = %1\n", transport_work_requested()));
 
-		for (i = rl_with_auditioner.begin(); !transport_work_requested() && should_run && i != rl_with_auditioner.end(); ++i) {
-
-			boost::shared_ptr<Track> tr = boost::dynamic_pointer_cast<Track> (*i);
-
-			if (!tr) {
-				continue;
-			}
-
-			boost::shared_ptr<IO> io = tr->input ();
-
-			if (io && !io->active()) {
-				/* don't read inactive tracks */
-				// DEBUG_TRACE (DEBUG::Butler, string_compose ("butler skips inactive track %1\n", tr->name()));
-				continue;
-			}
-			// DEBUG_TRACE (DEBUG::Butler, string_compose ("butler refills %1, playback load = %2\n", tr->name(), tr->playback_buffer_load()));
-			switch (tr->do_refill ()) {
-			case 0:
-				//DEBUG_TRACE (DEBUG::Butler, string_compose ("\ttrack refill done %1\n", tr->name()));
-				break;
-
-			case 1:
-				DEBUG_TRACE (DEBUG::Butler, string_compose ("\ttrack refill unfinished %1\n", tr->name()));
-				disk_work_outstanding = true;
-				break;
-
-			default:
-				error << string_compose(_("Butler read ahead failure on dstream %1"), (*i)->name()) << endmsg;
-                                std::cerr << string_compose(_("Butler read ahead failure on dstream %1"), (*i)->name()) << std::endl;
-				break;
-			}
-
-		}
-
-		if (i != rl_with_auditioner.begin() && i != rl_with_auditioner.end()) {
-			/* we didn't get to all the streams */
-			disk_work_outstanding = true;
-		}
+		disk_work_outstanding = refill_tracks (rl_with_auditioner);
 
 		if (!err && transport_work_requested()) {
 			DEBUG_TRACE (DEBUG::Butler, "transport work requested during refill, back to restart\n");
@@ -292,6 +268,7 @@ Butler::thread_work ()
 
 		if (!disk_work_outstanding) {
 			_session.refresh_disk_space ();
+			_session.update_critical_paths ();
 		}
 
 		{
@@ -314,6 +291,189 @@ Butler::thread_work ()
 	return (0);
 }
 
+/** Refill the playback buffers of all tracks in @a rl.
+ *
+ *  Tracks are handed out emptiest first, so that when the butler cannot keep
+ *  up (or is interrupted by transport work) the tracks closest to an underrun
+ *  have been served. With butler-threads > 1 the work is shared between the
+ *  butler thread and a pool of refill workers, each using their own working
+ *  buffers. Transport work is still only ever done by the butler thread: this
+ *  method does not return before all workers are idle again.
+ *
+ *  @return true if there is disk work outstanding.
+ */
+bool
+Butler::refill_tracks (RouteList const & rl)
+{
+	_refill_jobs.clear ();
+
+	for (RouteList::const_iterator i = rl.begin(); i != rl.end(); ++i) {
+
+		boost::shared_ptr<Track> tr = boost::dynamic_pointer_cast<Track> (*i);
+
+		if (!tr) {
+			continue;
+		}
+
+		boost::shared_ptr<IO> io = tr->input ();
+
+		if (io && !io->active()) {
+			/* don't read inactive tracks */
+			// DEBUG_TRACE (DEBUG::Butler, string_compose ("butler skips inactive track %1\n", tr->name()));
+			continue;
+		}
+
+		/* take a snapshot of the load, it changes while we sort */
+		_refill_jobs.push_back (RefillJob (tr, tr->playback_buffer_load ()));
+	}
+
+	std::stable_sort (_refill_jobs.begin(), _refill_jobs.end(), RefillJobSorter ());
+
+	g_atomic_int_set (&_refill_next, 0);
+	g_atomic_int_set (&_refill_outstanding, 0);
+
+	uint32_t n_workers = std::max ((uint32_t) 1, Config->get_butler_threads ()) - 1;
+	n_workers = std::min (n_workers, (uint32_t) _refill_jobs.size () / 2);
+
+	if (n_workers > _refill_threads.size ()) {
+		start_refill_workers (n_workers);
+	}
+
+	n_workers = std::min (n_workers, (uint32_t) _refill_threads.size ());
+
+	for (uint32_t n = 0; n < n_workers; ++n) {
+		_refill_start.signal ();
+	}
+
+	refill_some (0, 0);
+
+	for (uint32_t n = 0; n < n_workers; ++n) {
+		_refill_done.wait ();
+	}
+
+	const gint done = g_atomic_int_get (&_refill_next);
+
+	if (done > 0 && done < (gint) _refill_jobs.size ()) {
+		/* we didn't get to all the streams */
+		g_atomic_int_set (&_refill_outstanding, 1);
+	}
+
+	/* do not hold on to tracks that may be removed */
+	_refill_jobs.clear ();
+
+	return g_atomic_int_get (&_refill_outstanding);
+}
+
+/** Refill tracks from _refill_jobs until there are none left, or until
+ *  transport work is requested. Called concurrently by the butler thread
+ *  and its refill workers.
+ *
+ *  @param mixdown_buffer working buffer, or 0 to use the butler's own.
+ *  @param gain_buffer working buffer, or 0 to use the butler's own.
+ */
+void
+Butler::refill_some (Sample* mixdown_buffer, gain_t* gain_buffer)
+{
+	while (!transport_work_requested() && should_run) {
+
+		const gint n = g_atomic_int_add (&_refill_next, 1);
+
+		if (n >= (gint) _refill_jobs.size ()) {
+			/* undo, so that _refill_next tells how far we got */
+			g_atomic_int_add (&_refill_next, -1);
+			break;
+		}
+
+		boost::shared_ptr<Track> tr = _refill_jobs[n].track;
+
+		// DEBUG_TRACE (DEBUG::Butler, string_compose ("butler refills %1, playback load = %2\n", tr->name(), tr->playback_buffer_load()));
+		switch (mixdown_buffer ? tr->do_refill (mixdown_buffer, gain_buffer) : tr->do_refill ()) {
+		case 0:
+			//DEBUG_TRACE (DEBUG::Butler, string_compose ("\ttrack refill done %1\n", tr->name()));
+			break;
+
+		case 1:
+			DEBUG_TRACE (DEBUG::Butler, string_compose ("\ttrack refill unfinished %1\n", tr->name()));
+			g_atomic_int_set (&_refill_outstanding, 1);
+			break;
+
+		default:
+			error << string_compose(_("Butler read ahead failure on dstream %1"), tr->name()) << endmsg;
+			std::cerr << string_compose(_("Butler read ahead failure on dstream %1"), tr->name()) << std::endl;
+			break;
+		}
+	}
+}
+
+/** Called from the butler thread to grow the refill worker pool to @a n threads */
+void
+Butler::start_refill_workers (uint32_t n)
+{
+	while (_refill_threads.size () < n) {
+		pthread_t t;
+		const std::string name = string_compose ("disk butler %1", _refill_threads.size () + 1);
+
+		if (pthread_create_and_store (name, &t, _refill_worker, this)) {
+			error << _("Session: could not create butler refill thread") << endmsg;
+			break;
+		}
+
+		DEBUG_TRACE (DEBUG::Butler, string_compose ("started butler refill worker #%1\n", _refill_threads.size () + 1));
+		_refill_threads.push_back (t);
+	}
+}
+
+void
+Butler::stop_refill_workers ()
+{
+	if (_refill_threads.empty ()) {
+		return;
+	}
+
+	g_atomic_int_set (&_refill_quit, 1);
+
+	for (std::vector<pthread_t>::const_iterator i = _refill_threads.begin(); i != _refill_threads.end(); ++i) {
+		_refill_start.signal ();
+	}
+
+	for (std::vector<pthread_t>::const_iterator i = _refill_threads.begin(); i != _refill_threads.end(); ++i) {
+		void* status;
+		pthread_join (*i, &status);
+	}
+
+	_refill_threads.clear ();
+	g_atomic_int_set (&_refill_quit, 0);
+}
+
+void *
+Butler::_refill_worker (void* arg)
+{
+	pthread_set_name (X_("butler refill"));
+	return ((Butler *) arg)->refill_worker ();
+}
+
+void *
+Butler::refill_worker ()
+{
+	/* DiskReader's working buffers belong to the butler thread */
+	boost::scoped_array<Sample> mixdown_buffer (new Sample[DiskReader::working_buffer_samples ()]);
+	boost::scoped_array<gain_t> gain_buffer (new gain_t[DiskReader::working_buffer_samples ()]);
+
+	while (true) {
+		_refill_start.wait ();
+
+		if (g_atomic_int_get (&_refill_quit)) {
+			break;
+		}
+
+		refill_some (mixdown_buffer.get (), gain_buffer.get ());
+
+		_refill_done.signal ();
+	}
+
+	return 0;
+}
+
 bool
 Butler::flush_tracks_to_disk_normal (boost::shared_ptr<RouteList> rl, uint32_t& errors)
 {
@@ -89,13 +89,8 @@ DiskReader::~DiskReader ()
 void
 DiskReader::allocate_working_buffers()
 {
-	/* with varifill buffer refilling, we compute the read size in bytes (to optimize
-	   for disk i/o bandwidth) and then convert back into samples. These buffers
-	   need to reflect the maximum size we could use, which is 4MB reads, or 2M samples
-	   using 16 bit samples.
-	*/
-	_mixdown_buffer       = new Sample[2*1048576];
-	_gain_buffer          = new gain_t[2*1048576];
+	_mixdown_buffer       = new Sample[working_buffer_samples()];
+	_gain_buffer          = new gain_t[working_buffer_samples()];
 }
 
 void
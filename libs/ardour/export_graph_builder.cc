@@ -25,6 +25,7 @@
 #include <glibmm/miscutils.h>
 
 #include "audiographer/process_context.h"
+#include "audiographer/general/async_queue.h"
 #include "audiographer/general/chunker.h"
 #include "audiographer/general/interleaver.h"
 #include "audiographer/general/normalizer.h"
@@ -58,6 +59,7 @@ namespace ARDOUR {
 
 ExportGraphBuilder::ExportGraphBuilder (Session const & session)
 	: session (session)
+	, encode_pool (hardware_concurrency())
 	, thread_pool (hardware_concurrency())
 {
 	process_buffer_samples = session.engine().samples_per_cycle();
@@ -80,6 +82,10 @@ ExportGraphBuilder::process (samplecnt_t samples, bool last_cycle)
 		it->second->process (context);
 	}
 
+	if (last_cycle) {
+		flush_encode_queues ();
+	}
+
 	return 0;
 }
 
@@ -94,7 +100,23 @@ ExportGraphBuilder::post_process ()
 		}
 	}
 
-	return intermediates.empty();
+	if (!intermediates.empty()) {
+		return false;
+	}
+
+	flush_encode_queues ();
+	return true;
+}
+
+void
+ExportGraphBuilder::flush_encode_queues ()
+{
+	/* wait for the encoders to write all data, so that the files are
+	 * complete when the export handler tags or copies them
+	 */
+	for (std::list<AsyncQueuePtr>::iterator it = encode_queues.begin(); it != encode_queues.end(); ++it) {
+		(*it)->flush ();
+	}
 }
 
 unsigned
@@ -111,6 +133,7 @@ void
 ExportGraphBuilder::reset ()
 {
 	timespan.reset();
+	encode_queues.clear ();
 	channel_configs.clear ();
 	channels.clear ();
 	intermediates.clear ();
@@ -127,6 +150,8 @@ ExportGraphBuilder::cleanup (bool remove_out_files/*=false*/)
 		iter->remove_children(remove_out_files);
 		iter = channel_configs.erase(iter);
 	}
+
+	encode_queues.clear ();
 }
 
 void
@@ -327,23 +352,36 @@ ExportGraphBuilder::SFC::SFC (ExportGraphBuilder &parent, FileSpec const & new_c
 		parent.add_analyser (config.filename->get_path (config.format), analyser);
 	}
 
+	/* analysis, sample format conversion and encoding run in the
+	 * encode pool, the export process thread only queues the data
+	 */
+	queue.reset (new AsyncQueue<Sample> (parent.encode_pool, max_samples));
+	parent.add_encode_queue (queue);
+
 	if (data_width == 8 || data_width == 16) {
 		short_converter = ShortConverterPtr (new SampleFormatConverter<short> (channels));
 		short_converter->init (max_samples, config.format->dither_type(), data_width);
 		add_child (config);
 		if (_analyse) { analyser->add_output (short_converter); }
+		else { queue->add_output (short_converter); }
 
 	} else if (data_width == 24 || data_width == 32) {
 		int_converter = IntConverterPtr (new SampleFormatConverter<int> (channels));
 		int_converter->init (max_samples, config.format->dither_type(), data_width);
 		add_child (config);
 		if (_analyse) { analyser->add_output (int_converter); }
+		else { queue->add_output (int_converter); }
 	} else {
 		int actual_data_width = 8 * sizeof(Sample);
 		float_converter = FloatConverterPtr (new SampleFormatConverter<Sample> (channels));
 		float_converter->init (max_samples, config.format->dither_type(), actual_data_width);
 		add_child (config);
 		if (_analyse) { analyser->add_output (float_converter); }
+		else { queue->add_output (float_converter); }
+	}
+
+	if (_analyse) {
+		queue->add_output (chunker);
 	}
 }
 
@@ -358,15 +396,7 @@ ExportGraphBuilder::SFC::set_peak (float gain)
 ExportGraphBuilder::FloatSinkPtr
 ExportGraphBuilder::SFC::sink ()
 {
-	if (_analyse) {
-		return chunker;
-	} else if (data_width == 8 || data_width == 16) {
-		return short_converter;
-	} else if (data_width == 24 || data_width == 32) {
-		return int_converter;
-	} else {
-		return float_converter;
-	}
+	return queue;
 }
 
 void
@@ -394,6 +424,9 @@ ExportGraphBuilder::SFC::add_child (FileSpec const & new_config)
 void
 ExportGraphBuilder::SFC::remove_children (bool remove_out_files)
 {
+	/* do not close the files while data is still being written */
+	queue->wait ();
+
 	boost::ptr_list<Encoder>::iterator iter = children.begin ();
 
 	while (iter != children.end() ) {
@@ -54,6 +54,7 @@ using namespace PBD;
 using namespace Glib;
 
 PBD::Signal2<int,std::string,std::vector<std::string> > FileSource::AmbiguousFileName;
+Glib::Threads::Private<bool> FileSource::_query_ambiguous_files;
 
 FileSource::FileSource (Session& session, DataType type, const string& path, const string& origin, Source::Flag flag)
 	: Source(session, type, path, flag)
@@ -293,7 +294,16 @@ FileSource::find (Session& s, DataType type, const string& path, bool must_exist
 
                 if (de_duped_hits.size() > 1) {
 
-			/* more than one match: ask the user */
+			/* more than one match: ask the user, unless this thread
+			   may not do so, in which case the caller is expected
+			   to try again from one that can.
+			*/
+
+			bool* query = _query_ambiguous_files.get ();
+
+			if (query && !*query) {
+				goto out;
+			}
 
                         int which = FileSource::AmbiguousFileName (path, de_duped_hits).get_value_or (-1);
 
@@ -565,6 +575,12 @@ FileSource::replace_file (const std::string& newpath)
 	_name = Glib::path_get_basename (newpath);
 }
 
+void
+FileSource::set_query_ambiguous_files_in_this_thread (bool yn)
+{
+	_query_ambiguous_files.replace (new bool (yn));
+}
+
 void
 FileSource::inc_use_count ()
 {
@@ -140,6 +140,9 @@ apply_gain_to_buffer_t  ARDOUR::apply_gain_to_buffer = 0;
 mix_buffers_with_gain_t ARDOUR::mix_buffers_with_gain = 0;
 mix_buffers_no_gain_t   ARDOUR::mix_buffers_no_gain = 0;
 copy_vector_t			ARDOUR::copy_vector = 0;
+apply_gain_vector_t     ARDOUR::apply_gain_vector = 0;
+mix_buffers_with_gain_vector_t ARDOUR::mix_buffers_with_gain_vector = 0;
+crossfade_buffers_t     ARDOUR::crossfade_buffers = 0;
 
 PBD::Signal1<void,std::string> ARDOUR::BootMessage;
 PBD::Signal3<void,std::string,std::string,bool> ARDOUR::PluginScanMessage;
@@ -164,6 +167,7 @@ void
 setup_hardware_optimization (bool try_optimization)
 {
 	bool generic_mix_functions = true;
+	bool generic_gain_vector_functions = true;
 
 	if (try_optimization) {
 
@@ -171,6 +175,23 @@ setup_hardware_optimization (bool try_optimization)
 
 #if defined (ARCH_X86) && defined (BUILD_SSE_OPTIMIZATIONS)
 
+#ifdef BUILD_AVX512F_OPTIMIZATIONS
+		if (fpu->has_avx512f()) {
+
+			info << "Using AVX-512 optimized routines" << endmsg;
+
+			// AVX-512 SET
+			compute_peak          = x86_avx512f_compute_peak;
+			find_peaks            = x86_avx512f_find_peaks;
+			apply_gain_to_buffer  = x86_avx512f_apply_gain_to_buffer;
+			mix_buffers_with_gain = x86_avx512f_mix_buffers_with_gain;
+			mix_buffers_no_gain   = x86_avx512f_mix_buffers_no_gain;
+			copy_vector           = x86_avx512f_copy_vector;
+
+			generic_mix_functions = false;
+
+		} else
+#endif
 #ifdef PLATFORM_WINDOWS
 		/* We have AVX-optimized code for Windows */
 
@@ -208,6 +229,52 @@ setup_hardware_optimization (bool try_optimization)
 
 		}
 
+#ifdef BUILD_FMA_OPTIMIZATIONS
+		if (fpu->has_fma() && !fpu->has_avx512f()) {
+			info << "Using FMA optimized routines" << endmsg;
+			mix_buffers_with_gain = x86_fma_mix_buffers_with_gain;
+		}
+#endif
+
+		/* the per-sample gain functions are plain intrinsics and
+		 * can use AVX everywhere.
+		 */
+
+#ifdef BUILD_AVX512F_OPTIMIZATIONS
+		if (fpu->has_avx512f()) {
+			apply_gain_vector            = x86_avx512f_apply_gain_vector;
+			mix_buffers_with_gain_vector = x86_avx512f_mix_buffers_with_gain_vector;
+			crossfade_buffers            = x86_avx512f_crossfade_buffers;
+
+			generic_gain_vector_functions = false;
+
+		} else
+#endif
+#ifdef BUILD_FMA_OPTIMIZATIONS
+		if (fpu->has_fma()) {
+			apply_gain_vector            = x86_sse_avx_apply_gain_vector;
+			mix_buffers_with_gain_vector = x86_fma_mix_buffers_with_gain_vector;
+			crossfade_buffers            = x86_fma_crossfade_buffers;
+
+			generic_gain_vector_functions = false;
+
+		} else
+#endif
+		if (fpu->has_avx()) {
+			apply_gain_vector            = x86_sse_avx_apply_gain_vector;
+			mix_buffers_with_gain_vector = x86_sse_avx_mix_buffers_with_gain_vector;
+			crossfade_buffers            = x86_sse_avx_crossfade_buffers;
+
+			generic_gain_vector_functions = false;
+
+		} else if (fpu->has_sse()) {
+			apply_gain_vector            = x86_sse_apply_gain_vector;
+			mix_buffers_with_gain_vector = x86_sse_mix_buffers_with_gain_vector;
+			crossfade_buffers            = x86_sse_crossfade_buffers;
+
+			generic_gain_vector_functions = false;
+		}
+
 #elif defined (__APPLE__) && defined (BUILD_VECLIB_OPTIMIZATIONS)
 
 		if (floor (kCFCoreFoundationVersionNumber) > kCFCoreFoundationVersionNumber10_4) { /* at least Tiger */
@@ -218,7 +285,12 @@ setup_hardware_optimization (bool try_optimization)
 			mix_buffers_no_gain    = veclib_mix_buffers_no_gain;
 			copy_vector            = default_copy_vector;
 
+			apply_gain_vector            = veclib_apply_gain_vector;
+			mix_buffers_with_gain_vector = veclib_mix_buffers_with_gain_vector;
+			crossfade_buffers            = veclib_crossfade_buffers;
+
 			generic_mix_functions = false;
+			generic_gain_vector_functions = false;
 
 			info << "Apple VecLib H/W specific optimizations in use" << endmsg;
 		}
@@ -241,6 +313,12 @@ setup_hardware_optimization (bool try_optimization)
 		info << "No H/W specific optimizations in use" << endmsg;
 	}
 
+	if (generic_gain_vector_functions) {
+		apply_gain_vector            = default_apply_gain_vector;
+		mix_buffers_with_gain_vector = default_mix_buffers_with_gain_vector;
+		crossfade_buffers            = default_crossfade_buffers;
+	}
+
 	AudioGrapher::Routines::override_compute_peak (compute_peak);
 	AudioGrapher::Routines::override_apply_gain_to_buffer (apply_gain_to_buffer);
 }
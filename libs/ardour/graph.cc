@@ -19,6 +19,8 @@
 */
 #include <stdio.h>
 #include <cmath>
+#include <map>
+#include <set>
 
 #include "pbd/compose.h"
 #include "pbd/debug_rt_alloc.h"
@@ -26,6 +28,8 @@
 
 #include "ardour/debug.h"
 #include "ardour/graph.h"
+#include "ardour/graphnode.h"
+#include "ardour/rc_configuration.h"
 #include "ardour/types.h"
 #include "ardour/session.h"
 #include "ardour/route.h"
@@ -51,14 +55,85 @@ int alloc_allowed ()
 }
 #endif
 
+/** A bounded double-ended queue of nodes that are ready to run.
+ *
+ *  The owning process-thread pushes and pops at the back (most recently
+ *  queued node first, its data is most likely still in cache), idle threads
+ *  steal from the front. Every thread has its own queue and lock, so
+ *  threads only contend when they actually steal work from each other.
+ */
+class Graph::WorkQueue
+{
+public:
+	WorkQueue ()
+		: _head (0)
+		, _tail (0)
+	{
+		pthread_mutex_init (&_lock, NULL);
+	}
+
+	~WorkQueue ()
+	{
+		pthread_mutex_destroy (&_lock);
+	}
+
+	bool empty () const { return _head == _tail; }
+
+	void push (GraphNode* n)
+	{
+		pthread_mutex_lock (&_lock);
+		/* a node can only be queued once per cycle */
+		assert (_tail - _head < queue_size);
+		_nodes[_tail & queue_mask] = n;
+		++_tail;
+		pthread_mutex_unlock (&_lock);
+	}
+
+	GraphNode* pop ()
+	{
+		GraphNode* n = 0;
+		pthread_mutex_lock (&_lock);
+		if (_tail != _head) {
+			--_tail;
+			n = _nodes[_tail & queue_mask];
+		}
+		pthread_mutex_unlock (&_lock);
+		return n;
+	}
+
+	GraphNode* steal ()
+	{
+		GraphNode* n = 0;
+		pthread_mutex_lock (&_lock);
+		if (_tail != _head) {
+			n = _nodes[_head & queue_mask];
+			++_head;
+		}
+		pthread_mutex_unlock (&_lock);
+		return n;
+	}
+
+private:
+	/* same size as the (reserved) shared _trigger_queue */
+	static const guint queue_size = 8192;
+	static const guint queue_mask = queue_size - 1;
+
+	GraphNode*      _nodes[queue_size];
+	volatile guint  _head;
+	volatile guint  _tail;
+	pthread_mutex_t _lock;
+};
+
 Graph::Graph (Session & session)
 	: SessionHandleRef (session)
 	, _threads_active (false)
 	, _execution_sem ("graph_execution", 0)
+	, _work_stealing (false)
 	, _callback_start_sem ("graph_start", 0)
 	, _callback_done_sem ("graph_done", 0)
 {
 	pthread_mutex_init( &_trigger_mutex, NULL);
+	pthread_key_create (&_thread_id_key, NULL);
 
 	/* XXX: rather hacky `fix' to stop _trigger_queue.push_back() allocating
 	 * memory in the RT thread.
@@ -71,6 +146,9 @@ Graph::Graph (Session & session)
 	_pending_chain = 0;
 	_setup_chain   = 1;
 	_graph_empty = true;
+	_critical_path_load[0] = _critical_path_load[1] = 0;
+	_last_critical_path_update = 0;
+	_cycle_duration_us = 0;
 
 
 	ARDOUR::AudioEngine::instance()->Running.connect_same_thread (engine_connections, boost::bind (&Graph::reset_thread_list, this));
@@ -85,6 +163,14 @@ Graph::Graph (Session & session)
 #endif
 }
 
+Graph::~Graph ()
+{
+	for (vector<WorkQueue*>::iterator i = _work_queues.begin(); i != _work_queues.end(); ++i) {
+		delete *i;
+	}
+	pthread_key_delete (_thread_id_key);
+}
+
 void
 Graph::engine_stopped ()
 {
@@ -119,6 +205,15 @@ Graph::reset_thread_list ()
 		drop_threads ();
 	}
 
+	/* one work-queue per thread, the main-thread uses queue 0 */
+	for (vector<WorkQueue*>::iterator i = _work_queues.begin(); i != _work_queues.end(); ++i) {
+		delete *i;
+	}
+	_work_queues.clear ();
+	for (uint32_t i = 0; i < num_threads; ++i) {
+		_work_queues.push_back (new WorkQueue ());
+	}
+
 	_threads_active = true;
 
 	if (AudioEngine::instance()->create_process_thread (boost::bind (&Graph::main_thread, this)) != 0) {
@@ -126,7 +221,7 @@ Graph::reset_thread_list ()
 	}
 
 	for (uint32_t i = 1; i < num_threads; ++i) {
-		if (AudioEngine::instance()->create_process_thread (boost::bind (&Graph::helper_thread, this))) {
+		if (AudioEngine::instance()->create_process_thread (boost::bind (&Graph::helper_thread, this, i))) {
 			throw failed_constructor ();
 		}
 	}
@@ -228,6 +323,9 @@ Graph::prep()
 
 	chain = _current_chain;
 
+	/* the scheduler can only be switched between cycles */
+	_work_stealing = Config->get_graph_work_stealing () && !_work_queues.empty ();
+
 	_graph_empty = true;
 	for (i=_nodes_rt[chain].begin(); i!=_nodes_rt[chain].end(); i++) {
 		(*i)->prep( chain);
@@ -235,11 +333,23 @@ Graph::prep()
 	}
 	_finished_refcount = _init_finished_refcount[chain];
 
-	/* Trigger the initial nodes for processing, which are the ones at the `input' end */
+	/* Trigger the initial nodes for processing, which are the ones at the `input' end.
+	 * The list is sorted by critical path, most expensive first. Nodes are
+	 * taken from the back of the queues, so push them in reverse order.
+	 */
+	node_list_t::reverse_iterator r;
+
+	if (_work_stealing) {
+		for (r=_init_trigger_list[chain].rbegin(); r!=_init_trigger_list[chain].rend(); r++) {
+			trigger (r->get ());
+		}
+		return;
+	}
+
 	pthread_mutex_lock (&_trigger_mutex);
-	for (i=_init_trigger_list[chain].begin(); i!=_init_trigger_list[chain].end(); i++) {
+	for (r=_init_trigger_list[chain].rbegin(); r!=_init_trigger_list[chain].rend(); r++) {
 		/* don't use ::trigger here, as we have already locked the mutex */
-		_trigger_queue.push_back (i->get ());
+		_trigger_queue.push_back (r->get ());
 	}
 	pthread_mutex_unlock (&_trigger_mutex);
 }
@@ -247,11 +357,57 @@ Graph::prep()
 void
 Graph::trigger (GraphNode* n)
 {
+	if (_work_stealing) {
+		/* queue the node with the thread that ran it last time,
+		 * or with the current thread if it has not run yet.
+		 */
+		gint a = g_atomic_int_get (&n->_affinity);
+		if (a < 0 || a >= (gint) _work_queues.size ()) {
+			a = (gint) (intptr_t) pthread_getspecific (_thread_id_key) - 1;
+			if (a < 0) {
+				a = 0;
+			}
+		}
+		_work_queues[a]->push (n);
+		wake_one_sleeper ();
+		return;
+	}
+
 	pthread_mutex_lock (&_trigger_mutex);
 	_trigger_queue.push_back (n);
 	pthread_mutex_unlock (&_trigger_mutex);
 }
 
+/** Wake up one sleeping process-thread, if any, to pick up queued work */
+void
+Graph::wake_one_sleeper ()
+{
+	/* g_atomic_int_get() is a full barrier, so this sees the token of
+	 * a thread that is about to sleep, or that thread sees the node we
+	 * just queued when it checks the queues again (::run_one_stealing).
+	 */
+	if (g_atomic_int_get (&_execution_tokens) <= 0) {
+		/* everybody is busy. Any queued node will be picked up
+		 * by a thread when it is done with its current one.
+		 */
+		return;
+	}
+
+	pthread_mutex_lock (&_trigger_mutex);
+	if (_execution_tokens > 0) {
+		_execution_tokens -= 1;
+		_execution_sem.signal ();
+	}
+	pthread_mutex_unlock (&_trigger_mutex);
+}
+
+void
+Graph::set_thread_id (uint32_t thread_id)
+{
+	/* offset by one, so that unset (NULL) can be told apart from the main-thread */
+	pthread_setspecific (_thread_id_key, (void*) (intptr_t) (thread_id + 1));
+}
+
 /** Called when a node at the `output' end of the chain (ie one that has no-one to feed)
  *  is finished.
  */
@@ -295,6 +451,34 @@ again:
 	// starting with waking up the others.
 }
 
+/** Compute the accumulated DSP load of the most expensive chain of nodes
+ *  starting at @a n, using (and filling) @a loads as cache.
+ */
+float
+Graph::compute_critical_path (GraphNode* n, int chain, std::map<GraphNode*, float>& loads)
+{
+	std::map<GraphNode*, float>::const_iterator l = loads.find (n);
+	if (l != loads.end ()) {
+		return l->second;
+	}
+
+	float longest = 0;
+	for (node_set_t::const_iterator i = n->_activation_set[chain].begin(); i != n->_activation_set[chain].end(); ++i) {
+		longest = std::max (longest, compute_critical_path (i->get (), chain, loads));
+	}
+
+	float const load = n->dsp_load () + longest;
+	loads[n] = load;
+	return load;
+}
+
+/** Sort nodes by critical path, most expensive first */
+struct CriticalPathSorter {
+	bool operator() (node_ptr_t const & a, node_ptr_t const & b) const {
+		return a->critical_path_load () > b->critical_path_load ();
+	}
+};
+
 /** Rechain our stuff using a list of routes (which can be in any order) and
  *  a directed graph of their interconnections, which is guaranteed to be
  *  acyclic.
@@ -364,18 +548,133 @@ Graph::rechain (boost::shared_ptr<RouteList> routelist, GraphEdges const & edges
 		}
 	}
 
+	/* Weight every node by the DSP load it had in previous cycles and
+	 * start with the most expensive chain, so that long chains at the
+	 * end of the graph don't delay the completion of the cycle.
+	 */
+	std::map<GraphNode*, float> loads;
+	_critical_path_load[chain] = 0;
+
+	for (node_list_t::iterator ni = _nodes_rt[chain].begin(); ni != _nodes_rt[chain].end(); ni++) {
+		(*ni)->_critical_path_load = compute_critical_path (ni->get (), chain, loads);
+		_critical_path_load[chain] = std::max (_critical_path_load[chain], (*ni)->_critical_path_load);
+	}
+
+	_init_trigger_list[chain].sort (CriticalPathSorter ());
+
 	_pending_chain = chain;
 	dump(chain);
 }
 
+/** Sort the initial trigger list again using the DSP loads measured since
+ *  the last sort, e.g. after a session was loaded and all loads were 0.
+ *
+ *  Called periodically by the butler, never by a process thread. The
+ *  current chain is copied to the setup chain with the new order and
+ *  swapped in by ::prep() as if it was rechained, if the critical paths
+ *  changed by more than a tenth of the longest one and the order of the
+ *  initial nodes changes.
+ */
+void
+Graph::update_critical_paths ()
+{
+	int64_t const now = g_get_monotonic_time ();
+
+	if (now - _last_critical_path_update < 1000000) {
+		return;
+	}
+
+	/* don't wait for a rechain */
+	Glib::Threads::Mutex::Lock ls (_swap_mutex, Glib::Threads::TRY_LOCK);
+	if (!ls.locked ()) {
+		return;
+	}
+
+	_last_critical_path_update = now;
+
+	/* while we hold the swap mutex the current chain does not change */
+	int const chain = _current_chain;
+	int const setup = _setup_chain;
+
+	if (_pending_chain != chain || setup == chain) {
+		/* a chain swap is pending */
+		return;
+	}
+
+	/* only replace a setup chain whose nodes are all still in use, so
+	 * that we never drop the last reference to a route here.
+	 */
+	std::set<GraphNode*> current;
+	for (node_list_t::const_iterator ni = _nodes_rt[chain].begin(); ni != _nodes_rt[chain].end(); ++ni) {
+		current.insert (ni->get ());
+	}
+	for (node_list_t::const_iterator ni = _nodes_rt[setup].begin(); ni != _nodes_rt[setup].end(); ++ni) {
+		if (current.find (ni->get ()) == current.end ()) {
+			return;
+		}
+	}
+
+	std::map<GraphNode*, float> loads;
+	float longest = 0;
+
+	for (node_list_t::iterator ni = _nodes_rt[chain].begin(); ni != _nodes_rt[chain].end(); ni++) {
+		longest = std::max (longest, compute_critical_path (ni->get (), chain, loads));
+	}
+
+	/* ignore noise, and small changes of the loads */
+	float const threshold = std::max (0.01f, 0.1f * std::max (longest, _critical_path_load[chain]));
+	bool changed = false;
+
+	for (node_list_t::iterator ni = _nodes_rt[chain].begin(); ni != _nodes_rt[chain].end(); ni++) {
+		if (fabsf (loads[ni->get ()] - (*ni)->_critical_path_load) > threshold) {
+			changed = true;
+			break;
+		}
+	}
+
+	if (!changed) {
+		return;
+	}
+
+	for (node_list_t::iterator ni = _nodes_rt[chain].begin(); ni != _nodes_rt[chain].end(); ni++) {
+		(*ni)->_critical_path_load = loads[ni->get ()];
+	}
+	_critical_path_load[chain] = longest;
+
+	node_list_t sorted (_init_trigger_list[chain]);
+	sorted.sort (CriticalPathSorter ());
+
+	if (sorted == _init_trigger_list[chain]) {
+		return;
+	}
+
+	DEBUG_TRACE (DEBUG::Graph, string_compose ("critical paths changed, re-sorting chain %1 as %2\n", chain, setup));
+
+	for (node_list_t::iterator ni = _nodes_rt[chain].begin(); ni != _nodes_rt[chain].end(); ni++) {
+		(*ni)->_activation_set[setup] = (*ni)->_activation_set[chain];
+		(*ni)->_init_refcount[setup] = (*ni)->_init_refcount[chain];
+	}
+
+	_nodes_rt[setup] = _nodes_rt[chain];
+	_init_trigger_list[setup] = sorted;
+	_init_finished_refcount[setup] = _init_finished_refcount[chain];
+	_critical_path_load[setup] = longest;
+
+	_pending_chain = setup;
+}
+
 /** Called by both the main thread and all helpers.
  *  @return true to quit, false to carry on.
  */
 bool
-Graph::run_one()
+Graph::run_one (uint32_t thread_id)
 {
 	GraphNode* to_run;
 
+	if (_work_stealing) {
+		return run_one_stealing (thread_id);
+	}
+
 	pthread_mutex_lock (&_trigger_mutex);
 	if (_trigger_queue.size()) {
 		to_run = _trigger_queue.back();
@@ -408,6 +707,10 @@ Graph::run_one()
 		if (!_threads_active) {
 			return true;
 		}
+		if (_work_stealing) {
+			/* the scheduler was switched while we were asleep */
+			return false;
+		}
 		DEBUG_TRACE (DEBUG::ProcessThreads, string_compose ("%1 is awake\n", pthread_name()));
 		pthread_mutex_lock (&_trigger_mutex);
 		if (_trigger_queue.size()) {
@@ -417,7 +720,7 @@ Graph::run_one()
 	}
 	pthread_mutex_unlock (&_trigger_mutex);
 
-	to_run->process();
+	process_node (to_run);
 	to_run->finish (_current_chain);
 
 	DEBUG_TRACE(DEBUG::ProcessThreads, string_compose ("%1 has finished run_one()\n", pthread_name()));
@@ -425,17 +728,121 @@ Graph::run_one()
 	return !_threads_active;
 }
 
+/** Take a node from the queue of another thread, starting with
+ *  the thread next to us.
+ */
+GraphNode*
+Graph::steal_work (uint32_t thread_id)
+{
+	uint32_t const n_queues = _work_queues.size ();
+
+	for (uint32_t i = 1; i < n_queues; ++i) {
+		WorkQueue* q = _work_queues[(thread_id + i) % n_queues];
+		if (q->empty ()) {
+			/* unlocked peek, don't bother idle threads */
+			continue;
+		}
+		GraphNode* n = q->steal ();
+		if (n) {
+			DEBUG_TRACE(DEBUG::ProcessThreads, string_compose ("%1 steals from thread %2\n", pthread_name(), (thread_id + i) % n_queues));
+			return n;
+		}
+	}
+	return 0;
+}
+
+/** Work-stealing variant of ::run_one(). Nodes are taken from the
+ *  thread's own queue first, then stolen from the other threads.
+ *  @return true to quit, false to carry on.
+ */
+bool
+Graph::run_one_stealing (uint32_t thread_id)
+{
+	assert (thread_id < _work_queues.size ());
+	WorkQueue* q = _work_queues[thread_id];
+
+	GraphNode* to_run = q->pop ();
+
+	if (!to_run) {
+		to_run = steal_work (thread_id);
+	}
+
+	while (to_run == 0) {
+		/* no work anywhere. Announce that we are going to sleep, then
+		 * look again: a node queued before the token was visible did
+		 * not wake anyone, a node queued after it wakes us up.
+		 */
+		pthread_mutex_lock (&_trigger_mutex);
+		g_atomic_int_inc (&_execution_tokens);
+
+		to_run = q->pop ();
+		if (!to_run) {
+			to_run = steal_work (thread_id);
+		}
+		if (to_run) {
+			/* nobody can have taken our token while we hold the lock */
+			g_atomic_int_add (&_execution_tokens, -1);
+			pthread_mutex_unlock (&_trigger_mutex);
+			break;
+		}
+		pthread_mutex_unlock (&_trigger_mutex);
+
+		DEBUG_TRACE (DEBUG::ProcessThreads, string_compose ("%1 goes to sleep\n", pthread_name()));
+		_execution_sem.wait ();
+		if (!_threads_active) {
+			return true;
+		}
+		if (!_work_stealing) {
+			/* the scheduler was switched while we were asleep */
+			return false;
+		}
+		DEBUG_TRACE (DEBUG::ProcessThreads, string_compose ("%1 is awake\n", pthread_name()));
+
+		to_run = q->pop ();
+		if (!to_run) {
+			to_run = steal_work (thread_id);
+		}
+	}
+
+	g_atomic_int_set (&to_run->_affinity, (gint) thread_id);
+
+	process_node (to_run);
+	to_run->finish (_current_chain);
+
+	DEBUG_TRACE(DEBUG::ProcessThreads, string_compose ("%1 has finished run_one_stealing()\n", pthread_name()));
+
+	return !_threads_active;
+}
+
+/** Run a node, and measure its DSP load */
+void
+Graph::process_node (GraphNode* n)
+{
+	int64_t const start = g_get_monotonic_time ();
+
+	n->process ();
+
+	if (_cycle_duration_us > 0) {
+		if (n->_dsp_load.get_max_time_us () != _cycle_duration_us) {
+			n->_dsp_load.set_max_time_us (_cycle_duration_us);
+		}
+		n->_dsp_load.set_start_timestamp_us (start);
+		n->_dsp_load.set_stop_timestamp_us (g_get_monotonic_time ());
+	}
+}
+
 void
-Graph::helper_thread()
+Graph::helper_thread (uint32_t thread_id)
 {
 	suspend_rt_malloc_checks ();
 	ProcessThread* pt = new ProcessThread ();
 	resume_rt_malloc_checks ();
 
 	pt->get_buffers();
+	set_thread_id (thread_id);
 
 	while(1) {
-		if (run_one()) {
+		if (run_one (thread_id)) {
 			break;
 		}
 	}
@@ -453,6 +860,7 @@ Graph::main_thread()
 	resume_rt_malloc_checks ();
 
 	pt->get_buffers();
+	set_thread_id (0);
 
 again:
 	_callback_start_sem.wait ();
@@ -476,7 +884,7 @@ again:
 	/* This loop will run forever */
 	while (1) {
 		DEBUG_TRACE(DEBUG::ProcessThreads, string_compose ("main thread (%1) runs one graph node\n", pthread_name ()));
-		if (run_one()) {
+		if (run_one (0)) {
 			break;
 		}
 	}
@@ -497,7 +905,8 @@ Graph::dump (int chain)
 	DEBUG_TRACE (DEBUG::Graph, "--------------------------------------------Graph dump:\n");
 	for (ni=_nodes_rt[chain].begin(); ni!=_nodes_rt[chain].end(); ni++) {
 		boost::shared_ptr<Route> rp = boost::dynamic_pointer_cast<Route>( *ni);
-		DEBUG_TRACE (DEBUG::Graph, string_compose ("GraphNode: %1  refcount: %2\n", rp->name().c_str(), (*ni)->_init_refcount[chain]));
+		DEBUG_TRACE (DEBUG::Graph, string_compose ("GraphNode: %1  refcount: %2  dsp-load: %3  critical-path: %4\n",
+		                                           rp->name().c_str(), (*ni)->_init_refcount[chain], (*ni)->dsp_load (), (*ni)->critical_path_load ()));
 		for (ai=(*ni)->_activation_set[chain].begin(); ai!=(*ni)->_activation_set[chain].end(); ai++) {
 			DEBUG_TRACE (DEBUG::Graph, string_compose ("  triggers: %1\n", boost::dynamic_pointer_cast<Route>(*ai)->name().c_str()));
 		}
@@ -505,10 +914,12 @@ Graph::dump (int chain)
 
 	DEBUG_TRACE (DEBUG::Graph, "------------- trigger list:\n");
 	for (ni=_init_trigger_list[chain].begin(); ni!=_init_trigger_list[chain].end(); ni++) {
-		DEBUG_TRACE (DEBUG::Graph, string_compose ("GraphNode: %1  refcount: %2\n", boost::dynamic_pointer_cast<Route>(*ni)->name().c_str(), (*ni)->_init_refcount[chain]));
+		DEBUG_TRACE (DEBUG::Graph, string_compose ("GraphNode: %1  refcount: %2  critical-path: %3\n",
+		                                           boost::dynamic_pointer_cast<Route>(*ni)->name().c_str(), (*ni)->_init_refcount[chain], (*ni)->critical_path_load ()));
 	}
 
 	DEBUG_TRACE (DEBUG::Graph, string_compose ("final activation refcount: %1\n", _init_finished_refcount[chain]));
+	DEBUG_TRACE (DEBUG::Graph, string_compose ("critical path load: %1\n", _critical_path_load[chain]));
 #endif
 }
 
@@ -520,6 +931,7 @@ Graph::process_routes (pframes_t nframes, samplepos_t start_sample, samplepos_t
 	if (!_threads_active) return 0;
 
 	_process_nframes = nframes;
+	_cycle_duration_us = (int64_t) (nframes * 1e6 / AudioEngine::instance()->sample_rate ());
 	_process_start_sample = start_sample;
 	_process_end_sample = end_sample;
 	_process_declick = declick;
@@ -547,6 +959,7 @@ Graph::routes_no_roll (pframes_t nframes, samplepos_t start_sample, samplepos_t
 	if (!_threads_active) return 0;
 
 	_process_nframes = nframes;
+	_cycle_duration_us = (int64_t) (nframes * 1e6 / AudioEngine::instance()->sample_rate ());
 	_process_start_sample = start_sample;
 	_process_end_sample = end_sample;
 	_process_declick = declick;
@@ -26,6 +26,8 @@ using namespace ARDOUR;
 
 GraphNode::GraphNode (boost::shared_ptr<Graph> graph)
 	: _graph(graph)
+	, _affinity (-1)
+	, _critical_path_load (0)
 {
 }
 
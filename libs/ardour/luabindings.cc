@@ -21,6 +21,7 @@
 #include "timecode/bbt_time.h"
 #include "pbd/stateful_diff_command.h"
 #include "pbd/openuri.h"
+#include "pbd/timing.h"
 #include "evoral/Control.hpp"
 #include "evoral/ControlList.hpp"
 #include "evoral/Range.hpp"
@@ -371,6 +372,16 @@ LuaBindings::common (lua_State* L)
 
 		.beginStdVector <PBD::ID> ("IdVector").endClass ()
 
+		.beginClass <PBD::TimingStats> ("TimingStats")
+		.addRefFunction ("get_stats", &PBD::TimingStats::get_stats)
+		.addFunction ("percentile", &PBD::TimingStats::percentile)
+		.addFunction ("min", &PBD::TimingStats::min)
+		.addFunction ("max", &PBD::TimingStats::max)
+		.addFunction ("avg", &PBD::TimingStats::avg)
+		.addFunction ("count", &PBD::TimingStats::count)
+		.addFunction ("reset", &PBD::TimingStats::reset)
+		.endClass ()
+
 		.beginClass <XMLNode> ("XMLNode")
 		.addFunction ("name", &XMLNode::name)
 		.endClass ()
@@ -1032,6 +1043,9 @@ LuaBindings::common (lua_State* L)
 		.addFunction ("comment", &Route::comment)
 		.addFunction ("active", &Route::active)
 		.addFunction ("set_active", &Route::set_active)
+		.addFunction ("dsp_load", &Route::dsp_load)
+		.addFunction ("critical_path_load", &Route::critical_path_load)
+		.addFunction ("timing_stats", &Route::timing_stats)
 		.addFunction ("nth_plugin", &Route::nth_plugin)
 		.addFunction ("nth_processor", &Route::nth_processor)
 		.addFunction ("nth_send", &Route::nth_send)
@@ -1327,6 +1341,7 @@ LuaBindings::common (lua_State* L)
 		.addFunction ("deactivate", &Processor::deactivate)
 		.addFunction ("output_streams", &PluginInsert::output_streams)
 		.addFunction ("input_streams", &PluginInsert::input_streams)
+		.addFunction ("timing_stats", &Processor::timing_stats)
 		.endClass ()
 
 		.deriveWSPtrClass <IOProcessor, Processor> ("IOProcessor")
@@ -2130,6 +2145,7 @@ LuaBindings::common (lua_State* L)
 		.addFunction ("remove_monitor_section", &Session::remove_monitor_section)
 
 		.addFunction ("get_routes", &Session::get_routes)
+		.addFunction ("critical_path_load", &Session::critical_path_load)
 		.addFunction ("get_tracks", &Session::get_tracks)
 		.addFunction ("get_stripables", (StripableList (Session::*)() const)&Session::get_stripables)
 		.addFunction ("name", &Session::name)
@@ -0,0 +1,450 @@
+/*
+    Copyright (C) 2018 Paul Davis
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+*/
+
+#include <cassert>
+#include <cstring>
+#include <algorithm>
+
+#include <sys/stat.h>
+#include <fcntl.h>
+
+#ifndef PLATFORM_WINDOWS
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+
+#include "pbd/compose.h"
+
+#include "ardour/debug.h"
+#include "ardour/mapped_audio_file.h"
+
+using namespace ARDOUR;
+
+/* number of samples (per channel) that we ask the kernel to read ahead */
+static const samplecnt_t readahead_samples = 262144;
+
+#ifndef PLATFORM_WINDOWS
+
+static bool
+host_is_little_endian ()
+{
+	uint16_t const x = 1;
+	return *((uint8_t const*) &x) == 1;
+}
+
+static uint16_t
+read_le16 (uint8_t const* b)
+{
+	return b[0] | (b[1] << 8);
+}
+
+static uint32_t
+read_le32 (uint8_t const* b)
+{
+	return b[0] | (b[1] << 8) | (b[2] << 16) | ((uint32_t) b[3] << 24);
+}
+
+static uint64_t
+read_le64 (uint8_t const* b)
+{
+	return read_le32 (b) | ((uint64_t) read_le32 (b + 4) << 32);
+}
+
+static uint32_t
+read_be32 (uint8_t const* b)
+{
+	return ((uint32_t) b[0] << 24) | (b[1] << 16) | (b[2] << 8) | b[3];
+}
+
+static uint64_t
+read_be64 (uint8_t const* b)
+{
+	return ((uint64_t) read_be32 (b) << 32) | read_be32 (b + 4);
+}
+
+static bool
+read_at (int fd, int64_t pos, uint8_t* buf, size_t len)
+{
+	return ::pread (fd, buf, len, pos) == (ssize_t) len;
+}
+
+#endif
+
+MappedAudioFile::MappedAudioFile ()
+	: _fd (-1)
+	, _map (0)
+	, _map_length (0)
+	, _file_size (0)
+	, _data_offset (0)
+	, _data (0)
+	, _channels (0)
+	, _frames (0)
+	, _last_read (0)
+	, _advised_start (0)
+	, _advised_end (0)
+{
+}
+
+MappedAudioFile::~MappedAudioFile ()
+{
+	close ();
+}
+
+int
+MappedAudioFile::open (std::string const & path, uint32_t channels, samplecnt_t frames)
+{
+	close ();
+
+#ifdef PLATFORM_WINDOWS
+	return -1;
+#else
+	/* 32 bit address space is too small to map long sessions */
+	if (sizeof (void*) < 8 || !host_is_little_endian () || channels == 0) {
+		return -1;
+	}
+
+	int fd = ::open (path.c_str(), O_RDONLY);
+	if (fd < 0) {
+		return -1;
+	}
+
+	struct stat st;
+	if (fstat (fd, &st) != 0) {
+		::close (fd);
+		return -1;
+	}
+
+	int64_t offset = 0;
+	int64_t length = 0;
+	uint32_t file_channels = 0;
+
+	if (find_wav_data (fd, st.st_size, offset, length, file_channels) && find_caf_data (fd, st.st_size, offset, length, file_channels)) {
+		::close (fd);
+		return -1;
+	}
+
+	/* the data must match what libsndfile told the caller */
+	if (file_channels != channels
+	    || offset % sizeof (float) != 0
+	    || offset + length > st.st_size
+	    || length < (int64_t) (frames * channels * sizeof (float))) {
+		DEBUG_TRACE (DEBUG::AudioPlayback, string_compose ("cannot map %1: unexpected data layout\n", path));
+		::close (fd);
+		return -1;
+	}
+
+	void* addr = mmap (0, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+
+	if (addr == MAP_FAILED) {
+		::close (fd);
+		return -1;
+	}
+
+	/* keep the file open to check its size again later */
+	_fd = fd;
+	_map = addr;
+	_map_length = st.st_size;
+	_file_size = st.st_size;
+	_data_offset = offset;
+	_data = (float const*) ((uint8_t const*) addr + offset);
+	_channels = channels;
+	_frames = frames;
+	_last_read = 0;
+	_advised_start = _advised_end = 0;
+
+	DEBUG_TRACE (DEBUG::AudioPlayback, string_compose ("mapped %1 (%2 chn, %3 samples)\n", path, channels, frames));
+
+	return 0;
+#endif
+}
+
+void
+MappedAudioFile::close ()
+{
+#ifndef PLATFORM_WINDOWS
+	if (_map) {
+		munmap (_map, _map_length);
+	}
+	if (_fd >= 0) {
+		::close (_fd);
+	}
+#endif
+	_fd = -1;
+	_map = 0;
+	_map_length = 0;
+	_file_size = 0;
+	_data = 0;
+}
+
+void
+MappedAudioFile::update_size ()
+{
+#ifndef PLATFORM_WINDOWS
+	struct stat st;
+	if (_fd < 0 || fstat (_fd, &st) != 0) {
+		_file_size = 0;
+		return;
+	}
+	_file_size = st.st_size;
+#endif
+}
+
+/** @return true if the file (still) holds the samples before @a end */
+bool
+MappedAudioFile::size_covers (samplepos_t end)
+{
+	int64_t const needed = _data_offset + (int64_t) (end * _channels * sizeof (float));
+
+	if (needed <= _file_size) {
+		return true;
+	}
+
+	update_size ();
+	return needed <= _file_size;
+}
+
+/** Locate float samples in a RIFF/WAVE or RF64 file.
+ *  @return 0 on success
+ */
+int
+MappedAudioFile::find_wav_data (int fd, int64_t file_size, int64_t& offset, int64_t& length, uint32_t& channels)
+{
+#ifdef PLATFORM_WINDOWS
+	return -1;
+#else
+	uint8_t hdr[12];
+
+	if (!read_at (fd, 0, hdr, sizeof (hdr))) {
+		return -1;
+	}
+
+	bool const rf64 = !memcmp (hdr, "RF64", 4);
+
+	if ((memcmp (hdr, "RIFF", 4) && !rf64) || memcmp (hdr + 8, "WAVE", 4)) {
+		return -1;
+	}
+
+	int64_t rf64_data_size = -1;
+	bool is_float = false;
+	int64_t pos = 12;
+
+	channels = 0;
+
+	while (pos + 8 <= file_size) {
+		uint8_t chunk[8];
+		if (!read_at (fd, pos, chunk, sizeof (chunk))) {
+			return -1;
+		}
+
+		int64_t size = read_le32 (chunk + 4);
+
+		if (!memcmp (chunk, "ds64", 4)) {
+			uint8_t ds64[24];
+			if (size < 24 || !read_at (fd, pos + 8, ds64, sizeof (ds64))) {
+				return -1;
+			}
+			rf64_data_size = read_le64 (ds64 + 8);
+
+		} else if (!memcmp (chunk, "fmt ", 4)) {
+			uint8_t fmt[40];
+			if (size < 16 || !read_at (fd, pos + 8, fmt, std::min ((int64_t) sizeof (fmt), size))) {
+				return -1;
+			}
+			uint16_t tag = read_le16 (fmt);
+			if (tag == 0xfffe && size >= 40) {
+				/* WAVE_FORMAT_EXTENSIBLE, the format is the start of the sub-format GUID */
+				tag = read_le16 (fmt + 24);
+			}
+			channels = read_le16 (fmt + 2);
+			is_float = (tag == 3 /* WAVE_FORMAT_IEEE_FLOAT */) && read_le16 (fmt + 14) == 32;
+
+		} else if (!memcmp (chunk, "data", 4)) {
+			if (rf64 && size == 0xffffffff) {
+				size = rf64_data_size;
+			}
+			if (!is_float || channels == 0 || size < 0) {
+				return -1;
+			}
+			offset = pos + 8;
+			length = size;
+			return 0;
+		}
+
+		/* chunks are padded to an even size */
+		pos += 8 + size + (size & 1);
+	}
+
+	return -1;
+#endif
+}
+
+/** Locate float samples in a CoreAudio Format file.
+ *  @return 0 on success
+ */
+int
+MappedAudioFile::find_caf_data (int fd, int64_t file_size, int64_t& offset, int64_t& length, uint32_t& channels)
+{
+#ifdef PLATFORM_WINDOWS
+	return -1;
+#else
+	uint8_t hdr[8];
+
+	if (!read_at (fd, 0, hdr, sizeof (hdr)) || memcmp (hdr, "caff", 4)) {
+		return -1;
+	}
+
+	bool is_float = false;
+	int64_t pos = 8;
+
+	channels = 0;
+
+	while (pos + 12 <= file_size) {
+		uint8_t chunk[12];
+		if (!read_at (fd, pos, chunk, sizeof (chunk))) {
+			return -1;
+		}
+
+		int64_t size = (int64_t) read_be64 (chunk + 4);
+
+		if (!memcmp (chunk, "desc", 4)) {
+			uint8_t desc[32];
+			if (size < 32 || !read_at (fd, pos + 12, desc, sizeof (desc))) {
+				return -1;
+			}
+			uint32_t const flags = read_be32 (desc + 12);
+			channels = read_be32 (desc + 24);
+			is_float = !memcmp (desc + 8, "lpcm", 4)
+				&& (flags & 0x1) /* kCAFLinearPCMFormatFlagIsFloat */
+				&& (flags & 0x2) /* kCAFLinearPCMFormatFlagIsLittleEndian */
+				&& read_be32 (desc + 28) == 32;
+
+		} else if (!memcmp (chunk, "data", 4)) {
+			if (!is_float || channels == 0) {
+				return -1;
+			}
+			/* the data starts with a 32 bit edit count */
+			offset = pos + 12 + 4;
+			/* a size of -1 means: until the end of the file */
+			length = (size < 0) ? file_size - offset : size - 4;
+			return 0;
+		}
+
+		if (size < 0) {
+			return -1;
+		}
+		pos += 12 + size;
+	}
+
+	return -1;
+#endif
+}
+
+/** Ask the kernel to read ahead of @a start in the direction in which
+ *  we are currently reading (playback may be reverse or varispeed).
+ */
+void
+MappedAudioFile::advise (samplepos_t start, samplecnt_t cnt)
+{
+#ifndef PLATFORM_WINDOWS
+	bool const forward = start >= _last_read;
+	_last_read = start;
+
+	samplepos_t from;
+	samplepos_t to;
+
+	if (forward) {
+		if (start >= _advised_start && start + cnt + readahead_samples / 2 <= _advised_end) {
+			return;
+		}
+		from = start;
+		to = std::min (_frames, start + cnt + readahead_samples);
+	} else {
+		if (start >= _advised_start + readahead_samples / 2 && start + cnt <= _advised_end) {
+			return;
+		}
+		from = std::max ((samplepos_t) 0, start - readahead_samples);
+		to = std::min (_frames, start + cnt);
+	}
+
+	if (to <= from) {
+		return;
+	}
+
+	_advised_start = from;
+	_advised_end = to;
+
+	/* we make a system call here anyway, so this is a cheap point to
+	 * notice that someone else truncated the file.
+	 */
+	update_size ();
+
+	/* madvise needs a page-aligned address */
+	static const uintptr_t page_mask = ~((uintptr_t) sysconf (_SC_PAGESIZE) - 1);
+	uintptr_t const begin = (uintptr_t) (_data + from * _channels);
+	uintptr_t const aligned = begin & page_mask;
+	size_t const len = (to - from) * _channels * sizeof (float) + (begin - aligned);
+
+	posix_madvise ((void*) aligned, len, POSIX_MADV_WILLNEED);
+#endif
+}
+
+samplecnt_t
+MappedAudioFile::read (Sample* dst, samplepos_t start, samplecnt_t cnt, uint32_t channel, gain_t gain)
+{
+	assert (_data);
+	assert (channel < _channels);
+	assert (start >= 0 && start + cnt <= _frames);
+
+	advise (start, cnt);
+
+	/* pages beyond the end of the file raise SIGBUS when touched */
+	if (!size_covers (start + cnt)) {
+		DEBUG_TRACE (DEBUG::AudioPlayback, "mapped file was truncated, not reading from the mapping\n");
+		return -1;
+	}
+
+	float const* src = _data + start * _channels + channel;
+
+	if (_channels == 1) {
+		if (gain == 1.f) {
+			memcpy (dst, src, sizeof (Sample) * cnt);
+		} else {
+			for (samplecnt_t n = 0; n < cnt; ++n) {
+				dst[n] = src[n] * gain;
+			}
+		}
+		return cnt;
+	}
+
+	/* stride through the interleaved data */
+
+	if (gain == 1.f) {
+		for (samplecnt_t n = 0; n < cnt; ++n) {
+			dst[n] = *src;
+			src += _channels;
+		}
+	} else {
+		for (samplecnt_t n = 0; n < cnt; ++n) {
+			dst[n] = *src * gain;
+			src += _channels;
+		}
+	}
+
+	return cnt;
+}
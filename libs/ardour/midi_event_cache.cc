@@ -0,0 +1,171 @@
+/*
+    Copyright (C) 2017 Paul Davis
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+#include <algorithm>
+#include <cstring>
+
+#include "pbd/compose.h"
+
+#include "evoral/midi_events.h"
+
+#include "ardour/debug.h"
+#include "ardour/midi_channel_filter.h"
+#include "ardour/midi_cursor.h"
+#include "ardour/midi_event_cache.h"
+#include "ardour/midi_model.h"
+#include "ardour/midi_state_tracker.h"
+#include "ardour/tempo.h"
+
+using namespace ARDOUR;
+using namespace PBD;
+
+namespace {
+
+struct EventTimeCompare {
+	template<typename E>
+	bool operator() (E const & e, samplepos_t t) const { return e.time < t; }
+};
+
+}
+
+MidiEventCache::MidiEventCache ()
+	: _start_qn (0.0)
+	, _mode (Sustained)
+	, _generation (0)
+	, _dirty (1)
+{
+}
+
+bool
+MidiEventCache::valid_for (double start_qn, NoteMode mode) const
+{
+	return !g_atomic_int_get (&_dirty) && start_qn == _start_qn && mode == _mode;
+}
+
+void
+MidiEventCache::build (MidiModel const & model,
+                       TempoMap const & tempo_map,
+                       double start_qn,
+                       std::set<Evoral::Parameter> const & filtered,
+                       NoteMode mode)
+{
+	/* clear the flag first, so that an invalidation while we are building
+	   (the tempo map may change without the source lock) is not lost.
+	*/
+	g_atomic_int_set (&_dirty, 0);
+
+	_events.clear ();
+	_data.clear ();
+	_start_qn = start_qn;
+	_mode = mode;
+	++_generation;
+
+	/* time of the last note on for each note number and channel */
+	samplepos_t on_times[16 * 128];
+	std::fill (on_times, on_times + 16 * 128, 0);
+
+	for (MidiModel::const_iterator i = model.begin (Evoral::Beats(), false, filtered); i != model.end (); ++i) {
+
+		Event e;
+
+		e.time = tempo_map.sample_at_quarter_note (i->time().to_double() + start_qn);
+		e.on_time = e.time;
+		e.type = i->event_type ();
+		e.size = i->size ();
+		e.offset = _data.size ();
+
+		if (i->is_note_on ()) {
+			on_times[i->channel() * 128 + i->note()] = e.time;
+		} else if (i->is_note_off ()) {
+			e.on_time = on_times[i->channel() * 128 + i->note()];
+		}
+
+		_data.insert (_data.end (), i->buffer (), i->buffer () + i->size ());
+		_events.push_back (e);
+	}
+
+	DEBUG_TRACE (DEBUG::MidiSourceIO, string_compose ("MidiEventCache: rebuilt with %1 events (%2 bytes of data) at %3\n",
+	                                                  _events.size (), _data.size (), start_qn));
+}
+
+void
+MidiEventCache::read (Evoral::EventSink<samplepos_t>& dst,
+                      samplepos_t source_start,
+                      samplepos_t start,
+                      samplecnt_t cnt,
+                      Evoral::Range<samplepos_t>* loop_range,
+                      MidiCursor& cursor,
+                      MidiStateTracker* tracker,
+                      MidiChannelFilter* filter) const
+{
+	const samplepos_t read_start = start + source_start;
+	const samplepos_t read_end = read_start + cnt;
+
+	const bool linear_read = cursor.last_read_end != 0 && start == cursor.last_read_end && cursor.cache_generation == _generation;
+
+	if (!linear_read) {
+		/* note offs for notes that began before this point are only
+		   played if the tracker knows that their note is on, which
+		   matches what a freshly positioned model iterator does.
+		*/
+		cursor.cache_index = std::lower_bound (_events.begin (), _events.end (), read_start, EventTimeCompare ()) - _events.begin ();
+		cursor.cache_origin = read_start;
+		cursor.cache_generation = _generation;
+	}
+
+	cursor.last_read_end = start + cnt;
+
+	size_t n = cursor.cache_index;
+
+	for (; n < _events.size () && _events[n].time < read_end; ++n) {
+
+		Event const & e (_events[n]);
+		uint8_t const * buf = &_data[e.offset];
+
+		if ((buf[0] & 0xF0) == MIDI_CMD_NOTE_OFF && e.on_time < cursor.cache_origin) {
+			if (!tracker || !tracker->active (buf[1], buf[0] & 0x0F)) {
+				continue;
+			}
+		}
+
+		samplepos_t time = e.time;
+
+		if (loop_range) {
+			time = loop_range->squish (time);
+		}
+
+		const bool is_channel_event = (0x80 <= (buf[0] & 0xF0)) && (buf[0] <= 0xE0);
+
+		if (filter && is_channel_event && e.size <= 3) {
+			/* let the filter modify a copy, not the cache */
+			uint8_t copy[3];
+			memcpy (copy, buf, e.size);
+			if (!filter->filter (copy, e.size)) {
+				dst.write (time, e.type, e.size, copy);
+			}
+		} else {
+			dst.write (time, e.type, e.size, buf);
+		}
+
+		if (tracker) {
+			tracker->track (buf);
+		}
+	}
+
+	cursor.cache_index = n;
+}
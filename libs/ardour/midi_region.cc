@@ -85,6 +85,7 @@ MidiRegion::MidiRegion (const SourceList& srcs)
 {
 	register_properties ();
 	midi_source(0)->ModelChanged.connect_same_thread (_source_connection, boost::bind (&MidiRegion::model_changed, this));
+	midi_source(0)->Invalidated.connect_same_thread (_source_invalidated_connection, boost::bind (&MidiEventCache::invalidate, &_event_cache));
 	model_changed ();
 	assert(_name.val().find("/") == string::npos);
 	assert(_type == DataType::MIDI);
@@ -101,6 +102,7 @@ MidiRegion::MidiRegion (boost::shared_ptr<const MidiRegion> other)
 
 	assert(_name.val().find("/") == string::npos);
 	midi_source(0)->ModelChanged.connect_same_thread (_source_connection, boost::bind (&MidiRegion::model_changed, this));
+	midi_source(0)->Invalidated.connect_same_thread (_source_invalidated_connection, boost::bind (&MidiEventCache::invalidate, &_event_cache));
 	model_changed ();
 }
 
@@ -122,6 +124,7 @@ MidiRegion::MidiRegion (boost::shared_ptr<const MidiRegion> other, MusicSample o
 
 	assert(_name.val().find("/") == string::npos);
 	midi_source(0)->ModelChanged.connect_same_thread (_source_connection, boost::bind (&MidiRegion::model_changed, this));
+	midi_source(0)->Invalidated.connect_same_thread (_source_invalidated_connection, boost::bind (&MidiEventCache::invalidate, &_event_cache));
 	model_changed ();
 }
 
@@ -257,6 +260,9 @@ MidiRegion::set_length_internal (samplecnt_t len, const int32_t sub_num)
 void
 MidiRegion::update_after_tempo_map_change (bool /* send */)
 {
+	/* our events are cached with their times in samples */
+	_event_cache.invalidate ();
+
 	boost::shared_ptr<Playlist> pl (playlist());
 
 	if (!pl) {
@@ -453,6 +459,25 @@ MidiRegion::_read_at (const SourceList&              /*srcs*/,
 	     << endl;
 #endif
 
+	/* Read from our cache of the model's events if there is a model,
+	   rebuilding the cache first if the model or tempo map have changed
+	   (or we have moved) since it was built.
+	*/
+
+	boost::shared_ptr<MidiModel> model = src->model ();
+
+	if (model) {
+		const double start_qn = quarter_note() - _start_beats;
+
+		if (!_event_cache.valid_for (start_qn, mode)) {
+			_event_cache.build (*model, _session.tempo_map(), start_qn, _filtered_parameters, mode);
+		}
+
+		_event_cache.read (dst, _position - _start, _start + internal_offset, to_read, loop_range, cursor, tracker, filter);
+
+		return to_read;
+	}
+
 	/* This call reads events from a source and writes them to `dst' timed in session samples */
 
 	if (src->midi_read (
@@ -571,6 +596,8 @@ MidiRegion::model_changed ()
 		return;
 	}
 
+	_event_cache.invalidate ();
+
 	/* build list of filtered Parameters, being those whose automation state is not `Play' */
 
 	_filtered_parameters.clear ();
@@ -591,6 +618,11 @@ MidiRegion::model_changed ()
 		);
 
 	model()->ContentsShifted.connect_same_thread (_model_shift_connection, boost::bind (&MidiRegion::model_shifted, this, _1));
+
+	/* edits to the model's controllers do not invalidate the source, so
+	   watch for them here as they change what we have cached.
+	*/
+	model()->ContentsChanged.connect_same_thread (_model_contents_connection, boost::bind (&MidiEventCache::invalidate, &_event_cache));
 }
 void
 MidiRegion::model_shifted (double qn_distance)
@@ -626,6 +658,8 @@ MidiRegion::model_automation_state_changed (Evoral::Parameter const & p)
 		_filtered_parameters.insert (p);
 	}
 
+	_event_cache.invalidate ();
+
 	/* the source will have an iterator into the model, and that iterator will have been set up
 	   for a given set of filtered_parameters, so now that we've changed that list we must invalidate
 	   the iterator.
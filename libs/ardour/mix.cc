@@ -142,6 +142,36 @@ default_copy_vector (ARDOUR::Sample * dst, const ARDOUR::Sample * src, pframes_t
 	memcpy(dst, src, nframes*sizeof(ARDOUR::Sample));
 }
 
+void
+default_apply_gain_vector (ARDOUR::Sample * buf, const ARDOUR::gain_t * gain, pframes_t nframes)
+{
+	for (pframes_t i = 0; i < nframes; ++i) {
+		buf[i] *= gain[i];
+	}
+}
+
+void
+default_mix_buffers_with_gain_vector (ARDOUR::Sample * dst, const ARDOUR::Sample * src, const ARDOUR::gain_t * gain, pframes_t nframes)
+{
+	for (pframes_t i = 0; i < nframes; ++i) {
+		dst[i] += src[i] * gain[i];
+	}
+}
+
+void
+default_crossfade_buffers (ARDOUR::Sample * dst, const ARDOUR::Sample * src, const ARDOUR::gain_t * src_gain, const ARDOUR::gain_t * dst_gain, pframes_t nframes)
+{
+	if (dst_gain) {
+		for (pframes_t i = 0; i < nframes; ++i) {
+			dst[i] = (dst[i] * dst_gain[i]) + (src[i] * src_gain[i]);
+		}
+	} else {
+		for (pframes_t i = 0; i < nframes; ++i) {
+			dst[i] = (dst[i] * (1.f - src_gain[i])) + (src[i] * src_gain[i]);
+		}
+	}
+}
+
 #if defined (__APPLE__) && defined (BUILD_VECLIB_OPTIMIZATIONS)
 #include <Accelerate/Accelerate.h>
 
@@ -180,6 +210,29 @@ veclib_mix_buffers_no_gain (ARDOUR::Sample * dst, const ARDOUR::Sample * src, pf
 	vDSP_vsma(src, 1, &gain, dst, 1, dst, 1, nframes);
 }
 
+void
+veclib_apply_gain_vector (ARDOUR::Sample * buf, const ARDOUR::gain_t * gain, pframes_t nframes)
+{
+	vDSP_vmul(buf, 1, gain, 1, buf, 1, nframes);
+}
+
+void
+veclib_mix_buffers_with_gain_vector (ARDOUR::Sample * dst, const ARDOUR::Sample * src, const ARDOUR::gain_t * gain, pframes_t nframes)
+{
+	vDSP_vma(src, 1, gain, 1, dst, 1, dst, 1, nframes);
+}
+
+void
+veclib_crossfade_buffers (ARDOUR::Sample * dst, const ARDOUR::Sample * src, const ARDOUR::gain_t * src_gain, const ARDOUR::gain_t * dst_gain, pframes_t nframes)
+{
+	if (dst_gain) {
+		vDSP_vmma(dst, 1, dst_gain, 1, src, 1, src_gain, 1, dst, 1, nframes);
+	} else {
+		/* vDSP has no single operation for (1 - gain) */
+		default_crossfade_buffers (dst, src, src_gain, dst_gain, nframes);
+	}
+}
+
 #endif
 
 
@@ -34,6 +34,7 @@
 #include "ardour/playlist_source.h"
 #include "ardour/region.h"
 #include "ardour/region_factory.h"
+#include "ardour/region_index.h"
 #include "ardour/region_sorters.h"
 #include "ardour/session.h"
 #include "ardour/session_playlists.h"
@@ -305,6 +306,7 @@ Playlist::init (bool hide)
 
 	g_atomic_int_set (&block_notifications, 0);
 	g_atomic_int_set (&ignore_state_changes, 0);
+	g_atomic_int_set (&_region_generation, 0);
 	pending_contents_change = false;
 	pending_layering = false;
 	first_set_state = true;
@@ -759,6 +761,7 @@ Playlist::add_region_internal (boost::shared_ptr<Region> region, samplepos_t pos
 
 	regions.insert (upper_bound (regions.begin(), regions.end(), region, cmp), region);
 	all_regions.insert (region);
+	invalidate_region_index ();
 
 	possibly_splice_unlocked (position, region->length(), region);
 
@@ -820,6 +823,7 @@ Playlist::remove_region_internal (boost::shared_ptr<Region> region)
 			samplecnt_t distance = (*i)->length();
 
 			regions.erase (i);
+			invalidate_region_index ();
 
 			possibly_splice_unlocked (pos, -distance);
 
@@ -1704,6 +1708,13 @@ Playlist::region_bounds_changed (const PropertyChange& what_changed, boost::shar
 		 return;
 	 }
 
+	 /* even if region_changed() ignores this (e.g. during set_state) */
+	 if (what_changed.contains (Properties::position) || what_changed.contains (Properties::length)) {
+		 invalidate_region_index ();
+	 } else {
+		 bump_region_generation ();
+	 }
+
 	 /* this makes a virtual call to the right kind of playlist ... */
 
 	 region_changed (what_changed, region);
@@ -1833,6 +1844,42 @@ Playlist::deep_sources (std::set<boost::shared_ptr<Source> >& sources) const
 	}
 }
 
+/** @return an index of the current regions, building it if necessary.
+ *  Caller must hold the region lock.
+ */
+boost::shared_ptr<RegionIndex const>
+Playlist::region_index () const
+{
+	/* several readers may share the region lock, so building the
+	 * index needs its own lock.
+	 */
+	Glib::Threads::Mutex::Lock lm (_region_index_lock);
+
+	if (!_region_index) {
+		_region_index.reset (new RegionIndex (regions.begin(), regions.end()));
+	}
+
+	return _region_index;
+}
+
+/** Called whenever regions are added, removed, moved or trimmed */
+void
+Playlist::invalidate_region_index ()
+{
+	{
+		Glib::Threads::Mutex::Lock lm (_region_index_lock);
+		_region_index.reset ();
+	}
+	bump_region_generation ();
+}
+
+void
+Playlist::bump_region_generation ()
+{
+	g_atomic_int_inc (&_region_generation);
+	region_generation_changed ();
+}
+
 boost::shared_ptr<RegionList>
 Playlist::regions_at (samplepos_t sample)
 {
@@ -1844,15 +1891,11 @@ Playlist::regions_at (samplepos_t sample)
  Playlist::count_regions_at (samplepos_t sample) const
  {
 	 RegionReadLock rlock (const_cast<Playlist*>(this));
-	 uint32_t cnt = 0;
+	 RegionList rlist;
 
-	 for (RegionList::const_iterator i = regions.begin(); i != regions.end(); ++i) {
-		 if ((*i)->covers (sample)) {
-			 cnt++;
-		 }
-	 }
+	 region_index ()->touched (sample, sample, rlist);
 
-	 return cnt;
+	 return rlist.size ();
  }
 
  boost::shared_ptr<Region>
@@ -1909,13 +1952,7 @@ Playlist::find_regions_at (samplepos_t sample)
 	/* Caller must hold lock */
 
 	boost::shared_ptr<RegionList> rlist (new RegionList);
-
-	for (RegionList::iterator i = regions.begin(); i != regions.end(); ++i) {
-		if ((*i)->covers (sample)) {
-			rlist->push_back (*i);
-		}
-	}
-
+	region_index ()->touched (sample, sample, *rlist);
 	return rlist;
 }
 
@@ -1924,13 +1961,7 @@ Playlist::regions_with_start_within (Evoral::Range<samplepos_t> range)
 {
 	RegionReadLock rlock (this);
 	boost::shared_ptr<RegionList> rlist (new RegionList);
-
-	for (RegionList::iterator i = regions.begin(); i != regions.end(); ++i) {
-		if ((*i)->first_sample() >= range.from && (*i)->first_sample() <= range.to) {
-			rlist->push_back (*i);
-		}
-	}
-
+	region_index ()->starting_within (range.from, range.to, *rlist);
 	return rlist;
 }
 
@@ -1939,8 +1970,12 @@ Playlist::regions_with_end_within (Evoral::Range<samplepos_t> range)
 {
 	RegionReadLock rlock (this);
 	boost::shared_ptr<RegionList> rlist (new RegionList);
+	RegionList touched;
 
-	for (RegionList::iterator i = regions.begin(); i != regions.end(); ++i) {
+	/* any region that ends within the range also touches it */
+	region_index ()->touched (range.from, range.to, touched);
+
+	for (RegionList::iterator i = touched.begin(); i != touched.end(); ++i) {
 		if ((*i)->last_sample() >= range.from && (*i)->last_sample() <= range.to) {
 			rlist->push_back (*i);
 		}
@@ -1964,13 +1999,7 @@ boost::shared_ptr<RegionList>
 Playlist::regions_touched_locked (samplepos_t start, samplepos_t end)
 {
 	boost::shared_ptr<RegionList> rlist (new RegionList);
-
-	for (RegionList::iterator i = regions.begin(); i != regions.end(); ++i) {
-		if ((*i)->coverage (start, end) != Evoral::OverlapNone) {
-			rlist->push_back (*i);
-		}
-	}
-
+	region_index ()->touched (start, end, *rlist);
 	return rlist;
 }
 
@@ -2038,6 +2067,16 @@ boost::shared_ptr<Region>
 Playlist::find_next_region (samplepos_t sample, RegionPoint point, int dir)
 {
 	RegionReadLock rlock (this);
+
+	if (point == Start) {
+		/* regions are indexed by their start */
+		if (dir == 1) {
+			return region_index ()->next_start_after (sample);
+		} else {
+			return region_index ()->previous_start_before (sample);
+		}
+	}
+
 	boost::shared_ptr<Region> ret;
 	samplepos_t closest = max_samplepos;
 
@@ -28,6 +28,7 @@
 #include "pbd/types_convert.h"
 
 #include "ardour/audio_buffer.h"
+#include "ardour/audioengine.h"
 #include "ardour/automation_list.h"
 #include "ardour/buffer_set.h"
 #include "ardour/debug.h"
@@ -37,6 +38,7 @@
 #include "ardour/plugin.h"
 #include "ardour/plugin_insert.h"
 #include "ardour/port.h"
+#include "ardour/rc_configuration.h"
 
 #ifdef LV2_SUPPORT
 #include "ardour/lv2_plugin.h"
@@ -81,6 +83,7 @@ PluginInsert::PluginInsert (Session& s, boost::shared_ptr<Plugin> plug)
 	, _strict_io (false)
 	, _custom_cfg (false)
 	, _maps_from_state (false)
+	, _pin_tables (new PinTables)
 	, _latency_changed (false)
 	, _bypass_port (UINT32_MAX)
 {
@@ -735,32 +738,11 @@ PluginInsert::preset_load_set_value (uint32_t p, float v)
 }
 
 void
-PluginInsert::inplace_silence_unconnected (BufferSet& bufs, const PinMappings& out_map, samplecnt_t nframes, samplecnt_t offset) const
+PluginInsert::inplace_silence_unconnected (BufferSet& bufs, const PinTables& pins, samplecnt_t nframes, samplecnt_t offset) const
 {
-	// TODO optimize: store "unconnected" in a fixed set.
-	// it only changes on reconfiguration.
 	for (DataType::iterator t = DataType::begin(); t != DataType::end(); ++t) {
 		for (uint32_t out = 0; out < bufs.count().get (*t); ++out) {
-			bool mapped = false;
-			if (*t == DataType::MIDI && out == 0 && has_midi_bypass ()) {
-				mapped = true; // in-place Midi bypass
-			}
-			for (uint32_t pc = 0; pc < get_count() && !mapped; ++pc) {
-				PinMappings::const_iterator i = out_map.find (pc);
-				if (i == out_map.end ()) {
-					continue;
-				}
-				const ChanMapping& outmap (i->second);
-				for (uint32_t o = 0; o < natural_output_streams().get (*t); ++o) {
-					bool valid;
-					uint32_t idx = outmap.get (*t, o, &valid);
-					if (valid && idx == out) {
-						mapped = true;
-						break;
-					}
-				}
-			}
-			if (!mapped) {
+			if (!(pins.output_flags (*t, out) & (PinTables::PluginOutput | PinTables::MidiBypass))) {
 				bufs.get (*t, out).silence (nframes, offset);
 			}
 		}
@@ -770,14 +752,7 @@ PluginInsert::inplace_silence_unconnected (BufferSet& bufs, const PinMappings& o
 void
 PluginInsert::connect_and_run (BufferSet& bufs, samplepos_t start, samplepos_t end, double speed, pframes_t nframes, samplecnt_t offset, bool with_auto)
 {
-	// TODO: atomically copy maps & _no_inplace
-	PinMappings in_map (_in_map);
-	PinMappings out_map (_out_map);
-	ChanMapping thru_map (_thru_map);
-	if (_mapping_changed) { // ToDo use a counters, increment until match.
-		_no_inplace = check_inplace ();
-		_mapping_changed = false;
-	}
+	boost::shared_ptr<PinTables> pins = _pin_tables.reader ();
 
 	if (_latency_changed) {
 		/* delaylines are configured with the max possible latency (as reported by the plugin)
@@ -796,29 +771,21 @@ PluginInsert::connect_and_run (BufferSet& bufs, samplepos_t start, samplepos_t e
 		_delaybuffers.set (ChanCount::max(bufs.count(), _configured_out), plugin_latency ());
 	}
 
-	if (_match.method == Split && !_no_inplace) {
+	if (_match.method == Split && !pins->no_inplace) {
 		// TODO: also use this optimization if one source-buffer
 		// feeds _all_ *connected* inputs.
 		// currently this is *first* buffer to all only --
 		// see PluginInsert::check_inplace
 		for (DataType::iterator t = DataType::begin(); t != DataType::end(); ++t) {
-			if (_configured_internal.get (*t) == 0) {
-				continue;
-			}
-			bool valid;
-			uint32_t first_idx = in_map[0].get (*t, 0, &valid);
-			assert (valid && first_idx == 0); // check_inplace ensures this
-			/* copy the first stream's buffer contents to the others */
-			for (uint32_t i = 1; i < natural_input_streams ().get (*t); ++i) {
-				uint32_t idx = in_map[0].get (*t, i, &valid);
-				if (valid) {
-					assert (idx == 0);
-					bufs.get (*t, i).read_from (bufs.get (*t, first_idx), nframes, offset, offset);
-				}
+			/* copy the first stream's buffer contents to the others,
+			 * which produces the linear monotonic input map that
+			 * update_pin_tables() has prepared for the plugin.
+			 */
+			const std::vector<uint32_t>& copy (pins->split_copy[*t]);
+			for (std::vector<uint32_t>::const_iterator i = copy.begin (); i != copy.end (); ++i) {
+				bufs.get (*t, *i).read_from (bufs.get (*t, 0), nframes, offset, offset);
 			}
 		}
-		/* the copy operation produces a linear monotonic input map */
-		in_map[0] = ChanMapping (natural_input_streams ());
 	}
 
 	bufs.set_count(ChanCount::max(bufs.count(), _configured_internal));
@@ -892,110 +859,72 @@ PluginInsert::connect_and_run (BufferSet& bufs, samplepos_t start, samplepos_t e
 		}
 	} else
 #endif
-	if (_no_inplace) {
-		// TODO optimize -- build maps once.
+	if (pins->no_inplace) {
 		uint32_t pc = 0;
 		BufferSet& inplace_bufs  = _session.get_noinplace_buffers();
-		ARDOUR::ChanMapping used_outputs;
 
 		assert (inplace_bufs.count () >= natural_input_streams () + _configured_out);
 
-		/* build used-output map */
-		for (Plugins::iterator i = _plugins.begin(); i != _plugins.end(); ++i, ++pc) {
-			for (DataType::iterator t = DataType::begin(); t != DataType::end(); ++t) {
-				for (uint32_t out = 0; out < natural_output_streams().get (*t); ++out) {
-					bool valid;
-					uint32_t out_idx = out_map[pc].get (*t, out, &valid);
-					if (valid) {
-						used_outputs.set (*t, out_idx, 1); // mark as used
-					}
-				}
-			}
-		}
 		/* copy thru data to outputs before processing in-place */
 		for (DataType::iterator t = DataType::begin(); t != DataType::end(); ++t) {
 			for (uint32_t out = 0; out < bufs.count().get (*t); ++out) {
-				bool valid;
-				uint32_t in_idx = thru_map.get (*t, out, &valid);
+				uint32_t in_idx = PinTables::src (pins->thru_src[*t], out);
 				uint32_t m = out + natural_input_streams ().get (*t);
-				if (valid) {
+				if (in_idx != UINT32_MAX) {
 					_delaybuffers.delay (*t, out, inplace_bufs.get (*t, m), bufs.get (*t, in_idx), nframes, offset, offset);
-					used_outputs.set (*t, out, 1); // mark as used
-				} else {
-					used_outputs.get (*t, out, &valid);
-					if (valid) {
-						/* the plugin is expected to write here, but may not :(
-						 * (e.g. drumgizmo w/o kit loaded)
-						 */
-						inplace_bufs.get (*t, m).silence (nframes);
-					}
+				} else if (pins->output_flags (*t, out) & PinTables::PluginOutput) {
+					/* the plugin is expected to write here, but may not :(
+					 * (e.g. drumgizmo w/o kit loaded)
+					 */
+					inplace_bufs.get (*t, m).silence (nframes);
 				}
 			}
 		}
 
-		pc = 0;
-		for (Plugins::iterator i = _plugins.begin(); i != _plugins.end(); ++i, ++pc) {
-
-			ARDOUR::ChanMapping i_in_map (natural_input_streams());
-			ARDOUR::ChanMapping i_out_map (out_map[pc]);
-			ARDOUR::ChanCount mapped;
+		for (Plugins::iterator i = _plugins.begin(); i != _plugins.end() && pc < pins->in_map.size (); ++i, ++pc) {
 
 			/* map inputs sequentially */
 			for (DataType::iterator t = DataType::begin(); t != DataType::end(); ++t) {
-				for (uint32_t in = 0; in < natural_input_streams().get (*t); ++in) {
-					bool valid;
-					uint32_t in_idx = in_map[pc].get (*t, in, &valid);
-					uint32_t m = mapped.get (*t);
-					if (valid) {
-						inplace_bufs.get (*t, m).read_from (bufs.get (*t, in_idx), nframes, offset, offset);
+				const uint32_t n_in = natural_input_streams().get (*t);
+				for (uint32_t in = 0; in < n_in; ++in) {
+					uint32_t in_idx = PinTables::src (pins->in_src[*t], pc * n_in + in);
+					if (in_idx != UINT32_MAX) {
+						inplace_bufs.get (*t, in).read_from (bufs.get (*t, in_idx), nframes, offset, offset);
 					} else {
-						inplace_bufs.get (*t, m).silence (nframes, offset);
+						inplace_bufs.get (*t, in).silence (nframes, offset);
 					}
-					mapped.set (*t, m + 1);
 				}
 			}
 
 			/* outputs are mapped to inplace_bufs after the inputs */
-			for (DataType::iterator t = DataType::begin(); t != DataType::end(); ++t) {
-				i_out_map.offset_to (*t, natural_input_streams ().get (*t));
-			}
-
-			if ((*i)->connect_and_run (inplace_bufs, start, end, speed, i_in_map, i_out_map, nframes, offset)) {
+			if ((*i)->connect_and_run (inplace_bufs, start, end, speed, pins->in_map[pc], pins->out_map[pc], nframes, offset)) {
 				deactivate ();
 			}
 		}
 
 		/* all instances have completed, now copy data that was written
 		 * and zero unconnected buffers */
-		ARDOUR::ChanMapping nonzero_out (used_outputs);
-		if (has_midi_bypass ()) {
-			nonzero_out.set (DataType::MIDI, 0, 1); // Midi bypass.
-		}
 		for (DataType::iterator t = DataType::begin(); t != DataType::end(); ++t) {
 			for (uint32_t out = 0; out < bufs.count().get (*t); ++out) {
-				bool valid;
-				used_outputs.get (*t, out, &valid);
-				if (!valid) {
-					nonzero_out.get (*t, out, &valid);
-					if (!valid) {
-						bufs.get (*t, out).silence (nframes, offset);
-					}
-				} else {
+				const uint8_t flags = pins->output_flags (*t, out);
+				if (flags & (PinTables::PluginOutput | PinTables::ThruOutput)) {
 					uint32_t m = out + natural_input_streams ().get (*t);
 					bufs.get (*t, out).read_from (inplace_bufs.get (*t, m), nframes, offset, offset);
+				} else if (!(flags & PinTables::MidiBypass)) {
+					bufs.get (*t, out).silence (nframes, offset);
 				}
 			}
 		}
 	} else {
 		/* in-place processing */
 		uint32_t pc = 0;
-		for (Plugins::iterator i = _plugins.begin(); i != _plugins.end(); ++i, ++pc) {
-			if ((*i)->connect_and_run(bufs, start, end, speed, in_map[pc], out_map[pc], nframes, offset)) {
+		for (Plugins::iterator i = _plugins.begin(); i != _plugins.end() && pc < pins->in_map.size (); ++i, ++pc) {
+			if ((*i)->connect_and_run(bufs, start, end, speed, pins->in_map[pc], pins->out_map[pc], nframes, offset)) {
 				deactivate ();
 			}
 		}
 		// now silence unconnected outputs
-		inplace_silence_unconnected (bufs, _out_map, nframes, offset);
+		inplace_silence_unconnected (bufs, *pins, nframes, offset);
 	}
 
 	if (collect_signal_nframes > 0) {
@@ -1037,20 +966,14 @@ PluginInsert::bypass (BufferSet& bufs, pframes_t nframes)
 	 * -> use mappings just like connect_and_run
 	 */
 
-	// TODO: atomically copy maps & _no_inplace
-	const ChanMapping in_map (no_sc_input_map ());
-	const ChanMapping out_map (output_map ());
-	if (_mapping_changed) {
-		_no_inplace = check_inplace ();
-		_mapping_changed = false;
-	}
+	boost::shared_ptr<PinTables> pins = _pin_tables.reader ();
+	const ChanMapping& in_map (pins->bypass_in_map);
+	const ChanMapping& out_map (pins->bypass_out_map);
 
 	bufs.set_count(ChanCount::max(bufs.count(), _configured_internal));
 	bufs.set_count(ChanCount::max(bufs.count(), _configured_out));
 
-	if (_no_inplace) {
-		ChanMapping thru_map (_thru_map);
-
+	if (pins->no_inplace) {
 		BufferSet& inplace_bufs  = _session.get_noinplace_buffers();
 		// copy all inputs
 		for (DataType::iterator t = DataType::begin(); t != DataType::end(); ++t) {
@@ -1058,44 +981,16 @@ PluginInsert::bypass (BufferSet& bufs, pframes_t nframes)
 				inplace_bufs.get (*t, in).read_from (bufs.get (*t, in), nframes, 0, 0);
 			}
 		}
-		ARDOUR::ChanMapping used_outputs;
-		// copy thru
+		/* copy thru, or assuming that every plugin has an internal
+		 * identity map, what it would pass on; silence all unused outputs
+		 */
 		for (DataType::iterator t = DataType::begin(); t != DataType::end(); ++t) {
 			for (uint32_t out = 0; out < _configured_out.get (*t); ++out) {
-				bool valid;
-				uint32_t in_idx = thru_map.get (*t, out, &valid);
-				if (valid) {
+				uint32_t in_idx = PinTables::src (pins->bypass_src[*t], out);
+				if (in_idx != UINT32_MAX) {
 					bufs.get (*t, out).read_from (inplace_bufs.get (*t, in_idx), nframes, 0, 0);
-					used_outputs.set (*t, out, 1); // mark as used
-				}
-			}
-		}
-		// plugin no-op: assume every plugin has an internal identity map
-		for (DataType::iterator t = DataType::begin(); t != DataType::end(); ++t) {
-			for (uint32_t out = 0; out < _configured_out.get (*t); ++out) {
-				bool valid;
-				uint32_t src_idx = out_map.get_src (*t, out, &valid);
-				if (!valid) {
-					continue;
-				}
-				uint32_t in_idx = in_map.get (*t, src_idx, &valid);
-				if (!valid) {
-					continue;
-				}
-				bufs.get (*t, out).read_from (inplace_bufs.get (*t, in_idx), nframes, 0, 0);
-				used_outputs.set (*t, out, 1); // mark as used
-			}
-		}
-		// now silence all unused outputs
-		if (has_midi_bypass ()) {
-			used_outputs.set (DataType::MIDI, 0, 1); // Midi bypass.
-		}
-		for (DataType::iterator t = DataType::begin(); t != DataType::end(); ++t) {
-			for (uint32_t out = 0; out < _configured_out.get (*t); ++out) {
-				bool valid;
-				used_outputs.get (*t, out, &valid);
-				if (!valid) {
-						bufs.get (*t, out).silence (nframes, 0);
+				} else if (!(pins->output_flags (*t, out) & PinTables::MidiBypass)) {
+					bufs.get (*t, out).silence (nframes, 0);
 				}
 			}
 		}
@@ -1153,8 +1048,9 @@ PluginInsert::silence (samplecnt_t nframes, samplepos_t start_sample)
 
 	_delaybuffers.flush ();
 
-	ChanMapping in_map (natural_input_streams ());
-	ChanMapping out_map (natural_output_streams ());
+	boost::shared_ptr<PinTables> pins = _pin_tables.reader ();
+	const ChanMapping& in_map (pins->natural_in_map);
+	const ChanMapping& out_map (pins->natural_out_map);
 	ChanCount maxbuf = ChanCount::max (natural_input_streams (), natural_output_streams());
 #ifdef MIXBUS
 	if (is_channelstrip ()) {
@@ -1223,9 +1119,27 @@ PluginInsert::automate_and_run (BufferSet& bufs, samplepos_t start, samplepos_t
 		return;
 	}
 
+	/* with a quantum, automation events are batched: the block is only
+	 * split at the first multiple of the quantum at or after an event, so
+	 * dense automation causes at most one run per quantum, and each run
+	 * uses the values at its start.
+	 */
+	const samplecnt_t quantum = Config->get_plugin_automation_quantum ();
+
 	while (nframes) {
 
-		samplecnt_t cnt = min (((samplecnt_t) ceil (next_event.when) - start), (samplecnt_t) nframes);
+		samplepos_t next = (samplepos_t) ceil (next_event.when);
+
+		if (quantum > 1) {
+			const samplecnt_t rem = next % quantum;
+			if (rem > 0) {
+				next += quantum - rem;
+			} else if (rem < 0) {
+				next -= rem;
+			}
+		}
+
+		samplecnt_t cnt = min (next - start, (samplecnt_t) nframes);
 
 		connect_and_run (bufs, start, start + cnt, speed, cnt, offset, true); // XXX (start + cnt) * speed
 
@@ -1384,8 +1298,9 @@ PluginInsert::set_input_map (uint32_t num, ChanMapping m) {
 		_in_map[num] = m;
 		changed |= sanitize_maps ();
 		if (changed) {
+			update_pin_tables ();
+			flush_pin_tables ();
 			PluginMapChanged (); /* EMIT SIGNAL */
-			_mapping_changed = true;
 			_session.set_dirty();
 		}
 	}
@@ -1398,8 +1313,9 @@ PluginInsert::set_output_map (uint32_t num, ChanMapping m) {
 		_out_map[num] = m;
 		changed |= sanitize_maps ();
 		if (changed) {
+			update_pin_tables ();
+			flush_pin_tables ();
 			PluginMapChanged (); /* EMIT SIGNAL */
-			_mapping_changed = true;
 			_session.set_dirty();
 		}
 	}
@@ -1411,8 +1327,9 @@ PluginInsert::set_thru_map (ChanMapping m) {
 	_thru_map = m;
 	changed |= sanitize_maps ();
 	if (changed) {
+		update_pin_tables ();
+		flush_pin_tables ();
 		PluginMapChanged (); /* EMIT SIGNAL */
-		_mapping_changed = true;
 		_session.set_dirty();
 	}
 }
@@ -1604,6 +1521,137 @@ PluginInsert::check_inplace ()
 	return !inplace_ok; // no-inplace
 }
 
+static void
+set_output_flag (std::vector<uint8_t>& outputs, uint32_t out, uint8_t flag)
+{
+	if (out >= outputs.size ()) {
+		outputs.resize (out + 1, 0);
+	}
+	outputs[out] |= flag;
+}
+
+void
+PluginInsert::update_pin_tables ()
+{
+	/* called whenever the maps change, never by the process thread */
+
+	_no_inplace = check_inplace ();
+
+	const ChanCount natural_in (natural_input_streams ());
+	const ChanCount natural_out (natural_output_streams ());
+	const bool split_inplace = _match.method == Split && !_no_inplace;
+
+	RCUWriter<PinTables> writer (_pin_tables);
+	boost::shared_ptr<PinTables> pins = writer.get_copy ();
+
+	*pins = PinTables ();
+
+	pins->no_inplace = _no_inplace;
+	pins->natural_in_map = ChanMapping (natural_in);
+	pins->natural_out_map = ChanMapping (natural_out);
+	pins->bypass_in_map = no_sc_input_map ();
+	pins->bypass_out_map = output_map ();
+
+	/* the maps handed to the plugins */
+	for (uint32_t pc = 0; pc < get_count (); ++pc) {
+		ChanMapping in_map (_in_map[pc]);
+		ChanMapping out_map (_out_map[pc]);
+		if (_no_inplace) {
+			/* inputs are copied to the start of the no-inplace buffers,
+			 * and outputs follow them there
+			 */
+			in_map = ChanMapping (natural_in);
+			for (DataType::iterator t = DataType::begin(); t != DataType::end(); ++t) {
+				out_map.offset_to (*t, natural_in.get (*t));
+			}
+		} else if (split_inplace) {
+			/* connect_and_run() copies the first input to the others,
+			 * which produces a linear monotonic input map
+			 */
+			in_map = ChanMapping (natural_in);
+		}
+		pins->in_map.push_back (in_map);
+		pins->out_map.push_back (out_map);
+	}
+
+	for (DataType::iterator t = DataType::begin(); t != DataType::end(); ++t) {
+		bool valid;
+
+		if (split_inplace && _configured_internal.get (*t) > 0) {
+			uint32_t first_idx = _in_map[0].get (*t, 0, &valid);
+			assert (valid && first_idx == 0); // check_inplace ensures this
+			for (uint32_t i = 1; i < natural_in.get (*t); ++i) {
+				uint32_t idx = _in_map[0].get (*t, i, &valid);
+				if (valid) {
+					assert (idx == first_idx);
+					pins->split_copy[*t].push_back (i);
+				}
+			}
+		}
+
+		pins->in_src[*t].assign (get_count () * natural_in.get (*t), UINT32_MAX);
+		pins->outputs[*t].assign (_configured_out.get (*t), 0);
+
+		for (uint32_t pc = 0; pc < get_count (); ++pc) {
+			for (uint32_t in = 0; in < natural_in.get (*t); ++in) {
+				uint32_t in_idx = _in_map[pc].get (*t, in, &valid);
+				if (valid) {
+					pins->in_src[*t][pc * natural_in.get (*t) + in] = in_idx;
+				}
+			}
+			for (uint32_t out = 0; out < natural_out.get (*t); ++out) {
+				uint32_t out_idx = _out_map[pc].get (*t, out, &valid);
+				if (valid) {
+					set_output_flag (pins->outputs[*t], out_idx, PinTables::PluginOutput);
+				}
+			}
+		}
+
+		const ChanMapping::Mappings thru (_thru_map.mappings ());
+		ChanMapping::Mappings::const_iterator tm = thru.find (*t);
+		if (tm != thru.end ()) {
+			for (ChanMapping::TypeMapping::const_iterator i = tm->second.begin (); i != tm->second.end (); ++i) {
+				/* out-idx <= in-idx */
+				if (i->first >= pins->thru_src[*t].size ()) {
+					pins->thru_src[*t].resize (i->first + 1, UINT32_MAX);
+				}
+				pins->thru_src[*t][i->first] = i->second;
+				set_output_flag (pins->outputs[*t], i->first, PinTables::ThruOutput);
+			}
+		}
+
+		if (*t == DataType::MIDI && has_midi_bypass ()) {
+			set_output_flag (pins->outputs[*t], 0, PinTables::MidiBypass);
+		}
+
+		/* bypass without in-place processing passes on the thru map, and
+		 * what the plugins would if each had an internal identity map
+		 */
+		pins->bypass_src[*t].assign (_configured_out.get (*t), UINT32_MAX);
+		for (uint32_t out = 0; out < _configured_out.get (*t); ++out) {
+			pins->bypass_src[*t][out] = PinTables::src (pins->thru_src[*t], out);
+			uint32_t src_idx = pins->bypass_out_map.get_src (*t, out, &valid);
+			if (!valid) {
+				continue;
+			}
+			uint32_t in_idx = pins->bypass_in_map.get (*t, src_idx, &valid);
+			if (valid) {
+				pins->bypass_src[*t][out] = in_idx;
+			}
+		}
+	}
+}
+
+void
+PluginInsert::flush_pin_tables ()
+{
+	/* free the replaced tables, which the process thread may still be
+	 * using until we hold the process lock
+	 */
+	Glib::Threads::Mutex::Lock lm (AudioEngine::instance()->process_lock ());
+	_pin_tables.flush ();
+}
+
 bool
 PluginInsert::sanitize_maps ()
 {
@@ -1774,8 +1822,9 @@ PluginInsert::reset_map (bool emit)
 		return false;
 	}
 	if (emit) {
+		update_pin_tables ();
+		flush_pin_tables ();
 		PluginMapChanged (); /* EMIT SIGNAL */
-		_mapping_changed = true;
 		_session.set_dirty();
 	}
 	return true;
@@ -1967,8 +2016,9 @@ PluginInsert::configure_io (ChanCount in, ChanCount out)
 #endif
 	}
 
-	_no_inplace = check_inplace ();
-	_mapping_changed = false;
+	update_pin_tables ();
+	/* we are called with the process lock held, nothing uses the old tables */
+	_pin_tables.flush ();
 
 	/* only the "noinplace_buffers" thread buffers need to be this large,
 	 * this can be optimized. other buffers are fine with
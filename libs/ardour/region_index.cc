@@ -0,0 +1,180 @@
+/*
+    Copyright (C) 2018 Paul Davis
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+*/
+
+#include <algorithm>
+
+#include "ardour/region.h"
+#include "ardour/region_index.h"
+
+using namespace ARDOUR;
+
+RegionIndex::Entry::Entry (boost::shared_ptr<Region> r)
+	: first (r->first_sample ())
+	, last (r->last_sample ())
+	, region (r)
+{
+}
+
+RegionIndex::RegionIndex (RegionList::const_iterator begin, RegionList::const_iterator end)
+{
+	for (RegionList::const_iterator i = begin; i != end; ++i) {
+		_entries.push_back (Entry (*i));
+	}
+
+	/* a playlist's regions are normally sorted by position already, but not
+	 * while it is being spliced, nudged etc. A stable sort keeps the
+	 * playlist's order for regions at the same position.
+	 */
+	std::stable_sort (_entries.begin(), _entries.end(), EntrySorter ());
+
+	_max_last.resize (_entries.size ());
+	build (0, _entries.size ());
+}
+
+/** Fill in _max_last for the subtree of _entries[lo, hi)
+ *  @return the largest last sample in that subtree
+ */
+samplepos_t
+RegionIndex::build (size_t lo, size_t hi)
+{
+	if (lo >= hi) {
+		return -1;
+	}
+
+	size_t const mid = lo + (hi - lo) / 2;
+
+	samplepos_t m = _entries[mid].last;
+	m = std::max (m, build (lo, mid));
+	m = std::max (m, build (mid + 1, hi));
+
+	_max_last[mid] = m;
+	return m;
+}
+
+void
+RegionIndex::find (size_t lo, size_t hi, samplepos_t start, samplepos_t end, RegionList& result) const
+{
+	if (lo >= hi) {
+		return;
+	}
+
+	size_t const mid = lo + (hi - lo) / 2;
+
+	if (_max_last[mid] < start) {
+		/* everything in this subtree ends before the range */
+		return;
+	}
+
+	find (lo, mid, start, end, result);
+
+	if (_entries[mid].first > end) {
+		/* this and everything to its right starts after the range */
+		return;
+	}
+
+	/* use the same test as Playlist always did, on the region itself */
+	if (_entries[mid].region->coverage (start, end) != Evoral::OverlapNone) {
+		result.push_back (_entries[mid].region);
+	}
+
+	find (mid + 1, hi, start, end, result);
+}
+
+void
+RegionIndex::touched (samplepos_t start, samplepos_t end, RegionList& result) const
+{
+	find (0, _entries.size (), start, end, result);
+}
+
+/** @return index of the first entry starting at or after @a sample */
+size_t
+RegionIndex::lower_bound (samplepos_t sample) const
+{
+	size_t lo = 0;
+	size_t hi = _entries.size ();
+
+	while (lo < hi) {
+		size_t const mid = lo + (hi - lo) / 2;
+		if (_entries[mid].first < sample) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+
+	return lo;
+}
+
+/** @return index of the first entry starting after @a sample */
+size_t
+RegionIndex::upper_bound (samplepos_t sample) const
+{
+	size_t lo = 0;
+	size_t hi = _entries.size ();
+
+	while (lo < hi) {
+		size_t const mid = lo + (hi - lo) / 2;
+		if (_entries[mid].first <= sample) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+
+	return lo;
+}
+
+void
+RegionIndex::starting_within (samplepos_t start, samplepos_t end, RegionList& result) const
+{
+	for (size_t n = lower_bound (start); n < _entries.size () && _entries[n].first <= end; ++n) {
+		result.push_back (_entries[n].region);
+	}
+}
+
+boost::shared_ptr<Region>
+RegionIndex::next_start_after (samplepos_t sample) const
+{
+	size_t const n = upper_bound (sample);
+
+	if (n == _entries.size ()) {
+		return boost::shared_ptr<Region> ();
+	}
+
+	return _entries[n].region;
+}
+
+boost::shared_ptr<Region>
+RegionIndex::previous_start_before (samplepos_t sample) const
+{
+	size_t n = lower_bound (sample);
+
+	if (n == 0) {
+		return boost::shared_ptr<Region> ();
+	}
+
+	/* step back to the first of the regions at that position */
+	samplepos_t const pos = _entries[--n].first;
+
+	while (n > 0 && _entries[n - 1].first == pos) {
+		--n;
+	}
+
+	return _entries[n].region;
+}
@@ -325,6 +325,10 @@ Route::process_output_buffers (BufferSet& bufs,
 		return;
 	}
 
+	/* per route and per processor DSP time accounting, can be enabled at any time */
+	bool const collect_timing = Config->get_collect_dsp_timing ();
+	int64_t const route_start = collect_timing ? g_get_monotonic_time () : 0;
+
 	automation_run (start_sample, nframes);
 
 	/* figure out if we're going to use gain automation */
@@ -457,13 +461,23 @@ Route::process_output_buffers (BufferSet& bufs,
 		}
 
 		//cerr << name() << " run " << (*i)->name() << endl;
-		(*i)->run (bufs, start_sample - latency, end_sample - latency, speed, nframes, *i != _processors.back());
+		if (collect_timing) {
+			int64_t const start = g_get_monotonic_time ();
+			(*i)->run (bufs, start_sample - latency, end_sample - latency, speed, nframes, *i != _processors.back());
+			(*i)->timing_stats ().update (g_get_monotonic_time () - start);
+		} else {
+			(*i)->run (bufs, start_sample - latency, end_sample - latency, speed, nframes, *i != _processors.back());
+		}
 		bufs.set_count ((*i)->output_streams());
 
 		if ((*i)->active ()) {
 			latency += (*i)->signal_latency ();
 		}
 	}
+
+	if (collect_timing) {
+		_timing_stats.update (g_get_monotonic_time () - route_start);
+	}
 }
 
 void
@@ -297,11 +297,16 @@ Session::Session (AudioEngine &eng,
 	, _total_free_4k_blocks (0)
 	, _total_free_4k_blocks_uncertain (false)
 	, no_questions_about_missing_files (false)
+	, _load_phase_start (0)
 	, _playback_load (0)
 	, _capture_load (0)
 	, _bundles (new BundleList)
 	, _bundle_xml_node (0)
 	, _current_trans (0)
+	, _save_thread (0)
+	, _queued_save (0)
+	, _save_thread_busy (false)
+	, _save_thread_run (false)
 	, _clicking (false)
 	, _click_rec_only (false)
 	, click_data (0)
@@ -644,6 +649,10 @@ Session::destroy ()
 {
 	vector<void*> debug_pointers;
 
+	/* finish writing any state being saved in the background */
+
+	save_thread_terminate ();
+
 	/* if we got to here, leaving pending capture state around
 	   is a mistake.
 	*/
@@ -2500,6 +2509,23 @@ Session::resort_routes_using (boost::shared_ptr<RouteList> r)
 
 }
 
+float
+Session::critical_path_load () const
+{
+	if (!_process_graph) {
+		return 0;
+	}
+	return _process_graph->critical_path_load ();
+}
+
+void
+Session::update_critical_paths ()
+{
+	if (_process_graph) {
+		_process_graph->update_critical_paths ();
+	}
+}
+
 /** Find a route name starting with \a base, maybe followed by the
  *  lowest \a id.  \a id will always be added if \a definitely_add_number
  *  is true on entry; otherwise it will only be added if required
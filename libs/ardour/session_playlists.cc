@@ -325,40 +325,61 @@ get_id_sorted_playlists (const List& playlists, IDSortedList& id_sorted_playlist
 } // anonymous namespace
 
 void
-SessionPlaylists::add_state (XMLNode* node, bool full_state)
+SessionPlaylists::capture_state (StateSnapshot& snapshot) const
 {
-	XMLNode* child = node->add_child ("Playlists");
+	Glib::Threads::Mutex::Lock lm (lock);
 
 	IDSortedList id_sorted_playlists;
 	get_id_sorted_playlists (playlists, id_sorted_playlists);
 
 	for (IDSortedList::iterator i = id_sorted_playlists.begin (); i != id_sorted_playlists.end (); ++i) {
 		if (!(*i)->hidden ()) {
-			if (full_state) {
-				child->add_child_nocopy ((*i)->get_state ());
-			} else {
-				child->add_child_nocopy ((*i)->get_template ());
-			}
+			snapshot.playlists.push_back (*i);
 		}
 	}
 
-	child = node->add_child ("UnusedPlaylists");
-
 	IDSortedList id_sorted_unused_playlists;
 	get_id_sorted_playlists (unused_playlists, id_sorted_unused_playlists);
 
 	for (IDSortedList::iterator i = id_sorted_unused_playlists.begin ();
 	     i != id_sorted_unused_playlists.end (); ++i) {
-		if (!(*i)->hidden()) {
-			if (!(*i)->empty()) {
-				if (full_state) {
-					child->add_child_nocopy ((*i)->get_state());
-				} else {
-					child->add_child_nocopy ((*i)->get_template());
-				}
-			}
+		if (!(*i)->hidden() && !(*i)->empty()) {
+			snapshot.unused_playlists.push_back (*i);
+		}
+	}
+}
+
+/** Write the state of the playlists in @a snapshot to @a writer; this
+ *  may be called from any thread.
+ */
+void
+SessionPlaylists::add_state (XMLWriter& writer, bool full_state, StateSnapshot const & snapshot)
+{
+	typedef std::vector<boost::shared_ptr<Playlist> >::const_iterator iterator;
+
+	writer.start_element ("Playlists");
+
+	for (iterator i = snapshot.playlists.begin (); i != snapshot.playlists.end (); ++i) {
+		if (full_state) {
+			writer.add_child_nocopy ((*i)->get_state ());
+		} else {
+			writer.add_child_nocopy ((*i)->get_template ());
 		}
 	}
+
+	writer.end_element ();
+
+	writer.start_element ("UnusedPlaylists");
+
+	for (iterator i = snapshot.unused_playlists.begin (); i != snapshot.unused_playlists.end (); ++i) {
+		if (full_state) {
+			writer.add_child_nocopy ((*i)->get_state ());
+		} else {
+			writer.add_child_nocopy ((*i)->get_template ());
+		}
+	}
+
+	writer.end_element ();
 }
 
 /** @return true for `stop cleanup', otherwise false */
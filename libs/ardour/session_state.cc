@@ -64,6 +64,7 @@
 #include "evoral/SMF.hpp"
 
 #include "pbd/basename.h"
+#include "pbd/compact_memento.h"
 #include "pbd/debug.h"
 #include "pbd/enumwriter.h"
 #include "pbd/error.h"
@@ -147,6 +148,107 @@ using namespace PBD;
 
 #define DEBUG_UNDO_HISTORY(msg) DEBUG_TRACE (PBD::DEBUG::UndoHistory, string_compose ("%1: %2\n", __LINE__, msg));
 
+/** Session state captured by capture_state(), to be written by state() on
+ *  the same thread or on the background save thread.  The lists of routes,
+ *  playlists, sources and regions are copies, taken from the RCU managers or
+ *  under the appropriate lock, so that they cannot change while the state of
+ *  each object in them is written.  The smaller parts of the state are
+ *  captured as XMLNodes.
+ *
+ *  The get_state() methods of those objects may not run concurrently with
+ *  edits, so a snapshot for the background save thread is serialized into
+ *  tree by the thread which captured it, and the references to the
+ *  objects are dropped there.  The save thread only writes the tree out.
+ */
+struct Session::StateSnapshot {
+	StateSnapshot (bool f, snapshot_t t)
+		: full_state (f)
+		, snapshot_type (t)
+		, sample_rate (0)
+		, end_is_free (false)
+		, id_counter (0)
+		, name_counter (0)
+		, event_counter (0)
+		, vca_counter (0)
+		, tree (0)
+	{}
+
+	~StateSnapshot ()
+	{
+		delete tree;
+		delete_nodes (head);
+		delete_nodes (middle);
+		delete_nodes (tail);
+	}
+
+	static void delete_nodes (std::list<XMLNode*>& nodes)
+	{
+		for (std::list<XMLNode*>::iterator i = nodes.begin(); i != nodes.end(); ++i) {
+			delete *i;
+		}
+		nodes.clear ();
+	}
+
+	bool full_state;
+	snapshot_t snapshot_type;
+
+	std::string name;
+	samplecnt_t sample_rate;
+	bool end_is_free;
+	uint64_t id_counter;
+	unsigned int name_counter;
+	Evoral::event_id_t event_counter;
+	int32_t vca_counter;
+
+	/** ProgramVersion to Metadata */
+	std::list<XMLNode*> head;
+	std::vector<boost::shared_ptr<Source> > sources;
+	/** regions not used by any playlist */
+	std::vector<boost::shared_ptr<Region> > regions;
+	/** CompoundAssociations to VCAManager */
+	std::list<XMLNode*> middle;
+	std::vector<boost::shared_ptr<Route> > routes;
+	SessionPlaylists::StateSnapshot playlists;
+	/** RouteGroups onwards */
+	std::list<XMLNode*> tail;
+
+	/** the whole state, if it has been serialized by serialize() */
+	XMLNode* tree;
+
+	/** Build the whole state as a tree of XMLNodes, and drop the
+	 *  references to the session's objects.  This must be called on the
+	 *  thread which captured the snapshot.
+	 */
+	void serialize (Session& session)
+	{
+		XMLWriter writer;
+		session.state (writer, *this);
+		tree = writer.root ();
+
+		sources.clear ();
+		regions.clear ();
+		routes.clear ();
+		playlists = SessionPlaylists::StateSnapshot ();
+	}
+};
+
+/** A snapshot waiting to be written by the background save thread */
+struct Session::BackgroundSave {
+	BackgroundSave (StateSnapshot* s, std::string const & t, std::string const & x, std::string const & c)
+		: snapshot (s)
+		, tmp_path (t)
+		, xml_path (x)
+		, cache_path (c)
+	{}
+
+	~BackgroundSave () { delete snapshot; }
+
+	StateSnapshot* snapshot;
+	std::string tmp_path;
+	std::string xml_path;
+	std::string cache_path;
+};
+
 void
 Session::pre_engine_init (string fullpath)
 {
@@ -195,6 +297,7 @@ Session::pre_engine_init (string fullpath)
 	last_rr_session_dir = session_dirs.begin();
 
 	set_history_depth (Config->get_history_depth());
+	CompactMemento::set_memory_budget ((uint64_t) Config->get_history_memory_budget() * 1048576);
 
 	/* default: assume simple stereo speaker configuration */
 
@@ -222,6 +325,9 @@ Session::pre_engine_init (string fullpath)
 int
 Session::post_engine_init ()
 {
+	_load_times.clear ();
+	_load_phase_start = g_get_monotonic_time ();
+
 	BootMessage (_("Set block size and sample rate"));
 
 	set_block_size (_engine.samples_per_cycle());
@@ -289,6 +395,8 @@ Session::post_engine_init ()
 		DiskReader::allocate_working_buffers();
 		refresh_disk_space ();
 
+		load_phase_done (X_("engine setup"));
+
 		/* we're finally ready to call set_state() ... all objects have
 		 * been created, the engine is running.
 		 */
@@ -342,6 +450,8 @@ Session::post_engine_init ()
 
 		hookup_io ();
 
+		load_phase_done (X_("control protocols and connections"));
+
 		/* Let control protocols know that we are now all connected, so they
 		 * could start talking to surfaces if they want to.
 		 */
@@ -359,6 +469,8 @@ Session::post_engine_init ()
 
 		initialize_latencies ();
 
+		load_phase_done (X_("latencies"));
+
 		_locations->added.connect_same_thread (*this, boost::bind (&Session::location_added, this, _1));
 		_locations->removed.connect_same_thread (*this, boost::bind (&Session::location_removed, this, _1));
 		_locations->changed.connect_same_thread (*this, boost::bind (&Session::locations_changed, this));
@@ -413,9 +525,20 @@ Session::post_engine_init ()
 		}
 	}
 
+	load_phase_done (X_("playback buffers"));
+
 	return 0;
 }
 
+void
+Session::load_phase_done (std::string const & name)
+{
+	const gint64 now = g_get_monotonic_time ();
+	_load_times.push_back (std::make_pair (name, now - _load_phase_start));
+	DEBUG_TRACE (DEBUG::SessionLoad, string_compose ("%1 took %2 msec\n", name, (now - _load_phase_start) / 1000.0));
+	_load_phase_start = now;
+}
+
 void
 Session::session_loaded ()
 {
@@ -687,13 +810,157 @@ Session::maybe_write_autosave()
 	}
 }
 
+/** Hand @a save to the save thread, starting it if need be.  Any save which
+ *  is still waiting for the thread is superseded by this one.
+ */
+void
+Session::queue_background_save (BackgroundSave* save)
+{
+	BackgroundSave* superseded;
+
+	{
+		Glib::Threads::Mutex::Lock lm (_save_thread_lock);
+
+		if (!_save_thread) {
+			_save_thread_run = true;
+			_save_thread = Glib::Threads::Thread::create (boost::bind (&Session::save_thread_run, this));
+		}
+
+		superseded = _queued_save;
+		_queued_save = save;
+
+		_save_thread_cond.signal ();
+	}
+
+	delete superseded;
+	reap_background_saves ();
+}
+
+/** Delete the saves which the save thread has finished writing.  Never
+ *  called by the save thread; the snapshots are deleted without holding
+ *  _save_thread_lock.
+ */
+void
+Session::reap_background_saves ()
+{
+	std::list<BackgroundSave*> finished;
+
+	{
+		Glib::Threads::Mutex::Lock lm (_save_thread_lock);
+		finished.swap (_finished_saves);
+	}
+
+	for (std::list<BackgroundSave*>::iterator i = finished.begin(); i != finished.end(); ++i) {
+		delete *i;
+	}
+}
+
+void
+Session::save_thread_run ()
+{
+	pthread_set_name (X_("save"));
+
+	Glib::Threads::Mutex::Lock lm (_save_thread_lock);
+
+	while (true) {
+
+		while (_save_thread_run && !_queued_save) {
+			_save_thread_cond.wait (_save_thread_lock);
+		}
+
+		if (!_save_thread_run) {
+			break;
+		}
+
+		BackgroundSave* save = _queued_save;
+		_queued_save = 0;
+		_save_thread_busy = true;
+		lm.release ();
+
+#ifndef NDEBUG
+		const int64_t save_start_time = g_get_monotonic_time();
+#endif
+
+		cerr << "actually writing state to " << save->tmp_path << " in the background" << endl;
+
+		install_state_file (write_state (save->tmp_path, *save->snapshot, save->cache_path), save->tmp_path, save->xml_path);
+
+#ifndef NDEBUG
+		const int64_t elapsed_time_us = g_get_monotonic_time() - save_start_time;
+		cerr << "saved state in the background in " << fixed << setprecision (1) << elapsed_time_us / 1000. << " ms\n";
+#endif
+
+		lm.acquire ();
+		/* leave the save to be deleted by a thread which queues or
+		 * waits for saves, see reap_background_saves()
+		 */
+		_finished_saves.push_back (save);
+		_save_thread_busy = false;
+		_save_thread_cond.broadcast ();
+	}
+}
+
+/** Drop any save which is waiting for the save thread, and wait for the one
+ *  which it is writing, if any, to finish.
+ */
+void
+Session::wait_for_background_save ()
+{
+	BackgroundSave* dropped;
+
+	{
+		Glib::Threads::Mutex::Lock lm (_save_thread_lock);
+
+		dropped = _queued_save;
+		_queued_save = 0;
+
+		while (_save_thread_busy) {
+			_save_thread_cond.wait (_save_thread_lock);
+		}
+	}
+
+	delete dropped;
+	reap_background_saves ();
+}
+
+void
+Session::save_thread_terminate ()
+{
+	{
+		Glib::Threads::Mutex::Lock lm (_save_thread_lock);
+
+		if (!_save_thread) {
+			return;
+		}
+
+		delete _queued_save;
+		_queued_save = 0;
+
+		_save_thread_run = false;
+		_save_thread_cond.broadcast ();
+	}
+
+	_save_thread->join ();
+	_save_thread = 0;
+
+	reap_background_saves ();
+}
+
 void
 Session::remove_pending_capture_state ()
 {
+	/* don't let a background save write the pending state after it
+	 * has been removed.
+	 */
+	wait_for_background_save ();
+
 	std::string pending_state_file_path(_session_dir->root_path());
 
 	pending_state_file_path = Glib::build_filename (pending_state_file_path, legalize_for_path (_current_snapshot_name) + pending_suffix);
 
+	/* the cache is useless without the state, and may not exist */
+	g_remove ((pending_state_file_path + state_cache_suffix).c_str());
+
 	if (!Glib::file_test (pending_state_file_path, Glib::FILE_TEST_EXISTS)) return;
 
 	if (g_remove (pending_state_file_path.c_str()) != 0) {
@@ -723,7 +990,11 @@ Session::rename_state (string old_name, string new_name)
 	if (::g_rename (old_xml_path.c_str(), new_xml_path.c_str()) != 0) {
 		error << string_compose(_("could not rename snapshot %1 to %2 (%3)"),
 				old_name, new_name, g_strerror(errno)) << endmsg;
+		return;
 	}
+
+	/* the cache remains valid for the renamed state, if there is one */
+	::g_rename ((old_xml_path + state_cache_suffix).c_str(), (new_xml_path + state_cache_suffix).c_str());
 }
 
 /** Remove a state file.
@@ -752,6 +1023,8 @@ Session::remove_state (string snapshot_name)
 		error << string_compose(_("Could not remove session file at path \"%1\" (%2)"),
 				xml_path, g_strerror (errno)) << endmsg;
 	}
+
+	g_remove ((xml_path + state_cache_suffix).c_str());
 }
 
 /** @param snapshot_name Name to save under, without .ardour / .pending prefix */
@@ -808,8 +1081,6 @@ Session::save_state (string snapshot_name, bool pending, bool switch_to_snapshot
 	if (template_only) {
 		mark_as_clean = false;
 		tree.set_root (&get_template());
-	} else {
-		tree.set_root (&state (true, fork_state));
 	}
 
 	if (snapshot_name.empty()) {
@@ -839,32 +1110,35 @@ Session::save_state (string snapshot_name, bool pending, bool switch_to_snapshot
 		xml_path = Glib::build_filename (xml_path, legalize_for_path (snapshot_name) + pending_suffix);
 	}
 
+	if (pending && !template_only && Config->get_save_pending_state_in_background ()) {
+		/* serialize the state here, and leave the save thread to
+		 * write it out, so that we need not wait for the disk.
+		 */
+		StateSnapshot* snapshot = new StateSnapshot (true, NormalSave);
+		capture_state (*snapshot);
+		snapshot->serialize (*this);
+		queue_background_save (new BackgroundSave (snapshot, xml_path + temp_suffix, xml_path, state_cache_path (xml_path)));
+		return 0;
+	}
+
 	std::string tmp_path(_session_dir->root_path());
 	tmp_path = Glib::build_filename (tmp_path, legalize_for_path (snapshot_name) + temp_suffix);
 
 	cerr << "actually writing state to " << tmp_path << endl;
 
-	if (!tree.write (tmp_path)) {
-		error << string_compose (_("state could not be saved to %1"), tmp_path) << endmsg;
-		if (g_remove (tmp_path.c_str()) != 0) {
-			error << string_compose(_("Could not remove temporary session file at path \"%1\" (%2)"),
-					tmp_path, g_strerror (errno)) << endmsg;
-		}
-		return -1;
+	bool written;
 
+	if (template_only) {
+		written = tree.write (tmp_path);
 	} else {
+		/* the full state is written as it is generated, rather than
+		 * building it all as a tree of XMLNodes first.
+		 */
+		written = write_state (tmp_path, fork_state, state_cache_path (xml_path));
+	}
 
-		cerr << "renaming state to " << xml_path << endl;
-
-		if (::g_rename (tmp_path.c_str(), xml_path.c_str()) != 0) {
-			error << string_compose (_("could not rename temporary session file %1 to %2 (%3)"),
-					tmp_path, xml_path, g_strerror(errno)) << endmsg;
-			if (g_remove (tmp_path.c_str()) != 0) {
-				error << string_compose(_("Could not remove temporary session file at path \"%1\" (%2)"),
-						tmp_path, g_strerror (errno)) << endmsg;
-			}
-			return -1;
-		}
+	if (install_state_file (written, tmp_path, xml_path)) {
+		return -1;
 	}
 
 	if (!pending) {
@@ -948,7 +1222,11 @@ Session::load_state (string snapshot_name)
 
 	_writable = exists_and_writable (xmlpath) && exists_and_writable(Glib::path_get_dirname(xmlpath));
 
-	if (!state_tree->read (xmlpath)) {
+	const std::string cache_path = state_cache_path (xmlpath);
+
+	if (!cache_path.empty() && state_tree->read_cache (xmlpath, cache_path)) {
+		DEBUG_TRACE (DEBUG::SessionLoad, string_compose ("read session state from %1\n", cache_path));
+	} else if (!state_tree->read (xmlpath)) {
 		error << string_compose(_("Could not understand session file %1"), xmlpath) << endmsg;
 		delete state_tree;
 		state_tree = 0;
@@ -1113,28 +1391,155 @@ struct route_id_compare {
 };
 } // anon namespace
 
+/** Write the full state of the session to the file at @a path.
+ *  @param cache_path If not empty, also write a binary cache of the state
+ *  to this file.
+ *  @return true on success.
+ */
+bool
+Session::write_state (const std::string& path, snapshot_t snapshot_type, std::string const & cache_path)
+{
+	StateSnapshot snapshot (true, snapshot_type);
+	capture_state (snapshot);
+	return write_state (path, snapshot, cache_path);
+}
+
+/** Write the state in @a snapshot to the file at @a path, and a binary
+ *  cache of it to @a cache_path if that is not empty; see state() for
+ *  the threads this may be called from.
+ *  @return true on success.  Failing to write the cache is not an error,
+ *  since the XML will be read if the cache is not valid for it.
+ */
+bool
+Session::write_state (const std::string& path, StateSnapshot& snapshot, std::string const & cache_path)
+{
+	FILE* f = g_fopen (path.c_str(), "wb");
+
+	if (!f) {
+		error << string_compose (_("cannot open %1 for writing (%2)"), path, g_strerror (errno)) << endmsg;
+		return false;
+	}
+
+	std::vector<char> buffer (1 << 16);
+	setvbuf (f, &buffer[0], _IOFBF, buffer.size());
+
+	FILE* cache = 0;
+	std::vector<char> cache_buffer;
+
+	if (!cache_path.empty ()) {
+		if ((cache = g_fopen (cache_path.c_str(), "wb")) != 0) {
+			cache_buffer.resize (1 << 16);
+			setvbuf (cache, &cache_buffer[0], _IOFBF, cache_buffer.size());
+		} else {
+			warning << string_compose (_("cannot open %1 for writing (%2)"), cache_path, g_strerror (errno)) << endmsg;
+		}
+	}
+
+	bool ok;
+
+	{
+		XMLWriter writer (f, cache);
+		state (writer, snapshot);
+		ok = writer.good ();
+	}
+
+	if (cache && fclose (cache) != 0) {
+		warning << string_compose (_("could not write session state cache to %1 (%2)"), cache_path, g_strerror (errno)) << endmsg;
+		g_remove (cache_path.c_str());
+	}
+
+	if (fclose (f) != 0 || !ok) {
+		error << string_compose (_("could not write session state to %1 (%2)"), path, g_strerror (errno)) << endmsg;
+		return false;
+	}
+
+	return true;
+}
+
+/** @return the path of the binary cache of the state file at @a xml_path,
+ *  or an empty string if state caches are not in use.
+ */
+std::string
+Session::state_cache_path (std::string const & xml_path) const
+{
+	if (!Config->get_use_state_cache ()) {
+		return std::string ();
+	}
+	return xml_path + state_cache_suffix;
+}
+
+/** Move the state file written to @a tmp_path into place at @a xml_path,
+ *  or remove it if it could not be @a written.
+ *  @return 0 on success, otherwise -1.
+ */
+int
+Session::install_state_file (bool written, std::string const & tmp_path, std::string const & xml_path)
+{
+	if (!written) {
+		error << string_compose (_("state could not be saved to %1"), tmp_path) << endmsg;
+		if (g_remove (tmp_path.c_str()) != 0) {
+			error << string_compose(_("Could not remove temporary session file at path \"%1\" (%2)"),
+					tmp_path, g_strerror (errno)) << endmsg;
+		}
+		return -1;
+	}
+
+	cerr << "renaming state to " << xml_path << endl;
+
+	if (::g_rename (tmp_path.c_str(), xml_path.c_str()) != 0) {
+		error << string_compose (_("could not rename temporary session file %1 to %2 (%3)"),
+				tmp_path, xml_path, g_strerror(errno)) << endmsg;
+		if (g_remove (tmp_path.c_str()) != 0) {
+			error << string_compose(_("Could not remove temporary session file at path \"%1\" (%2)"),
+					tmp_path, g_strerror (errno)) << endmsg;
+		}
+		return -1;
+	}
+
+	return 0;
+}
+
 XMLNode&
 Session::state (bool full_state, snapshot_t snapshot_type)
+{
+	StateSnapshot snapshot (full_state, snapshot_type);
+	capture_state (snapshot);
+
+	XMLWriter writer;
+	state (writer, snapshot);
+	return *writer.root ();
+}
+
+/** Capture everything that state() needs to write the session's state.
+ *  This must be called from the thread which asked for the save, with
+ *  save_state_lock held if the state is to be written to a file.
+ */
+void
+Session::capture_state (StateSnapshot& snapshot)
 {
 	LocaleGuard lg;
-	XMLNode* node = new XMLNode("Session");
-	XMLNode* child;
 
-	node->set_property("version", CURRENT_SESSION_FILE_VERSION);
+	const bool full_state = snapshot.full_state;
 
-	child = node->add_child ("ProgramVersion");
-	child->set_property("created-with", created_with);
+	snapshot.name = _name;
+	snapshot.sample_rate = _base_sample_rate;
+	snapshot.end_is_free = _session_range_end_is_free;
+	snapshot.id_counter = ID::counter();
+	snapshot.name_counter = name_id_counter ();
+	snapshot.event_counter = Evoral::event_id_counter();
+	snapshot.vca_counter = VCA::get_next_vca_number();
+
+	XMLNode* node = new XMLNode ("ProgramVersion");
+	node->set_property("created-with", created_with);
 
 	std::string modified_with = string_compose ("%1 %2", PROGRAM_NAME, revision);
-	child->set_property("modified-with", modified_with);
+	node->set_property("modified-with", modified_with);
+	snapshot.head.push_back (node);
 
 	/* store configuration settings */
 
 	if (full_state) {
 
-		node->set_property ("name", _name);
-		node->set_property ("sample-rate", _base_sample_rate);
-
 		if (session_dirs.size() > 1) {
 
 			string p;
@@ -1160,35 +1565,21 @@ Session::state (bool full_state, snapshot_t snapshot_type)
 				++i;
 			}
 
-			child = node->add_child ("Path");
-			child->add_content (p);
+			node = new XMLNode ("Path");
+			node->add_content (p);
+			snapshot.head.push_back (node);
 		}
-		node->set_property ("end-is-free", _session_range_end_is_free);
 	}
 
-	/* save the ID counter */
-
-	node->set_property ("id-counter", ID::counter());
-
-	node->set_property ("name-counter", name_id_counter ());
-
-	/* save the event ID counter */
-
-	node->set_property ("event-counter", Evoral::event_id_counter());
-
-	/* save the VCA counter */
-
-	node->set_property ("vca-counter", VCA::get_next_vca_number());
-
 	/* various options */
 
 	list<XMLNode*> midi_port_nodes = _midi_ports->get_midi_port_states();
 	if (!midi_port_nodes.empty()) {
-		XMLNode* midi_port_stuff = new XMLNode ("MIDIPorts");
+		node = new XMLNode ("MIDIPorts");
 		for (list<XMLNode*>::const_iterator n = midi_port_nodes.begin(); n != midi_port_nodes.end(); ++n) {
-			midi_port_stuff->add_child_nocopy (**n);
+			node->add_child_nocopy (**n);
 		}
-		node->add_child_nocopy (*midi_port_stuff);
+		snapshot.head.push_back (node);
 	}
 
 	XMLNode& cfgxml (config.get_variables ());
@@ -1198,11 +1589,9 @@ Session::state (bool full_state, snapshot_t snapshot_type)
 		cfgxml.remove_nodes_and_delete ("name", "midi-search-path");
 		cfgxml.remove_nodes_and_delete ("name", "raid-path");
 	}
-	node->add_child_nocopy (cfgxml);
+	snapshot.head.push_back (&cfgxml);
 
-	node->add_child_nocopy (ARDOUR::SessionMetadata::Metadata()->get_state());
-
-	child = node->add_child ("Sources");
+	snapshot.head.push_back (&ARDOUR::SessionMetadata::Metadata()->get_state());
 
 	if (full_state) {
 		Glib::Threads::Mutex::Lock sl (source_lock);
@@ -1225,108 +1614,42 @@ Session::state (bool full_state, snapshot_t snapshot_type)
 				}
 			}
 
-			if (snapshot_type != NormalSave && fs->within_session ()) {
-				/* copy MIDI sources to new file
-				 *
-				 * We cannot replace the midi-source and MidiRegion::clobber_sources,
-				 * because the GUI (midi_region) has a direct pointer to the midi-model
-				 * of the source, as does UndoTransaction.
-				 *
-				 * On the upside, .mid files are not kept open. The file is only open
-				 * when reading the model initially and when flushing the model to disk:
-				 * source->session_saved () or export.
-				 *
-				 * We can change the _path of the existing source under the hood, keeping
-				 * all IDs, references and pointers intact.
-				 * */
-				boost::shared_ptr<SMFSource> ms;
-				if ((ms = boost::dynamic_pointer_cast<SMFSource> (siter->second)) != 0) {
-					const std::string ancestor_name = ms->ancestor_name();
-					const std::string base          = PBD::basename_nosuffix(ancestor_name);
-					const string path               = new_midi_source_path (base, false);
-
-					/* use SMF-API to clone data (use the midi_model, not data on disk) */
-					boost::shared_ptr<SMFSource> newsrc (new SMFSource (*this, path, SndFileSource::default_writable_flags));
-					Source::Lock lm (ms->mutex());
-
-					// TODO special-case empty, removable() files: just create a new removable.
-					// (load + write flushes the model and creates the file)
-					if (!ms->model()) {
-						ms->load_model (lm);
-					}
-					if (ms->write_to (lm, newsrc, Evoral::Beats(), std::numeric_limits<Evoral::Beats>::max())) {
-						error << string_compose (_("Session-Save: Failed to copy MIDI Source '%1' for snapshot"), ancestor_name) << endmsg;
-					} else {
-						if (snapshot_type == SnapshotKeep) {
-							/* keep working on current session.
-							 *
-							 * Save snapshot-state with the original filename.
-							 * Switch to use new path for future saves of the main session.
-							 */
-							child->add_child_nocopy (ms->get_state());
-						}
-
-						/* swap file-paths.
-						 * ~SMFSource  unlinks removable() files.
-						 */
-						std::string npath (ms->path ());
-						ms->replace_file (newsrc->path ());
-						newsrc->replace_file (npath);
-
-						if (snapshot_type == SwitchToSnapshot) {
-							/* save and switch to snapshot.
-							 *
-							 * Leave the old file in place (as is).
-							 * Snapshot uses new source directly
-							 */
-							child->add_child_nocopy (ms->get_state());
-						}
-						continue;
-					}
-				}
-			}
-
-			child->add_child_nocopy (siter->second->get_state());
+			snapshot.sources.push_back (siter->second);
 		}
 	}
 
-	child = node->add_child ("Regions");
-
 	if (full_state) {
 		Glib::Threads::Mutex::Lock rl (region_lock);
 		const RegionFactory::RegionMap& region_map (RegionFactory::all_regions());
 		for (RegionFactory::RegionMap::const_iterator i = region_map.begin(); i != region_map.end(); ++i) {
-			boost::shared_ptr<Region> r = i->second;
 			/* only store regions not attached to playlists */
-			if (r->playlist() == 0) {
-				if (boost::dynamic_pointer_cast<AudioRegion>(r)) {
-					child->add_child_nocopy ((boost::dynamic_pointer_cast<AudioRegion>(r))->get_basic_state ());
-				} else {
-					child->add_child_nocopy (r->get_state ());
-				}
+			if (i->second->playlist() == 0) {
+				snapshot.regions.push_back (i->second);
 			}
 		}
 
 		RegionFactory::CompoundAssociations& cassocs (RegionFactory::compound_associations());
 
 		if (!cassocs.empty()) {
-			XMLNode* ca = node->add_child (X_("CompoundAssociations"));
+			node = new XMLNode (X_("CompoundAssociations"));
 
 			for (RegionFactory::CompoundAssociations::iterator i = cassocs.begin(); i != cassocs.end(); ++i) {
 				XMLNode* can = new XMLNode (X_("CompoundAssociation"));
 				can->set_property (X_("copy"), i->first->id());
 				can->set_property (X_("original"), i->second->id());
-				ca->add_child_nocopy (*can);
+				node->add_child_nocopy (*can);
 			}
+
+			snapshot.middle.push_back (node);
 		}
 	}
 
 	if (full_state) {
 
-		node->add_child_nocopy (_selection->get_state());
+		snapshot.middle.push_back (&_selection->get_state());
 
 		if (_locations) {
-			node->add_child_nocopy (_locations->get_state());
+			snapshot.middle.push_back (&_locations->get_state());
 		}
 	} else {
 		Locations loc (*this);
@@ -1346,7 +1669,7 @@ Session::state (bool full_state, snapshot_t snapshot_type)
 				}
 			}
 		}
-		node->add_child_nocopy (locations_state);
+		snapshot.middle.push_back (&locations_state);
 
 		/* adding a location above will have marked the session
 		 * dirty. This is an artifact, so fix it if the session wasn't
@@ -1358,20 +1681,20 @@ Session::state (bool full_state, snapshot_t snapshot_type)
 		}
 	}
 
-	child = node->add_child ("Bundles");
+	node = new XMLNode ("Bundles");
 	{
 		boost::shared_ptr<BundleList> bundles = _bundles.reader ();
 		for (BundleList::iterator i = bundles->begin(); i != bundles->end(); ++i) {
 			boost::shared_ptr<UserBundle> b = boost::dynamic_pointer_cast<UserBundle> (*i);
 			if (b) {
-				child->add_child_nocopy (b->get_state());
+				node->add_child_nocopy (b->get_state());
 			}
 		}
 	}
+	snapshot.middle.push_back (node);
 
-	node->add_child_nocopy (_vca_manager->get_state());
+	snapshot.middle.push_back (&_vca_manager->get_state());
 
-	child = node->add_child ("Routes");
 	{
 		boost::shared_ptr<RouteList> r = routes.reader ();
 
@@ -1381,44 +1704,44 @@ Session::state (bool full_state, snapshot_t snapshot_type)
 
 		for (RouteList::const_iterator i = xml_node_order.begin(); i != xml_node_order.end(); ++i) {
 			if (!(*i)->is_auditioner()) {
-				if (full_state) {
-					child->add_child_nocopy ((*i)->get_state());
-				} else {
-					child->add_child_nocopy ((*i)->get_template());
-				}
+				snapshot.routes.push_back (*i);
 			}
 		}
 	}
 
-	playlists->add_state (node, full_state);
+	playlists->capture_state (snapshot.playlists);
 
-	child = node->add_child ("RouteGroups");
+	node = new XMLNode ("RouteGroups");
 	for (list<RouteGroup *>::iterator i = _route_groups.begin(); i != _route_groups.end(); ++i) {
-		child->add_child_nocopy ((*i)->get_state());
+		node->add_child_nocopy ((*i)->get_state());
 	}
+	snapshot.tail.push_back (node);
 
 	if (_click_io) {
-		XMLNode* gain_child = node->add_child ("Click");
-		gain_child->add_child_nocopy (_click_io->state (full_state));
-		gain_child->add_child_nocopy (_click_gain->state (full_state));
+		node = new XMLNode ("Click");
+		node->add_child_nocopy (_click_io->state (full_state));
+		node->add_child_nocopy (_click_gain->state (full_state));
+		snapshot.tail.push_back (node);
 	}
 
 	if (_ltc_input) {
-		XMLNode* ltc_input_child = node->add_child ("LTC-In");
-		ltc_input_child->add_child_nocopy (_ltc_input->state (full_state));
+		node = new XMLNode ("LTC-In");
+		node->add_child_nocopy (_ltc_input->state (full_state));
+		snapshot.tail.push_back (node);
 	}
 
 	if (_ltc_input) {
-		XMLNode* ltc_output_child = node->add_child ("LTC-Out");
-		ltc_output_child->add_child_nocopy (_ltc_output->state (full_state));
+		node = new XMLNode ("LTC-Out");
+		node->add_child_nocopy (_ltc_output->state (full_state));
+		snapshot.tail.push_back (node);
 	}
 
-	node->add_child_nocopy (_speakers->get_state());
-	node->add_child_nocopy (_tempo_map->get_state());
-	node->add_child_nocopy (get_control_protocol_state());
+	snapshot.tail.push_back (&_speakers->get_state());
+	snapshot.tail.push_back (&_tempo_map->get_state());
+	snapshot.tail.push_back (&get_control_protocol_state());
 
 	if (_extra_xml) {
-		node->add_child_copy (*_extra_xml);
+		snapshot.tail.push_back (new XMLNode (*_extra_xml));
 	}
 
 	{
@@ -1438,10 +1761,172 @@ Session::state (bool full_state, snapshot_t snapshot_type)
 		XMLNode* script_node = new XMLNode (X_("Script"));
 		script_node->set_property (X_("lua"), LUA_VERSION);
 		script_node->add_content (b64s);
-		node->add_child_nocopy (*script_node);
+		snapshot.tail.push_back (script_node);
 	}
+}
 
-	return *node;
+static void
+add_nodes (XMLWriter& writer, std::list<XMLNode*>& nodes)
+{
+	for (std::list<XMLNode*>::iterator i = nodes.begin(); i != nodes.end(); ++i) {
+		writer.add_child_nocopy (**i);
+	}
+	nodes.clear ();
+}
+
+/** Write the session's state in @a snapshot to @a writer, one object at a
+ *  time, so that it need never all be in memory at once when writing to a
+ *  file.  The nodes in the snapshot are handed over to @a writer.  Only a
+ *  snapshot which has been serialized may be written by another thread
+ *  than the one which captured it.
+ */
+void
+Session::state (XMLWriter& writer, StateSnapshot& snapshot)
+{
+	if (snapshot.tree) {
+		writer.add_child_nocopy (*snapshot.tree);
+		snapshot.tree = 0;
+		return;
+	}
+
+	LocaleGuard lg;
+
+	const bool full_state = snapshot.full_state;
+
+	writer.start_element ("Session");
+
+	/* all properties of the Session node must be set before its
+	 * children are added.
+	 */
+
+	writer.set_property("version", CURRENT_SESSION_FILE_VERSION);
+
+	if (full_state) {
+		writer.set_property ("name", snapshot.name);
+		writer.set_property ("sample-rate", snapshot.sample_rate);
+		writer.set_property ("end-is-free", snapshot.end_is_free);
+	}
+
+	/* save the ID counter */
+
+	writer.set_property ("id-counter", snapshot.id_counter);
+
+	writer.set_property ("name-counter", snapshot.name_counter);
+
+	/* save the event ID counter */
+
+	writer.set_property ("event-counter", snapshot.event_counter);
+
+	/* save the VCA counter */
+
+	writer.set_property ("vca-counter", snapshot.vca_counter);
+
+	add_nodes (writer, snapshot.head);
+
+	writer.start_element ("Sources");
+
+	for (vector<boost::shared_ptr<Source> >::iterator siter = snapshot.sources.begin(); siter != snapshot.sources.end(); ++siter) {
+
+		boost::shared_ptr<FileSource> fs = boost::dynamic_pointer_cast<FileSource> (*siter);
+
+		if (snapshot.snapshot_type != NormalSave && fs->within_session ()) {
+			/* copy MIDI sources to new file
+			 *
+			 * We cannot replace the midi-source and MidiRegion::clobber_sources,
+			 * because the GUI (midi_region) has a direct pointer to the midi-model
+			 * of the source, as does UndoTransaction.
+			 *
+			 * On the upside, .mid files are not kept open. The file is only open
+			 * when reading the model initially and when flushing the model to disk:
+			 * source->session_saved () or export.
+			 *
+			 * We can change the _path of the existing source under the hood, keeping
+			 * all IDs, references and pointers intact.
+			 * */
+			boost::shared_ptr<SMFSource> ms;
+			if ((ms = boost::dynamic_pointer_cast<SMFSource> (*siter)) != 0) {
+				const std::string ancestor_name = ms->ancestor_name();
+				const std::string base          = PBD::basename_nosuffix(ancestor_name);
+				const string path               = new_midi_source_path (base, false);
+
+				/* use SMF-API to clone data (use the midi_model, not data on disk) */
+				boost::shared_ptr<SMFSource> newsrc (new SMFSource (*this, path, SndFileSource::default_writable_flags));
+				Source::Lock lm (ms->mutex());
+
+				// TODO special-case empty, removable() files: just create a new removable.
+				// (load + write flushes the model and creates the file)
+				if (!ms->model()) {
+					ms->load_model (lm);
+				}
+				if (ms->write_to (lm, newsrc, Evoral::Beats(), std::numeric_limits<Evoral::Beats>::max())) {
+					error << string_compose (_("Session-Save: Failed to copy MIDI Source '%1' for snapshot"), ancestor_name) << endmsg;
+				} else {
+					if (snapshot.snapshot_type == SnapshotKeep) {
+						/* keep working on current session.
+						 *
+						 * Save snapshot-state with the original filename.
+						 * Switch to use new path for future saves of the main session.
+						 */
+						writer.add_child_nocopy (ms->get_state());
+					}
+
+					/* swap file-paths.
+					 * ~SMFSource  unlinks removable() files.
+					 */
+					std::string npath (ms->path ());
+					ms->replace_file (newsrc->path ());
+					newsrc->replace_file (npath);
+
+					if (snapshot.snapshot_type == SwitchToSnapshot) {
+						/* save and switch to snapshot.
+						 *
+						 * Leave the old file in place (as is).
+						 * Snapshot uses new source directly
+						 */
+						writer.add_child_nocopy (ms->get_state());
+					}
+					continue;
+				}
+			}
+		}
+
+		writer.add_child_nocopy ((*siter)->get_state());
+	}
+
+	writer.end_element ();
+
+	writer.start_element ("Regions");
+
+	for (vector<boost::shared_ptr<Region> >::iterator i = snapshot.regions.begin(); i != snapshot.regions.end(); ++i) {
+		boost::shared_ptr<AudioRegion> ar = boost::dynamic_pointer_cast<AudioRegion> (*i);
+		if (ar) {
+			writer.add_child_nocopy (ar->get_basic_state ());
+		} else {
+			writer.add_child_nocopy ((*i)->get_state ());
+		}
+	}
+
+	writer.end_element ();
+
+	add_nodes (writer, snapshot.middle);
+
+	writer.start_element ("Routes");
+
+	for (vector<boost::shared_ptr<Route> >::iterator i = snapshot.routes.begin(); i != snapshot.routes.end(); ++i) {
+		if (full_state) {
+			writer.add_child_nocopy ((*i)->get_state());
+		} else {
+			writer.add_child_nocopy ((*i)->get_template());
+		}
+	}
+
+	writer.end_element ();
+
+	SessionPlaylists::add_state (writer, full_state, snapshot.playlists);
+
+	add_nodes (writer, snapshot.tail);
+
+	writer.end_element ();
 }
 
 XMLNode&
@@ -1460,6 +1945,7 @@ Session::set_state (const XMLNode& node, int version)
 	int ret = -1;
 
 	_state_of_the_state = StateOfTheState (_state_of_the_state|CannotSave);
+	_load_phase_start = g_get_monotonic_time ();
 
 	if (node.name() != X_("Session")) {
 		fatal << _("programming error: Session: incorrect XML node sent to set_state()") << endmsg;
@@ -1545,6 +2031,8 @@ Session::set_state (const XMLNode& node, int version)
 		_speakers->set_state (*child, version);
 	}
 
+	load_phase_done (X_("options"));
+
 	if ((child = find_named_node (node, "Sources")) == 0) {
 		error << _("Session: XML state has no sources section") << endmsg;
 		goto out;
@@ -1552,6 +2040,8 @@ Session::set_state (const XMLNode& node, int version)
 		goto out;
 	}
 
+	load_phase_done (X_("sources"));
+
 	if ((child = find_named_node (node, "TempoMap")) == 0) {
 		error << _("Session: XML state has no Tempo Map section") << endmsg;
 		goto out;
@@ -1572,6 +2062,8 @@ Session::set_state (const XMLNode& node, int version)
 		AudioFileSource::set_header_position_offset (_session_range_location->start());
 	}
 
+	load_phase_done (X_("tempo map and locations"));
+
 	if ((child = find_named_node (node, "Regions")) == 0) {
 		error << _("Session: XML state has no Regions section") << endmsg;
 		goto out;
@@ -1579,6 +2071,8 @@ Session::set_state (const XMLNode& node, int version)
 		goto out;
 	}
 
+	load_phase_done (X_("regions"));
+
 	if ((child = find_named_node (node, "Playlists")) == 0) {
 		error << _("Session: XML state has no playlists section") << endmsg;
 		goto out;
@@ -1598,6 +2092,8 @@ Session::set_state (const XMLNode& node, int version)
 		}
 	}
 
+	load_phase_done (X_("playlists"));
+
 	if (version >= 3000) {
 		if ((child = find_named_node (node, "Bundles")) == 0) {
 			warning << _("Session: XML state has no bundles section") << endmsg;
@@ -1621,6 +2117,8 @@ Session::set_state (const XMLNode& node, int version)
 		goto out;
 	}
 
+	load_phase_done (X_("routes"));
+
 	/* Now that we have Routes and masters loaded, connect them if appropriate */
 
 	Slavable::Assign (_vca_manager); /* EMIT SIGNAL */
@@ -1682,6 +2180,8 @@ Session::set_state (const XMLNode& node, int version)
 
 	update_route_record_state ();
 
+	load_phase_done (X_("route groups and other state"));
+
 	/* here beginneth the second phase ... */
 	set_snapshot_name (_current_snapshot_name);
 
@@ -2256,11 +2756,42 @@ Session::load_sources (const XMLNode& node)
 	set_dirty();
 	std::map<std::string, std::string> relocation;
 
-	for (niter = nlist.begin(); niter != nlist.end(); ++niter) {
+	/* Opening files is most of the work for audio sources, and does not
+	 * need this thread, so do that for all of them at once in parallel.
+	 * They are set up and added to the session below, in the same
+	 * order as the other sources. Any that could not be opened (or
+	 * found) are created in the usual way, which may ask the user.
+	 */
+
+	std::vector<XMLNode const *> nodes (nlist.begin(), nlist.end());
+	std::vector<boost::shared_ptr<Source> > opened;
+
+	{
+#ifdef PLATFORM_WINDOWS
+		int old_mode = SetErrorMode(SEM_FAILCRITICALERRORS);
+#endif
+		SourceFactory::open (*this, nodes, opened);
+#ifdef PLATFORM_WINDOWS
+		SetErrorMode(old_mode);
+#endif
+	}
+
+	std::vector<boost::shared_ptr<Source> >::iterator op = opened.begin();
+
+	for (niter = nlist.begin(); niter != nlist.end(); ++niter, ++op) {
 #ifdef PLATFORM_WINDOWS
 		int old_mode = 0;
 #endif
 
+		if (*op) {
+			/* note: do peak building in another thread when loading session state */
+			if (SourceFactory::announce (*op, true)) {
+				error << _("Session: cannot create Source from XML description.") << endmsg;
+			}
+			op->reset ();
+			continue;
+		}
+
 		XMLNode srcnode (**niter);
 		bool try_replace_abspath = true;
 
@@ -3231,7 +3762,7 @@ Session::cleanup_peakfiles ()
 	_state_of_the_state = StateOfTheState (_state_of_the_state | PeakCleanup);
 
 	int timeout = 5000; // 5 seconds
-	while (!SourceFactory::files_with_peaks.empty()) {
+	while (SourceFactory::peak_work_queue_length () > 0) {
 		Glib::usleep (1000);
 		if (--timeout < 0) {
 			warning << _("Timeout waiting for peak-file creation to terminate before cleanup, please try again later.") << endmsg;
@@ -4178,6 +4709,8 @@ Session::config_changed (std::string p, bool ours)
 		setup_fpu ();
 	} else if (p == "history-depth") {
 		set_history_depth (Config->get_history_depth());
+	} else if (p == "history-memory-budget") {
+		CompactMemento::set_memory_budget ((uint64_t) Config->get_history_memory_budget() * 1048576);
 	} else if (p == "remote-model") {
 		/* XXX DO SOMETHING HERE TO TELL THE GUI THAT WE NEED
 		   TO SET REMOTE ID'S
@@ -36,6 +36,7 @@
 #include <glibmm/fileutils.h>
 #include <glibmm/miscutils.h>
 
+#include "ardour/rc_configuration.h"
 #include "ardour/runtime_functions.h"
 #include "ardour/sndfilesource.h"
 #include "ardour/sndfile_helpers.h"
@@ -63,6 +64,7 @@ SndFileSource::SndFileSource (Session& s, const XMLNode& node)
 	, AudioFileSource (s, node)
 	, _sndfile (0)
 	, _broadcast_info (0)
+	, _map_attempted (false)
 	, _capture_start (false)
 	, _capture_end (false)
 	, file_pos (0)
@@ -87,6 +89,7 @@ SndFileSource::SndFileSource (Session& s, const string& path, int chn, Flag flag
 	, AudioFileSource (s, path, Flag (flags & ~(Writable|Removable|RemovableIfEmpty|RemoveAtDestroy)))
 	, _sndfile (0)
 	, _broadcast_info (0)
+	, _map_attempted (false)
 	, _capture_start (false)
 	, _capture_end (false)
 	, file_pos (0)
@@ -113,6 +116,7 @@ SndFileSource::SndFileSource (Session& s, const string& path, const string& orig
 	, AudioFileSource (s, path, origin, flags, sfmt, hf)
 	, _sndfile (0)
 	, _broadcast_info (0)
+	, _map_attempted (false)
 	, _capture_start (false)
 	, _capture_end (false)
 	, file_pos (0)
@@ -216,6 +220,7 @@ SndFileSource::SndFileSource (Session& s, const string& path, int chn)
 	, AudioFileSource (s, path, Flag (0))
 	, _sndfile (0)
 	, _broadcast_info (0)
+	, _map_attempted (false)
 	, _capture_start (false)
 	, _capture_end (false)
 	, file_pos (0)
@@ -239,6 +244,7 @@ SndFileSource::SndFileSource (Session& s, const AudioFileSource& other, const st
 	, AudioFileSource (s, path, "", Flag ((other.flags () | default_writable_flags | NoPeakFile) & ~RF64_RIFF), /*unused*/ FormatFloat, /*unused*/ WAVE64)
 	, _sndfile (0)
 	, _broadcast_info (0)
+	, _map_attempted (false)
 	, _capture_start (false)
 	, _capture_end (false)
 	, file_pos (0)
@@ -335,6 +341,9 @@ SndFileSource::init_sndfile ()
 void
 SndFileSource::close ()
 {
+	_mapped_file.close ();
+	_map_attempted = false;
+
 	if (_sndfile) {
 		sf_close (_sndfile);
 		_sndfile = 0;
@@ -533,6 +542,15 @@ SndFileSource::read_unlocked (Sample *dst, samplepos_t start, samplecnt_t cnt) c
 		memset (dst+file_cnt, 0, sizeof (Sample) * delta);
 	}
 
+	if (file_cnt && use_mapped_file ()) {
+		samplecnt_t const ret = _mapped_file.read (dst, start, file_cnt, _channel, _gain);
+		if (ret >= 0) {
+			return ret;
+		}
+		/* the file was truncated by someone else, let libsndfile handle it */
+		_mapped_file.close ();
+	}
+
 	if (file_cnt) {
 
 		if (sf_seek (_sndfile, (sf_count_t) start, SEEK_SET|SFM_READ) != (sf_count_t) start) {
@@ -583,6 +601,36 @@ SndFileSource::read_unlocked (Sample *dst, samplepos_t start, samplecnt_t cnt) c
 	return nread;
 }
 
+/** @return true if reads can be served from a memory-mapping of the file */
+bool
+SndFileSource::use_mapped_file () const
+{
+	if (_mapped_file.is_open ()) {
+		return true;
+	}
+
+	if (_map_attempted || writable () || !Config->get_map_float_audio_files ()) {
+		return false;
+	}
+
+	/* only try once, until the file is re-opened */
+	_map_attempted = true;
+
+	int const type = _info.format & SF_FORMAT_TYPEMASK;
+
+	if ((_info.format & SF_FORMAT_SUBMASK) != SF_FORMAT_FLOAT
+	    || (_info.format & SF_FORMAT_ENDMASK) == SF_ENDIAN_BIG
+	    || (type != SF_FORMAT_WAV && type != SF_FORMAT_WAVEX && type != SF_FORMAT_CAF
+#ifdef HAVE_RF64_RIFF
+	        && type != SF_FORMAT_RF64
+#endif
+	       )) {
+		return false;
+	}
+
+	return _mapped_file.open (_path, _info.channels, _info.frames) == 0;
+}
+
 samplecnt_t
 SndFileSource::write_unlocked (Sample *data, samplecnt_t cnt)
 {
@@ -931,26 +979,20 @@ SndFileSource::crossfade (Sample* data, samplecnt_t cnt, int fade_in)
 
 	if (xfade == xfade_samples) {
 
-		samplecnt_t n;
-
 		/* use the standard xfade curve */
 
 		if (fade_in) {
 
 			/* fade new material in */
 
-			for (n = 0; n < xfade; ++n) {
-				xfade_buf[n] = (xfade_buf[n] * out_coefficient[n]) + (fade_data[n] * in_coefficient[n]);
-			}
+			crossfade_buffers (xfade_buf, fade_data, in_coefficient, out_coefficient, xfade);
 
 		} else {
 
 
 			/* fade new material out */
 
-			for (n = 0; n < xfade; ++n) {
-				xfade_buf[n] = (xfade_buf[n] * in_coefficient[n]) + (fade_data[n] * out_coefficient[n]);
-			}
+			crossfade_buffers (xfade_buf, fade_data, out_coefficient, in_coefficient, xfade);
 		}
 
 	} else if (xfade < xfade_samples) {
@@ -962,9 +1004,7 @@ SndFileSource::crossfade (Sample* data, samplecnt_t cnt, int fade_in)
 
 		compute_equal_power_fades (xfade, &in[0], &out[0]);
 
-		for (samplecnt_t n = 0; n < xfade; ++n) {
-			xfade_buf[n] = (xfade_buf[n] * out[n]) + (fade_data[n] * in[n]);
-		}
+		crossfade_buffers (xfade_buf, fade_data, &in[0], &out[0], xfade);
 
 	} else if (xfade) {
 
@@ -1108,6 +1148,14 @@ SndFileSource::clamped_at_unity () const
 	return (sub != SF_FORMAT_FLOAT && sub != SF_FORMAT_DOUBLE && type != SF_FORMAT_OGG);
 }
 
+bool
+SndFileSource::cpu_bound () const
+{
+	/* compressed files: decoding takes longer than reading */
+	int const type = _info.format & SF_FORMAT_TYPEMASK;
+	return (type == SF_FORMAT_FLAC || type == SF_FORMAT_OGG);
+}
+
 void
 SndFileSource::file_closed ()
 {
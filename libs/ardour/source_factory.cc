@@ -22,6 +22,9 @@
 #include "libardour-config.h"
 #endif
 
+#include <list>
+
+#include "pbd/cpus.h"
 #include "pbd/error.h"
 #include "pbd/convert.h"
 #include "pbd/pthread_utils.h"
@@ -32,6 +35,7 @@
 #include "ardour/boost_debug.h"
 #include "ardour/midi_playlist.h"
 #include "ardour/midi_playlist_source.h"
+#include "ardour/rc_configuration.h"
 #include "ardour/source.h"
 #include "ardour/source_factory.h"
 #include "ardour/sndfilesource.h"
@@ -53,9 +57,59 @@ using namespace PBD;
 PBD::Signal1<void,boost::shared_ptr<Source> > SourceFactory::SourceCreated;
 Glib::Threads::Cond SourceFactory::PeaksToBuild;
 Glib::Threads::Mutex SourceFactory::peak_building_lock;
-std::list<boost::weak_ptr<AudioSource> > SourceFactory::files_with_peaks;
 
-static int active_threads = 0;
+/* Peakfiles are set up, and built if necessary, by a pool of threads.
+ * A peakfile which needs to be built is split into ranges, which are
+ * computed independently, so that the threads can share the work for
+ * long sources. Sources whose reading is limited by the disk are built
+ * by at most max_io_bound_jobs threads at a time, to avoid seeking
+ * between too many files; the other threads build peaks for sources
+ * which need the CPU (compressed files, compound regions).
+ */
+
+/** The peak work for one source */
+struct PeakBuild {
+	PeakBuild (boost::shared_ptr<AudioSource> as)
+		: source (as)
+		, cpu_bound (as->cpu_bound ())
+		, jobs (1)
+	{}
+
+	boost::weak_ptr<AudioSource> source;
+	bool cpu_bound;
+	uint32_t jobs; ///< queued and active jobs for this source
+};
+
+struct PeakJob {
+	PeakJob (boost::shared_ptr<PeakBuild> b, int32_t r) : build (b), range (r) {}
+
+	boost::shared_ptr<PeakBuild> build;
+	int32_t range; ///< range of the peakfile to build, or one of the jobs below
+
+	static const int32_t Setup = -1;  ///< set up the peakfile
+	static const int32_t Levels = -2; ///< prepare the coarser peak levels of a complete peakfile
+};
+
+static std::list<PeakJob> peak_jobs;
+static int sources_with_peak_work = 0;
+static int active_io_bound_jobs = 0;
+
+static const int max_io_bound_jobs = 2;
+static const samplecnt_t peak_range_size = 8388608; // samples, about 3 minutes at 48kHz
+
+/** @return the next job which can be started, or peak_jobs.end().
+ *  peak_building_lock MUST be held by caller.
+ */
+static std::list<PeakJob>::iterator
+next_peak_job ()
+{
+	for (std::list<PeakJob>::iterator j = peak_jobs.begin(); j != peak_jobs.end(); ++j) {
+		if (j->range < 0 || j->build->cpu_bound || active_io_bound_jobs < max_io_bound_jobs) {
+			return j;
+		}
+	}
+	return peak_jobs.end();
+}
 
 static void
 peak_thread_work ()
@@ -66,27 +120,66 @@ peak_thread_work ()
 
 		SourceFactory::peak_building_lock.lock ();
 
-	  wait:
-		if (SourceFactory::files_with_peaks.empty()) {
+		std::list<PeakJob>::iterator j;
+
+		while ((j = next_peak_job ()) == peak_jobs.end()) {
 			SourceFactory::PeaksToBuild.wait (SourceFactory::peak_building_lock);
 		}
 
-		if (SourceFactory::files_with_peaks.empty()) {
-			goto wait;
+		PeakJob job (*j);
+		peak_jobs.erase (j);
+
+		const bool io_bound = job.range >= 0 && !job.build->cpu_bound;
+
+		if (io_bound) {
+			++active_io_bound_jobs;
 		}
 
-		boost::shared_ptr<AudioSource> as (SourceFactory::files_with_peaks.front().lock());
-		SourceFactory::files_with_peaks.pop_front ();
-		++active_threads;
 		SourceFactory::peak_building_lock.unlock ();
 
-		if (!as) {
-			continue;
+		int ranges = 0;
+
+		{
+			boost::shared_ptr<AudioSource> as (job.build->source.lock());
+
+			if (as) {
+				if (job.range == PeakJob::Setup) {
+					as->set_defer_peak_building (true);
+					as->setup_peakfile ();
+					as->set_defer_peak_building (false);
+					ranges = as->prepare_peak_ranges (peak_range_size);
+				} else if (job.range == PeakJob::Levels) {
+					as->prepare_peak_levels ();
+				} else {
+					as->build_peak_range (job.range);
+				}
+			}
 		}
 
-		as->setup_peakfile ();
 		SourceFactory::peak_building_lock.lock ();
-		--active_threads;
+
+		if (io_bound) {
+			--active_io_bound_jobs;
+		}
+
+		if (ranges > 0) {
+			/* build this source's ranges before starting on other sources */
+			std::list<PeakJob>::iterator front = peak_jobs.begin();
+			for (int n = 0; n < ranges; ++n) {
+				peak_jobs.insert (front, PeakJob (job.build, n));
+			}
+			job.build->jobs += ranges;
+		}
+
+		if (--job.build->jobs == 0) {
+			--sources_with_peak_work;
+		}
+
+		if (ranges > 0 || io_bound) {
+			/* new work, or other threads may now start an I/O bound job */
+			SourceFactory::PeaksToBuild.broadcast ();
+		}
+
 		SourceFactory::peak_building_lock.unlock ();
 	}
 }
@@ -94,15 +187,29 @@ peak_thread_work ()
 int
 SourceFactory::peak_work_queue_length ()
 {
-	// ideally we'd loop over the queue and check for duplicates
-	// and existing valid peak-files..
-	return SourceFactory::files_with_peaks.size () + active_threads;
+	Glib::Threads::Mutex::Lock lm (peak_building_lock);
+	return sources_with_peak_work;
+}
+
+void
+SourceFactory::prepare_peak_levels (boost::shared_ptr<AudioSource> as)
+{
+	Glib::Threads::Mutex::Lock lm (peak_building_lock);
+	peak_jobs.push_back (PeakJob (boost::shared_ptr<PeakBuild> (new PeakBuild (as)), PeakJob::Levels));
+	++sources_with_peak_work;
+	PeaksToBuild.broadcast ();
 }
 
 void
 SourceFactory::init ()
 {
-	for (int n = 0; n < 2; ++n) {
+	uint32_t n_threads = Config->get_peak_building_threads ();
+
+	if (n_threads == 0) {
+		n_threads = hardware_concurrency ();
+	}
+
+	for (uint32_t n = 0; n < max (1U, n_threads); ++n) {
 		Glib::Threads::Thread::create (sigc::ptr_fun (::peak_thread_work));
 	}
 }
@@ -118,7 +225,8 @@ SourceFactory::setup_peakfile (boost::shared_ptr<Source> s, bool async)
 		if (async && !as->empty() && !(as->flags() & Source::NoPeakFile)) {
 
 			Glib::Threads::Mutex::Lock lm (peak_building_lock);
-			files_with_peaks.push_back (boost::weak_ptr<AudioSource> (as));
+			peak_jobs.push_back (PeakJob (boost::shared_ptr<PeakBuild> (new PeakBuild (as)), PeakJob::Setup));
+			++sources_with_peak_work;
 			PeaksToBuild.broadcast ();
 
 		} else {
@@ -187,11 +295,9 @@ SourceFactory::create (Session& s, const XMLNode& node, bool defer_peaks)
 				// boost_debug_shared_ptr_mark_interesting (src, "Source");
 #endif
 				boost::shared_ptr<Source> ret (src);
-				if (setup_peakfile (ret, defer_peaks)) {
+				if (announce (ret, defer_peaks)) {
 					return boost::shared_ptr<Source>();
 				}
-				ret->check_for_analysis_data_on_disk ();
-				SourceCreated (ret);
 				return ret;
 			}
 
@@ -234,6 +340,108 @@ SourceFactory::create (Session& s, const XMLNode& node, bool defer_peaks)
 	return boost::shared_ptr<Source>();
 }
 
+/** Nodes to be opened by SourceFactory::open(), shared by its threads */
+struct SourceOpenQueue {
+	SourceOpenQueue (Session& s, const vector<XMLNode const *>& n, vector<boost::shared_ptr<Source> >& o)
+		: session (s)
+		, nodes (n)
+		, opened (o)
+		, next (0)
+	{}
+
+	Session& session;
+	const vector<XMLNode const *>& nodes;
+	vector<boost::shared_ptr<Source> >& opened;
+	gint next;
+};
+
+static boost::shared_ptr<Source>
+open_audio_source (Session& s, const XMLNode& node)
+{
+	if (node.name() != X_("Source") || node.property ("playlist") != 0) {
+		return boost::shared_ptr<Source>();
+	}
+
+	DataType type = DataType::AUDIO;
+	XMLProperty const * prop = node.property ("type");
+
+	if (prop) {
+		type = DataType (prop->value());
+	}
+
+	if (type != DataType::AUDIO) {
+		return boost::shared_ptr<Source>();
+	}
+
+	try {
+		return boost::shared_ptr<Source> (new SndFileSource (s, node));
+	} catch (...) {
+		/* missing, ambiguous or unreadable: leave it to create(),
+		 * which can ask the user about it.
+		 */
+	}
+
+	return boost::shared_ptr<Source>();
+}
+
+static void
+source_open_work (SourceOpenQueue* queue)
+{
+	FileSource::NoAmbiguityQueries naq;
+	const gint n_nodes = queue->nodes.size ();
+	gint n;
+
+	while ((n = g_atomic_int_add (&queue->next, 1)) < n_nodes) {
+		queue->opened[n] = open_audio_source (queue->session, *queue->nodes[n]);
+	}
+}
+
+void
+SourceFactory::open (Session& s, const vector<XMLNode const *>& nodes, vector<boost::shared_ptr<Source> >& opened)
+{
+	opened.clear ();
+	opened.resize (nodes.size ());
+
+	if (Stateful::loading_state_version < 3000) {
+		/* 2.X sessions locate their files with FileSource::find_2X(),
+		 * which reports errors itself; leave them to create().
+		 */
+		return;
+	}
+
+	SourceOpenQueue queue (s, nodes, opened);
+	vector<Glib::Threads::Thread*> threads;
+	const uint32_t n_threads = min ((uint32_t) nodes.size (), hardware_concurrency ());
+
+	/* this thread does its share of the work too */
+
+	for (uint32_t n = 1; n < n_threads; ++n) {
+		try {
+			threads.push_back (Glib::Threads::Thread::create (sigc::bind (sigc::ptr_fun (source_open_work), &queue)));
+		} catch (Glib::Threads::ThreadError& e) {
+			break;
+		}
+	}
+
+	source_open_work (&queue);
+
+	for (vector<Glib::Threads::Thread*>::iterator t = threads.begin(); t != threads.end(); ++t) {
+		(*t)->join ();
+	}
+}
+
+int
+SourceFactory::announce (boost::shared_ptr<Source> src, bool async)
+{
+	if (setup_peakfile (src, async)) {
+		return -1;
+	}
+
+	src->check_for_analysis_data_on_disk ();
+	SourceCreated (src);
+	return 0;
+}
+
 boost::shared_ptr<Source>
 SourceFactory::createExternal (DataType type, Session& s, const string& path,
 			       int chn, Source::Flag flags, bool announce, bool defer_peaks)
@@ -0,0 +1,223 @@
+/*
+    Copyright (C) 2018 Paul Davis
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+*/
+
+/* AVX-512 Foundation versions of the mixing functions. This file is
+ * compiled with -mavx512f and must only be called after checking
+ * FPU::has_avx512f().
+ *
+ * Buffers need not be aligned; the last (nframes % 16) samples are
+ * handled with masked loads and stores rather than a scalar loop.
+ */
+
+#include <immintrin.h>
+
+#include "ardour/mix.h"
+
+/** @return a mask for the first @a n (< 16) elements */
+static inline __mmask16
+tail_mask (uint32_t n)
+{
+	return (__mmask16) ((1u << n) - 1);
+}
+
+float
+x86_avx512f_compute_peak (const float * buf, uint32_t nframes, float current)
+{
+	__m512 vmax = _mm512_set1_ps (current);
+
+	while (nframes >= 16) {
+		vmax = _mm512_max_ps (vmax, _mm512_abs_ps (_mm512_loadu_ps (buf)));
+		buf += 16;
+		nframes -= 16;
+	}
+
+	if (nframes > 0) {
+		/* masked-off elements are zero, which never exceed a peak */
+		vmax = _mm512_max_ps (vmax, _mm512_abs_ps (_mm512_maskz_loadu_ps (tail_mask (nframes), buf)));
+	}
+
+	return _mm512_reduce_max_ps (vmax);
+}
+
+void
+x86_avx512f_find_peaks (const float * buf, uint32_t nframes, float *min, float *max)
+{
+	__m512 vmin = _mm512_set1_ps (*min);
+	__m512 vmax = _mm512_set1_ps (*max);
+
+	while (nframes >= 16) {
+		__m512 work = _mm512_loadu_ps (buf);
+		vmin = _mm512_min_ps (vmin, work);
+		vmax = _mm512_max_ps (vmax, work);
+		buf += 16;
+		nframes -= 16;
+	}
+
+	if (nframes > 0) {
+		const __mmask16 m = tail_mask (nframes);
+		__m512 work = _mm512_maskz_loadu_ps (m, buf);
+		vmin = _mm512_mask_min_ps (vmin, m, vmin, work);
+		vmax = _mm512_mask_max_ps (vmax, m, vmax, work);
+	}
+
+	*min = _mm512_reduce_min_ps (vmin);
+	*max = _mm512_reduce_max_ps (vmax);
+}
+
+void
+x86_avx512f_apply_gain_to_buffer (float * buf, uint32_t nframes, float gain)
+{
+	const __m512 g = _mm512_set1_ps (gain);
+
+	while (nframes >= 16) {
+		_mm512_storeu_ps (buf, _mm512_mul_ps (_mm512_loadu_ps (buf), g));
+		buf += 16;
+		nframes -= 16;
+	}
+
+	if (nframes > 0) {
+		const __mmask16 m = tail_mask (nframes);
+		_mm512_mask_storeu_ps (buf, m, _mm512_mul_ps (_mm512_maskz_loadu_ps (m, buf), g));
+	}
+}
+
+void
+x86_avx512f_mix_buffers_with_gain (float * dst, const float * src, uint32_t nframes, float gain)
+{
+	const __m512 g = _mm512_set1_ps (gain);
+
+	while (nframes >= 16) {
+		_mm512_storeu_ps (dst, _mm512_fmadd_ps (_mm512_loadu_ps (src), g, _mm512_loadu_ps (dst)));
+		dst += 16;
+		src += 16;
+		nframes -= 16;
+	}
+
+	if (nframes > 0) {
+		const __mmask16 m = tail_mask (nframes);
+		_mm512_mask_storeu_ps (dst, m, _mm512_fmadd_ps (_mm512_maskz_loadu_ps (m, src), g, _mm512_maskz_loadu_ps (m, dst)));
+	}
+}
+
+void
+x86_avx512f_mix_buffers_no_gain (float * dst, const float * src, uint32_t nframes)
+{
+	while (nframes >= 16) {
+		_mm512_storeu_ps (dst, _mm512_add_ps (_mm512_loadu_ps (src), _mm512_loadu_ps (dst)));
+		dst += 16;
+		src += 16;
+		nframes -= 16;
+	}
+
+	if (nframes > 0) {
+		const __mmask16 m = tail_mask (nframes);
+		_mm512_mask_storeu_ps (dst, m, _mm512_add_ps (_mm512_maskz_loadu_ps (m, src), _mm512_maskz_loadu_ps (m, dst)));
+	}
+}
+
+void
+x86_avx512f_copy_vector (float * dst, const float * src, uint32_t nframes)
+{
+	while (nframes >= 16) {
+		_mm512_storeu_ps (dst, _mm512_loadu_ps (src));
+		dst += 16;
+		src += 16;
+		nframes -= 16;
+	}
+
+	if (nframes > 0) {
+		const __mmask16 m = tail_mask (nframes);
+		_mm512_mask_storeu_ps (dst, m, _mm512_maskz_loadu_ps (m, src));
+	}
+}
+
+void
+x86_avx512f_apply_gain_vector (float * buf, const float * gain, uint32_t nframes)
+{
+	while (nframes >= 16) {
+		_mm512_storeu_ps (buf, _mm512_mul_ps (_mm512_loadu_ps (buf), _mm512_loadu_ps (gain)));
+		buf += 16;
+		gain += 16;
+		nframes -= 16;
+	}
+
+	if (nframes > 0) {
+		const __mmask16 m = tail_mask (nframes);
+		_mm512_mask_storeu_ps (buf, m, _mm512_mul_ps (_mm512_maskz_loadu_ps (m, buf), _mm512_maskz_loadu_ps (m, gain)));
+	}
+}
+
+void
+x86_avx512f_mix_buffers_with_gain_vector (float * dst, const float * src, const float * gain, uint32_t nframes)
+{
+	while (nframes >= 16) {
+		_mm512_storeu_ps (dst, _mm512_fmadd_ps (_mm512_loadu_ps (src), _mm512_loadu_ps (gain), _mm512_loadu_ps (dst)));
+		dst += 16;
+		src += 16;
+		gain += 16;
+		nframes -= 16;
+	}
+
+	if (nframes > 0) {
+		const __mmask16 m = tail_mask (nframes);
+		_mm512_mask_storeu_ps (dst, m, _mm512_fmadd_ps (_mm512_maskz_loadu_ps (m, src), _mm512_maskz_loadu_ps (m, gain), _mm512_maskz_loadu_ps (m, dst)));
+	}
+}
+
+void
+x86_avx512f_crossfade_buffers (float * dst, const float * src, const float * src_gain, const float * dst_gain, uint32_t nframes)
+{
+	if (dst_gain) {
+		while (nframes >= 16) {
+			__m512 d = _mm512_mul_ps (_mm512_loadu_ps (dst), _mm512_loadu_ps (dst_gain));
+			_mm512_storeu_ps (dst, _mm512_fmadd_ps (_mm512_loadu_ps (src), _mm512_loadu_ps (src_gain), d));
+			dst += 16;
+			src += 16;
+			src_gain += 16;
+			dst_gain += 16;
+			nframes -= 16;
+		}
+
+		if (nframes > 0) {
+			const __mmask16 m = tail_mask (nframes);
+			__m512 d = _mm512_mul_ps (_mm512_maskz_loadu_ps (m, dst), _mm512_maskz_loadu_ps (m, dst_gain));
+			_mm512_mask_storeu_ps (dst, m, _mm512_fmadd_ps (_mm512_maskz_loadu_ps (m, src), _mm512_maskz_loadu_ps (m, src_gain), d));
+		}
+		return;
+	}
+
+	/* dst * (1 - g) + src * g == dst + (src - dst) * g */
+
+	while (nframes >= 16) {
+		__m512 d = _mm512_loadu_ps (dst);
+		__m512 diff = _mm512_sub_ps (_mm512_loadu_ps (src), d);
+		_mm512_storeu_ps (dst, _mm512_fmadd_ps (diff, _mm512_loadu_ps (src_gain), d));
+		dst += 16;
+		src += 16;
+		src_gain += 16;
+		nframes -= 16;
+	}
+
+	if (nframes > 0) {
+		const __mmask16 m = tail_mask (nframes);
+		__m512 d = _mm512_maskz_loadu_ps (m, dst);
+		__m512 diff = _mm512_sub_ps (_mm512_maskz_loadu_ps (m, src), d);
+		_mm512_mask_storeu_ps (dst, m, _mm512_fmadd_ps (diff, _mm512_maskz_loadu_ps (m, src_gain), d));
+	}
+}
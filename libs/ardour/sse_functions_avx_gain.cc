@@ -0,0 +1,106 @@
+/*
+    Copyright (C) 2018 Paul Davis
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+*/
+
+/* AVX versions of the per-sample gain functions (fades, envelopes).
+ * Unlike the rest of the AVX code these are intrinsics only, so they
+ * are used on all platforms. This file is compiled with -mavx and must
+ * only be called after checking FPU::has_avx().
+ */
+
+#include <immintrin.h>
+
+#include "ardour/mix.h"
+
+void
+x86_sse_avx_apply_gain_vector (float * buf, const float * gain, uint32_t nframes)
+{
+	while (nframes >= 8) {
+		_mm256_storeu_ps (buf, _mm256_mul_ps (_mm256_loadu_ps (buf), _mm256_loadu_ps (gain)));
+		buf += 8;
+		gain += 8;
+		nframes -= 8;
+	}
+
+	while (nframes > 0) {
+		*buf++ *= *gain++;
+		--nframes;
+	}
+}
+
+void
+x86_sse_avx_mix_buffers_with_gain_vector (float * dst, const float * src, const float * gain, uint32_t nframes)
+{
+	while (nframes >= 8) {
+		__m256 s = _mm256_mul_ps (_mm256_loadu_ps (src), _mm256_loadu_ps (gain));
+		_mm256_storeu_ps (dst, _mm256_add_ps (_mm256_loadu_ps (dst), s));
+		dst += 8;
+		src += 8;
+		gain += 8;
+		nframes -= 8;
+	}
+
+	while (nframes > 0) {
+		*dst++ += *src++ * *gain++;
+		--nframes;
+	}
+}
+
+void
+x86_sse_avx_crossfade_buffers (float * dst, const float * src, const float * src_gain, const float * dst_gain, uint32_t nframes)
+{
+	if (dst_gain) {
+		while (nframes >= 8) {
+			__m256 d = _mm256_mul_ps (_mm256_loadu_ps (dst), _mm256_loadu_ps (dst_gain));
+			__m256 s = _mm256_mul_ps (_mm256_loadu_ps (src), _mm256_loadu_ps (src_gain));
+			_mm256_storeu_ps (dst, _mm256_add_ps (d, s));
+			dst += 8;
+			src += 8;
+			src_gain += 8;
+			dst_gain += 8;
+			nframes -= 8;
+		}
+
+		while (nframes > 0) {
+			*dst = (*dst * *dst_gain++) + (*src++ * *src_gain++);
+			++dst;
+			--nframes;
+		}
+		return;
+	}
+
+	const __m256 one = _mm256_set1_ps (1.f);
+
+	while (nframes >= 8) {
+		__m256 g = _mm256_loadu_ps (src_gain);
+		__m256 d = _mm256_mul_ps (_mm256_loadu_ps (dst), _mm256_sub_ps (one, g));
+		__m256 s = _mm256_mul_ps (_mm256_loadu_ps (src), g);
+		_mm256_storeu_ps (dst, _mm256_add_ps (d, s));
+		dst += 8;
+		src += 8;
+		src_gain += 8;
+		nframes -= 8;
+	}
+
+	while (nframes > 0) {
+		*dst = (*dst * (1.f - *src_gain)) + (*src++ * *src_gain);
+		++dst;
+		++src_gain;
+		--nframes;
+	}
+}
@@ -0,0 +1,121 @@
+/*
+    Copyright (C) 2018 Paul Davis
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+*/
+
+/* AVX versions of the mixing functions which gain from fused multiply-add
+ * (FMA3: Haswell, Zen and later). This file is compiled with -mavx -mfma
+ * and must only be called after checking FPU::has_fma().
+ *
+ * Note that a fused multiply-add rounds only once, so results may differ
+ * from the generic versions in the last bit. The scalar loops which handle
+ * the last few samples use fmaf(), so that every sample of a buffer is
+ * computed exactly as the vector lanes compute it.
+ */
+
+#include <math.h>
+#include <immintrin.h>
+
+#include "ardour/mix.h"
+
+void
+x86_fma_mix_buffers_with_gain (float * dst, const float * src, uint32_t nframes, float gain)
+{
+	const __m256 g = _mm256_set1_ps (gain);
+
+	while (nframes >= 16) {
+		__m256 d0 = _mm256_fmadd_ps (_mm256_loadu_ps (src), g, _mm256_loadu_ps (dst));
+		__m256 d1 = _mm256_fmadd_ps (_mm256_loadu_ps (src + 8), g, _mm256_loadu_ps (dst + 8));
+		_mm256_storeu_ps (dst, d0);
+		_mm256_storeu_ps (dst + 8, d1);
+		dst += 16;
+		src += 16;
+		nframes -= 16;
+	}
+
+	while (nframes >= 8) {
+		_mm256_storeu_ps (dst, _mm256_fmadd_ps (_mm256_loadu_ps (src), g, _mm256_loadu_ps (dst)));
+		dst += 8;
+		src += 8;
+		nframes -= 8;
+	}
+
+	while (nframes > 0) {
+		*dst = fmaf (*src++, gain, *dst);
+		++dst;
+		--nframes;
+	}
+}
+
+void
+x86_fma_mix_buffers_with_gain_vector (float * dst, const float * src, const float * gain, uint32_t nframes)
+{
+	while (nframes >= 8) {
+		_mm256_storeu_ps (dst, _mm256_fmadd_ps (_mm256_loadu_ps (src), _mm256_loadu_ps (gain), _mm256_loadu_ps (dst)));
+		dst += 8;
+		src += 8;
+		gain += 8;
+		nframes -= 8;
+	}
+
+	while (nframes > 0) {
+		*dst = fmaf (*src++, *gain++, *dst);
+		++dst;
+		--nframes;
+	}
+}
+
+void
+x86_fma_crossfade_buffers (float * dst, const float * src, const float * src_gain, const float * dst_gain, uint32_t nframes)
+{
+	if (dst_gain) {
+		while (nframes >= 8) {
+			__m256 d = _mm256_mul_ps (_mm256_loadu_ps (dst), _mm256_loadu_ps (dst_gain));
+			_mm256_storeu_ps (dst, _mm256_fmadd_ps (_mm256_loadu_ps (src), _mm256_loadu_ps (src_gain), d));
+			dst += 8;
+			src += 8;
+			src_gain += 8;
+			dst_gain += 8;
+			nframes -= 8;
+		}
+
+		while (nframes > 0) {
+			*dst = fmaf (*src++, *src_gain++, *dst * *dst_gain++);
+			++dst;
+			--nframes;
+		}
+		return;
+	}
+
+	/* dst * (1 - g) + src * g == dst + (src - dst) * g */
+
+	while (nframes >= 8) {
+		__m256 d = _mm256_loadu_ps (dst);
+		__m256 diff = _mm256_sub_ps (_mm256_loadu_ps (src), d);
+		_mm256_storeu_ps (dst, _mm256_fmadd_ps (diff, _mm256_loadu_ps (src_gain), d));
+		dst += 8;
+		src += 8;
+		src_gain += 8;
+		nframes -= 8;
+	}
+
+	while (nframes > 0) {
+		*dst = fmaf (*src++ - *dst, *src_gain++, *dst);
+		++dst;
+		--nframes;
+	}
+}
@@ -117,3 +117,84 @@ x86_sse_find_peaks(const ARDOUR::Sample* buf, ARDOUR::pframes_t nframes, float *
 
 
 
+void
+x86_sse_apply_gain_vector (float * buf, const float * gain, uint32_t nframes)
+{
+	/* the gain buffer and the data need not be aligned the same way,
+	 * so always use unaligned loads (no penalty on aligned data on any
+	 * recent CPU).
+	 */
+	while (nframes >= 4) {
+		_mm_storeu_ps (buf, _mm_mul_ps (_mm_loadu_ps (buf), _mm_loadu_ps (gain)));
+		buf += 4;
+		gain += 4;
+		nframes -= 4;
+	}
+
+	while (nframes > 0) {
+		*buf++ *= *gain++;
+		--nframes;
+	}
+}
+
+void
+x86_sse_mix_buffers_with_gain_vector (float * dst, const float * src, const float * gain, uint32_t nframes)
+{
+	while (nframes >= 4) {
+		__m128 s = _mm_mul_ps (_mm_loadu_ps (src), _mm_loadu_ps (gain));
+		_mm_storeu_ps (dst, _mm_add_ps (_mm_loadu_ps (dst), s));
+		dst += 4;
+		src += 4;
+		gain += 4;
+		nframes -= 4;
+	}
+
+	while (nframes > 0) {
+		*dst++ += *src++ * *gain++;
+		--nframes;
+	}
+}
+
+void
+x86_sse_crossfade_buffers (float * dst, const float * src, const float * src_gain, const float * dst_gain, uint32_t nframes)
+{
+	if (dst_gain) {
+		while (nframes >= 4) {
+			__m128 d = _mm_mul_ps (_mm_loadu_ps (dst), _mm_loadu_ps (dst_gain));
+			__m128 s = _mm_mul_ps (_mm_loadu_ps (src), _mm_loadu_ps (src_gain));
+			_mm_storeu_ps (dst, _mm_add_ps (d, s));
+			dst += 4;
+			src += 4;
+			src_gain += 4;
+			dst_gain += 4;
+			nframes -= 4;
+		}
+
+		while (nframes > 0) {
+			*dst = (*dst * *dst_gain++) + (*src++ * *src_gain++);
+			++dst;
+			--nframes;
+		}
+		return;
+	}
+
+	const __m128 one = _mm_set1_ps (1.f);
+
+	while (nframes >= 4) {
+		__m128 g = _mm_loadu_ps (src_gain);
+		__m128 d = _mm_mul_ps (_mm_loadu_ps (dst), _mm_sub_ps (one, g));
+		__m128 s = _mm_mul_ps (_mm_loadu_ps (src), g);
+		_mm_storeu_ps (dst, _mm_add_ps (d, s));
+		dst += 4;
+		src += 4;
+		src_gain += 4;
+		nframes -= 4;
+	}
+
+	while (nframes > 0) {
+		*dst = (*dst * (1.f - *src_gain)) + (*src++ * *src_gain);
+		++dst;
+		++src_gain;
+		--nframes;
+	}
+}
@@ -0,0 +1,283 @@
+/*
+    Copyright (C) 2018 Paul Davis
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+#include <vector>
+
+#include "evoral/EventSink.hpp"
+#include "evoral/Note.hpp"
+#include "evoral/midi_events.h"
+
+#include "ardour/midi_cursor.h"
+#include "ardour/midi_model.h"
+#include "ardour/midi_region.h"
+#include "ardour/midi_source.h"
+#include "ardour/midi_state_tracker.h"
+#include "ardour/region_factory.h"
+#include "ardour/session.h"
+#include "ardour/tempo.h"
+
+#include "midi_event_cache_test.h"
+
+CPPUNIT_TEST_SUITE_REGISTRATION (MidiEventCacheTest);
+
+using namespace std;
+using namespace ARDOUR;
+
+namespace {
+
+/** Records the note ons and offs written to it */
+class NoteSink : public Evoral::EventSink<samplepos_t>
+{
+public:
+	struct Note {
+		Note (samplepos_t t, uint8_t s, uint8_t n) : time (t), status (s), note (n) {}
+		samplepos_t time;
+		uint8_t     status;
+		uint8_t     note;
+	};
+
+	uint32_t write (samplepos_t time, Evoral::EventType, uint32_t size, const uint8_t* buf)
+	{
+		if (size == 3 && ((buf[0] & 0xF0) == MIDI_CMD_NOTE_ON || (buf[0] & 0xF0) == MIDI_CMD_NOTE_OFF)) {
+			notes.push_back (Note (time, buf[0] & 0xF0, buf[1]));
+		}
+		return size;
+	}
+
+	/** @return the number of ons (or offs) of @a note, at @a time if it is not -1 */
+	int count (uint8_t status, uint8_t note, samplepos_t time = -1) const
+	{
+		int n = 0;
+		for (vector<Note>::const_iterator i = notes.begin(); i != notes.end(); ++i) {
+			if (i->status == status && i->note == note && (time < 0 || i->time == time)) {
+				++n;
+			}
+		}
+		return n;
+	}
+
+	/** @return true if every note which was turned on was turned off once,
+	 *  and no note was turned off without being on.
+	 */
+	bool balanced () const
+	{
+		int on[128] = { 0 };
+		for (vector<Note>::const_iterator i = notes.begin(); i != notes.end(); ++i) {
+			if (i->status == MIDI_CMD_NOTE_ON) {
+				++on[i->note];
+			} else if (--on[i->note] < 0) {
+				return false;
+			}
+		}
+		for (int n = 0; n < 128; ++n) {
+			if (on[n] != 0) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	vector<Note> notes;
+};
+
+}
+
+void
+MidiEventCacheTest::setUp ()
+{
+	TestNeedingSession::setUp ();
+
+	_source = _session->create_midi_source_for_session ("midi_event_cache");
+
+	{
+		Source::Lock lm (_source->mutex ());
+		_source->load_model (lm);
+	}
+
+	_model = _source->model ();
+	CPPUNIT_ASSERT (_model);
+
+	add_note (60, 0, 2);
+	add_note (62, 2, 1);
+	add_note (64, 5, 2);
+
+	PropertyList plist;
+	plist.add (Properties::start, 0);
+	plist.add (Properties::length, beat (8));
+	plist.add (Properties::length_beats, 8.0);
+	plist.add (Properties::name, "midi_event_cache");
+
+	_region = boost::dynamic_pointer_cast<MidiRegion> (RegionFactory::create (_source, plist));
+	CPPUNIT_ASSERT (_region);
+}
+
+void
+MidiEventCacheTest::tearDown ()
+{
+	_region.reset ();
+	_model.reset ();
+	_source.reset ();
+
+	TestNeedingSession::tearDown ();
+}
+
+void
+MidiEventCacheTest::add_note (uint8_t note, double time, double length)
+{
+	MidiModel::NoteDiffCommand* cmd = _model->new_note_diff_command ("add note");
+	cmd->add (MidiModel::NotePtr (new Evoral::Note<Evoral::Beats> (0, Evoral::Beats (time), Evoral::Beats (length), note, 100)));
+	_model->apply_command (*_session, cmd);
+}
+
+samplepos_t
+MidiEventCacheTest::beat (double qn) const
+{
+	return _session->tempo_map().sample_at_quarter_note (qn);
+}
+
+/** Locating with notes sounding must leave none stuck, and must not play
+ *  the note offs of notes whose note ons were never played.
+ */
+void
+MidiEventCacheTest::locateTest ()
+{
+	NoteSink sink;
+	MidiCursor cursor;
+	MidiStateTracker tracker;
+
+	/* play the first beat, which turns 60 on */
+	_region->read_at (sink, 0, beat (1), 0, cursor, 0, Sustained, &tracker);
+	CPPUNIT_ASSERT_EQUAL (1, sink.count (MIDI_CMD_NOTE_ON, 60, 0));
+	CPPUNIT_ASSERT_EQUAL (uint16_t (1), tracker.on ());
+
+	/* locate into the middle of 64, resolving 60 as a track does */
+	tracker.resolve_notes (sink, beat (6));
+	CPPUNIT_ASSERT_EQUAL (uint16_t (0), tracker.on ());
+
+	_region->read_at (sink, beat (6), beat (2), 0, cursor, 0, Sustained, &tracker);
+
+	/* 60 was turned off once, by the tracker; 64 was never turned on,
+	 * so its note off must not have been played either.
+	 */
+	CPPUNIT_ASSERT_EQUAL (1, sink.count (MIDI_CMD_NOTE_OFF, 60));
+	CPPUNIT_ASSERT_EQUAL (0, sink.count (MIDI_CMD_NOTE_ON, 64));
+	CPPUNIT_ASSERT_EQUAL (0, sink.count (MIDI_CMD_NOTE_OFF, 64));
+	CPPUNIT_ASSERT (sink.balanced ());
+
+	/* play the first beat again, then locate into the middle of 60
+	 * without resolving it: its note off is still due, and is played.
+	 */
+	sink.notes.clear ();
+	tracker.reset ();
+
+	_region->read_at (sink, 0, beat (1), 0, cursor, 0, Sustained, &tracker);
+	_region->read_at (sink, beat (1.5), beat (6.5), 0, cursor, 0, Sustained, &tracker);
+
+	CPPUNIT_ASSERT_EQUAL (1, sink.count (MIDI_CMD_NOTE_OFF, 60, beat (2)));
+	CPPUNIT_ASSERT_EQUAL (1, sink.count (MIDI_CMD_NOTE_ON, 62, beat (2)));
+	CPPUNIT_ASSERT_EQUAL (1, sink.count (MIDI_CMD_NOTE_OFF, 64, beat (7)));
+	CPPUNIT_ASSERT (sink.balanced ());
+	CPPUNIT_ASSERT_EQUAL (uint16_t (0), tracker.on ());
+}
+
+/** Changes to the model must be seen by the next read, even one which
+ *  continues linearly from the last.
+ */
+void
+MidiEventCacheTest::invalidateTest ()
+{
+	NoteSink sink;
+	MidiCursor cursor;
+	MidiStateTracker tracker;
+
+	_region->read_at (sink, 0, beat (3), 0, cursor, 0, Sustained, &tracker);
+	CPPUNIT_ASSERT_EQUAL (size_t (3), sink.notes.size ());
+
+	add_note (67, 4, 0.5);
+
+	_region->read_at (sink, beat (3), beat (5), 0, cursor, 0, Sustained, &tracker);
+
+	CPPUNIT_ASSERT_EQUAL (1, sink.count (MIDI_CMD_NOTE_OFF, 62, beat (3)));
+	CPPUNIT_ASSERT_EQUAL (1, sink.count (MIDI_CMD_NOTE_ON, 67, beat (4)));
+	CPPUNIT_ASSERT_EQUAL (1, sink.count (MIDI_CMD_NOTE_OFF, 67, beat (4.5)));
+	CPPUNIT_ASSERT_EQUAL (1, sink.count (MIDI_CMD_NOTE_ON, 64, beat (5)));
+	CPPUNIT_ASSERT_EQUAL (1, sink.count (MIDI_CMD_NOTE_OFF, 64, beat (7)));
+	CPPUNIT_ASSERT_EQUAL (size_t (8), sink.notes.size ());
+	CPPUNIT_ASSERT (sink.balanced ());
+
+	/* moving the region moves its cached events */
+	sink.notes.clear ();
+	_region->set_position (beat (8));
+
+	MidiCursor moved;
+	_region->read_at (sink, beat (8), beat (8), 0, moved);
+
+	CPPUNIT_ASSERT_EQUAL (1, sink.count (MIDI_CMD_NOTE_ON, 60, beat (8)));
+	CPPUNIT_ASSERT_EQUAL (1, sink.count (MIDI_CMD_NOTE_ON, 67, beat (12)));
+	CPPUNIT_ASSERT_EQUAL (size_t (8), sink.notes.size ());
+}
+
+/** Reads which start before a trimmed region, end after it, or are split
+ *  anywhere inside it must each play the region's events exactly once.
+ */
+void
+MidiEventCacheTest::regionBoundaryTest ()
+{
+	/* trim the region to beats [1, 6) of the source, and put it at beat 10 */
+	_region->trim_front (beat (1));
+	_region->set_length (beat (5), 0);
+	_region->set_position (beat (10));
+
+	const samplepos_t start = beat (10) - beat (1);
+
+	NoteSink sink;
+	MidiCursor cursor;
+	MidiStateTracker tracker;
+
+	/* from a beat before the region to a beat after it, in one read */
+	_region->read_at (sink, beat (9), beat (7), 0, cursor, 0, Sustained, &tracker);
+
+	/* 60 began before the region, so its note off is not played; 64 ends
+	 * after it, and is left for the tracker to resolve.
+	 */
+	CPPUNIT_ASSERT_EQUAL (0, sink.count (MIDI_CMD_NOTE_OFF, 60));
+	CPPUNIT_ASSERT_EQUAL (1, sink.count (MIDI_CMD_NOTE_ON, 62, start + beat (2)));
+	CPPUNIT_ASSERT_EQUAL (1, sink.count (MIDI_CMD_NOTE_OFF, 62, start + beat (3)));
+	CPPUNIT_ASSERT_EQUAL (1, sink.count (MIDI_CMD_NOTE_ON, 64, start + beat (5)));
+	CPPUNIT_ASSERT_EQUAL (size_t (3), sink.notes.size ());
+	CPPUNIT_ASSERT_EQUAL (uint16_t (1), tracker.on ());
+
+	/* the same range in reads which cross the region's start, the
+	 * middle of 62, and the region's end
+	 */
+	const samplepos_t splits[] = { beat (9), beat (10) + 7, beat (11.5), beat (14) + 3, beat (16) };
+
+	NoteSink split_sink;
+	MidiCursor split_cursor;
+
+	for (size_t i = 0; i < sizeof (splits) / sizeof (splits[0]) - 1; ++i) {
+		_region->read_at (split_sink, splits[i], splits[i + 1] - splits[i], 0, split_cursor);
+	}
+
+	CPPUNIT_ASSERT_EQUAL (sink.notes.size (), split_sink.notes.size ());
+	for (size_t i = 0; i < sink.notes.size (); ++i) {
+		CPPUNIT_ASSERT_EQUAL (sink.notes[i].time, split_sink.notes[i].time);
+		CPPUNIT_ASSERT_EQUAL (sink.notes[i].status, split_sink.notes[i].status);
+		CPPUNIT_ASSERT_EQUAL (sink.notes[i].note, split_sink.notes[i].note);
+	}
+}
@@ -0,0 +1,57 @@
+/*
+    Copyright (C) 2018 Paul Davis
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+#include <boost/shared_ptr.hpp>
+
+#include "ardour/types.h"
+#include "test_needing_session.h"
+
+namespace ARDOUR {
+	class MidiModel;
+	class MidiRegion;
+	class MidiSource;
+}
+
+/** Tests of reading a MidiRegion through its MidiEventCache.
+ *  The region's model has notes 60 at beat 0 for 2 beats, 62 at beat 2
+ *  for 1 beat and 64 at beat 5 for 2 beats, on channel 0.
+ */
+class MidiEventCacheTest : public TestNeedingSession
+{
+	CPPUNIT_TEST_SUITE (MidiEventCacheTest);
+	CPPUNIT_TEST (locateTest);
+	CPPUNIT_TEST (invalidateTest);
+	CPPUNIT_TEST (regionBoundaryTest);
+	CPPUNIT_TEST_SUITE_END ();
+
+public:
+	void setUp ();
+	void tearDown ();
+
+	void locateTest ();
+	void invalidateTest ();
+	void regionBoundaryTest ();
+
+private:
+	void add_note (uint8_t note, double time, double length);
+	ARDOUR::samplepos_t beat (double qn) const;
+
+	boost::shared_ptr<ARDOUR::MidiSource> _source;
+	boost::shared_ptr<ARDOUR::MidiModel>  _model;
+	boost::shared_ptr<ARDOUR::MidiRegion> _region;
+};
@@ -0,0 +1,118 @@
+/*
+    Copyright (C) 2018 Paul Davis
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+#include <glibmm/miscutils.h>
+
+#include "ardour/audiosource.h"
+#include "ardour/source_factory.h"
+#include "peak_levels_test.h"
+#include "test_util.h"
+
+CPPUNIT_TEST_SUITE_REGISTRATION (PeakLevelsTest);
+
+using namespace std;
+using namespace ARDOUR;
+
+void
+PeakLevelsTest::setUp ()
+{
+	TestNeedingSession::setUp ();
+
+	_build_peakfiles = AudioSource::get_build_peakfiles ();
+	AudioSource::set_build_peakfiles (true);
+
+	std::string const test_wav_path = Glib::build_filename (new_test_output_dir(), "peak_levels.wav");
+	_source = boost::dynamic_pointer_cast<AudioSource> (
+		SourceFactory::createWritable (DataType::AUDIO, *_session, test_wav_path, false, get_test_sample_rate ()));
+	CPPUNIT_ASSERT (_source);
+
+	/* 4 peaks of the second level (16 * 16 * 256 samples per peak) */
+	_length = 4 * 65536;
+
+	Sample buf[4096];
+
+	CPPUNIT_ASSERT_EQUAL (0, _source->prepare_for_peakfile_writes ());
+
+	for (samplecnt_t n = 0; n < _length; n += 4096) {
+		for (samplecnt_t i = 0; i < 4096; ++i) {
+			buf[i] = (n + i) / (float) _length;
+		}
+		CPPUNIT_ASSERT_EQUAL ((samplecnt_t) 4096, _source->write (buf, 4096));
+	}
+
+	_source->done_with_peakfile_writes ();
+}
+
+void
+PeakLevelsTest::tearDown ()
+{
+	_source.reset ();
+	AudioSource::set_build_peakfiles (_build_peakfiles);
+
+	TestNeedingSession::tearDown ();
+}
+
+/** Read @a npeaks (1 or 2) visual peaks of at least one level peak each, and
+ *  check that they do not include any samples from outside the range.
+ *  @a start and @a cnt are multiples of the peakfile's 256 samples per peak.
+ */
+void
+PeakLevelsTest::check_read (samplepos_t start, samplecnt_t cnt, samplecnt_t npeaks)
+{
+	PeakData peaks[2];
+	const double samples_per_visual_peak = cnt / (double) npeaks;
+
+	CPPUNIT_ASSERT (samples_per_visual_peak >= 4096);
+	CPPUNIT_ASSERT_EQUAL (0, _source->read_peaks (peaks, npeaks, start, cnt, samples_per_visual_peak));
+
+	CPPUNIT_ASSERT_DOUBLES_EQUAL (start / (double) _length, peaks[0].min, 1e-6);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL ((start + cnt - 1) / (double) _length, peaks[npeaks - 1].max, 1e-6);
+
+	if (npeaks == 2) {
+		/* the visual peaks may share a level peak, but stay within the range */
+		CPPUNIT_ASSERT (peaks[0].max <= peaks[1].max);
+		CPPUNIT_ASSERT (peaks[1].min >= peaks[0].min);
+		CPPUNIT_ASSERT (peaks[0].max < (start + cnt) / (double) _length);
+		CPPUNIT_ASSERT (peaks[1].min >= start / (double) _length);
+	}
+}
+
+void
+PeakLevelsTest::readTest ()
+{
+	/* aligned to the first level (4096 samples per peak) */
+	check_read (0, _length, 1);
+	check_read (4096, 65536, 2);
+
+	/* ranges starting and ending within level peaks */
+	check_read (256, 8192, 1);
+	check_read (3 * 256, 65536 + 5 * 256, 1);
+	check_read (65536 + 256, 2 * 65536 - 512, 2);
+	check_read (12 * 256, 3 * 65536 + 7 * 256, 2);
+}
+
+void
+PeakLevelsTest::buildTest ()
+{
+	/* build the levels from the peakfile rather than while writing it */
+	CPPUNIT_ASSERT_EQUAL (0, _source->prepare_peak_levels (true));
+
+	check_read (0, _length, 1);
+	check_read (3 * 256, 65536 + 5 * 256, 1);
+	check_read (12 * 256, 3 * 65536 + 7 * 256, 2);
+}
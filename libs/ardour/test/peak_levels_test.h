@@ -0,0 +1,48 @@
+/*
+    Copyright (C) 2018 Paul Davis
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+#include <boost/shared_ptr.hpp>
+#include "test_needing_session.h"
+
+namespace ARDOUR {
+	class AudioSource;
+}
+
+/** Tests of reading peaks from the coarser peak levels of an AudioSource */
+class PeakLevelsTest : public TestNeedingSession
+{
+	CPPUNIT_TEST_SUITE (PeakLevelsTest);
+	CPPUNIT_TEST (readTest);
+	CPPUNIT_TEST (buildTest);
+	CPPUNIT_TEST_SUITE_END ();
+
+public:
+	void setUp ();
+	void tearDown ();
+
+	void readTest ();
+	void buildTest ();
+
+private:
+	void check_read (ARDOUR::samplepos_t start, ARDOUR::samplecnt_t cnt, ARDOUR::samplecnt_t npeaks);
+
+	bool _build_peakfiles;
+	/** a source which is a rising ramp, sample n having the value n / _length */
+	boost::shared_ptr<ARDOUR::AudioSource> _source;
+	ARDOUR::samplecnt_t _length;
+};
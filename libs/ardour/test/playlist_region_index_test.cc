@@ -0,0 +1,116 @@
+/*
+    Copyright (C) 2018 Paul Davis
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+#include "ardour/playlist.h"
+#include "ardour/region.h"
+#include "playlist_region_index_test.h"
+
+CPPUNIT_TEST_SUITE_REGISTRATION (PlaylistRegionIndexTest);
+
+using namespace std;
+using namespace ARDOUR;
+
+static bool
+contains (boost::shared_ptr<RegionList> rl, boost::shared_ptr<Region> r)
+{
+	return find (rl->begin(), rl->end(), r) != rl->end();
+}
+
+void
+PlaylistRegionIndexTest::touchedTest ()
+{
+	/* regions are 100 samples long: [0, 99], [50, 149], [400, 499], and
+	   a long one [1000, 1099] that starts before a short one [1020, 1119]
+	*/
+	_playlist->add_region (_r[0], 0);
+	_playlist->add_region (_r[1], 50);
+	_playlist->add_region (_r[2], 400);
+	_playlist->add_region (_r[3], 1000);
+	_playlist->add_region (_r[4], 1020);
+
+	boost::shared_ptr<RegionList> rl = _playlist->regions_touched (60, 90);
+	CPPUNIT_ASSERT_EQUAL (size_t (2), rl->size ());
+	CPPUNIT_ASSERT (contains (rl, _r[0]));
+	CPPUNIT_ASSERT (contains (rl, _r[1]));
+
+	rl = _playlist->regions_touched (149, 399);
+	CPPUNIT_ASSERT_EQUAL (size_t (1), rl->size ());
+	CPPUNIT_ASSERT (contains (rl, _r[1]));
+
+	rl = _playlist->regions_touched (150, 399);
+	CPPUNIT_ASSERT (rl->empty ());
+
+	rl = _playlist->regions_at (1050);
+	CPPUNIT_ASSERT_EQUAL (size_t (2), rl->size ());
+	CPPUNIT_ASSERT_EQUAL (uint32_t (2), _playlist->count_regions_at (1050));
+	CPPUNIT_ASSERT_EQUAL (uint32_t (0), _playlist->count_regions_at (2000));
+
+	rl = _playlist->regions_with_start_within (Evoral::Range<samplepos_t> (50, 1000));
+	CPPUNIT_ASSERT_EQUAL (size_t (3), rl->size ());
+	CPPUNIT_ASSERT (!contains (rl, _r[0]));
+
+	rl = _playlist->regions_with_end_within (Evoral::Range<samplepos_t> (99, 1100));
+	CPPUNIT_ASSERT_EQUAL (size_t (4), rl->size ());
+	CPPUNIT_ASSERT (!contains (rl, _r[4]));
+}
+
+void
+PlaylistRegionIndexTest::editTest ()
+{
+	_playlist->add_region (_r[0], 0);
+	_playlist->add_region (_r[1], 200);
+
+	CPPUNIT_ASSERT_EQUAL (_r[1], _playlist->top_region_at (250));
+
+	/* a moved region must be found at its new position only */
+	_r[1]->set_position (500);
+	CPPUNIT_ASSERT (!_playlist->top_region_at (250));
+	CPPUNIT_ASSERT_EQUAL (_r[1], _playlist->top_region_at (550));
+
+	/* likewise for a trimmed region */
+	_r[0]->trim_end (49);
+	CPPUNIT_ASSERT (!_playlist->top_region_at (60));
+	CPPUNIT_ASSERT_EQUAL (_r[0], _playlist->top_region_at (40));
+
+	_playlist->add_region (_r[2], 20);
+	CPPUNIT_ASSERT_EQUAL (uint32_t (2), _playlist->count_regions_at (40));
+
+	_playlist->remove_region (_r[0]);
+	CPPUNIT_ASSERT_EQUAL (uint32_t (1), _playlist->count_regions_at (40));
+	CPPUNIT_ASSERT_EQUAL (_r[2], _playlist->top_region_at (40));
+
+	_playlist->clear ();
+	CPPUNIT_ASSERT_EQUAL (uint32_t (0), _playlist->count_regions_at (550));
+}
+
+void
+PlaylistRegionIndexTest::nextRegionTest ()
+{
+	_playlist->add_region (_r[0], 0);
+	_playlist->add_region (_r[1], 300);
+	_playlist->add_region (_r[2], 600);
+
+	CPPUNIT_ASSERT_EQUAL (_r[1], _playlist->find_next_region (0, Start, 1));
+	CPPUNIT_ASSERT_EQUAL (_r[1], _playlist->find_next_region (299, Start, 1));
+	CPPUNIT_ASSERT_EQUAL (_r[2], _playlist->find_next_region (300, Start, 1));
+	CPPUNIT_ASSERT (!_playlist->find_next_region (600, Start, 1));
+
+	CPPUNIT_ASSERT_EQUAL (_r[1], _playlist->find_next_region (600, Start, -1));
+	CPPUNIT_ASSERT_EQUAL (_r[2], _playlist->find_next_region (601, Start, -1));
+	CPPUNIT_ASSERT (!_playlist->find_next_region (0, Start, -1));
+}
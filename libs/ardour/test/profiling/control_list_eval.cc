@@ -0,0 +1,181 @@
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+#include <vector>
+
+#include <glib.h>
+
+#include "pbd/compose.h"
+
+#include "evoral/ControlList.hpp"
+#include "evoral/Curve.hpp"
+#include "evoral/Parameter.hpp"
+#include "evoral/ParameterDescriptor.hpp"
+
+using namespace std;
+
+static const int n_points = 100000;
+static const int block_size = 1024;
+static int failures = 0;
+
+/** The value of @a list at @a x, found by walking the list from the start
+ *  as ControlList::unlocked_eval() used to.
+ */
+static double
+linear_scan_eval (Evoral::ControlList const & list, double x)
+{
+	Evoral::ControlList::EventList const & events (list.events ());
+
+	if (x <= events.front()->when) {
+		return events.front()->value;
+	}
+	if (x >= events.back()->when) {
+		return events.back()->value;
+	}
+
+	Evoral::ControlList::const_iterator after = events.begin ();
+	while ((*after)->when < x) {
+		++after;
+	}
+	if ((*after)->when == x) {
+		return (*after)->value;
+	}
+
+	Evoral::ControlList::const_iterator before = after;
+	--before;
+
+	const double fraction = (x - (*before)->when) / ((*after)->when - (*before)->when);
+	return (*before)->value + fraction * ((*after)->value - (*before)->value);
+}
+
+static void
+report (string const & name, int n, gint64 t)
+{
+	cout << string_compose ("  %1: %2 ns per value\n", name, (t * 1000.0) / n);
+}
+
+static void
+check (string const & what, double x, double expected, double value, double tolerance)
+{
+	if (fabs (expected - value) > tolerance) {
+		cerr << string_compose ("%1 at %2: %3 instead of %4\n", what, x, value, expected);
+		++failures;
+	}
+}
+
+/** Evaluate a linear automation list of 100k points in random order,
+ *  sequentially (as automation playback does), in process-sized vectors
+ *  and by searching for the next event, and compare the results with a
+ *  linear scan of the list.
+ *
+ *  Usage: control_list_eval [points]
+ */
+int
+main (int argc, char* argv[])
+{
+	int points = n_points;
+
+	if (argc > 1) {
+		points = atoi (argv[1]);
+	}
+
+	Evoral::ParameterDescriptor desc;
+	desc.lower = -1;
+	desc.upper = 1;
+
+	Evoral::ControlList list (Evoral::Parameter (0), desc);
+	list.set_interpolation (Evoral::ControlList::Linear);
+	list.create_curve ();
+
+	srandom (1);
+
+	double when = 0;
+	for (int n = 0; n < points; ++n) {
+		/* every 100th point is a step: a second event at the same time */
+		list.fast_simple_add (when, sin (n / 100.0));
+		if (n % 100 == 99) {
+			list.fast_simple_add (when, -sin (n / 100.0));
+		}
+		when += 1 + random () % 64;
+	}
+
+	const double end = when;
+
+	cout << string_compose ("%1 control points over %2 samples\n", list.size (), end);
+
+	/* random access */
+
+	const int n_random = 100000;
+	const int n_checked = 1000;
+	vector<double> xs (n_random);
+	for (int n = 0; n < n_random; ++n) {
+		xs[n] = (random () / (double) RAND_MAX) * end;
+	}
+
+	gint64 before = g_get_monotonic_time ();
+	double sum = 0;
+	for (int n = 0; n < n_random; ++n) {
+		sum += list.eval (xs[n]);
+	}
+	report ("eval, random", n_random, g_get_monotonic_time () - before);
+
+	before = g_get_monotonic_time ();
+	for (int n = 0; n < n_checked; ++n) {
+		check ("eval", xs[n], linear_scan_eval (list, xs[n]), list.eval (xs[n]), 1e-9);
+	}
+	report ("linear scan, random", n_checked, g_get_monotonic_time () - before);
+
+	/* sequential access, one value at a time */
+
+	before = g_get_monotonic_time ();
+	int n_sequential = 0;
+	for (double x = 0; x < end; x += 7.0, ++n_sequential) {
+		sum += list.eval (x);
+	}
+	report ("eval, sequential", n_sequential, g_get_monotonic_time () - before);
+
+	/* sequential access, in process-sized vectors */
+
+	vector<float> vec (block_size);
+	const double span = block_size - 1;
+
+	before = g_get_monotonic_time ();
+	int n_blocks = 0;
+	for (double x = 0; x < end; x += block_size, ++n_blocks) {
+		list.curve().get_vector (x, x + span, &vec[0], block_size);
+	}
+	report ("get_vector, sequential", n_blocks * block_size, g_get_monotonic_time () - before);
+
+	for (int n = 0; n < 16; ++n) {
+		const double x = floor ((random () / (double) RAND_MAX) * end);
+		list.curve().get_vector (x, x + span, &vec[0], block_size);
+		for (int i = 0; i < block_size; ++i) {
+			check ("get_vector", x + i, linear_scan_eval (list, x + i), vec[i], 1e-6);
+		}
+	}
+
+	/* searching for the next event, as automation playback does to find
+	 * the next point at which to change a value.
+	 */
+
+	before = g_get_monotonic_time ();
+	int n_events = 0;
+	double x = 0;
+	double y;
+	while (list.rt_safe_earliest_event (x, x, y)) {
+		++n_events;
+	}
+	report ("rt_safe_earliest_event, sequential", n_events, g_get_monotonic_time () - before);
+
+	/* keep the evaluation from being optimized away */
+	if (sum == HUGE_VAL) {
+		cout << sum << "\n";
+	}
+
+	if (failures) {
+		cerr << string_compose ("%1 values differ from a linear scan\n", failures);
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
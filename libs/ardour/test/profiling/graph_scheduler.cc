@@ -0,0 +1,97 @@
+#include <iostream>
+#include <cstdlib>
+
+#include "pbd/compose.h"
+
+#include "ardour/ardour.h"
+#include "ardour/io.h"
+#include "ardour/port.h"
+#include "ardour/rc_configuration.h"
+#include "ardour/route.h"
+#include "ardour/session.h"
+#include "ardour/utils.h"
+
+#include "test_util.h"
+
+using namespace std;
+using namespace PBD;
+using namespace ARDOUR;
+
+static const char* localedir = LOCALEDIR;
+
+/** Connect all audio outputs of @a from to the audio inputs of @a to */
+static void
+connect_routes (boost::shared_ptr<Route> from, boost::shared_ptr<Route> to)
+{
+	PortSet& out = from->output()->ports ();
+	PortSet& in = to->input()->ports ();
+
+	for (uint32_t c = 0; c < out.num_ports (DataType::AUDIO); ++c) {
+		boost::shared_ptr<Port> p = in.port (DataType::AUDIO, c % in.num_ports (DataType::AUDIO));
+		from->output()->connect (out.port (DataType::AUDIO, c), p->name(), 0);
+	}
+}
+
+/** Build a synthetic route graph and compare the shared trigger-queue
+ *  scheduler of ARDOUR::Graph with the per-thread work-stealing one.
+ *
+ *  The topology is:  n_sources routes -> n_busses busses -> master,
+ *  with every bus being fed by n_sources / n_busses routes.
+ */
+int
+main (int argc, char* argv[])
+{
+	if (argc != 4) {
+		cerr << "Syntax: " << argv[0] << " <n-sources> <n-busses> <seconds>\n";
+		exit (EXIT_FAILURE);
+	}
+
+	uint32_t const n_sources = atoi (argv[1]);
+	uint32_t const n_busses = atoi (argv[2]);
+	int const seconds = atoi (argv[3]);
+
+	if (n_sources == 0 || n_busses == 0 || seconds <= 0) {
+		cerr << "Invalid arguments\n";
+		exit (EXIT_FAILURE);
+	}
+
+	ARDOUR::init (false, true, localedir);
+
+	/* the process graph is only used with more than one DSP thread */
+	Config->set_processor_usage (0);
+	Config->set_graph_work_stealing (false);
+
+	Session* session = create_profiling_session ();
+
+	RouteList sources = session->new_audio_route (2, 2, 0, n_sources, "source", PresentationInfo::AudioBus, PresentationInfo::max_order);
+	RouteList busses = session->new_audio_route (2, 2, 0, n_busses, "bus", PresentationInfo::AudioBus, PresentationInfo::max_order);
+
+	if (sources.size () != n_sources || busses.size () != n_busses) {
+		cerr << "Failed to create routes\n";
+		exit (EXIT_FAILURE);
+	}
+
+	uint32_t n = 0;
+	for (RouteList::iterator i = sources.begin(); i != sources.end(); ++i, ++n) {
+		RouteList::iterator b = busses.begin ();
+		std::advance (b, n % n_busses);
+		(*i)->output()->disconnect (0);
+		connect_routes (*i, *b);
+	}
+
+	for (RouteList::iterator b = busses.begin(); b != busses.end(); ++b) {
+		(*b)->output()->disconnect (0);
+		connect_routes (*b, session->master_out ());
+	}
+
+	cout << string_compose ("INFO: %1 routes, %2 DSP threads.\n", session->get_routes()->size(), how_many_dsp_threads ());
+
+	measure_dsp_load ("shared trigger queue", seconds);
+
+	Config->set_graph_work_stealing (true);
+	measure_dsp_load ("work stealing", seconds);
+
+	destroy_profiling_session (session);
+
+	return 0;
+}
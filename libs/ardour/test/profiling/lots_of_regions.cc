@@ -1,3 +1,8 @@
+#include <iostream>
+#include <cstdlib>
+
+#include <glib.h>
+
 #include "test_util.h"
 #include "ardour/ardour.h"
 #include "ardour/midi_track.h"
@@ -12,9 +17,60 @@ using namespace PBD;
 
 static const char* localedir = LOCALEDIR;
 
+static const int n_queries = 10000;
+
+/** Time range queries on @a playlist, both using the playlist's region
+ *  index and by walking a copy of its region list (as Playlist used to).
+ */
+static void
+time_queries (boost::shared_ptr<Playlist> playlist, samplepos_t extent)
+{
+	boost::shared_ptr<RegionList> all = playlist->region_list ();
+	samplecnt_t const width = extent / all->size ();
+
+	size_t found_indexed = 0;
+	size_t found_linear = 0;
+
+	srand (1);
+	gint64 before = g_get_monotonic_time ();
+	for (int n = 0; n < n_queries; ++n) {
+		samplepos_t const start = rand () % extent;
+		found_indexed += playlist->regions_touched (start, start + width)->size ();
+	}
+	gint64 const indexed = g_get_monotonic_time () - before;
+
+	srand (1);
+	before = g_get_monotonic_time ();
+	for (int n = 0; n < n_queries; ++n) {
+		samplepos_t const start = rand () % extent;
+		for (RegionList::const_iterator i = all->begin(); i != all->end(); ++i) {
+			if ((*i)->coverage (start, start + width) != Evoral::OverlapNone) {
+				++found_linear;
+			}
+		}
+	}
+	gint64 const linear = g_get_monotonic_time () - before;
+
+	assert (found_indexed == found_linear);
+
+	before = g_get_monotonic_time ();
+	for (int n = 0; n < n_queries; ++n) {
+		playlist->top_region_at (rand () % extent);
+	}
+	gint64 const top = g_get_monotonic_time () - before;
+
+	cout << all->size () << " regions, " << n_queries << " queries:\n"
+	     << "\tregions_touched (indexed): " << indexed << " us\n"
+	     << "\tregions_touched (linear):  " << linear << " us\n"
+	     << "\ttop_region_at (indexed):   " << top << " us\n";
+}
+
 int
 main (int argc, char* argv[])
 {
+	/* number of copies of the region; comped takes can easily make 20k+ */
+	int const copies = argc > 1 ? atoi (argv[1]) : 1000;
+
 	ARDOUR::init (false, true, localedir);
 	Session* session = load_session ("../libs/ardour/test/profiling/sessions/1region", "1region");
 
@@ -35,7 +91,7 @@ main (int argc, char* argv[])
 	/* Duplicate it a lot */
 	session->begin_reversible_command ("foo");
 	playlist->clear_changes ();
-	playlist->duplicate (region, region->last_sample() + 1, 1000);
+	playlist->duplicate (region, region->last_sample() + 1, copies);
 	session->add_command (new StatefulDiffCommand (playlist));
 	session->commit_reversible_command ();
 
@@ -45,7 +101,9 @@ main (int argc, char* argv[])
 	/* And do it again */
 	session->begin_reversible_command ("foo");
 	playlist->clear_changes ();
-	playlist->duplicate (region, region->last_sample() + 1, 1000);
+	playlist->duplicate (region, region->last_sample() + 1, copies);
 	session->add_command (new StatefulDiffCommand (playlist));
 	session->commit_reversible_command ();
+
+	time_queries (playlist, region->position() + (copies + 1) * region->length());
 }
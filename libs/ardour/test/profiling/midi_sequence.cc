@@ -0,0 +1,229 @@
+#include <algorithm>
+#include <iostream>
+#include <cstdlib>
+#include <vector>
+
+#include <glib.h>
+
+#include "pbd/compose.h"
+
+#include "evoral/Beats.hpp"
+#include "evoral/Control.hpp"
+#include "evoral/ControlList.hpp"
+#include "evoral/Event.hpp"
+#include "evoral/ParameterDescriptor.hpp"
+#include "evoral/Sequence.hpp"
+#include "evoral/TypeMap.hpp"
+#include "evoral/midi_events.h"
+
+using namespace std;
+
+typedef Evoral::Beats Time;
+typedef Evoral::Sequence<Time> Sequence;
+
+static const int n_chords = 25000;
+static const int chord_size = 4;
+static int failures = 0;
+
+class TypeMap : public Evoral::TypeMap
+{
+  public:
+	bool type_is_midi (uint32_t) const { return true; }
+	uint8_t parameter_midi_type (Evoral::Parameter const &) const { return 0; }
+	Evoral::ParameterType midi_parameter_type (uint8_t const *, uint32_t) const { return 0; }
+	Evoral::ParameterDescriptor descriptor (Evoral::Parameter const &) const { return Evoral::ParameterDescriptor (); }
+	std::string to_symbol (Evoral::Parameter const &) const { return "control"; }
+};
+
+class NoteSequence : public Sequence
+{
+  public:
+	NoteSequence (TypeMap const & map) : Sequence (map) {}
+
+	boost::shared_ptr<Evoral::Control> control_factory (Evoral::Parameter const & param) {
+		Evoral::ParameterDescriptor const desc;
+		boost::shared_ptr<Evoral::ControlList> list (new Evoral::ControlList (param, desc));
+		return boost::shared_ptr<Evoral::Control> (new Evoral::Control (param, desc, list));
+	}
+};
+
+static void
+report (string const & name, int n, gint64 t)
+{
+	cout << string_compose ("  %1: %2 ns per %3\n", name, (t * 1000.0) / n, n);
+}
+
+static void
+check (string const & what, bool ok)
+{
+	if (!ok) {
+		cerr << what << "\n";
+		++failures;
+	}
+}
+
+/** Load a sequence of 100k notes (in chords of four, as an orchestral
+ *  mockup might have), iterate over it as playback and the GUI do, and
+ *  edit it the way MidiModel::NoteDiffCommand does, checking that the
+ *  sequence stays consistent.
+ *
+ *  Usage: midi_sequence [chords]
+ */
+int
+main (int argc, char* argv[])
+{
+	int chords = n_chords;
+
+	if (argc > 1) {
+		chords = atoi (argv[1]);
+	}
+
+	const int n_notes = chords * chord_size;
+
+	srandom (1);
+
+	/* creating notes */
+
+	vector<Sequence::NotePtr> notes;
+	notes.reserve (n_notes);
+
+	gint64 before = g_get_monotonic_time ();
+	for (int n = 0; n < n_notes; ++n) {
+		notes.push_back (Sequence::NotePtr (new Evoral::Note<Time> (0, Time (), Time (), 60, 100)));
+	}
+	notes.clear ();
+	report ("create and destroy note with new", n_notes, g_get_monotonic_time () - before);
+
+	before = g_get_monotonic_time ();
+	for (int n = 0; n < n_notes; ++n) {
+		notes.push_back (Sequence::make_note (0, Time (), Time (), 60, 100));
+	}
+	notes.clear ();
+	report ("create and destroy note with make_note", n_notes, g_get_monotonic_time () - before);
+
+	/* loading: each chord is a beat long, its notes half a beat, and the
+	 * same pitch is not used twice in a row on any channel.
+	 */
+
+	vector<uint8_t> data (n_notes * 2 * 3);
+	vector<Evoral::Event<Time> > events;
+	events.reserve (n_notes * 2);
+
+	for (int c = 0; c < chords; ++c) {
+		for (int n = 0; n < chord_size * 2; ++n) {
+			const bool on = n < chord_size;
+			uint8_t* buf = &data[events.size() * 3];
+			buf[0] = (on ? MIDI_CMD_NOTE_ON : MIDI_CMD_NOTE_OFF) | (c % 16);
+			buf[1] = 48 + (c * 5 + (n % chord_size) * 4) % 48;
+			buf[2] = on ? 1 + random () % 127 : 64;
+			events.push_back (Evoral::Event<Time> (Evoral::MIDI_EVENT, Time::beats (c) + Time (on ? 0 : 0.5), 3, buf));
+		}
+	}
+
+	TypeMap type_map;
+	NoteSequence seq (type_map);
+
+	before = g_get_monotonic_time ();
+	seq.start_write ();
+	for (vector<Evoral::Event<Time> >::const_iterator e = events.begin(); e != events.end(); ++e) {
+		seq.append (*e, Evoral::next_event_id ());
+	}
+	seq.end_write (Sequence::Relax);
+	report ("load, per note", n_notes, g_get_monotonic_time () - before);
+
+	check (string_compose ("%1 notes loaded instead of %2", seq.n_notes (), n_notes), (int) seq.n_notes () == n_notes);
+
+	/* iterating over all events, as playback and export do */
+
+	before = g_get_monotonic_time ();
+	int n_events = 0;
+	Time last;
+	for (Sequence::const_iterator i = seq.begin (); i != seq.end (); ++i, ++n_events) {
+		if (i->time () < last) {
+			check (string_compose ("event at %1 follows one at %2", i->time (), last), false);
+		}
+		last = i->time ();
+	}
+	report ("iterate, per event", n_events, g_get_monotonic_time () - before);
+
+	check (string_compose ("iterated over %1 events instead of %2", n_events, n_notes * 2), n_events == n_notes * 2);
+
+	/* iterating over the notes, as the GUI does */
+
+	before = g_get_monotonic_time ();
+	int velocities = 0;
+	for (Sequence::Notes::const_iterator n = seq.notes().begin(); n != seq.notes().end(); ++n) {
+		velocities += (*n)->velocity ();
+	}
+	report ("iterate over notes, per note", n_notes, g_get_monotonic_time () - before);
+
+	/* starting playback at random positions */
+
+	const int n_seeks = 1000;
+	before = g_get_monotonic_time ();
+	for (int n = 0; n < n_seeks; ++n) {
+		Sequence::const_iterator i = seq.begin (Time::beats (random () % chords));
+	}
+	report ("seek", n_seeks, g_get_monotonic_time () - before);
+
+	/* editing: move every tenth note a quarter of a beat later and
+	 * transpose every tenth note an octave up, removing each note while it
+	 * changes and adding it back afterwards so that the indices stay sorted.
+	 */
+
+	vector<Sequence::NotePtr> to_edit;
+	int n = 0;
+	for (Sequence::Notes::const_iterator i = seq.notes().begin(); i != seq.notes().end(); ++i, ++n) {
+		if (n % 10 == 0) {
+			to_edit.push_back (*i);
+		}
+	}
+
+	before = g_get_monotonic_time ();
+	{
+		Sequence::WriteLock lock (seq.write_lock ());
+		for (vector<Sequence::NotePtr>::const_iterator i = to_edit.begin(); i != to_edit.end(); ++i) {
+			seq.remove_note_unlocked (*i);
+			(*i)->set_time ((*i)->time () + Time (0.25));
+			seq.add_note_unlocked (*i);
+		}
+		for (vector<Sequence::NotePtr>::const_iterator i = to_edit.begin(); i != to_edit.end(); ++i) {
+			seq.remove_note_unlocked (*i);
+			(*i)->set_note ((*i)->note () + 12);
+			seq.add_note_unlocked (*i);
+		}
+	}
+	report ("edit, per change", to_edit.size () * 2, g_get_monotonic_time () - before);
+
+	check (string_compose ("%1 notes after editing instead of %2", seq.n_notes (), n_notes), (int) seq.n_notes () == n_notes);
+
+	for (vector<Sequence::NotePtr>::const_iterator i = to_edit.begin(); i != to_edit.end(); ++i) {
+		check (string_compose ("edited note %1 not found", **i), seq.contains (*i));
+	}
+
+	uint8_t lowest = 127;
+	uint8_t highest = 0;
+	last = Time ();
+	for (Sequence::Notes::const_iterator i = seq.notes().begin(); i != seq.notes().end(); ++i) {
+		check (string_compose ("note at %1 follows one at %2", (*i)->time (), last), (*i)->time () >= last);
+		check (string_compose ("note %1 not indexed by pitch", **i), seq.contains (*i));
+		lowest = min (lowest, (*i)->note ());
+		highest = max (highest, (*i)->note ());
+		last = (*i)->time ();
+	}
+
+	check (string_compose ("note range %1 .. %2 instead of %3 .. %4", (int) seq.lowest_note (), (int) seq.highest_note (), (int) lowest, (int) highest),
+	       seq.lowest_note () == lowest && seq.highest_note () == highest);
+
+	/* keep the iteration from being optimized away */
+	if (velocities == 0) {
+		cout << velocities << "\n";
+	}
+
+	if (failures) {
+		cerr << string_compose ("%1 checks failed\n", failures);
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,369 @@
+#ifdef WAF_BUILD
+#include "libardour-config.h"
+#endif
+
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include <glib.h>
+
+#include "pbd/compose.h"
+#include "pbd/fpu.h"
+
+#include "evoral/Curve.hpp"
+
+#include "ardour/ardour.h"
+#include "ardour/automation_list.h"
+#include "ardour/mix.h"
+#include "ardour/runtime_functions.h"
+
+using namespace std;
+using namespace ARDOUR;
+
+static const char* localedir = LOCALEDIR;
+
+static const pframes_t n_samples = 8192;
+static int n_iterations = 10000;
+
+/** One implementation of the runtime_functions table.
+ *  Functions which a variant does not provide are 0.
+ */
+struct Variant {
+	const char* name;
+	bool available;
+	compute_peak_t compute_peak;
+	find_peaks_t find_peaks;
+	apply_gain_to_buffer_t apply_gain_to_buffer;
+	mix_buffers_with_gain_t mix_buffers_with_gain;
+	mix_buffers_no_gain_t mix_buffers_no_gain;
+	copy_vector_t copy_vector;
+	apply_gain_vector_t apply_gain_vector;
+	mix_buffers_with_gain_vector_t mix_buffers_with_gain_vector;
+	crossfade_buffers_t crossfade_buffers;
+};
+
+static vector<Variant>
+variants ()
+{
+	vector<Variant> v;
+
+#if defined (ARCH_X86) && defined (BUILD_SSE_OPTIMIZATIONS)
+	PBD::FPU* fpu = PBD::FPU::instance ();
+
+	Variant sse = { "sse", fpu->has_sse (),
+		x86_sse_compute_peak, x86_sse_find_peaks, x86_sse_apply_gain_to_buffer,
+		x86_sse_mix_buffers_with_gain, x86_sse_mix_buffers_no_gain, 0,
+		x86_sse_apply_gain_vector, x86_sse_mix_buffers_with_gain_vector, x86_sse_crossfade_buffers };
+	v.push_back (sse);
+
+	Variant avx = { "avx", fpu->has_avx (),
+		x86_sse_avx_compute_peak, x86_sse_avx_find_peaks, x86_sse_avx_apply_gain_to_buffer,
+		x86_sse_avx_mix_buffers_with_gain, x86_sse_avx_mix_buffers_no_gain, x86_sse_avx_copy_vector,
+		x86_sse_avx_apply_gain_vector, x86_sse_avx_mix_buffers_with_gain_vector, x86_sse_avx_crossfade_buffers };
+	v.push_back (avx);
+
+#ifdef BUILD_FMA_OPTIMIZATIONS
+	Variant fma = { "fma", fpu->has_fma (),
+		0, 0, 0, x86_fma_mix_buffers_with_gain, 0, 0,
+		0, x86_fma_mix_buffers_with_gain_vector, x86_fma_crossfade_buffers };
+	v.push_back (fma);
+#endif
+
+#ifdef BUILD_AVX512F_OPTIMIZATIONS
+	Variant avx512f = { "avx512f", fpu->has_avx512f (),
+		x86_avx512f_compute_peak, x86_avx512f_find_peaks, x86_avx512f_apply_gain_to_buffer,
+		x86_avx512f_mix_buffers_with_gain, x86_avx512f_mix_buffers_no_gain, x86_avx512f_copy_vector,
+		x86_avx512f_apply_gain_vector, x86_avx512f_mix_buffers_with_gain_vector, x86_avx512f_crossfade_buffers };
+	v.push_back (avx512f);
+#endif
+#endif
+
+#if defined (__APPLE__) && defined (BUILD_VECLIB_OPTIMIZATIONS)
+	Variant veclib = { "veclib", true,
+		veclib_compute_peak, veclib_find_peaks, veclib_apply_gain_to_buffer,
+		veclib_mix_buffers_with_gain, veclib_mix_buffers_no_gain, 0,
+		veclib_apply_gain_vector, veclib_mix_buffers_with_gain_vector, veclib_crossfade_buffers };
+	v.push_back (veclib);
+#endif
+
+	Variant dispatched = { "dispatched", true,
+		compute_peak, find_peaks, apply_gain_to_buffer,
+		mix_buffers_with_gain, mix_buffers_no_gain, copy_vector,
+		apply_gain_vector, mix_buffers_with_gain_vector, crossfade_buffers };
+	v.push_back (dispatched);
+
+	return v;
+}
+
+static Variant const reference = { "default", true,
+	default_compute_peak, default_find_peaks, default_apply_gain_to_buffer,
+	default_mix_buffers_with_gain, default_mix_buffers_no_gain, default_copy_vector,
+	default_apply_gain_vector, default_mix_buffers_with_gain_vector, default_crossfade_buffers };
+
+/* ---- validation ---- */
+
+/** number of samples around the processed range which must not be touched */
+static const pframes_t guard = 32;
+static const float canary = 1234.5f;
+
+struct Buffers {
+	Buffers (pframes_t offset, pframes_t n)
+		: offset (offset)
+		, n (n)
+		, size (guard + offset + n + guard)
+		, dst (size, canary)
+		, src (size, canary)
+		, gain (size, canary)
+		, gain2 (size, canary)
+	{
+		for (pframes_t i = 0; i < n; ++i) {
+			dst[guard + offset + i] = 2.f * rand () / RAND_MAX - 1.f;
+			src[guard + offset + i] = 2.f * rand () / RAND_MAX - 1.f;
+			gain[guard + offset + i] = (float) rand () / RAND_MAX;
+			gain2[guard + offset + i] = (float) rand () / RAND_MAX;
+		}
+	}
+
+	Sample* d () { return &dst[guard + offset]; }
+	Sample* s () { return &src[guard + offset]; }
+	gain_t* g () { return &gain[guard + offset]; }
+	gain_t* g2 () { return &gain2[guard + offset]; }
+
+	pframes_t offset;
+	pframes_t n;
+	size_t size;
+	vector<Sample> dst;
+	vector<Sample> src;
+	vector<gain_t> gain;
+	vector<gain_t> gain2;
+};
+
+static int failures = 0;
+
+static void
+fail (Variant const & v, string const & function, Buffers const & b, string const & what)
+{
+	if (++failures <= 20) {
+		cerr << string_compose ("FAIL %1 %2 (offset %3, %4 samples): %5\n", v.name, function, b.offset, b.n, what);
+	}
+}
+
+static bool
+close_enough (float a, float b)
+{
+	/* FMA rounds once where the reference rounds twice */
+	return fabsf (a - b) <= 1e-6f * max (1.f, max (fabsf (a), fabsf (b)));
+}
+
+/** Compare the dst buffers of @a a (reference) and @a b, including the guard areas */
+static void
+compare (Variant const & v, string const & function, Buffers const & a, Buffers const & b)
+{
+	for (size_t i = 0; i < a.size; ++i) {
+		if (!close_enough (a.dst[i], b.dst[i])) {
+			bool const in_guard = i < guard + a.offset || i >= guard + a.offset + a.n;
+			fail (v, function, b, string_compose ("%1 at %2: %3 instead of %4",
+			                                      in_guard ? "wrote outside buffer" : "wrong result",
+			                                      (int) i - (int) (guard + a.offset), b.dst[i], a.dst[i]));
+			return;
+		}
+	}
+}
+
+#define CHECK_BUFFER_FUNCTION(name, call) \
+	if (v.name) { \
+		srand (seed); Buffers ref (offset, n); \
+		srand (seed); Buffers test (offset, n); \
+		{ Variant const & f (reference); Buffers& b (ref); call; } \
+		{ Variant const & f (v); Buffers& b (test); call; } \
+		compare (v, #name, ref, test); \
+	}
+
+static void
+validate (Variant const & v)
+{
+	/* all lengths up to a few times the widest vector (16 floats),
+	 * plus some long ones, starting at every offset up to 16 samples.
+	 * All buffers share the same misalignment, as they do in Ardour
+	 * (the older assembler SSE functions rely on it).
+	 */
+	vector<pframes_t> lengths;
+	for (pframes_t n = 0; n < 67; ++n) {
+		lengths.push_back (n);
+	}
+	lengths.push_back (1023);
+	lengths.push_back (1024);
+	lengths.push_back (4099);
+
+	unsigned seed = 1;
+
+	for (pframes_t offset = 0; offset < 16; ++offset) {
+		for (vector<pframes_t>::const_iterator l = lengths.begin(); l != lengths.end(); ++l, ++seed) {
+			pframes_t const n = *l;
+
+			if (v.compute_peak) {
+				srand (seed);
+				Buffers b (offset, n);
+				float const current = 0.25f;
+				float const expected = reference.compute_peak (b.d (), n, current);
+				float const got = v.compute_peak (b.d (), n, current);
+				if (got != expected) {
+					fail (v, "compute_peak", b, string_compose ("%1 instead of %2", got, expected));
+				}
+			}
+
+			if (v.find_peaks && n > 0) {
+				srand (seed);
+				Buffers b (offset, n);
+				float emin = 0.5f, emax = -0.5f;
+				float gmin = 0.5f, gmax = -0.5f;
+				reference.find_peaks (b.d (), n, &emin, &emax);
+				v.find_peaks (b.d (), n, &gmin, &gmax);
+				if (gmin != emin || gmax != emax) {
+					fail (v, "find_peaks", b, string_compose ("[%1, %2] instead of [%3, %4]", gmin, gmax, emin, emax));
+				}
+			}
+
+			CHECK_BUFFER_FUNCTION (apply_gain_to_buffer, f.apply_gain_to_buffer (b.d (), n, 0.7f));
+			CHECK_BUFFER_FUNCTION (mix_buffers_with_gain, f.mix_buffers_with_gain (b.d (), b.s (), n, 0.7f));
+			CHECK_BUFFER_FUNCTION (mix_buffers_no_gain, f.mix_buffers_no_gain (b.d (), b.s (), n));
+			CHECK_BUFFER_FUNCTION (copy_vector, f.copy_vector (b.d (), b.s (), n));
+			CHECK_BUFFER_FUNCTION (apply_gain_vector, f.apply_gain_vector (b.d (), b.g (), n));
+			CHECK_BUFFER_FUNCTION (mix_buffers_with_gain_vector, f.mix_buffers_with_gain_vector (b.d (), b.s (), b.g (), n));
+			CHECK_BUFFER_FUNCTION (crossfade_buffers, f.crossfade_buffers (b.d (), b.s (), b.g (), b.g2 (), n));
+			CHECK_BUFFER_FUNCTION (crossfade_buffers, f.crossfade_buffers (b.d (), b.s (), b.g (), 0, n));
+		}
+	}
+}
+
+/* ---- benchmark ---- */
+
+static void
+report (string const & name, gint64 generic, gint64 t)
+{
+	cout << string_compose ("  %1: %2 us (x %3)\n", name, t, generic / (double) max (t, (gint64) 1));
+}
+
+static void
+benchmark (Variant const & v)
+{
+	/* misaligned by one sample, as buffers are when reading regions */
+	vector<Sample> dst (n_samples + 1);
+	vector<Sample> src (n_samples + 1);
+	vector<gain_t> gain (n_samples + 1);
+	vector<gain_t> gain2 (n_samples + 1);
+
+	for (pframes_t n = 0; n <= n_samples; ++n) {
+		src[n] = 2.f * rand () / RAND_MAX - 1.f;
+		gain[n] = n / (float) n_samples;
+		gain2[n] = 1.f - gain[n];
+	}
+
+	Sample* d = &dst[1];
+	Sample const* s = &src[1];
+	gain_t const* g = &gain[1];
+	gain_t const* g2 = &gain2[1];
+
+	cout << v.name << ":\n";
+
+#define BENCH(function, call) \
+	if (v.function) { \
+		gint64 before = g_get_monotonic_time (); \
+		for (int i = 0; i < n_iterations; ++i) { reference.call; } \
+		gint64 const generic = g_get_monotonic_time () - before; \
+		before = g_get_monotonic_time (); \
+		for (int i = 0; i < n_iterations; ++i) { v.call; } \
+		report (#function, generic, g_get_monotonic_time () - before); \
+	}
+
+	float peak = 0;
+	float pmin = 0, pmax = 0;
+
+	BENCH (compute_peak, compute_peak (s, n_samples, peak));
+	BENCH (find_peaks, find_peaks (s, n_samples, &pmin, &pmax));
+	BENCH (apply_gain_to_buffer, apply_gain_to_buffer (d, n_samples, 0.999f));
+	BENCH (mix_buffers_with_gain, mix_buffers_with_gain (d, s, n_samples, 0.001f));
+	BENCH (mix_buffers_no_gain, mix_buffers_no_gain (d, s, n_samples));
+	BENCH (copy_vector, copy_vector (d, s, n_samples));
+	BENCH (apply_gain_vector, apply_gain_vector (d, g, n_samples));
+	BENCH (mix_buffers_with_gain_vector, mix_buffers_with_gain_vector (d, s, g, n_samples));
+	BENCH (crossfade_buffers, crossfade_buffers (d, s, g, g2, n_samples));
+}
+
+/** Evaluate a 64 point fade, like AudioRegion's default fades, per sample and
+ *  with Curve::get_vector
+ */
+static void
+benchmark_curve ()
+{
+	vector<gain_t> gain (n_samples);
+
+	boost::shared_ptr<AutomationList> fade (new AutomationList (Evoral::Parameter (FadeInAutomation)));
+	fade->create_curve ();
+
+	for (int n = 0; n < 64; ++n) {
+		double const x = n / 63.0;
+		fade->fast_simple_add (x * n_samples, sin (x * M_PI / 2.0));
+	}
+
+	gint64 before = g_get_monotonic_time ();
+	for (int i = 0; i < n_iterations; ++i) {
+		for (pframes_t n = 0; n < n_samples; ++n) {
+			gain[n] = fade->eval (n);
+		}
+	}
+	gint64 const generic = g_get_monotonic_time () - before;
+
+	before = g_get_monotonic_time ();
+	for (int i = 0; i < n_iterations; ++i) {
+		fade->curve().get_vector (0, n_samples - 1, &gain[0], n_samples);
+	}
+
+	cout << "fade curve:\n";
+	report ("get_vector vs. eval per sample", generic, g_get_monotonic_time () - before);
+}
+
+/** Check every implementation of the runtime mixing functions which this CPU
+ *  can run against the default_* reference versions (with misaligned heads
+ *  and odd-length tails, and checking nothing outside the buffer is
+ *  written), then time them.
+ *
+ *  Usage: mix_kernels [iterations]    (0 iterations: validate only)
+ */
+int
+main (int argc, char* argv[])
+{
+	if (argc > 1) {
+		n_iterations = atoi (argv[1]);
+	}
+
+	ARDOUR::init (false, true, localedir);
+
+	vector<Variant> const all = variants ();
+
+	for (vector<Variant>::const_iterator v = all.begin(); v != all.end(); ++v) {
+		if (!v->available) {
+			cout << string_compose ("%1: not supported by this CPU, skipped\n", v->name);
+			continue;
+		}
+		int const before = failures;
+		validate (*v);
+		cout << string_compose ("%1: %2\n", v->name, failures == before ? "ok" : "FAILED");
+	}
+
+	if (n_iterations > 0) {
+		for (vector<Variant>::const_iterator v = all.begin(); v != all.end(); ++v) {
+			if (v->available) {
+				benchmark (*v);
+			}
+		}
+		benchmark_curve ();
+	}
+
+	ARDOUR::cleanup ();
+
+	return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,129 @@
+#include <iostream>
+#include <cmath>
+#include <cstdlib>
+
+#include <glibmm/timer.h>
+
+#include "pbd/compose.h"
+
+#include "ardour/ardour.h"
+#include "ardour/audioengine.h"
+#include "ardour/automation_control.h"
+#include "ardour/automation_list.h"
+#include "ardour/lua_api.h"
+#include "ardour/plugin_insert.h"
+#include "ardour/rc_configuration.h"
+#include "ardour/route.h"
+#include "ardour/session.h"
+
+#include "test_util.h"
+
+using namespace std;
+using namespace PBD;
+using namespace ARDOUR;
+
+static const char* localedir = LOCALEDIR;
+
+/** Roll from the start of the session for @a seconds and report the DSP
+ *  load the engine measured.
+ *  @return the average DSP load.
+ */
+static float
+measure (Session* session, string const & name, int seconds)
+{
+	session->request_locate (0, true);
+
+	float const load = measure_dsp_load (name, seconds);
+
+	session->request_transport_speed (0.0);
+	Glib::usleep (500000);
+
+	return load;
+}
+
+/** Play routes with a chain of plugin inserts each, all with densely
+ *  automated parameters, with sample-accurate automation and with
+ *  automation batched to a few quanta.
+ *
+ *  For dense automation, run from the build directory with an event
+ *  every sample or every few samples, e.g.
+ *
+ *    libs/ardour/run-profiling.sh plugin_automation 32 4 1 10
+ *    libs/ardour/run-profiling.sh plugin_automation 32 4 8 10
+ */
+int
+main (int argc, char* argv[])
+{
+	if (argc != 5) {
+		cerr << "Syntax: " << argv[0] << " <n-routes> <n-plugins-per-route> <samples-between-automation-events> <seconds>\n";
+		exit (EXIT_FAILURE);
+	}
+
+	uint32_t const n_routes = atoi (argv[1]);
+	uint32_t const n_plugins = atoi (argv[2]);
+	uint32_t const spacing = atoi (argv[3]);
+	int const seconds = atoi (argv[4]);
+
+	if (n_routes == 0 || n_plugins == 0 || spacing == 0 || seconds <= 0) {
+		cerr << "Invalid arguments\n";
+		exit (EXIT_FAILURE);
+	}
+
+	ARDOUR::init (false, true, localedir);
+
+	Session* session = create_profiling_session ();
+
+	RouteList routes = session->new_audio_route (2, 2, 0, n_routes, "automated", PresentationInfo::AudioBus, PresentationInfo::max_order);
+
+	if (routes.size () != n_routes) {
+		cerr << "Failed to create routes\n";
+		exit (EXIT_FAILURE);
+	}
+
+	/* enough automation for the measurement and some slack */
+	samplepos_t const length = (seconds + 2) * session->nominal_sample_rate ();
+
+	for (RouteList::iterator r = routes.begin(); r != routes.end(); ++r) {
+		for (uint32_t n = 0; n < n_plugins; ++n) {
+			boost::shared_ptr<PluginInsert> pi = boost::dynamic_pointer_cast<PluginInsert> (LuaAPI::new_luaproc (session, "a-Amplifier"));
+			if (!pi || (*r)->add_processor (pi, PreFader)) {
+				cerr << "Failed to add a-Amplifier\n";
+				exit (EXIT_FAILURE);
+			}
+
+			boost::shared_ptr<AutomationControl> ac = pi->automation_control (Evoral::Parameter (PluginAutomation, 0, 0));
+			if (!ac) {
+				cerr << "a-Amplifier has no gain control\n";
+				exit (EXIT_FAILURE);
+			}
+
+			boost::shared_ptr<AutomationList> al = ac->alist ();
+			for (samplepos_t s = 0; s < length; s += spacing) {
+				al->fast_simple_add (s, -6.0 + 6.0 * sin (s * 2.0 * M_PI / session->nominal_sample_rate ()));
+			}
+			ac->set_automation_state (Play);
+		}
+	}
+
+	cout << string_compose ("INFO: %1 routes, %2 plugins per route, an automation event every %3 samples, %4 samples per cycle.\n",
+	                        routes.size (), n_plugins, spacing, AudioEngine::instance()->samples_per_cycle ());
+
+	uint32_t const quanta[] = { 0, 16, 32, 64 };
+
+	size_t const n_quanta = sizeof (quanta) / sizeof (quanta[0]);
+	float loads[n_quanta];
+
+	for (size_t q = 0; q < n_quanta; ++q) {
+		Config->set_plugin_automation_quantum (quanta[q]);
+		loads[q] = measure (session, quanta[q] ? string_compose ("quantum %1", quanta[q]) : string ("sample-accurate"), seconds);
+	}
+
+	cout << "quantum\tavg DSP load\trelative to sample-accurate\n";
+	for (size_t q = 0; q < n_quanta; ++q) {
+		cout << string_compose ("%1\t%2%%\t%3\n", quanta[q], loads[q], loads[0] > 0 ? loads[q] / loads[0] : 0);
+	}
+
+	destroy_profiling_session (session);
+
+	return 0;
+}
@@ -0,0 +1,133 @@
+/*
+    Copyright (C) 2018 Paul Davis
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+#include <iostream>
+#include <cstdlib>
+#include <list>
+
+#include <boost/bind.hpp>
+
+#include "pbd/compose.h"
+
+#include "ardour/ardour.h"
+#include "ardour/chan_mapping.h"
+#include "ardour/lua_api.h"
+#include "ardour/plugin_insert.h"
+#include "ardour/rc_configuration.h"
+#include "ardour/route.h"
+#include "ardour/session.h"
+#include "ardour/utils.h"
+
+#include "test_util.h"
+
+using namespace std;
+using namespace PBD;
+using namespace ARDOUR;
+
+static const char* localedir = LOCALEDIR;
+
+typedef std::list<boost::shared_ptr<PluginInsert> > Inserts;
+
+/** Swap the outputs of the first two channels of @a pi, or undo that */
+static void
+set_crossed (boost::shared_ptr<PluginInsert> pi, bool crossed)
+{
+	ChanMapping m (pi->natural_output_streams ());
+	if (crossed) {
+		m.set (DataType::AUDIO, 0, 1);
+		m.set (DataType::AUDIO, 1, 0);
+	}
+	pi->set_output_map (0, m);
+}
+
+/** Switch every other insert in @a inserts between in-place and no-inplace
+ *  processing.
+ */
+static void
+toggle_crossed (Inserts const * inserts, bool* crossed)
+{
+	*crossed = !*crossed;
+
+	int k = 0;
+	for (Inserts::const_iterator p = inserts->begin(); p != inserts->end(); ++p, ++k) {
+		if (k % 2) {
+			set_crossed (*p, *crossed);
+		}
+	}
+}
+
+/** Run routes with a chain of plugin inserts each, half of which process
+ *  in-place and half not, while their pin mappings are being changed.
+ *
+ *  When built with --rt-alloc-debug, any heap allocation by a process
+ *  thread aborts the program.
+ */
+int
+main (int argc, char* argv[])
+{
+	if (argc != 4) {
+		cerr << "Syntax: " << argv[0] << " <n-routes> <n-plugins-per-route> <seconds>\n";
+		exit (EXIT_FAILURE);
+	}
+
+	uint32_t const n_routes = atoi (argv[1]);
+	uint32_t const n_plugins = atoi (argv[2]);
+	int const seconds = atoi (argv[3]);
+
+	if (n_routes == 0 || n_plugins == 0 || seconds <= 0) {
+		cerr << "Invalid arguments\n";
+		exit (EXIT_FAILURE);
+	}
+
+	ARDOUR::init (false, true, localedir);
+
+	/* use the process graph, whose threads are checked by --rt-alloc-debug */
+	Config->set_processor_usage (0);
+
+	Session* session = create_profiling_session ();
+
+	RouteList routes = session->new_audio_route (2, 2, 0, n_routes, "pins", PresentationInfo::AudioBus, PresentationInfo::max_order);
+
+	if (routes.size () != n_routes) {
+		cerr << "Failed to create routes\n";
+		exit (EXIT_FAILURE);
+	}
+
+	Inserts inserts;
+
+	for (RouteList::iterator r = routes.begin(); r != routes.end(); ++r) {
+		for (uint32_t n = 0; n < n_plugins; ++n) {
+			boost::shared_ptr<PluginInsert> pi = boost::dynamic_pointer_cast<PluginInsert> (LuaAPI::new_luaproc (session, "a-Amplifier"));
+			if (!pi || (*r)->add_processor (pi, PreFader)) {
+				cerr << "Failed to add a-Amplifier\n";
+				exit (EXIT_FAILURE);
+			}
+			inserts.push_back (pi);
+		}
+	}
+
+	cout << string_compose ("INFO: %1 routes, %2 plugins, %3 DSP threads.\n", routes.size (), inserts.size (), how_many_dsp_threads ());
+
+	/* reconfigure the pin mappings every second while measuring */
+	bool crossed = false;
+	measure_dsp_load ("pin changes", seconds, boost::bind (&toggle_crossed, &inserts, &crossed));
+
+	destroy_profiling_session (session);
+
+	return 0;
+}
@@ -0,0 +1,118 @@
+#include <sys/resource.h>
+
+#include <iostream>
+#include <fstream>
+#include <iterator>
+#include <cstdlib>
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <glibmm/miscutils.h>
+
+#include "test_util.h"
+#include "pbd/compose.h"
+#include "pbd/failed_constructor.h"
+#include "pbd/xml++.h"
+#include "ardour/ardour.h"
+#include "ardour/audioengine.h"
+#include "ardour/session.h"
+
+using namespace std;
+using namespace ARDOUR;
+
+static const char* localedir = LOCALEDIR;
+
+/** @return peak resident set size of this process, in kilobytes */
+static long
+peak_rss ()
+{
+	struct rusage usage;
+	getrusage (RUSAGE_SELF, &usage);
+	return usage.ru_maxrss;
+}
+
+static string
+contents (string const & path)
+{
+	ifstream f (path.c_str (), ios::binary);
+	return string (istreambuf_iterator<char> (f), istreambuf_iterator<char> ());
+}
+
+/** Load a session and save its state twice: once streamed to disk through
+ *  an XMLWriter, as Session::save_state() does, and once by building the
+ *  whole XMLNode tree first, as it used to.  Report the time taken and the
+ *  growth in peak RSS of each, and check that the two files are identical.
+ *
+ *  The streamed save is done first, since the peak RSS never goes down.
+ *
+ *  Usage: save_session <dir> <snapshot-name>
+ */
+int
+main (int argc, char* argv[])
+{
+	if (argc != 3) {
+		cerr << "Syntax: " << argv[0] << " <dir> <snapshot-name>\n";
+		exit (EXIT_FAILURE);
+	}
+
+	ARDOUR::init (false, true, localedir);
+
+	Session* s = 0;
+
+	try {
+		s = load_session (argv[1], argv[2]);
+	} catch (failed_constructor& e) {
+		cerr << "failed_constructor: " << e.what() << "\n";
+		exit (EXIT_FAILURE);
+	} catch (AudioEngine::PortRegistrationFailure& e) {
+		cerr << "PortRegistrationFailure: " << e.what() << "\n";
+		exit (EXIT_FAILURE);
+	} catch (exception& e) {
+		cerr << "exception: " << e.what() << "\n";
+		exit (EXIT_FAILURE);
+	} catch (...) {
+		cerr << "unknown exception.\n";
+		exit (EXIT_FAILURE);
+	}
+
+	const string streamed = Glib::build_filename (g_get_tmp_dir (), "save_session_streamed.ardour");
+	const string tree = Glib::build_filename (g_get_tmp_dir (), "save_session_tree.ardour");
+
+	int ret = EXIT_SUCCESS;
+
+	long rss = peak_rss ();
+	gint64 before = g_get_monotonic_time ();
+	if (!s->write_state (streamed)) {
+		cerr << "could not write " << streamed << "\n";
+		ret = EXIT_FAILURE;
+	}
+	cout << string_compose ("streamed: %1 ms, peak RSS +%2 kB\n", (g_get_monotonic_time () - before) / 1000.0, peak_rss () - rss);
+
+	rss = peak_rss ();
+	before = g_get_monotonic_time ();
+	{
+		XMLTree t;
+		t.set_root (&s->get_state ());
+		if (!t.write (tree)) {
+			cerr << "could not write " << tree << "\n";
+			ret = EXIT_FAILURE;
+		}
+	}
+	cout << string_compose ("XMLTree:  %1 ms, peak RSS +%2 kB\n", (g_get_monotonic_time () - before) / 1000.0, peak_rss () - rss);
+
+	if (ret == EXIT_SUCCESS && contents (streamed) != contents (tree)) {
+		cerr << "streamed state differs from XMLTree state\n";
+		ret = EXIT_FAILURE;
+	}
+
+	g_remove (streamed.c_str ());
+	g_remove (tree.c_str ());
+
+	AudioEngine::instance()->remove_session ();
+	delete s;
+	AudioEngine::instance()->stop ();
+
+	AudioEngine::destroy ();
+
+	return ret;
+}
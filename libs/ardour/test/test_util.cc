@@ -16,11 +16,15 @@
     with this program; if not, write to the Free Software Foundation, Inc.,
     675 Mass Ave, Cambridge, MA 02139, USA.
 */
+#include <algorithm>
+#include <iostream>
 #include <sstream>
 
 #include <glibmm/fileutils.h>
 #include <glibmm/miscutils.h>
+#include <glibmm/timer.h>
 
+#include "pbd/compose.h"
 #include "pbd/xml++.h"
 #include "pbd/file_utils.h"
 
@@ -129,6 +133,57 @@ load_session (string dir, string state)
 	return session;
 }
 
+/** Start the dummy backend and load the empty session which the profiling
+ *  programs add their routes to.  Run from the build directory.
+ */
+Session *
+create_profiling_session ()
+{
+	create_and_start_dummy_backend ();
+	return load_session ("../libs/ardour/test/profiling/sessions/0tracks", "0tracks");
+}
+
+void
+destroy_profiling_session (Session* session)
+{
+	AudioEngine::instance()->remove_session ();
+	delete session;
+	stop_and_destroy_backend ();
+}
+
+/** Let the engine run for @a seconds, calling @a each_second (if set) at the
+ *  start of every second, and print the average and maximum DSP load it
+ *  measured, labelled @a name.
+ *  @return the average DSP load.
+ */
+float
+measure_dsp_load (string const & name, int seconds, boost::function<void()> each_second)
+{
+	float sum = 0;
+	float max = 0;
+	int n = 0;
+
+	/* let the engine settle */
+	Glib::usleep (500000);
+
+	for (int i = 0; i < seconds * 10; ++i) {
+		if (i % 10 == 0 && each_second) {
+			each_second ();
+		}
+
+		Glib::usleep (100000);
+
+		float const l = AudioEngine::instance()->get_dsp_load ();
+		sum += l;
+		max = std::max (max, l);
+		++n;
+	}
+
+	cout << string_compose ("%1: avg DSP load %2%% max %3%%\n", name, sum / n, max);
+
+	return sum / n;
+}
+
 PBD::Searchpath
 test_search_path ()
 {
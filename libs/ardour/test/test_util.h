@@ -23,6 +23,8 @@
 #include <string>
 #include <list>
 
+#include <boost/function.hpp>
+
 #include "pbd/search_path.h"
 
 class XMLNode;
@@ -43,6 +45,10 @@ extern void create_and_start_dummy_backend ();
 extern void stop_and_destroy_backend ();
 extern ARDOUR::Session* load_session (std::string, std::string);
 
+extern ARDOUR::Session* create_profiling_session ();
+extern void destroy_profiling_session (ARDOUR::Session *);
+extern float measure_dsp_load (std::string const &, int, boost::function<void()> each_second = boost::function<void()> ());
+
 void get_utf8_test_strings (std::vector<std::string>& results);
 
 #endif
@@ -630,6 +630,12 @@ Track::do_refill ()
 	return _disk_reader->do_refill ();
 }
 
+int
+Track::do_refill (Sample* mixdown_buffer, gain_t* gain_buffer)
+{
+	return _disk_reader->do_refill (mixdown_buffer, gain_buffer);
+}
+
 int
 Track::do_flush (RunContext c, bool force)
 {
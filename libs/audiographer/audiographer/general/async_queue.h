@@ -0,0 +1,227 @@
+#ifndef AUDIOGRAPHER_ASYNC_QUEUE_H
+#define AUDIOGRAPHER_ASYNC_QUEUE_H
+
+#include <glibmm/threadpool.h>
+#include <glibmm/threads.h>
+#include <sigc++/slot.h>
+#include <boost/format.hpp>
+
+#include <glib.h>
+#include <algorithm>
+
+#include "pbd/ringbuffer.h"
+
+#include "audiographer/visibility.h"
+#include "audiographer/flag_debuggable.h"
+#include "audiographer/sink.h"
+#include "audiographer/exception.h"
+#include "audiographer/utils/listed_source.h"
+#include "audiographer/general/threader.h"
+
+namespace AudioGrapher
+{
+
+/** A class that passes data on to its outputs in another thread.
+  * process() copies the data to a lock-free ringbuffer and returns, a job
+  * scheduled to the given thread pool passes the queued data on to the outputs.
+  * Only one job per queue runs at a time, so the outputs see the data
+  * in the order it was queued, in chunks of at most \a max_samples samples.
+  */
+template <typename T = DefaultSampleType>
+class /*LIBAUDIOGRAPHER_API*/ AsyncQueue
+  : public ListedSource<T>
+  , public Sink<T>
+  , public FlagDebuggable<>
+{
+  public:
+
+	/** Constructor
+	  * \n NOT RT safe
+	  * \param thread_pool a thread pool from which the output jobs are scheduled
+	  * \param max_samples maximum amount of samples passed to the outputs at a time
+	  * \param n_chunks the queue holds \a n_chunks times \a max_samples samples
+	  */
+	AsyncQueue (Glib::ThreadPool & thread_pool, samplecnt_t max_samples, unsigned int n_chunks = 8)
+	  : thread_pool (thread_pool)
+	  , max_samples (max_samples)
+	  , data (max_samples * n_chunks)
+	  , chunks (n_chunks * 4)
+	  , scheduled (0)
+	  , failed (0)
+	{
+		buffer = new T[max_samples];
+		add_supported_flag (ProcessContext<T>::EndOfInput);
+	}
+
+	~AsyncQueue ()
+	{
+		wait ();
+		delete [] buffer;
+	}
+
+	/** Queues the data in \a c and schedules passing it on to the outputs.
+	  * Waits if the queue is full. Throws the first exception an output threw, if any.
+	  * \n NOT RT safe
+	  */
+	void process (ProcessContext<T> const & c)
+	{
+		check_flags (*this, c);
+		rethrow ();
+
+		samplecnt_t const chunk_size = max_samples - (max_samples % c.channels());
+
+		if (chunk_size == 0) {
+			throw Exception (*this, boost::str (boost::format
+				("Maximum chunk size (%1%) is smaller than the channel count (%2%)")
+				% max_samples % c.channels()));
+		}
+
+		samplecnt_t position = 0;
+
+		/* queue at least one chunk, so that the outputs see EndOfInput
+		 * even with an empty context
+		 */
+		do {
+			Chunk chunk;
+			chunk.samples = std::min (c.samples() - position, chunk_size);
+			chunk.channels = c.channels();
+
+			wait_for_space (chunk.samples);
+			data.write (&c.data()[position], chunk.samples);
+
+			position += chunk.samples;
+			chunk.end_of_input = position == c.samples() && c.has_flag (ProcessContext<T>::EndOfInput);
+			chunks.write (&chunk, 1);
+
+			schedule ();
+		} while (position < c.samples());
+	}
+
+	using Sink<T>::process;
+
+	/** Waits until all queued data has been passed on to the outputs.
+	  * \n NOT RT safe
+	  */
+	void wait ()
+	{
+		Glib::Threads::Mutex::Lock lm (mutex);
+		while (g_atomic_int_get (&scheduled) || chunks.read_space () > 0) {
+			cond.wait (mutex);
+		}
+	}
+
+	/** Waits like wait() and throws the first exception an output threw, if any.
+	  * \n NOT RT safe
+	  */
+	void flush ()
+	{
+		wait ();
+		rethrow ();
+	}
+
+  private:
+
+	struct Chunk {
+		samplecnt_t  samples;
+		ChannelCount channels;
+		bool         end_of_input;
+	};
+
+	void wait_for_space (samplecnt_t samples)
+	{
+		if (data.write_space () >= (guint) samples && chunks.write_space () > 0) {
+			return;
+		}
+
+		Glib::Threads::Mutex::Lock lm (mutex);
+		while (data.write_space () < (guint) samples || chunks.write_space () == 0) {
+			cond.wait (mutex);
+		}
+	}
+
+	void schedule ()
+	{
+		if (g_atomic_int_compare_and_exchange (&scheduled, 0, 1)) {
+			thread_pool.push (sigc::mem_fun (this, &AsyncQueue::run));
+		}
+	}
+
+	void run ()
+	{
+		while (true) {
+			Chunk chunk;
+
+			while (chunks.read (&chunk, 1) == 1) {
+				data.read (buffer, chunk.samples);
+
+				/* let process() continue while the outputs run */
+				mutex.lock ();
+				cond.broadcast ();
+				mutex.unlock ();
+
+				ProcessContext<T> c (buffer, chunk.samples, chunk.channels);
+				if (chunk.end_of_input) {
+					c.set_flag (ProcessContext<T>::EndOfInput);
+				}
+				process_output (c);
+			}
+
+			/* data queued after the last read either sees scheduled == 0
+			 * and schedules a new job, or is picked up here.
+			 */
+			Glib::Threads::Mutex::Lock lm (mutex);
+			g_atomic_int_set (&scheduled, 0);
+			if (chunks.read_space () == 0 || !g_atomic_int_compare_and_exchange (&scheduled, 0, 1)) {
+				cond.broadcast ();
+				return;
+			}
+		}
+	}
+
+	void process_output (ProcessContext<T> const & c)
+	{
+		if (g_atomic_int_get (&failed)) {
+			// discard data after an error, but keep the queue moving
+			return;
+		}
+
+		try {
+			ListedSource<T>::output (c);
+		} catch (std::exception const & e) {
+			exception_mutex.lock ();
+			exception.reset (new ThreaderException (*this, e));
+			g_atomic_int_set (&failed, 1);
+			exception_mutex.unlock ();
+		}
+	}
+
+	void rethrow ()
+	{
+		Glib::Threads::Mutex::Lock lm (exception_mutex);
+		if (exception) {
+			boost::shared_ptr<ThreaderException> e (exception);
+			exception.reset ();
+			g_atomic_int_set (&failed, 0);
+			throw *e;
+		}
+	}
+
+	Glib::ThreadPool & thread_pool;
+	samplecnt_t        max_samples;
+	T *                buffer;
+
+	PBD::RingBuffer<T>     data;
+	PBD::RingBuffer<Chunk> chunks;
+	gint                   scheduled;
+	gint                   failed;
+
+	Glib::Threads::Mutex mutex;
+	Glib::Threads::Cond  cond;
+
+	Glib::Threads::Mutex exception_mutex;
+	boost::shared_ptr<ThreaderException> exception;
+};
+
+} // namespace
+
+#endif // AUDIOGRAPHER_ASYNC_QUEUE_H
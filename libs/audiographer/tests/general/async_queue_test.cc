@@ -0,0 +1,133 @@
+#include "tests/utils.h"
+
+#include "audiographer/general/async_queue.h"
+
+using namespace AudioGrapher;
+
+class AsyncQueueTest : public CppUnit::TestFixture
+{
+  CPPUNIT_TEST_SUITE (AsyncQueueTest);
+  CPPUNIT_TEST (testProcess);
+  CPPUNIT_TEST (testFullQueue);
+  CPPUNIT_TEST (testEndOfInput);
+  CPPUNIT_TEST (testExceptions);
+  CPPUNIT_TEST_SUITE_END ();
+
+  public:
+	void setUp()
+	{
+		samples = 128;
+		random_data = TestUtils::init_random_data (samples, 1.0);
+
+		thread_pool = new Glib::ThreadPool (3);
+
+		sink.reset (new AppendingVectorSink<float>());
+		grabber.reset (new ProcessContextGrabber<float>());
+		throwing_sink.reset (new ThrowingSink<float>());
+	}
+
+	void tearDown()
+	{
+		queue.reset ();
+
+		delete [] random_data;
+
+		thread_pool->shutdown();
+		delete thread_pool;
+	}
+
+	void testProcess()
+	{
+		queue.reset (new AsyncQueue<float> (*thread_pool, samples));
+		queue->add_output (sink);
+
+		ProcessContext<float> c (random_data, samples, 1);
+		queue->process (c);
+		queue->process (c);
+		queue->flush ();
+
+		CPPUNIT_ASSERT_EQUAL (samples * 2, (samplecnt_t) sink->get_data().size());
+		CPPUNIT_ASSERT (TestUtils::array_equals (random_data, sink->get_array(), samples));
+		CPPUNIT_ASSERT (TestUtils::array_equals (random_data, &sink->get_array()[samples], samples));
+	}
+
+	void testFullQueue()
+	{
+		// The queue holds four contexts, process() has to wait for the output
+		queue.reset (new AsyncQueue<float> (*thread_pool, samples, 4));
+		queue->add_output (sink);
+
+		ProcessContext<float> c (random_data, samples, 1);
+		for (int i = 0; i < 100; ++i) {
+			queue->process (c);
+		}
+		queue->flush ();
+
+		CPPUNIT_ASSERT_EQUAL (samples * 100, (samplecnt_t) sink->get_data().size());
+		for (int i = 0; i < 100; ++i) {
+			CPPUNIT_ASSERT (TestUtils::array_equals (random_data, &sink->get_array()[i * samples], samples));
+		}
+	}
+
+	void testEndOfInput()
+	{
+		// Contexts larger than the maximum are split, keeping the channels interleaved
+		queue.reset (new AsyncQueue<float> (*thread_pool, 51));
+		queue->add_output (grabber);
+
+		ProcessContext<float> c (random_data, samples, 2);
+		c.set_flag (ProcessContext<float>::EndOfInput);
+		queue->process (c);
+		queue->flush ();
+
+		CPPUNIT_ASSERT_EQUAL ((size_t) 3, grabber->contexts.size());
+
+		ProcessContextGrabber<float>::ContextList::iterator it = grabber->contexts.begin();
+		CPPUNIT_ASSERT_EQUAL ((samplecnt_t) 50, it->samples());
+		CPPUNIT_ASSERT_EQUAL ((ChannelCount) 2, it->channels());
+		CPPUNIT_ASSERT (!it->has_flag (ProcessContext<float>::EndOfInput));
+		++it;
+		CPPUNIT_ASSERT_EQUAL ((samplecnt_t) 50, it->samples());
+		CPPUNIT_ASSERT (!it->has_flag (ProcessContext<float>::EndOfInput));
+		++it;
+		CPPUNIT_ASSERT_EQUAL ((samplecnt_t) 28, it->samples());
+		CPPUNIT_ASSERT (it->has_flag (ProcessContext<float>::EndOfInput));
+
+		// An empty context still passes on the flag
+		grabber->contexts.clear();
+		ProcessContext<float> empty (random_data, 0, 2);
+		empty.set_flag (ProcessContext<float>::EndOfInput);
+		queue->process (empty);
+		queue->flush ();
+
+		CPPUNIT_ASSERT_EQUAL ((size_t) 1, grabber->contexts.size());
+		CPPUNIT_ASSERT_EQUAL ((samplecnt_t) 0, grabber->contexts.front().samples());
+		CPPUNIT_ASSERT (grabber->contexts.front().has_flag (ProcessContext<float>::EndOfInput));
+	}
+
+	void testExceptions()
+	{
+		queue.reset (new AsyncQueue<float> (*thread_pool, samples));
+		queue->add_output (throwing_sink);
+
+		ProcessContext<float> c (random_data, samples, 1);
+		queue->process (c);
+		CPPUNIT_ASSERT_THROW (queue->flush (), Exception);
+
+		// The exception is only thrown once
+		queue->flush ();
+	}
+
+  private:
+	Glib::ThreadPool * thread_pool;
+
+	boost::shared_ptr<AsyncQueue<float> > queue;
+	boost::shared_ptr<AppendingVectorSink<float> > sink;
+	boost::shared_ptr<ProcessContextGrabber<float> > grabber;
+	boost::shared_ptr<ThrowingSink<float> > throwing_sink;
+
+	float * random_data;
+	samplecnt_t samples;
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION (AsyncQueueTest);
@@ -0,0 +1,123 @@
+#include <sys/time.h>
+#include <cairomm/context.h>
+#include <cairomm/surface.h>
+#include "canvas/canvas.h"
+#include "canvas/container.h"
+#include "canvas/rectangle.h"
+#include "benchmark.h"
+
+using namespace std;
+using namespace ArdourCanvas;
+
+/* Compare the default lookup table with the R-tree for picking, render
+ * culling and moving items in a container holding many small items, much
+ * like the notes in a large MIDI region.
+ */
+
+class HeadlessCanvas : public Canvas
+{
+public:
+	void request_redraw (Rect const &) {}
+	void request_size (Duple) {}
+	void grab (Item *) {}
+	void ungrab () {}
+	void focus (Item *) {}
+	void unfocus (Item *) {}
+	Rect visible_area () const { return Rect (0, 0, 1920, 1080); }
+	Coord width () const { return 1920; }
+	Coord height () const { return 1080; }
+	bool get_mouse_position (Duple &) const { return false; }
+	void re_enter () {}
+	Glib::RefPtr<Pango::Context> get_pango_context () { return Glib::RefPtr<Pango::Context> (); }
+
+protected:
+	void pick_current_item (int) {}
+	void pick_current_item (Duple const &, int) {}
+};
+
+static double
+seconds_since (timeval const & start)
+{
+	timeval stop;
+	gettimeofday (&stop, 0);
+
+	int sec = stop.tv_sec - start.tv_sec;
+	int usec = stop.tv_usec - start.tv_usec;
+	if (usec < 0) {
+		--sec;
+		usec += 1e6;
+	}
+
+	return sec + ((double) usec / 1e6);
+}
+
+static void
+test (int n_items, bool spatial_index)
+{
+	int const n_picks = 10000;
+	int const n_moves = 1000;
+	double const width = 200000;
+	double const height = 1080;
+
+	srand (1);
+
+	HeadlessCanvas canvas;
+	Container* group = new Container (canvas.root ());
+	group->set_spatial_index (spatial_index);
+
+	vector<Rectangle*> rectangles;
+
+	for (int i = 0; i < n_items; ++i) {
+		double const x = double_random () * width;
+		double const y = double_random () * height;
+		rectangles.push_back (new Rectangle (group, Rect (x, y, x + 5 + double_random () * 50, y + 8)));
+	}
+
+	timeval start;
+
+	/* pointer motion */
+
+	gettimeofday (&start, 0);
+	for (int i = 0; i < n_picks; ++i) {
+		vector<Item const *> items;
+		group->add_items_at_point (Duple (double_random () * 1920, double_random () * height), items);
+	}
+	double const pick = seconds_since (start);
+
+	/* expose, in strips as the canvas is scrolled */
+
+	Cairo::RefPtr<Cairo::ImageSurface> surface = Cairo::ImageSurface::create (Cairo::FORMAT_ARGB32, 1920, 1080);
+	Cairo::RefPtr<Cairo::Context> context = Cairo::Context::create (surface);
+
+	gettimeofday (&start, 0);
+	for (int x = 0; x < 1920; x += 64) {
+		canvas.render (Rect (x, 0, x + 64, height), context);
+	}
+	double const render = seconds_since (start);
+
+	/* drag notes about, picking after each move */
+
+	gettimeofday (&start, 0);
+	for (int i = 0; i < n_moves; ++i) {
+		Rectangle* r = rectangles[rand () % rectangles.size ()];
+		r->set_position (Duple (double_random () * 1920, r->position().y));
+		vector<Item const *> items;
+		group->add_items_at_point (Duple (double_random () * 1920, double_random () * height), items);
+	}
+	double const move = seconds_since (start);
+
+	cout << n_items << (spatial_index ? " rtree" : " linear")
+	     << " pick: " << pick << " render: " << render << " move+pick: " << move << "\n";
+}
+
+int main ()
+{
+	int tests[] = { 1000, 10000, 50000 };
+
+	for (unsigned int i = 0; i < sizeof (tests) / sizeof (int); ++i) {
+		test (tests[i], false);
+		test (tests[i], true);
+	}
+
+	return 0;
+}
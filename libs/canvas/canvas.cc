@@ -42,6 +42,7 @@
 #include "canvas/debug.h"
 #include "canvas/line.h"
 #include "canvas/scroll_group.h"
+#include "canvas/tile_cache.h"
 
 #ifdef __APPLE__
 #include <gdk/gdk.h>
@@ -222,6 +223,8 @@ Canvas::item_shown_or_hidden (Item* item)
 	if (bbox) {
 		if (item->item_to_window (bbox).intersection (visible_area ())) {
 			queue_draw_item_area (item, bbox);
+		} else {
+			invalidate_tiles (item, bbox);
 		}
 	}
 }
@@ -237,6 +240,8 @@ Canvas::item_visual_property_changed (Item* item)
 	if (bbox) {
 		if (item->item_to_window (bbox).intersection (visible_area ())) {
 			queue_draw_item_area (item, bbox);
+		} else {
+			invalidate_tiles (item, bbox);
 		}
 	}
 }
@@ -255,6 +260,8 @@ Canvas::item_changed (Item* item, Rect pre_change_bounding_box)
 		if (item->item_to_window (pre_change_bounding_box).intersection (window_bbox)) {
 			/* request a redraw of the item's old bounding box */
 			queue_draw_item_area (item, pre_change_bounding_box);
+		} else {
+			invalidate_tiles (item, pre_change_bounding_box);
 		}
 	}
 
@@ -272,6 +279,7 @@ Canvas::item_changed (Item* item, Rect pre_change_bounding_box)
 			item->prepare_for_render (window_intersection);
 		} else {
 			// No intersection with visible window area
+			invalidate_tiles (item, post_change_bounding_box);
 		}
 	}
 }
@@ -394,11 +402,32 @@ Canvas::item_moved (Item* item, Rect pre_change_parent_bounding_box)
  *  @param area Area to redraw in the item's coordinates.
  */
 void
-Canvas::queue_draw_item_area (Item* item, Rect area)
+Canvas::queue_draw_item_area (Item const * item, Rect area)
 {
+	invalidate_tiles (item, area);
 	request_redraw (item->item_to_window (area));
 }
 
+/** Tell the tile cache (if any) of the scroll group that contains an item
+ *  that part of it must be rendered again. This must be done whether or not
+ *  the area is currently visible, since tiles outlive scrolling.
+ *  @param item Item.
+ *  @param area Area in the item's coordinates.
+ */
+void
+Canvas::invalidate_tiles (Item const * item, Rect area)
+{
+	ScrollGroup const * sg = item->scroll_parent ();
+
+	if (!sg) {
+		sg = dynamic_cast<ScrollGroup const *> (item);
+	}
+
+	if (sg && sg->tile_cache ()) {
+		sg->tile_cache()->invalidate (item->item_to_canvas (area));
+	}
+}
+
 void
 Canvas::set_tooltip_timeout (uint32_t msecs)
 {
@@ -979,6 +1008,18 @@ GtkCanvas::prepare_for_render () const
 {
 	Rect window_bbox = visible_area ();
 	Canvas::prepare_for_render (window_bbox);
+
+	/* Also give items a page above and below the visible area the chance to
+	 * prepare, so that they are likely to be ready when scrolled into view.
+	 * Items are expected to treat this work as lower priority than anything
+	 * that is visible.
+	 */
+	const Distance page = window_bbox.height ();
+
+	if (page > 0) {
+		Canvas::prepare_for_render (Rect (window_bbox.x0, window_bbox.y0 - page, window_bbox.x1, window_bbox.y0));
+		Canvas::prepare_for_render (Rect (window_bbox.x0, window_bbox.y1, window_bbox.x1, window_bbox.y1 + page));
+	}
 }
 
 /** Handler for GDK scroll events.
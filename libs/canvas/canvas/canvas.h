@@ -108,6 +108,9 @@ public:
 	void item_changed (Item *, Rect);
 	void item_moved (Item *, Rect);
 
+	/** Request a redraw of an area given in an item's coordinates */
+	void queue_draw_item_area (Item const *, Rect);
+
 	Duple canvas_to_window (Duple const&, bool rounded = true) const;
 	Duple window_to_canvas (Duple const&) const;
 
@@ -177,7 +180,7 @@ protected:
 
 	static uint32_t tooltip_timeout_msecs;
 
-	void queue_draw_item_area (Item *, Rect);
+	void invalidate_tiles (Item const *, Rect);
 	virtual void pick_current_item (int state) = 0;
 	virtual void pick_current_item (Duple const &, int state) = 0;
 
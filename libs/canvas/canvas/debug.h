@@ -33,6 +33,7 @@ namespace PBD {
 		LIBCANVAS_API extern DebugBits CanvasEvents;
 		LIBCANVAS_API extern DebugBits CanvasRender;
 		LIBCANVAS_API extern DebugBits CanvasEnterLeave;
+		LIBCANVAS_API extern DebugBits CanvasTiles;
 	}
 }
 
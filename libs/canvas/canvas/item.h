@@ -221,6 +221,12 @@ public:
 	void lower_child_to_bottom (Item *);
 	virtual void child_changed ();
 
+	/** Find our children using an incrementally maintained spatial index
+	 *  rather than a linear search when rendering and picking.  Worthwhile
+	 *  for items with thousands of children.
+	 */
+	void set_spatial_index (bool);
+
 	static int default_items_per_cell;
 
 
@@ -310,7 +316,12 @@ protected:
 	void clear_items (bool with_delete);
 
 	void ensure_lut () const;
+	void lut_item_added (Item*) const;
+	void lut_item_removed (Item*) const;
+	void lut_items_reordered () const;
+	void lut_entry_changed () const;
 	mutable LookupTable* _lut;
+	bool _spatial_index;
 	/* our items, from lowest to highest in the stack */
 	std::list<Item*> _items;
 
@@ -20,13 +20,17 @@
 #ifndef __CANVAS_LOOKUP_TABLE_H__
 #define __CANVAS_LOOKUP_TABLE_H__
 
+#include <map>
+#include <set>
 #include <vector>
 #include <boost/multi_array.hpp>
+#include <stdint.h>
 
 #include "canvas/visibility.h"
 #include "canvas/types.h"
 
 class OptimizingLookupTableTest;
+class RTreeLookupTableTest;
 
 namespace ArdourCanvas {
 
@@ -42,6 +46,18 @@ public:
     virtual std::vector<Item*> items_at_point (Duple const &) const = 0;
     virtual bool has_item_at_point (Duple const & point) const = 0;
 
+    /** @return true if this table is kept up to date by the notifications
+     *  below; if false the table is deleted and rebuilt whenever our item's
+     *  children change.
+     */
+    virtual bool incremental () const { return false; }
+
+    virtual void item_added (Item *) {}
+    virtual void item_removed (Item *) {}
+    /** @param item child whose position or bounding box may have changed */
+    virtual void item_changed (Item const *) {}
+    virtual void items_reordered () {}
+
 protected:
 
     Item const & _item;
@@ -84,6 +100,91 @@ public:
     bool _added;
 };
 
+/** A lookup table which keeps our item's children in an R-tree, keyed on
+ *  their bounding boxes in our item's coordinates.  Changes to children are
+ *  noted as they happen and applied to the tree on the next lookup, so
+ *  moving one of many thousands of children does not require a rebuild.
+ */
+class LIBCANVAS_API RTreeLookupTable : public LookupTable
+{
+public:
+    RTreeLookupTable (Item const &);
+    ~RTreeLookupTable ();
+
+    std::vector<Item*> get (Rect const &);
+    std::vector<Item*> items_at_point (Duple const &) const;
+    bool has_item_at_point (Duple const & point) const;
+
+    bool incremental () const { return true; }
+    void item_added (Item *);
+    void item_removed (Item *);
+    void item_changed (Item const *);
+    void items_reordered ();
+
+    /** Distance around a point within which children are asked whether
+     *  they cover it, for items whose covers() reaches a little outside
+     *  their bounding box.
+     */
+    static Distance pick_margin;
+
+  private:
+
+    friend class ::RTreeLookupTableTest;
+
+    static size_t const max_branches = 16;
+    static size_t const min_branches = 6;
+
+    struct Node;
+    struct Entry;
+
+    struct Branch {
+        Rect rect;
+        Node* child;  /* only set in internal nodes */
+        Entry* entry; /* only set in leaf nodes */
+    };
+
+    struct Node {
+        Node (bool l) : parent (0), leaf (l) {}
+        Node* parent;
+        bool leaf;
+        std::vector<Branch> branches;
+
+        Rect cover () const;
+    };
+
+    struct Entry {
+        Entry () : item (0), leaf (0), order (0) {}
+        Item* item;
+        Rect rect;     /* bounding box in our item's coordinates */
+        Node* leaf;    /* 0 if the item is not in the tree */
+        int64_t order; /* position in our item's stack of children */
+    };
+
+    typedef std::map<Item const *, Entry> Entries;
+
+    mutable Node* _root;
+    mutable Entries _entries;
+    mutable std::set<Item const *> _dirty;
+    mutable bool _order_dirty;
+    mutable int64_t _min_order;
+    mutable int64_t _max_order;
+
+    void update () const;
+    void renumber () const;
+    Rect window_to_parent (Rect const &) const;
+    void search (Node const *, Rect const &, std::vector<Entry*>&) const;
+    std::vector<Item*> items_in (Rect const &) const;
+
+    void insert (Entry &, Rect const &) const;
+    void remove (Entry &) const;
+    void adjust (Node *) const;
+    Node* split (Node *) const;
+    void add_branch (Node *, Branch const &) const;
+    Branch& branch_for (Node *) const;
+    void collect (Node *, std::vector<Entry*>&) const;
+    void destroy (Node *) const;
+};
+
 }
 
 #endif
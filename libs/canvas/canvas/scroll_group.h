@@ -23,6 +23,8 @@
 
 namespace ArdourCanvas {
 
+class TileCache;
+
 /** A ScrollGroup has no contents of its own, but renders
  *  its children in a way that reflects the most recent
  *  call to its scroll_to() method.
@@ -37,6 +39,7 @@ class LIBCANVAS_API ScrollGroup : public Container
 
 	ScrollGroup (Canvas*, ScrollSensitivity);
 	ScrollGroup (Item*, ScrollSensitivity);
+	~ScrollGroup ();
 
 	void scroll_to (Duple const& d);
 	Duple scroll_offset() const { return _scroll_offset; }
@@ -48,9 +51,16 @@ class LIBCANVAS_API ScrollGroup : public Container
 
 	ScrollSensitivity sensitivity() const { return _scroll_sensitivity; }
 
+	/** Render our contents via a cache of pre-rendered tiles (see TileCache)
+	 *  rather than directly.
+	 */
+	void set_tile_cache (bool);
+	TileCache* tile_cache () const { return _tile_cache; }
+
   private:
 	ScrollSensitivity _scroll_sensitivity;
 	Duple             _scroll_offset;
+	TileCache*        _tile_cache;
 };
 
 }
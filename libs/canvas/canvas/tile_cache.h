@@ -0,0 +1,101 @@
+/*
+    Copyright (C) 2017 Paul Davis
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+#ifndef __CANVAS_TILE_CACHE_H__
+#define __CANVAS_TILE_CACHE_H__
+
+#include <map>
+#include <stdint.h>
+
+#include <cairomm/context.h>
+#include <cairomm/surface.h>
+
+#include "canvas/visibility.h"
+#include "canvas/types.h"
+
+namespace ArdourCanvas {
+
+class ScrollGroup;
+
+/** A cache of rendered tiles for the contents of a ScrollGroup.
+ *
+ *  Tiles are fixed-size images addressed in canvas coordinates, so they
+ *  stay valid while the group scrolls and only newly exposed parts of the
+ *  window have to be rendered from scratch. Changes to items inside the
+ *  group are reported via invalidate() (see Canvas::queue_draw_item_area())
+ *  and only the invalidated part of each tile is rendered again.
+ *
+ *  A tile only ever holds the part of itself that was visible when it was
+ *  rendered; nothing is rendered speculatively.
+ */
+class LIBCANVAS_API TileCache
+{
+  public:
+	TileCache (ScrollGroup const &);
+	~TileCache ();
+
+	/** Width and height of a tile in pixels */
+	static const int tile_size = 256;
+
+	/** Render @param area (in window coordinates) of our group to @param context,
+	 *  using and updating cached tiles. @param self is the window area occupied
+	 *  by the group.
+	 *
+	 *  @return false if the cache could not be used, in which case nothing
+	 *  has been drawn.
+	 */
+	bool render (Rect const & area, Rect const & self, Cairo::RefPtr<Cairo::Context> context);
+
+	/** Mark @param area (in canvas coordinates) as needing to be rendered again */
+	void invalidate (Rect const & area);
+
+	/** Drop all tiles */
+	void clear ();
+
+	/** Set the total size, in bytes, that the tiles of all caches may use */
+	static void set_memory_budget (uint64_t bytes);
+	static uint64_t memory_budget () { return _budget; }
+
+  private:
+	struct Tile {
+		Tile () : last_used (0) {}
+
+		Cairo::RefPtr<Cairo::ImageSurface> surface;
+		Rect     valid; ///< part of the tile that holds rendered content (canvas coordinates)
+		Rect     dirty; ///< part of valid that has been invalidated since (canvas coordinates)
+		uint64_t last_used;
+	};
+
+	typedef std::pair<int,int> TileIndex;
+	typedef std::map<TileIndex, Tile> Tiles;
+
+	ScrollGroup const & _group;
+	Tiles               _tiles;
+	uint64_t            _generation;
+
+	static uint64_t _budget;
+	static uint64_t _used;
+
+	static Rect tile_rect (TileIndex const &);
+	void fill (TileIndex const &, Tile &, Rect const & area, Duple const & scroll_offset);
+	void evict ();
+};
+
+}
+
+#endif /* __CANVAS_TILE_CACHE_H__ */
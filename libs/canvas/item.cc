@@ -41,6 +41,7 @@ Item::Item (Canvas* canvas)
 	, _visible (true)
 	, _bounding_box_dirty (true)
 	, _lut (0)
+	, _spatial_index (false)
 	, _ignore_events (false)
 {
 	DEBUG_TRACE (DEBUG::CanvasItems, string_compose ("new canvas item %1\n", this));
@@ -55,6 +56,7 @@ Item::Item (Item* parent)
 	, _visible (true)
 	, _bounding_box_dirty (true)
 	, _lut (0)
+	, _spatial_index (false)
 	, _ignore_events (false)
 {
 	DEBUG_TRACE (DEBUG::CanvasItems, string_compose ("new canvas item %1\n", this));
@@ -76,6 +78,7 @@ Item::Item (Item* parent, Duple const& p)
 	, _visible (true)
 	, _bounding_box_dirty (true)
 	, _lut (0)
+	, _spatial_index (false)
 	, _ignore_events (false)
 {
 	DEBUG_TRACE (DEBUG::CanvasItems, string_compose ("new canvas item %1\n", this));
@@ -269,6 +272,8 @@ Item::set_position (Duple p)
 
 	_position = p;
 
+	lut_entry_changed ();
+
 	/* only update canvas and parent if visible. Otherwise, this
 	   will be done when ::show() is called.
 	*/
@@ -375,6 +380,8 @@ Item::propagate_show_hide ()
 {
 	/* bounding box may have changed while we were hidden */
 
+	lut_entry_changed ();
+
 	if (_parent) {
 		_parent->child_changed ();
 	}
@@ -621,7 +628,7 @@ void
 Item::redraw () const
 {
 	if (visible() && _bounding_box && _canvas) {
-		_canvas->request_redraw (item_to_window (_bounding_box));
+		_canvas->queue_draw_item_area (this, _bounding_box);
 	}
 }
 
@@ -634,6 +641,8 @@ Item::begin_change ()
 void
 Item::end_change ()
 {
+	lut_entry_changed ();
+
 	if (visible()) {
 		_canvas->item_changed (this, _pre_change_bounding_box);
 
@@ -912,8 +921,9 @@ Item::add (Item* i)
 
 	_items.push_back (i);
 	i->reparent (this, true);
-	invalidate_lut ();
+	lut_item_added (i);
 	_bounding_box_dirty = true;
+	lut_entry_changed ();
 }
 
 void
@@ -923,8 +933,9 @@ Item::add_front (Item* i)
 
 	_items.push_front (i);
 	i->reparent (this, true);
-	invalidate_lut ();
+	lut_item_added (i);
 	_bounding_box_dirty = true;
+	lut_entry_changed ();
 }
 
 void
@@ -949,7 +960,7 @@ Item::remove (Item* i)
 
 	i->unparent ();
 	_items.remove (i);
-	invalidate_lut ();
+	lut_item_removed (i);
 	_bounding_box_dirty = true;
 
 	end_change ();
@@ -1006,7 +1017,7 @@ Item::raise_child_to_top (Item* i)
 	_items.remove (i);
 	_items.push_back (i);
 
-	invalidate_lut ();
+	lut_items_reordered ();
         redraw ();
 }
 
@@ -1025,7 +1036,7 @@ Item::raise_child (Item* i, int levels)
 	}
 
 	_items.insert (j, i);
-	invalidate_lut ();
+	lut_items_reordered ();
         redraw ();
 }
 
@@ -1039,15 +1050,28 @@ Item::lower_child_to_bottom (Item* i)
 	}
 	_items.remove (i);
 	_items.push_front (i);
-	invalidate_lut ();
+	lut_items_reordered ();
         redraw ();
 }
 
+void
+Item::set_spatial_index (bool yn)
+{
+	if (yn != _spatial_index) {
+		_spatial_index = yn;
+		invalidate_lut ();
+	}
+}
+
 void
 Item::ensure_lut () const
 {
 	if (!_lut) {
-		_lut = new DumbLookupTable (*this);
+		if (_spatial_index) {
+			_lut = new RTreeLookupTable (*this);
+		} else {
+			_lut = new DumbLookupTable (*this);
+		}
 	}
 }
 
@@ -1058,10 +1082,58 @@ Item::invalidate_lut () const
 	_lut = 0;
 }
 
+void
+Item::lut_item_added (Item* i) const
+{
+	if (_lut && _lut->incremental ()) {
+		_lut->item_added (i);
+	} else {
+		invalidate_lut ();
+	}
+}
+
+void
+Item::lut_item_removed (Item* i) const
+{
+	if (_lut && _lut->incremental ()) {
+		_lut->item_removed (i);
+	} else {
+		invalidate_lut ();
+	}
+}
+
+void
+Item::lut_items_reordered () const
+{
+	if (_lut && _lut->incremental ()) {
+		_lut->items_reordered ();
+	} else {
+		invalidate_lut ();
+	}
+}
+
+/** Tell the lookup tables of our parent and its ancestors that our position
+ *  or bounding box (and hence theirs) may have changed.
+ */
+void
+Item::lut_entry_changed () const
+{
+	for (Item const * i = this; i->_parent; i = i->_parent) {
+		LookupTable* lut = i->_parent->_lut;
+		if (lut && lut->incremental ()) {
+			lut->item_changed (i);
+		}
+	}
+}
+
 void
 Item::child_changed ()
 {
-	invalidate_lut ();
+	if (!_lut || !_lut->incremental ()) {
+		/* incremental tables were told about the change by the child */
+		invalidate_lut ();
+	}
+
 	_bounding_box_dirty = true;
 
 	if (_parent) {
@@ -17,6 +17,9 @@
     Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
 */
 
+#include <algorithm>
+#include <cmath>
+
 #include "canvas/item.h"
 #include "canvas/lookup_table.h"
 
@@ -325,3 +328,589 @@ OptimizingLookupTable::get (Rect const & area)
 	return vitems;
 }
 
+
+/* RTreeLookupTable: a Guttman R-tree with quadratic split */
+
+Distance RTreeLookupTable::pick_margin = 4.0;
+
+static double
+rtree_area (Rect const & r)
+{
+	/* avoid inf - inf when comparing areas of items that extend to COORD_MAX */
+	double const limit = 1e150;
+	return min (r.width (), limit) * min (r.height (), limit);
+}
+
+static bool
+rtree_overlaps (Rect const & a, Rect const & b)
+{
+	return a.x0 <= b.x1 && b.x0 <= a.x1 && a.y0 <= b.y1 && b.y0 <= a.y1;
+}
+
+struct RTreeEntryOrder {
+	template<typename T> bool operator() (T const * a, T const * b) const {
+		return a->order < b->order;
+	}
+};
+
+RTreeLookupTable::RTreeLookupTable (Item const & item)
+	: LookupTable (item)
+	, _root (new Node (true))
+	, _order_dirty (false)
+	, _min_order (0)
+	, _max_order (-1)
+{
+	list<Item*> const & items = _item.items ();
+
+	for (list<Item*>::const_iterator i = items.begin(); i != items.end(); ++i) {
+		Entry& e = _entries[*i];
+		e.item = *i;
+		e.order = ++_max_order;
+		_dirty.insert (*i);
+	}
+}
+
+RTreeLookupTable::~RTreeLookupTable ()
+{
+	destroy (_root);
+}
+
+Rect
+RTreeLookupTable::Node::cover () const
+{
+	assert (!branches.empty ());
+
+	Rect r = branches.front().rect;
+
+	for (vector<Branch>::const_iterator b = branches.begin() + 1; b != branches.end(); ++b) {
+		r = r.extend (b->rect);
+	}
+
+	return r;
+}
+
+void
+RTreeLookupTable::destroy (Node* n) const
+{
+	if (!n->leaf) {
+		for (vector<Branch>::iterator b = n->branches.begin(); b != n->branches.end(); ++b) {
+			destroy (b->child);
+		}
+	}
+	delete n;
+}
+
+void
+RTreeLookupTable::item_added (Item* item)
+{
+	Entries::iterator i = _entries.find (item);
+
+	if (i != _entries.end ()) {
+		if (i->second.leaf) {
+			remove (i->second);
+		}
+	} else {
+		i = _entries.insert (make_pair (item, Entry ())).first;
+		i->second.item = item;
+	}
+
+	list<Item*> const & items = _item.items ();
+
+	if (!items.empty() && items.back() == item) {
+		i->second.order = ++_max_order;
+	} else if (!items.empty() && items.front() == item) {
+		i->second.order = --_min_order;
+	} else {
+		_order_dirty = true;
+	}
+
+	/* the item may still be under construction, so leave looking at its
+	   bounding box until the next lookup.
+	*/
+	_dirty.insert (item);
+}
+
+void
+RTreeLookupTable::item_removed (Item* item)
+{
+	Entries::iterator i = _entries.find (item);
+
+	if (i == _entries.end ()) {
+		return;
+	}
+
+	if (i->second.leaf) {
+		remove (i->second);
+	}
+
+	_dirty.erase (item);
+	_entries.erase (i);
+}
+
+void
+RTreeLookupTable::item_changed (Item const * item)
+{
+	if (_entries.find (item) != _entries.end ()) {
+		_dirty.insert (item);
+	}
+}
+
+void
+RTreeLookupTable::items_reordered ()
+{
+	_order_dirty = true;
+}
+
+void
+RTreeLookupTable::renumber () const
+{
+	list<Item*> const & items = _item.items ();
+
+	_min_order = 0;
+	_max_order = -1;
+
+	for (list<Item*>::const_iterator i = items.begin(); i != items.end(); ++i) {
+		Entries::iterator e = _entries.find (*i);
+		if (e != _entries.end ()) {
+			e->second.order = ++_max_order;
+		}
+	}
+
+	_order_dirty = false;
+}
+
+/** Apply any pending changes to our children to the tree */
+void
+RTreeLookupTable::update () const
+{
+	if (_order_dirty) {
+		renumber ();
+	}
+
+	set<Item const *> dirty;
+	dirty.swap (_dirty);
+
+	for (set<Item const *>::const_iterator i = dirty.begin(); i != dirty.end(); ++i) {
+
+		Entries::iterator e = _entries.find (*i);
+
+		if (e == _entries.end ()) {
+			continue;
+		}
+
+		Entry& entry (e->second);
+		Rect const item_bbox = entry.item->bounding_box ();
+
+		if (!item_bbox) {
+			if (entry.leaf) {
+				remove (entry);
+			}
+			continue;
+		}
+
+		Rect const r = entry.item->item_to_parent (item_bbox);
+
+		if (entry.leaf) {
+			if (!(r != entry.rect)) {
+				continue;
+			}
+			remove (entry);
+		}
+
+		insert (entry, r);
+	}
+}
+
+/** @return @param area, which is in window coordinates, in our item's coordinates */
+Rect
+RTreeLookupTable::window_to_parent (Rect const & area) const
+{
+	/* Our children share a scroll parent, which is not necessarily our
+	 * own (for instance when our item is a ScrollGroup), so use one of
+	 * them to find the offset between window and our coordinates.
+	 */
+	Item const * child = _item.items().front ();
+	Duple const offset = child->item_to_window (Duple (0, 0), false) - child->position ();
+
+	return area.translate (-offset);
+}
+
+void
+RTreeLookupTable::search (Node const * n, Rect const & area, vector<Entry*>& found) const
+{
+	for (vector<Branch>::const_iterator b = n->branches.begin(); b != n->branches.end(); ++b) {
+		if (!rtree_overlaps (b->rect, area)) {
+			continue;
+		}
+		if (n->leaf) {
+			found.push_back (b->entry);
+		} else {
+			search (b->child, area, found);
+		}
+	}
+}
+
+/** @return children whose bounding boxes overlap @param area (in our item's
+ *  coordinates), from lowest to highest in the stack.
+ */
+vector<Item*>
+RTreeLookupTable::items_in (Rect const & area) const
+{
+	vector<Entry*> found;
+	search (_root, area, found);
+
+	sort (found.begin (), found.end (), RTreeEntryOrder ());
+
+	vector<Item*> vitems;
+	vitems.reserve (found.size ());
+
+	for (vector<Entry*>::const_iterator i = found.begin(); i != found.end(); ++i) {
+		vitems.push_back ((*i)->item);
+	}
+
+	return vitems;
+}
+
+vector<Item*>
+RTreeLookupTable::get (Rect const & area)
+{
+	if (_item.items().empty ()) {
+		return vector<Item*> ();
+	}
+
+	update ();
+
+	/* allow for item_to_window() rounding; callers check the exact
+	 * intersection themselves.
+	 */
+	return items_in (window_to_parent (area).expand (1.0));
+}
+
+vector<Item*>
+RTreeLookupTable::items_at_point (Duple const & point) const
+{
+	/* Point is in window coordinate system */
+
+	vector<Item*> vitems;
+
+	if (_item.items().empty ()) {
+		return vitems;
+	}
+
+	update ();
+
+	Rect const area = window_to_parent (Rect (point.x, point.y, point.x, point.y)).expand (pick_margin);
+	vector<Item*> const candidates = items_in (area);
+
+	for (vector<Item*>::const_iterator i = candidates.begin(); i != candidates.end(); ++i) {
+		if ((*i)->covers (point)) {
+			vitems.push_back (*i);
+		}
+	}
+
+	return vitems;
+}
+
+bool
+RTreeLookupTable::has_item_at_point (Duple const & point) const
+{
+	/* Point is in window coordinate system */
+
+	if (_item.items().empty ()) {
+		return false;
+	}
+
+	update ();
+
+	Rect const area = window_to_parent (Rect (point.x, point.y, point.x, point.y)).expand (pick_margin);
+	vector<Item*> const candidates = items_in (area);
+
+	for (vector<Item*>::const_iterator i = candidates.begin(); i != candidates.end(); ++i) {
+		if ((*i)->visible () && (*i)->covers (point)) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void
+RTreeLookupTable::insert (Entry& entry, Rect const & r) const
+{
+	Node* n = _root;
+
+	/* descend to the leaf whose area grows least by adding r */
+
+	while (!n->leaf) {
+		Node* best = 0;
+		double best_growth = 0;
+		double best_area = 0;
+
+		for (vector<Branch>::const_iterator b = n->branches.begin(); b != n->branches.end(); ++b) {
+			double const area = rtree_area (b->rect);
+			double const growth = rtree_area (b->rect.extend (r)) - area;
+			if (!best || growth < best_growth || (growth == best_growth && area < best_area)) {
+				best = b->child;
+				best_growth = growth;
+				best_area = area;
+			}
+		}
+
+		n = best;
+	}
+
+	Branch b;
+	b.rect = r;
+	b.child = 0;
+	b.entry = &entry;
+
+	entry.rect = r;
+	add_branch (n, b);
+
+	adjust (n);
+}
+
+void
+RTreeLookupTable::add_branch (Node* n, Branch const & b) const
+{
+	n->branches.push_back (b);
+
+	if (b.child) {
+		b.child->parent = n;
+	} else {
+		b.entry->leaf = n;
+	}
+}
+
+RTreeLookupTable::Branch&
+RTreeLookupTable::branch_for (Node* n) const
+{
+	vector<Branch>& branches (n->parent->branches);
+
+	for (vector<Branch>::iterator b = branches.begin(); b != branches.end(); ++b) {
+		if (b->child == n) {
+			return *b;
+		}
+	}
+
+	assert (false);
+	return branches.front ();
+}
+
+/** Split @param n if it has overflowed and update the covering rectangles
+ *  from @param n up to the root.
+ */
+void
+RTreeLookupTable::adjust (Node* n) const
+{
+	while (true) {
+		Node* sibling = 0;
+
+		if (n->branches.size () > max_branches) {
+			sibling = split (n);
+		}
+
+		Node* parent = n->parent;
+
+		if (!parent) {
+			if (sibling) {
+				Node* root = new Node (false);
+				Branch b;
+				b.entry = 0;
+				b.rect = n->cover ();
+				b.child = n;
+				add_branch (root, b);
+				b.rect = sibling->cover ();
+				b.child = sibling;
+				add_branch (root, b);
+				_root = root;
+			}
+			return;
+		}
+
+		branch_for (n).rect = n->cover ();
+
+		if (sibling) {
+			Branch b;
+			b.entry = 0;
+			b.rect = sibling->cover ();
+			b.child = sibling;
+			add_branch (parent, b);
+		}
+
+		n = parent;
+	}
+}
+
+/** Split @param n into two, using Guttman's quadratic method.
+ *  @return the new node holding some of @param n's branches.
+ */
+RTreeLookupTable::Node*
+RTreeLookupTable::split (Node* n) const
+{
+	vector<Branch> all;
+	all.swap (n->branches);
+
+	/* pick the two branches which would waste most area if kept together */
+
+	size_t seed_a = 0;
+	size_t seed_b = 1;
+	double worst = -1;
+
+	for (size_t i = 0; i < all.size (); ++i) {
+		for (size_t j = i + 1; j < all.size (); ++j) {
+			double const waste = rtree_area (all[i].rect.extend (all[j].rect)) - rtree_area (all[i].rect) - rtree_area (all[j].rect);
+			if (waste > worst) {
+				worst = waste;
+				seed_a = i;
+				seed_b = j;
+			}
+		}
+	}
+
+	Node* m = new Node (n->leaf);
+
+	add_branch (n, all[seed_a]);
+	add_branch (m, all[seed_b]);
+
+	Rect cover_n = all[seed_a].rect;
+	Rect cover_m = all[seed_b].rect;
+
+	vector<Branch> rest;
+	for (size_t i = 0; i < all.size (); ++i) {
+		if (i != seed_a && i != seed_b) {
+			rest.push_back (all[i]);
+		}
+	}
+
+	while (!rest.empty ()) {
+
+		/* make sure both nodes end up with at least min_branches */
+
+		if (n->branches.size () + rest.size () <= min_branches) {
+			for (vector<Branch>::iterator b = rest.begin(); b != rest.end(); ++b) {
+				add_branch (n, *b);
+			}
+			break;
+		}
+
+		if (m->branches.size () + rest.size () <= min_branches) {
+			for (vector<Branch>::iterator b = rest.begin(); b != rest.end(); ++b) {
+				add_branch (m, *b);
+			}
+			break;
+		}
+
+		/* next, the branch with the strongest preference for one node */
+
+		size_t next = 0;
+		double preference = -1;
+		double growth_n = 0;
+		double growth_m = 0;
+
+		for (size_t i = 0; i < rest.size (); ++i) {
+			double const gn = rtree_area (cover_n.extend (rest[i].rect)) - rtree_area (cover_n);
+			double const gm = rtree_area (cover_m.extend (rest[i].rect)) - rtree_area (cover_m);
+			double const p = fabs (gn - gm);
+			if (p > preference) {
+				preference = p;
+				next = i;
+				growth_n = gn;
+				growth_m = gm;
+			}
+		}
+
+		bool to_n;
+
+		if (growth_n != growth_m) {
+			to_n = growth_n < growth_m;
+		} else if (rtree_area (cover_n) != rtree_area (cover_m)) {
+			to_n = rtree_area (cover_n) < rtree_area (cover_m);
+		} else {
+			to_n = n->branches.size () <= m->branches.size ();
+		}
+
+		if (to_n) {
+			add_branch (n, rest[next]);
+			cover_n = cover_n.extend (rest[next].rect);
+		} else {
+			add_branch (m, rest[next]);
+			cover_m = cover_m.extend (rest[next].rect);
+		}
+
+		rest.erase (rest.begin () + next);
+	}
+
+	return m;
+}
+
+void
+RTreeLookupTable::collect (Node* n, vector<Entry*>& entries) const
+{
+	for (vector<Branch>::iterator b = n->branches.begin(); b != n->branches.end(); ++b) {
+		if (n->leaf) {
+			entries.push_back (b->entry);
+		} else {
+			collect (b->child, entries);
+			delete b->child;
+		}
+	}
+}
+
+void
+RTreeLookupTable::remove (Entry& entry) const
+{
+	Node* n = entry.leaf;
+	assert (n);
+
+	for (vector<Branch>::iterator b = n->branches.begin(); b != n->branches.end(); ++b) {
+		if (b->entry == &entry) {
+			n->branches.erase (b);
+			break;
+		}
+	}
+
+	entry.leaf = 0;
+
+	/* remove underfull nodes on the way up, and insert their entries
+	 * again afterwards.
+	 */
+
+	vector<Entry*> orphans;
+
+	while (n != _root) {
+		Node* parent = n->parent;
+
+		if (n->branches.size () < min_branches) {
+			vector<Branch>& siblings (parent->branches);
+			for (vector<Branch>::iterator b = siblings.begin(); b != siblings.end(); ++b) {
+				if (b->child == n) {
+					siblings.erase (b);
+					break;
+				}
+			}
+			collect (n, orphans);
+			delete n;
+		} else {
+			branch_for (n).rect = n->cover ();
+		}
+
+		n = parent;
+	}
+
+	while (!_root->leaf && _root->branches.size () == 1) {
+		Node* child = _root->branches.front().child;
+		child->parent = 0;
+		delete _root;
+		_root = child;
+	}
+
+	if (!_root->leaf && _root->branches.empty ()) {
+		delete _root;
+		_root = new Node (true);
+	}
+
+	for (vector<Entry*>::iterator e = orphans.begin(); e != orphans.end(); ++e) {
+		insert (**e, (*e)->rect);
+	}
+}
@@ -838,7 +838,7 @@ Meter::queue_vertical_redraw (float old_level)
 		if (visible() && _bounding_box && _canvas) {
 			Cairo::RectangleInt iri = region->get_extents();
 			Rect ir (iri.x, iri.y, iri.x + iri.width, iri.y + iri.height);
-			_canvas->request_redraw (item_to_window (ir));
+			_canvas->queue_draw_item_area (this, ir);
 		}
 	}
 }
@@ -909,7 +909,7 @@ Meter::queue_horizontal_redraw (float old_level)
 		if (visible() && _bounding_box && _canvas) {
 			Cairo::RectangleInt iri = region->get_extents();
 			Rect ir (iri.x, iri.y, iri.x + iri.width, iri.y + iri.height);
-			_canvas->request_redraw (item_to_window (ir));
+			_canvas->queue_draw_item_area (this, ir);
 		}
 	}
 }
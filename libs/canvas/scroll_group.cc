@@ -23,6 +23,7 @@
 #include "canvas/canvas.h"
 #include "canvas/debug.h"
 #include "canvas/scroll_group.h"
+#include "canvas/tile_cache.h"
 
 using namespace std;
 using namespace ArdourCanvas;
@@ -30,15 +31,40 @@ using namespace ArdourCanvas;
 ScrollGroup::ScrollGroup (Canvas* c, ScrollSensitivity s)
 	: Container (c)
 	, _scroll_sensitivity (s)
+	, _tile_cache (0)
 {
 }
 
 ScrollGroup::ScrollGroup (Item* parent, ScrollSensitivity s)
 	: Container (parent)
 	, _scroll_sensitivity (s)
+	, _tile_cache (0)
 {
 }
 
+ScrollGroup::~ScrollGroup ()
+{
+	delete _tile_cache;
+	_tile_cache = 0;
+}
+
+void
+ScrollGroup::set_tile_cache (bool yn)
+{
+	if (yn == (_tile_cache != 0)) {
+		return;
+	}
+
+	if (yn) {
+		_tile_cache = new TileCache (*this);
+	} else {
+		delete _tile_cache;
+		_tile_cache = 0;
+	}
+
+	redraw ();
+}
+
 void
 ScrollGroup::render (Rect const & area, Cairo::RefPtr<Cairo::Context> context) const
 {
@@ -64,7 +90,9 @@ ScrollGroup::render (Rect const & area, Cairo::RefPtr<Cairo::Context> context) c
 	context->rectangle (self.x0, self.y0, self.width(), self.height());
 	context->clip ();
 
-	Container::render (area, context);
+	if (!_tile_cache || !_tile_cache->render (area, self, context)) {
+		Container::render (area, context);
+	}
 
 	context->restore ();
 }
@@ -0,0 +1,201 @@
+#include <algorithm>
+
+#include "canvas/lookup_table.h"
+#include "canvas/types.h"
+#include "canvas/rectangle.h"
+#include "canvas/container.h"
+#include "canvas/canvas.h"
+#include "rtree_lookup_table.h"
+
+using namespace std;
+using namespace ArdourCanvas;
+
+CPPUNIT_TEST_SUITE_REGISTRATION (RTreeLookupTableTest);
+
+namespace {
+
+/** A canvas with no window, just enough to hold items */
+class HeadlessCanvas : public Canvas
+{
+public:
+	void request_redraw (Rect const &) {}
+	void request_size (Duple) {}
+	void grab (Item *) {}
+	void ungrab () {}
+	void focus (Item *) {}
+	void unfocus (Item *) {}
+	Rect visible_area () const { return Rect (0, 0, 4096, 4096); }
+	Coord width () const { return 4096; }
+	Coord height () const { return 4096; }
+	bool get_mouse_position (Duple &) const { return false; }
+	void re_enter () {}
+	Glib::RefPtr<Pango::Context> get_pango_context () { return Glib::RefPtr<Pango::Context> (); }
+
+protected:
+	void pick_current_item (int) {}
+	void pick_current_item (Duple const &, int) {}
+};
+
+bool
+picked (Item const & group, Duple const & point, Item const * item)
+{
+	vector<Item const *> items;
+	group.add_items_at_point (point, items);
+	return find (items.begin (), items.end (), item) != items.end ();
+}
+
+}
+
+void
+RTreeLookupTableTest::get_small ()
+{
+	HeadlessCanvas canvas;
+	Rectangle a (canvas.root(), Rect (0, 0, 32, 32));
+	a.set_outline_width (0);
+	Rectangle b (canvas.root(), Rect (0, 33, 32, 64));
+	b.set_outline_width (0);
+	Rectangle c (canvas.root(), Rect (33, 0, 64, 32));
+	c.set_outline_width (0);
+	Rectangle d (canvas.root(), Rect (33, 33, 64, 64));
+	d.set_outline_width (0);
+	RTreeLookupTable table (*canvas.root());
+
+	vector<Item*> items = table.get (Rect (16, 16, 48, 48));
+	CPPUNIT_ASSERT (items.size() == 4);
+
+	/* get() may return a little more than asked for, to allow for rounding */
+	items = table.get (Rect (8, 8, 9, 9));
+	CPPUNIT_ASSERT (items.size() == 1);
+	CPPUNIT_ASSERT (items.front() == &a);
+}
+
+void
+RTreeLookupTableTest::get_big ()
+{
+	HeadlessCanvas canvas;
+
+	double const s = 8;
+	int const N = 256;
+
+	for (int x = 0; x < N; ++x) {
+		for (int y = 0; y < N; ++y) {
+			Rectangle* r = new Rectangle (canvas.root());
+			r->set_outline_width (0);
+			r->set (Rect (x * s + 2, y * s + 2, (x + 1) * s - 2, (y + 1) * s - 2));
+		}
+	}
+
+	RTreeLookupTable table (*canvas.root());
+	vector<Item*> items = table.get (Rect (0, 0, 32, 32));
+	CPPUNIT_ASSERT (items.size() == 16);
+}
+
+/** Check that RTreeLookupTable::get() returns things in the same order as
+ *  they are in the owning group.
+ */
+void
+RTreeLookupTableTest::check_ordering ()
+{
+	HeadlessCanvas canvas;
+
+	Rectangle a (canvas.root (), Rect (0, 0, 64, 64));
+	Rectangle b (canvas.root (), Rect (0, 0, 64, 64));
+	Rectangle c (canvas.root (), Rect (0, 0, 64, 64));
+
+	list<Item*> items;
+	items.push_back (&a);
+	items.push_back (&b);
+	items.push_back (&c);
+	items.sort ();
+
+	RTreeLookupTable table (*canvas.root ());
+
+	/* now arrange these items in the group in reverse order of address */
+
+	for (list<Item*>::reverse_iterator i = items.rbegin(); i != items.rend(); ++i) {
+		(*i)->raise_to_top ();
+		table.items_reordered ();
+	}
+
+	vector<Item*> lut_items = table.get (Rect (0, 0, 64, 64));
+	CPPUNIT_ASSERT (lut_items.size() == 3);
+
+	vector<Item*>::iterator i = lut_items.begin ();
+	list<Item*>::reverse_iterator j = items.rbegin ();
+
+	while (i != lut_items.end ()) {
+		CPPUNIT_ASSERT (*i == *j);
+		++i;
+		++j;
+	}
+}
+
+/** Check that picking follows a child which moves after the table is built */
+void
+RTreeLookupTableTest::move ()
+{
+	HeadlessCanvas canvas;
+	Container group (canvas.root ());
+	group.set_spatial_index (true);
+
+	for (int i = 0; i < 1000; ++i) {
+		Rectangle* r = new Rectangle (&group, Rect (0, 0, 10, 10));
+		r->set_position (Duple ((i % 100) * 20, (i / 100) * 20));
+	}
+
+	Rectangle moving (&group, Rect (0, 0, 10, 10));
+	moving.set_position (Duple (5, 500));
+
+	CPPUNIT_ASSERT (picked (group, Duple (10, 505), &moving));
+
+	moving.set_position (Duple (1005, 700));
+
+	CPPUNIT_ASSERT (!picked (group, Duple (10, 505), &moving));
+	CPPUNIT_ASSERT (picked (group, Duple (1010, 705), &moving));
+
+	moving.set (Rect (0, 0, 100, 10));
+
+	CPPUNIT_ASSERT (picked (group, Duple (1095, 705), &moving));
+
+	/* changes while hidden are picked up when shown again */
+
+	moving.hide ();
+	moving.set_position (Duple (1500, 900));
+	moving.show ();
+
+	CPPUNIT_ASSERT (picked (group, Duple (1505, 905), &moving));
+}
+
+void
+RTreeLookupTableTest::add_remove ()
+{
+	HeadlessCanvas canvas;
+	Container group (canvas.root ());
+	group.set_spatial_index (true);
+
+	vector<Rectangle*> rects;
+
+	for (int i = 0; i < 500; ++i) {
+		rects.push_back (new Rectangle (&group, Rect (i * 4, 0, i * 4 + 3, 3)));
+	}
+
+	CPPUNIT_ASSERT (picked (group, Duple (401, 1), rects[100]));
+
+	delete rects[100];
+	rects[100] = 0;
+
+	CPPUNIT_ASSERT (!picked (group, Duple (401, 1), rects[101]));
+	vector<Item const *> items;
+	group.add_items_at_point (Duple (401, 1), items);
+	CPPUNIT_ASSERT (items.size () == 1); /* just the group */
+
+	Rectangle* top = new Rectangle (&group, Rect (0, 0, 2000, 3));
+	CPPUNIT_ASSERT (picked (group, Duple (401, 1), top));
+
+	for (vector<Rectangle*>::iterator i = rects.begin (); i != rects.end (); ++i) {
+		delete *i;
+	}
+
+	CPPUNIT_ASSERT (picked (group, Duple (1, 1), top));
+	CPPUNIT_ASSERT (group.items ().size () == 1);
+}
@@ -0,0 +1,20 @@
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+class RTreeLookupTableTest : public CppUnit::TestFixture
+{
+	CPPUNIT_TEST_SUITE (RTreeLookupTableTest);
+	CPPUNIT_TEST (get_small);
+	CPPUNIT_TEST (get_big);
+	CPPUNIT_TEST (check_ordering);
+	CPPUNIT_TEST (move);
+	CPPUNIT_TEST (add_remove);
+	CPPUNIT_TEST_SUITE_END ();
+
+public:
+	void get_small ();
+	void get_big ();
+	void check_ordering ();
+	void move ();
+	void add_remove ();
+};
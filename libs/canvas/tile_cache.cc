@@ -0,0 +1,273 @@
+/*
+    Copyright (C) 2017 Paul Davis
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+#include <cmath>
+#include <cstdlib>
+
+#include "pbd/compose.h"
+
+#include "canvas/debug.h"
+#include "canvas/scroll_group.h"
+#include "canvas/tile_cache.h"
+
+using namespace std;
+using namespace ArdourCanvas;
+
+uint64_t TileCache::_budget = 0;
+uint64_t TileCache::_used = 0;
+
+static const uint64_t tile_bytes = TileCache::tile_size * TileCache::tile_size * 4;
+
+static bool
+covers (Rect const & outer, Rect const & inner)
+{
+	return outer && inner.x0 >= outer.x0 && inner.y0 >= outer.y0 && inner.x1 <= outer.x1 && inner.y1 <= outer.y1;
+}
+
+/* tile pixels map 1:1 onto integer canvas coordinates, so anything we
+ * render into a tile must cover whole pixels.
+ */
+static Rect
+pixel_align (Rect const & r)
+{
+	return Rect (floor (r.x0), floor (r.y0), ceil (r.x1), ceil (r.y1));
+}
+
+TileCache::TileCache (ScrollGroup const & g)
+	: _group (g)
+	, _generation (0)
+{
+}
+
+TileCache::~TileCache ()
+{
+	clear ();
+}
+
+void
+TileCache::set_memory_budget (uint64_t bytes)
+{
+	_budget = bytes;
+}
+
+Rect
+TileCache::tile_rect (TileIndex const & i)
+{
+	return Rect ((Coord) i.first * tile_size, (Coord) i.second * tile_size,
+	             (Coord) (i.first + 1) * tile_size, (Coord) (i.second + 1) * tile_size);
+}
+
+void
+TileCache::clear ()
+{
+	_used -= _tiles.size() * tile_bytes;
+	_tiles.clear ();
+}
+
+void
+TileCache::invalidate (Rect const & area)
+{
+	/* the area may be enormous (items that extend to COORD_MAX), so walk
+	 * the tiles we actually have rather than the tile indices it covers.
+	 */
+
+	for (Tiles::iterator t = _tiles.begin(); t != _tiles.end(); ++t) {
+		Rect const r = t->second.valid.intersection (area);
+		if (!r) {
+			continue;
+		}
+		if (t->second.dirty) {
+			t->second.dirty = t->second.dirty.extend (r);
+		} else {
+			t->second.dirty = r;
+		}
+	}
+}
+
+bool
+TileCache::render (Rect const & area, Rect const & self, Cairo::RefPtr<Cairo::Context> context)
+{
+	Duple const scroll = _group.scroll_offset ();
+
+	if (scroll.x != floor (scroll.x) || scroll.y != floor (scroll.y)) {
+		/* tiles would not line up with device pixels */
+		return false;
+	}
+
+	Rect const visible = self.translate (scroll);
+	Rect const draw = area.intersection (self).translate (scroll);
+
+	if (!draw || draw.width() <= 0 || draw.height() <= 0) {
+		return true;
+	}
+
+	++_generation;
+
+	int const tx0 = (int) floor (draw.x0 / tile_size);
+	int const ty0 = (int) floor (draw.y0 / tile_size);
+	int const tx1 = max (tx0, (int) ceil (draw.x1 / tile_size) - 1);
+	int const ty1 = max (ty0, (int) ceil (draw.y1 / tile_size) - 1);
+
+	uint32_t hits = 0;
+	uint32_t misses = 0;
+
+	for (int ty = ty0; ty <= ty1; ++ty) {
+		for (int tx = tx0; tx <= tx1; ++tx) {
+
+			TileIndex const index (tx, ty);
+			Rect const bounds = tile_rect (index);
+			Rect const need = bounds.intersection (draw);
+
+			if (!need || need.width() <= 0 || need.height() <= 0) {
+				continue;
+			}
+
+			Rect const vis = pixel_align (bounds.intersection (visible)).intersection (bounds);
+			Tile& tile (_tiles[index]);
+			bool hit = true;
+
+			if (!tile.surface) {
+				tile.surface = Cairo::ImageSurface::create (Cairo::FORMAT_ARGB32, tile_size, tile_size);
+				_used += tile_bytes;
+			}
+
+			tile.last_used = _generation;
+
+			/* dirty is always reset before rendering, so that anything
+			 * invalidated while we render (e.g. by an item finishing
+			 * some asynchronous work) is picked up next time.
+			 */
+
+			if (!covers (tile.valid, need)) {
+				tile.valid = vis;
+				tile.dirty = Rect ();
+				fill (index, tile, vis, scroll);
+				hit = false;
+			} else if (tile.dirty) {
+				Rect const dirty = pixel_align (tile.dirty).intersection (bounds);
+				tile.dirty = Rect ();
+				if (covers (vis, dirty)) {
+					fill (index, tile, dirty, scroll);
+				} else {
+					/* some of the damage is no longer on screen, and
+					 * items are only rendered where they are visible.
+					 */
+					tile.valid = vis;
+					fill (index, tile, vis, scroll);
+				}
+				hit = false;
+			}
+
+			if (hit) {
+				++hits;
+			} else {
+				++misses;
+			}
+
+			Rect const w = need.translate (-scroll);
+
+			context->save ();
+			context->rectangle (w.x0, w.y0, w.width(), w.height());
+			context->clip ();
+			context->set_source (tile.surface, bounds.x0 - scroll.x, bounds.y0 - scroll.y);
+			context->paint ();
+
+#if defined CANVAS_DEBUG
+			if (getenv ("CANVAS_TILE_DEBUGGING")) {
+				/* green for tiles drawn straight from the cache, red for
+				 * those that needed (some) rendering.
+				 */
+				Rect const b = bounds.translate (-scroll);
+				if (hit) {
+					context->set_source_rgba (0, 1, 0, 0.15);
+				} else {
+					context->set_source_rgba (1, 0, 0, 0.15);
+				}
+				context->paint ();
+				context->rectangle (b.x0 + 0.5, b.y0 + 0.5, b.width() - 1, b.height() - 1);
+				context->set_line_width (1.0);
+				context->set_source_rgba (1, 1, 0, 0.5);
+				context->stroke ();
+			}
+#endif
+			context->restore ();
+		}
+	}
+
+	DEBUG_TRACE (PBD::DEBUG::CanvasTiles, string_compose ("tile cache render %1: %2 hits %3 misses, %4 tiles total %5 kB in use\n",
+	                                                      draw, hits, misses, _tiles.size(), _used / 1024));
+
+	evict ();
+
+	return true;
+}
+
+/** Render @param area (canvas coordinates) of our group into tile @param index,
+ *  replacing whatever was there.
+ */
+void
+TileCache::fill (TileIndex const & index, Tile & tile, Rect const & area, Duple const & scroll)
+{
+	if (!area || area.width() <= 0 || area.height() <= 0) {
+		return;
+	}
+
+	Rect const bounds = tile_rect (index);
+	Rect const w = area.translate (-scroll);
+	Cairo::RefPtr<Cairo::Context> c = Cairo::Context::create (tile.surface);
+
+	/* items render in window coordinates; map those onto the tile */
+
+	c->translate (scroll.x - bounds.x0, scroll.y - bounds.y0);
+	c->rectangle (w.x0, w.y0, w.width(), w.height());
+	c->clip ();
+
+	c->set_operator (Cairo::OPERATOR_CLEAR);
+	c->paint ();
+	c->set_operator (Cairo::OPERATOR_OVER);
+
+	_group.Container::render (w, c);
+}
+
+/** Drop the least recently used tiles until we are within budget. Tiles used
+ *  by the render that is in progress are never dropped.
+ */
+void
+TileCache::evict ()
+{
+	while (_used > _budget) {
+
+		Tiles::iterator oldest = _tiles.end();
+
+		for (Tiles::iterator t = _tiles.begin(); t != _tiles.end(); ++t) {
+			if (t->second.last_used == _generation) {
+				continue;
+			}
+			if (oldest == _tiles.end() || t->second.last_used < oldest->second.last_used) {
+				oldest = t;
+			}
+		}
+
+		if (oldest == _tiles.end()) {
+			break;
+		}
+
+		_tiles.erase (oldest);
+		_used -= tile_bytes;
+	}
+}
@@ -21,11 +21,13 @@
 
 #include <cassert>
 #include <list>
+#include <vector>
 #include <stdint.h>
 
 #include <boost/pool/pool.hpp>
 #include <boost/pool/pool_alloc.hpp>
 
+#include <glib.h>
 #include <glibmm/threads.h>
 
 #include "pbd/signals.h"
@@ -208,6 +210,10 @@ public:
 	 */
 	double eval (double where) const {
 		Glib::Threads::RWLock::ReaderLock lm (_lock);
+		if (_events.size() > 2) {
+			/* not in the process thread, build the segment table if necessary */
+			segment_table ();
+		}
 		return unlocked_eval (where);
 	}
 
@@ -231,13 +237,6 @@ public:
 		return a->when < b->when;
 	}
 
-	/** Lookup cache for eval functions, range contains equivalent values */
-	struct LookupCache {
-		LookupCache() : left(-1) {}
-		double left;  /* leftmost x coordinate used when finding "range" */
-		std::pair<ControlList::const_iterator,ControlList::const_iterator> range;
-	};
-
 	/** Lookup cache for point finding, range contains points after left */
 	struct SearchCache {
 		SearchCache () : left(-1) {}
@@ -249,7 +248,6 @@ public:
 
 	// FIXME: const violations for Curve
 	Glib::Threads::RWLock& lock()       const { return _lock; }
-	LookupCache& lookup_cache() const { return _lookup_cache; }
 	SearchCache& search_cache() const { return _search_cache; }
 
 	/** Called by locked entry point and various private
@@ -280,6 +278,67 @@ public:
 		Exponential // fader, gain
 	};
 
+	/** One segment of the list, from an event up to the next one.
+	 *  The interpolation is precomputed in the domain of the list's
+	 *  interpolation style (log position, gain fader position or value).
+	 */
+	struct Segment {
+		double when;   /* time of the event starting the segment */
+		double value;  /* value of that event */
+		double start;  /* value, in the interpolation domain */
+		double delta;  /* change over the segment, in the interpolation domain */
+		ControlList::const_iterator event;
+	};
+
+	/** The list's events as an array of segments, to find the segment
+	 *  for any time in O(log n) rather than walking the event list.
+	 */
+	struct LIBEVORAL_API SegmentTable {
+		SegmentTable (InterpolationStyle, ParameterDescriptor const &);
+
+		InterpolationStyle interpolation;
+		double lower;
+		double upper;
+		std::vector<Segment> segments;
+
+		/** @return index of the last segment starting at or before @a x
+		 *  (0 if @a x is before the first). @a hint is the index found by
+		 *  the previous call, which is checked first.
+		 */
+		size_t find (double x, size_t hint = 0) const;
+		/** @return index of the first segment starting at or after @a x */
+		size_t lower_bound (double x) const;
+		/** @return value at @a x within segment @a n (which must not be the last) */
+		double interpolate (size_t n, double x) const;
+	};
+
+	/** @return the segment table of the current events, building it if necessary.
+	 *  The caller must hold the lock (as reader or writer).
+	 *  NOT realtime safe: this may block and allocate, use SegmentTableReader
+	 *  in the process thread.  The table is only ever built here, by
+	 *  readers outside of the process thread, never as part of an edit.
+	 */
+	boost::shared_ptr<const SegmentTable> segment_table () const;
+
+	/** Realtime safe access to the segment table. It never blocks or builds
+	 *  the table: table() is 0 if the table is out of date or busy, and the
+	 *  caller has to walk the event list instead. The table stays valid for
+	 *  the lifetime of the reader, which must not outlive the caller's hold
+	 *  on the lock (as reader or writer).
+	 */
+	class LIBEVORAL_API SegmentTableReader {
+	public:
+		SegmentTableReader (ControlList const &);
+
+		SegmentTable const * table () const { return _table; }
+		size_t& hint () const { return _list._segment_hint; }
+
+	private:
+		ControlList const &        _list;
+		Glib::Threads::Mutex::Lock _lm;
+		SegmentTable const *       _table;
+	};
+
 	/** query interpolation style of the automation data
 	 * @returns Interpolation Style
 	 */
@@ -321,6 +380,14 @@ protected:
 
 	/** Called by unlocked_eval() to handle cases of 3 or more control points. */
 	double multipoint_eval (double x) const;
+	/** multipoint_eval() by walking the event list, when there is no segment table */
+	double multipoint_eval_list (double x) const;
+
+	/** Mark the segment table out of date. Realtime safe: it neither
+	 *  blocks nor frees the table, which is replaced by the next
+	 *  segment_table() call.
+	 */
+	void invalidate_segment_table () const { g_atomic_int_set (&_segment_table_dirty, 1); }
 
 	void build_search_cache_if_necessary (double start) const;
 
@@ -335,9 +402,15 @@ protected:
 
 	void _x_scale (double factor);
 
-	mutable LookupCache   _lookup_cache;
 	mutable SearchCache   _search_cache;
 
+	friend class SegmentTableReader;
+
+	mutable Glib::Threads::Mutex                  _segment_lock;
+	mutable boost::shared_ptr<const SegmentTable> _segment_table;
+	mutable size_t                                _segment_hint;
+	mutable gint                                  _segment_table_dirty;
+
 	mutable Glib::Threads::RWLock _lock;
 
 	Parameter             _parameter;
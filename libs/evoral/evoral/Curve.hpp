@@ -23,11 +23,10 @@
 #include <boost/utility.hpp>
 
 #include "evoral/visibility.h"
+#include "evoral/ControlList.hpp"
 
 namespace Evoral {
 
-class ControlList;
-
 class LIBEVORAL_API Curve : public boost::noncopyable
 {
 public:
@@ -41,12 +40,15 @@ public:
 	void mark_dirty() const { _dirty = true; }
 
 private:
-	double multipoint_eval (double x) const;
-
 	void _get_vector (double x0, double x1, float *arg, int32_t veclen) const;
+	void list_get_vector (double rx, double dx, float* vec, int32_t veclen) const;
+	int32_t eval_segment (ControlList::SegmentTable const &, size_t n, double& rx, double dx, float* vec, int32_t i, int32_t veclen) const;
+	int32_t eval_segment (ControlEvent const & before, ControlEvent const & after, double& rx, double dx, float* vec, int32_t i, int32_t veclen) const;
 
 	mutable bool       _dirty;
 	const ControlList& _list;
+	/** segment at which the last _get_vector() ended */
+	mutable size_t     _segment_hint;
 };
 
 } // namespace Evoral
@@ -25,6 +25,7 @@
 #include <list>
 #include <utility>
 #include <boost/shared_ptr.hpp>
+#include <boost/pool/pool_alloc.hpp>
 #include <glibmm/threads.h>
 
 #include "evoral/visibility.h"
@@ -85,6 +86,14 @@ public:
 	typedef typename boost::weak_ptr<Evoral::Note<Time> >         WeakNotePtr;
 	typedef typename boost::shared_ptr<const Evoral::Note<Time> > constNotePtr;
 
+	/** Create a note whose storage, together with that of its reference
+	 *  count, is taken from a pool shared by all sequences.  Large MIDI
+	 *  regions hold 100k+ notes, and notes created with new cost several
+	 *  separate heap allocations each.
+	 */
+	static NotePtr make_note (uint8_t chan = 0, Time time = Time(), Time len = Time(), uint8_t note = 0, uint8_t vel = 0x40);
+	static NotePtr make_note (const Note<Time>& copy);
+
 	typedef boost::shared_ptr<Glib::Threads::RWLock::ReaderLock> ReadLock;
 	typedef boost::shared_ptr<WriteLockImpl>                     WriteLock;
 
@@ -119,16 +128,29 @@ public:
 		return a->time() < b->time();
 	}
 
+	/* The comparators take their arguments by reference and in whatever
+	 * pointer type they are given: converting a NotePtr to a constNotePtr
+	 * copies it, which costs two atomic reference count operations for
+	 * every comparison made by the containers below.
+	 */
+
+	/** Orders notes by note number, and notes of the same number by time,
+	 *  so that a particular note can be found in the pitch indices without
+	 *  walking through all others of the same number.
+	 */
 	struct NoteNumberComparator {
-		inline bool operator()(const boost::shared_ptr< const Note<Time> > a,
-		                       const boost::shared_ptr< const Note<Time> > b) const {
-			return a->note() < b->note();
+		template<typename A, typename B>
+		inline bool operator()(const A& a, const B& b) const {
+			if (a->note() != b->note()) {
+				return a->note() < b->note();
+			}
+			return a->time() < b->time();
 		}
 	};
 
 	struct EarlierNoteComparator {
-		inline bool operator()(const boost::shared_ptr< const Note<Time> > a,
-		                       const boost::shared_ptr< const Note<Time> > b) const {
+		template<typename A, typename B>
+		inline bool operator()(const A& a, const B& b) const {
 			return a->time() < b->time();
 		}
 	};
@@ -145,13 +167,18 @@ public:
 
 	struct LaterNoteEndComparator {
 		typedef const Note<Time>* value_type;
-		inline bool operator()(const boost::shared_ptr< const Note<Time> > a,
-		                       const boost::shared_ptr< const Note<Time> > b) const {
+		template<typename A, typename B>
+		inline bool operator()(const A& a, const B& b) const {
 			return a->end_time().to_double() > b->end_time().to_double();
 		}
 	};
 
-	typedef std::multiset<NotePtr, EarlierNoteComparator> Notes;
+	/* The nodes of all the containers that index notes and other events
+	 * come from pools, which are kept for reuse once the nodes are freed.
+	 */
+	typedef boost::fast_pool_allocator<NotePtr> NotePtrAllocator;
+
+	typedef std::multiset<NotePtr, EarlierNoteComparator, NotePtrAllocator> Notes;
 	inline       Notes& notes()       { return _notes; }
 	inline const Notes& notes() const { return _notes; }
 
@@ -190,12 +217,13 @@ public:
 	typedef boost::shared_ptr<const Event<Time> > constSysExPtr;
 
 	struct EarlierSysExComparator {
-		inline bool operator() (constSysExPtr a, constSysExPtr b) const {
+		template<typename A, typename B>
+		inline bool operator() (const A& a, const B& b) const {
 			return a->time() < b->time();
 		}
 	};
 
-	typedef std::multiset<SysExPtr, EarlierSysExComparator> SysExes;
+	typedef std::multiset<SysExPtr, EarlierSysExComparator, boost::fast_pool_allocator<SysExPtr> > SysExes;
 	inline       SysExes& sysexes()       { return _sysexes; }
 	inline const SysExes& sysexes() const { return _sysexes; }
 
@@ -203,12 +231,13 @@ public:
 	typedef boost::shared_ptr<const PatchChange<Time> > constPatchChangePtr;
 
 	struct EarlierPatchChangeComparator {
-		inline bool operator() (constPatchChangePtr a, constPatchChangePtr b) const {
+		template<typename A, typename B>
+		inline bool operator() (const A& a, const B& b) const {
 			return a->time() < b->time();
 		}
 	};
 
-	typedef std::multiset<PatchChangePtr, EarlierPatchChangeComparator> PatchChanges;
+	typedef std::multiset<PatchChangePtr, EarlierPatchChangeComparator, boost::fast_pool_allocator<PatchChangePtr> > PatchChanges;
 	inline       PatchChanges& patch_changes ()       { return _patch_changes; }
 	inline const PatchChanges& patch_changes () const { return _patch_changes; }
 
@@ -323,10 +352,12 @@ protected:
 		return 0;
 	}
 
-	typedef std::multiset<NotePtr, NoteNumberComparator>  Pitches;
+	typedef std::multiset<NotePtr, NoteNumberComparator, NotePtrAllocator> Pitches;
 	inline       Pitches& pitches(uint8_t chan)       { return _pitches[chan&0xf]; }
 	inline const Pitches& pitches(uint8_t chan) const { return _pitches[chan&0xf]; }
 
+	static typename Pitches::const_iterator pitch_lower_bound (const Pitches& p, uint8_t note);
+
 	virtual void control_list_marked_dirty ();
 
 private:
@@ -351,7 +382,7 @@ private:
 	SysExes      _sysexes;
 	PatchChanges _patch_changes;
 
-	typedef std::multiset<NotePtr, EarlierNoteComparator> WriteNotes;
+	typedef std::multiset<NotePtr, EarlierNoteComparator, NotePtrAllocator> WriteNotes;
 	WriteNotes _write_notes[16];
 
 	/** Current bank number on each channel so that we know what
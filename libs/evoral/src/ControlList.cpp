@@ -62,11 +62,10 @@ ControlList::ControlList (const Parameter& id, const ParameterDescriptor& desc)
 {
 	_frozen = 0;
 	_changed_when_thawed = false;
-	_lookup_cache.left = -1;
-	_lookup_cache.range.first = _events.end();
-	_lookup_cache.range.second = _events.end();
 	_search_cache.left = -1;
 	_search_cache.first = _events.end();
+	_segment_hint = 0;
+	_segment_table_dirty = 1;
 	_sort_pending = false;
 	new_write_pass = true;
 	_in_write_pass = false;
@@ -83,9 +82,9 @@ ControlList::ControlList (const ControlList& other)
 {
 	_frozen = 0;
 	_changed_when_thawed = false;
-	_lookup_cache.range.first = _events.end();
-	_lookup_cache.range.second = _events.end();
 	_search_cache.first = _events.end();
+	_segment_hint = 0;
+	_segment_table_dirty = 1;
 	_sort_pending = false;
 	new_write_pass = true;
 	_in_write_pass = false;
@@ -105,9 +104,9 @@ ControlList::ControlList (const ControlList& other, double start, double end)
 {
 	_frozen = 0;
 	_changed_when_thawed = false;
-	_lookup_cache.range.first = _events.end();
-	_lookup_cache.range.second = _events.end();
 	_search_cache.first = _events.end();
+	_segment_hint = 0;
+	_segment_table_dirty = 1;
 	_sort_pending = false;
 
 	/* now grab the relevant points, and shift them back if necessary */
@@ -444,6 +443,10 @@ ControlList::unlocked_remove_duplicates ()
 	iterator prev = i++;
 	while (i != _events.end()) {
 		if ((*prev)->when == (*i)->when && (*prev)->value == (*i)->value) {
+			/* the table and search cache may refer to the erased event */
+			invalidate_segment_table ();
+			_search_cache.left = -1;
+			_search_cache.first = _events.end();
 			i = _events.erase (i);
 		} else {
 			++prev;
@@ -1093,6 +1096,8 @@ ControlList::thaw ()
 			unlocked_remove_duplicates ();
 			unlocked_invalidate_insert_iterator ();
 			_sort_pending = false;
+			/* a table built while we were frozen has the old order */
+			mark_dirty ();
 		}
 	}
 }
@@ -1100,12 +1105,12 @@ ControlList::thaw ()
 void
 ControlList::mark_dirty () const
 {
-	_lookup_cache.left = -1;
-	_lookup_cache.range.first = _events.end();
-	_lookup_cache.range.second = _events.end();
 	_search_cache.left = -1;
 	_search_cache.first = _events.end();
 
+	/* this may be called in the process thread, by add() */
+	invalidate_segment_table ();
+
 	if (_curve) {
 		_curve->mark_dirty();
 	}
@@ -1385,14 +1390,52 @@ ControlList::unlocked_eval (double x) const
 double
 ControlList::multipoint_eval (double x) const
 {
-	double upos, lpos;
-	double uval, lval;
-	double fraction;
+	/* this may run in the process thread, so never wait for or build the table */
+	SegmentTableReader reader (*this);
+	SegmentTable const * table = reader.table ();
+
+	if (!table) {
+		return multipoint_eval_list (x);
+	}
+
+	std::vector<Segment> const & segments (table->segments);
+
+	size_t n = table->find (x, reader.hint ());
+	reader.hint () = n;
+
+	if (segments[n].when == x) {
+		/* x is a control point in the data, use the first one at that time */
+		while (n > 0 && segments[n - 1].when == x) {
+			--n;
+		}
+		return segments[n].value;
+	}
+
+	if (x < segments.front().when) {
+		/* we're before the first point */
+		return segments.front().value;
+	}
+
+	if (n + 1 == segments.size()) {
+		/* we're after the last point */
+		return segments.back().value;
+	}
+
+	/* "Stepped" lookup (no interpolation) */
+	if (_interpolation == Discrete) {
+		return segments[n].value;
+	}
+
+	return table->interpolate (n, x);
+}
+
+double
+ControlList::multipoint_eval_list (double x) const
+{
+	const ControlEvent cp (x, 0);
 
 	/* "Stepped" lookup (no interpolation) */
-	/* FIXME: no cache.  significant? */
 	if (_interpolation == Discrete) {
-		const ControlEvent cp (x, 0);
 		EventList::const_iterator i = lower_bound (_events.begin(), _events.end(), &cp, time_comparator);
 
 		// shouldn't have made it to multipoint_eval
@@ -1404,67 +1447,171 @@ ControlList::multipoint_eval (double x) const
 			return (*(--i))->value;
 	}
 
-	/* Only do the range lookup if x is in a different range than last time
-	 * this was called (or if the lookup cache has been marked "dirty" (left<0) */
-	if ((_lookup_cache.left < 0) ||
-	    ((_lookup_cache.left > x) ||
-	     (_lookup_cache.range.first == _events.end()) ||
-	     ((*_lookup_cache.range.second)->when < x))) {
+	pair<const_iterator,const_iterator> range = equal_range (_events.begin(), _events.end(), &cp, time_comparator);
 
-		const ControlEvent cp (x, 0);
+	if (range.first != range.second) {
+		/* x is a control point in the data */
+		return (*range.first)->value;
+	}
 
-		_lookup_cache.range = equal_range (_events.begin(), _events.end(), &cp, time_comparator);
+	if (range.first == _events.begin()) {
+		/* we're before the first point */
+		return _events.front()->value;
 	}
 
-	pair<const_iterator,const_iterator> range = _lookup_cache.range;
+	if (range.second == _events.end()) {
+		/* we're after the last point */
+		return _events.back()->value;
+	}
 
-	if (range.first == range.second) {
+	--range.first;
 
-		/* x does not exist within the list as a control point */
+	const double lpos = (*range.first)->when;
+	const double lval = (*range.first)->value;
+	const double upos = (*range.second)->when;
+	const double uval = (*range.second)->value;
 
-		_lookup_cache.left = x;
+	const double fraction = (double) (x - lpos) / (double) (upos - lpos);
 
-		if (range.first != _events.begin()) {
-			--range.first;
-			lpos = (*range.first)->when;
-			lval = (*range.first)->value;
-		}  else {
-			/* we're before the first point */
-			// return _default_value;
-			return _events.front()->value;
-		}
+	switch (_interpolation) {
+		case Logarithmic:
+			return interpolate_logarithmic (lval, uval, fraction, _desc.lower, _desc.upper);
+		case Exponential:
+			return interpolate_gain (lval, uval, fraction, _desc.upper);
+		default: // Linear
+			return interpolate_linear (lval, uval, fraction);
+	}
+}
 
-		if (range.second == _events.end()) {
-			/* we're after the last point */
-			return _events.back()->value;
+ControlList::SegmentTableReader::SegmentTableReader (ControlList const & list)
+	: _list (list)
+	, _lm (list._segment_lock, Glib::Threads::TRY_LOCK)
+	, _table (0)
+{
+	if (_lm.locked() && _list._segment_table && _list._segment_table->interpolation == _list._interpolation
+	    && !g_atomic_int_get (&_list._segment_table_dirty)) {
+		_table = _list._segment_table.get ();
+	}
+}
+
+ControlList::SegmentTable::SegmentTable (InterpolationStyle style, ParameterDescriptor const & desc)
+	: interpolation (style)
+	, lower (desc.lower)
+	, upper (desc.upper)
+{
+}
+
+struct SegmentTimeComparator {
+	bool operator() (double x, ControlList::Segment const & s) const {
+		return x < s.when;
+	}
+	bool operator() (ControlList::Segment const & s, double x) const {
+		return s.when < x;
+	}
+};
+
+size_t
+ControlList::SegmentTable::find (double x, size_t hint) const
+{
+	const size_t n = segments.size();
+
+	/* sequential access mostly stays within a segment or moves on to the next one */
+	for (size_t i = hint; i < n && i <= hint + 1; ++i) {
+		if (segments[i].when <= x && (i + 1 == n || x < segments[i + 1].when)) {
+			return i;
 		}
+	}
 
-		upos = (*range.second)->when;
-		uval = (*range.second)->value;
+	std::vector<Segment>::const_iterator s = upper_bound (segments.begin(), segments.end(), x, SegmentTimeComparator());
 
-		fraction = (double) (x - lpos) / (double) (upos - lpos);
+	if (s == segments.begin()) {
+		return 0;
+	}
+
+	return (s - segments.begin()) - 1;
+}
+
+size_t
+ControlList::SegmentTable::lower_bound (double x) const
+{
+	return std::lower_bound (segments.begin(), segments.end(), x, SegmentTimeComparator()) - segments.begin();
+}
+
+double
+ControlList::SegmentTable::interpolate (size_t n, double x) const
+{
+	Segment const & before (segments[n]);
+	Segment const & after (segments[n + 1]);
+
+	const double fraction = (x - before.when) / (after.when - before.when);
+
+	switch (interpolation) {
+		case Logarithmic:
+			if (isnan_local (before.start) || isnan_local (after.start)) {
+				/* out of range, not precomputed */
+				return interpolate_logarithmic (before.value, after.value, fraction, lower, upper);
+			}
+			return position_to_logscale (before.start + fraction * before.delta, lower, upper);
+		case Exponential:
+			return position_to_gain (before.start + fraction * before.delta) * upper / 2.;
+		default: // Linear
+			return before.start + (fraction * before.delta);
+	}
+}
+
+boost::shared_ptr<const ControlList::SegmentTable>
+ControlList::segment_table () const
+{
+	/* several readers may get here at the same time */
+	Glib::Threads::Mutex::Lock lm (_segment_lock);
+
+	if (_segment_table && _segment_table->interpolation == _interpolation && !g_atomic_int_get (&_segment_table_dirty)) {
+		return _segment_table;
+	}
+
+	/* our caller holds the list's lock, so no edit can happen while we
+	 * build; one that marked us dirty before we got here is included.
+	 */
+	g_atomic_int_set (&_segment_table_dirty, 0);
+
+	SegmentTable* table = new SegmentTable (_interpolation, _desc);
+
+	for (const_iterator i = _events.begin(); i != _events.end(); ++i) {
+		Segment s;
+		s.when = (*i)->when;
+		s.value = (*i)->value;
+		s.event = i;
 
 		switch (_interpolation) {
 			case Logarithmic:
-				return interpolate_logarithmic (lval, uval, fraction, _desc.lower, _desc.upper);
+				if (s.value >= _desc.lower && s.value <= _desc.upper) {
+					s.start = logscale_to_position (s.value, _desc.lower, _desc.upper);
+				} else {
+					s.start = NAN;
+				}
+				break;
 			case Exponential:
-				return interpolate_gain (lval, uval, fraction, _desc.upper);
-			case Discrete:
-				/* should not reach here */
-				assert (0);
-			case Curved:
-				/* only used x-fade curves, never direct eval */
-				assert (0);
-			default: // Linear
-				return interpolate_linear (lval, uval, fraction);
+				s.start = gain_to_position (s.value * 2. / _desc.upper);
+				break;
+			default:
+				s.start = s.value;
 				break;
 		}
-		assert (0);
+
+		s.delta = 0;
+
+		if (!table->segments.empty()) {
+			Segment& prev (table->segments.back());
+			prev.delta = s.start - prev.start;
+		}
+
+		table->segments.push_back (s);
 	}
 
-	/* x is a control point in the data */
-	_lookup_cache.left = -1;
-	return (*range.first)->value;
+	_segment_table.reset (table);
+	_segment_hint = 0;
+
+	return _segment_table;
 }
 
 void
@@ -1478,9 +1625,17 @@ ControlList::build_search_cache_if_necessary (double start) const
 	} else if ((_search_cache.left < 0) || (_search_cache.left > start)) {
 		/* Marked dirty (left < 0), or we're too far forward, re-search. */
 
-		const ControlEvent start_point (start, 0);
+		SegmentTableReader reader (*this);
+		SegmentTable const * table = reader.table ();
+
+		if (table) {
+			const size_t n = table->lower_bound (start);
+			_search_cache.first = (n < table->segments.size()) ? table->segments[n].event : _events.end();
+		} else {
+			const ControlEvent start_point (start, 0);
+			_search_cache.first = lower_bound (_events.begin(), _events.end(), &start_point, time_comparator);
+		}
 
-		_search_cache.first = lower_bound (_events.begin(), _events.end(), &start_point, time_comparator);
 		_search_cache.left = start;
 	}
 
@@ -40,6 +40,7 @@ namespace Evoral {
 Curve::Curve (const ControlList& cl)
 	: _dirty (true)
 	, _list (cl)
+	, _segment_hint (0)
 {
 }
 
@@ -187,6 +188,10 @@ void
 Curve::get_vector (double x0, double x1, float *vec, int32_t veclen) const
 {
 	Glib::Threads::RWLock::ReaderLock lm(_list.lock());
+	if (_list.events().size() > 2) {
+		/* not in the process thread, build the segment table if necessary */
+		_list.segment_table ();
+	}
 	_get_vector (x0, x1, vec, veclen);
 }
 
@@ -360,94 +365,244 @@ Curve::_get_vector (double x0, double x1, float *vec, int32_t veclen) const
 		dx = (hx - lx) / (veclen - 1);
 	}
 
-	for (i = 0; i < veclen; ++i, rx += dx) {
-		vec[i] = multipoint_eval (rx);
+	/* walk through the segments between control points, evaluating
+	 * all the samples within each segment in one go, rather than
+	 * looking up the segment (and interpolation style) for each sample.
+	 * The segment to start at is usually the one where the previous
+	 * call left off (sequential playback).
+	 */
+
+	ControlList::SegmentTableReader reader (_list);
+	ControlList::SegmentTable const * table = reader.table ();
+
+	if (!table) {
+		/* the table is out of date or busy, and this may be the process thread */
+		list_get_vector (lx, dx, vec, veclen);
+		return;
 	}
-}
 
-double
-Curve::multipoint_eval (double x) const
-{
-	pair<ControlList::EventList::const_iterator,ControlList::EventList::const_iterator> range;
+	std::vector<ControlList::Segment> const & segments (table->segments);
+
+	size_t n = _segment_hint;
 
-	ControlList::LookupCache& lookup_cache = _list.lookup_cache();
+	i = 0;
 
-	if ((lookup_cache.left < 0) ||
-	    ((lookup_cache.left > x) ||
-	     (lookup_cache.range.first == _list.events().end()) ||
-	     ((*lookup_cache.range.second)->when < x))) {
+	while (i < veclen) {
 
-		ControlEvent cp (x, 0.0);
+		if (rx < segments.front().when) {
+			/* before the first point */
+			vec[i] = segments.front().value;
+			++i;
+			rx += dx;
+			continue;
+		}
+
+		n = table->find (rx, n);
+
+		ControlList::Segment const & before (segments[n]);
+
+		/* a control point itself evaluates to the first event at that time */
 
-		lookup_cache.range = equal_range (_list.events().begin(), _list.events().end(), &cp, ControlList::time_comparator);
+		size_t first = n;
+		while (first > 0 && segments[first - 1].when == before.when) {
+			--first;
+		}
+
+		while (i < veclen && rx == before.when) {
+			vec[i] = segments[first].value;
+			++i;
+			rx += dx;
+		}
+
+		if (n + 1 == segments.size()) {
+			/* after the last point */
+			while (i < veclen && rx > before.when) {
+				vec[i] = segments.back().value;
+				++i;
+				rx += dx;
+			}
+			continue;
+		}
+
+		i = eval_segment (*table, n, rx, dx, vec, i, veclen);
 	}
 
-	range = lookup_cache.range;
+	_segment_hint = n;
+}
 
-	/* EITHER
+/** Evaluate the curve at @a veclen samples from @a rx, incremented by @a dx,
+ *  by walking the event list. Used when the segment table is not available.
+ */
+void
+Curve::list_get_vector (double rx, double dx, float* vec, int32_t veclen) const
+{
+	ControlList::EventList const & events (_list.events());
+	ControlList::EventList::const_iterator after = events.begin();
+
+	int32_t i = 0;
 
-	   a) x is an existing control point, so first == existing point, second == next point
+	while (i < veclen) {
 
-	   OR
+		while (after != events.end() && (*after)->when <= rx) {
+			++after;
+		}
 
-	   b) x is between control points, so range is empty (first == second, points to where
-	       to insert x)
+		if (after == events.begin()) {
+			/* before the first point */
+			vec[i] = events.front()->value;
+			++i;
+			rx += dx;
+			continue;
+		}
 
-	*/
+		ControlList::EventList::const_iterator b = after;
+		--b;
+		ControlEvent const * before = *b;
 
-	if (range.first == range.second) {
+		/* a control point itself evaluates to the first event at that time */
 
-		/* x does not exist within the list as a control point */
+		while (b != events.begin()) {
+			ControlList::EventList::const_iterator p = b;
+			--p;
+			if ((*p)->when != before->when) {
+				break;
+			}
+			b = p;
+		}
 
-		lookup_cache.left = x;
+		const double at_point = (*b)->value;
 
-		if (range.first == _list.events().begin()) {
-			/* we're before the first point */
-			// return default_value;
-			return _list.events().front()->value;
+		while (i < veclen && rx == before->when) {
+			vec[i] = at_point;
+			++i;
+			rx += dx;
 		}
 
-		if (range.second == _list.events().end()) {
-			/* we're after the last point */
-			return _list.events().back()->value;
+		if (after == events.end()) {
+			/* after the last point */
+			while (i < veclen && rx > before->when) {
+				vec[i] = events.back()->value;
+				++i;
+				rx += dx;
+			}
+			continue;
 		}
 
-		ControlEvent* after = (*range.second);
-		range.second--;
-		ControlEvent* before = (*range.second);
+		i = eval_segment (*before, **after, rx, dx, vec, i, veclen);
+	}
+}
+
+/** Evaluate the curve for the samples from @a i (at @a rx, incremented by
+ *  @a dx for every sample) that lie between @a before and @a after.
+ *  @return index of the first sample that lies beyond @a after
+ */
+int32_t
+Curve::eval_segment (ControlEvent const & before, ControlEvent const & after, double& rx, double dx, float* vec, int32_t i, int32_t veclen) const
+{
+	const double bwhen = before.when;
+	const double awhen = after.when;
+	const double bval = before.value;
+	const double vdelta = after.value - before.value;
+	const double trange = awhen - bwhen;
+
+	if (vdelta == 0.0) {
+		for (; i < veclen && rx < awhen; ++i, rx += dx) {
+			vec[i] = bval;
+		}
+		return i;
+	}
+
+	switch (_list.interpolation()) {
+	case ControlList::Discrete:
+		for (; i < veclen && rx < awhen; ++i, rx += dx) {
+			vec[i] = bval;
+		}
+		break;
+	case ControlList::Logarithmic:
+		for (; i < veclen && rx < awhen; ++i, rx += dx) {
+			vec[i] = interpolate_logarithmic (bval, after.value, (rx - bwhen) / trange, _list.descriptor().lower, _list.descriptor().upper);
+		}
+		break;
+	case ControlList::Exponential:
+		for (; i < veclen && rx < awhen; ++i, rx += dx) {
+			vec[i] = interpolate_gain (bval, after.value, (rx - bwhen) / trange, _list.descriptor().upper);
+		}
+		break;
+	case ControlList::Curved:
+		if (after.coeff) {
+			const double* c = after.coeff;
+			for (; i < veclen && rx < awhen; ++i, rx += dx) {
+				const double x2 = rx * rx;
+				vec[i] = c[0] + (c[1] * rx) + (c[2] * x2) + (c[3] * x2 * rx);
+			}
+			break;
+		}
+		/* fallthrough */
+	default: // Linear
+		for (; i < veclen && rx < awhen; ++i, rx += dx) {
+			vec[i] = bval + (vdelta * ((rx - bwhen) / trange));
+		}
+		break;
+	}
 
-		double vdelta = after->value - before->value;
+	return i;
+}
 
-		if (vdelta == 0.0) {
-			return before->value;
+/** Evaluate the curve for the samples from @a i (at @a rx, incremented by
+ *  @a dx for every sample) that lie within segment @a n of @a table.
+ *  @return index of the first sample that lies beyond the segment
+ */
+int32_t
+Curve::eval_segment (ControlList::SegmentTable const & table, size_t n, double& rx, double dx, float* vec, int32_t i, int32_t veclen) const
+{
+	ControlList::Segment const & before (table.segments[n]);
+	ControlList::Segment const & after (table.segments[n + 1]);
+
+	const double bwhen = before.when;
+	const double awhen = after.when;
+	const double bval = before.value;
+	const double vdelta = after.value - before.value;
+	const double trange = awhen - bwhen;
+
+	if (vdelta == 0.0) {
+		for (; i < veclen && rx < awhen; ++i, rx += dx) {
+			vec[i] = bval;
 		}
+		return i;
+	}
 
-		double tdelta = x - before->when;
-		double trange = after->when - before->when;
-
-		switch (_list.interpolation()) {
-			case ControlList::Discrete:
-				return before->value;
-			case ControlList::Logarithmic:
-				return interpolate_logarithmic (before->value, after->value, tdelta / trange, _list.descriptor().lower, _list.descriptor().upper);
-			case ControlList::Exponential:
-				return interpolate_gain (before->value, after->value, tdelta / trange, _list.descriptor().upper);
-			case ControlList::Curved:
-				if (after->coeff) {
-					ControlEvent* ev = after;
-					double x2 = x * x;
-					return ev->coeff[0] + (ev->coeff[1] * x) + (ev->coeff[2] * x2) + (ev->coeff[3] * x2 * x);
-				}
-				// no break, fallthru
-			default: // Linear
-				return before->value + (vdelta * (tdelta / trange));
+	switch (_list.interpolation()) {
+	case ControlList::Discrete:
+		for (; i < veclen && rx < awhen; ++i, rx += dx) {
+			vec[i] = bval;
+		}
+		break;
+	case ControlList::Logarithmic:
+	case ControlList::Exponential:
+		/* the segment table has the expensive part precomputed */
+		for (; i < veclen && rx < awhen; ++i, rx += dx) {
+			vec[i] = table.interpolate (n, rx);
+		}
+		break;
+	case ControlList::Curved:
+		if ((*after.event)->coeff) {
+			const double* c = (*after.event)->coeff;
+			for (; i < veclen && rx < awhen; ++i, rx += dx) {
+				const double x2 = rx * rx;
+				vec[i] = c[0] + (c[1] * rx) + (c[2] * x2) + (c[3] * x2 * rx);
+			}
+			break;
+		}
+		/* fallthrough */
+	default: // Linear
+		for (; i < veclen && rx < awhen; ++i, rx += dx) {
+			vec[i] = bval + (vdelta * ((rx - bwhen) / trange));
 		}
+		break;
 	}
 
-	/* x is a control point in the data */
-	/* invalidate the cached range because its not usable */
-	lookup_cache.left = -1;
-	return (*range.first)->value;
+	return i;
 }
 
+
 } // namespace Evoral
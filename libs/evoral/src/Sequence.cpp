@@ -24,6 +24,8 @@
 #include <stdint.h>
 #include <cstdio>
 
+#include <boost/make_shared.hpp>
+
 #if __clang__
 #include "evoral/Note.hpp"
 #endif
@@ -457,6 +459,20 @@ Sequence<Time>::const_iterator::operator=(const const_iterator& other)
 
 // Sequence
 
+template<typename Time>
+typename Sequence<Time>::NotePtr
+Sequence<Time>::make_note (uint8_t chan, Time time, Time len, uint8_t note, uint8_t vel)
+{
+	return boost::allocate_shared<Note<Time> > (boost::fast_pool_allocator<Note<Time> > (), chan, time, len, note, vel);
+}
+
+template<typename Time>
+typename Sequence<Time>::NotePtr
+Sequence<Time>::make_note (const Note<Time>& copy)
+{
+	return boost::allocate_shared<Note<Time> > (boost::fast_pool_allocator<Note<Time> > (), copy);
+}
+
 template<typename Time>
 Sequence<Time>::Sequence(const TypeMap& type_map)
 	: _edited(false)
@@ -492,8 +508,7 @@ Sequence<Time>::Sequence(const Sequence<Time>& other)
 	, _highest_note(other._highest_note)
 {
 	for (typename Notes::const_iterator i = other._notes.begin(); i != other._notes.end(); ++i) {
-		NotePtr n (new Note<Time> (**i));
-		_notes.insert (n);
+		_notes.insert (make_note (**i));
 	}
 
 	for (typename SysExes::const_iterator i = other._sysexes.begin(); i != other._sysexes.end(); ++i) {
@@ -743,20 +758,6 @@ Sequence<Time>::remove_note_unlocked(const constNotePtr note)
 
 			DEBUG_TRACE (DEBUG::Sequence, string_compose ("%1\terasing note #%2 %3 @ %4\n", this, (*i)->id(), (int)(*i)->note(), (*i)->time()));
 			_notes.erase (i);
-
-			if (note->note() == _lowest_note || note->note() == _highest_note) {
-
-				_lowest_note = 127;
-				_highest_note = 0;
-
-				for (typename Sequence<Time>::Notes::iterator ii = _notes.begin(); ii != _notes.end(); ++ii) {
-					if ((*ii)->note() < _lowest_note)
-						_lowest_note = (*ii)->note();
-					if ((*ii)->note() > _highest_note)
-						_highest_note = (*ii)->note();
-				}
-			}
-
 			erased = true;
 			break;
 		}
@@ -783,20 +784,6 @@ Sequence<Time>::remove_note_unlocked(const constNotePtr note)
 
 				DEBUG_TRACE (DEBUG::Sequence, string_compose ("%1\tID-based pass, erasing note #%2 %3 @ %4\n", this, (*i)->id(), (int)(*i)->note(), (*i)->time()));
 				_notes.erase (i);
-
-				if (note->note() == _lowest_note || note->note() == _highest_note) {
-
-					_lowest_note = 127;
-					_highest_note = 0;
-
-					for (typename Sequence<Time>::Notes::iterator ii = _notes.begin(); ii != _notes.end(); ++ii) {
-						if ((*ii)->note() < _lowest_note)
-							_lowest_note = (*ii)->note();
-						if ((*ii)->note() > _highest_note)
-							_highest_note = (*ii)->note();
-					}
-				}
-
 				erased = true;
 				id_matched = true;
 				break;
@@ -828,11 +815,12 @@ Sequence<Time>::remove_note_unlocked(const constNotePtr note)
 		} else {
 
 			/* Now find the same note in the "pitches" list (which indexes
-			 * notes by channel+time. We care only about its note number
-			 * so the search_note has all other properties unset.
+			 * notes by channel+pitch+time). We care only about its note
+			 * number and time, so the search_note has all other properties
+			 * unset.
 			 */
 
-			NotePtr search_note (new Note<Time>(0, Time(), Time(), note->note(), 0));
+			NotePtr search_note (make_note (0, note->time(), Time(), note->note(), 0));
 
 			for (j = p.lower_bound (search_note); j != p.end() && (*j)->note() == note->note(); ++j) {
 
@@ -848,6 +836,23 @@ Sequence<Time>::remove_note_unlocked(const constNotePtr note)
 			warning << string_compose ("erased note %1 not found in pitches for channel %2", *note, (int) note->channel()) << endmsg;
 		}
 
+		if (note->note() == _lowest_note || note->note() == _highest_note) {
+
+			/* the pitch indices are sorted by note number, so there
+			 * is no need to look at every note to find the new range.
+			 */
+
+			_lowest_note = 127;
+			_highest_note = 0;
+
+			for (int c = 0; c < 16; ++c) {
+				if (!_pitches[c].empty()) {
+					_lowest_note = std::min (_lowest_note, (*_pitches[c].begin())->note());
+					_highest_note = std::max (_highest_note, (*_pitches[c].rbegin())->note());
+				}
+			}
+		}
+
 		_edited = true;
 
 	} else {
@@ -988,7 +993,7 @@ Sequence<Time>::append_note_on_unlocked (const Event<Time>& ev, event_id_t evid)
 		return;
 	}
 
-	NotePtr note(new Note<Time>(ev.channel(), ev.time(), Time(), ev.note(), ev.velocity()));
+	NotePtr note (make_note (ev.channel(), ev.time(), Time(), ev.note(), ev.velocity()));
 	note->set_id (evid);
 
 	add_note_unlocked (note);
@@ -1130,10 +1135,13 @@ bool
 Sequence<Time>::contains_unlocked (const NotePtr& note) const
 {
 	const Pitches& p (pitches (note->channel()));
-	NotePtr search_note(new Note<Time>(0, Time(), Time(), note->note()));
 
-	for (typename Pitches::const_iterator i = p.lower_bound (search_note);
-	     i != p.end() && (*i)->note() == note->note(); ++i) {
+	/* an identical note has the same note number and time, and so would
+	 * be found right where this one would go.
+	 */
+
+	for (typename Pitches::const_iterator i = p.lower_bound (note);
+	     i != p.end() && (*i)->note() == note->note() && (*i)->time() == note->time(); ++i) {
 
 		if (**i == *note) {
 			return true;
@@ -1159,9 +1167,8 @@ Sequence<Time>::overlaps_unlocked (const NotePtr& note, const NotePtr& without)
 	Time ea  = note->end_time();
 
 	const Pitches& p (pitches (note->channel()));
-	NotePtr search_note(new Note<Time>(0, Time(), Time(), note->note()));
 
-	for (typename Pitches::const_iterator i = p.lower_bound (search_note);
+	for (typename Pitches::const_iterator i = pitch_lower_bound (p, note->note());
 	     i != p.end() && (*i)->note() == note->note(); ++i) {
 
 		if (without && (**i) == *without) {
@@ -1196,7 +1203,7 @@ template<typename Time>
 typename Sequence<Time>::Notes::const_iterator
 Sequence<Time>::note_lower_bound (Time t) const
 {
-	NotePtr search_note(new Note<Time>(0, t, Time(), 0, 0));
+	NotePtr search_note (make_note (0, t, Time(), 0, 0));
 	typename Sequence<Time>::Notes::const_iterator i = _notes.lower_bound(search_note);
 	assert(i == _notes.end() || (*i)->time() >= t);
 	return i;
@@ -1224,6 +1231,29 @@ Sequence<Time>::sysex_lower_bound (Time t) const
 	return i;
 }
 
+/** Return the first note in @a p with a note number >= @a note */
+template<typename Time>
+typename Sequence<Time>::Pitches::const_iterator
+Sequence<Time>::pitch_lower_bound (const Pitches& p, uint8_t note)
+{
+	/* notes of the same number are sorted by time; searching from time
+	 * zero skips any that are earlier, so step back over those.
+	 */
+	NotePtr search_note (make_note (0, Time(), Time(), note, 0));
+	typename Pitches::const_iterator i = p.lower_bound (search_note);
+
+	while (i != p.begin()) {
+		typename Pitches::const_iterator prev = i;
+		--prev;
+		if ((*prev)->note() < note) {
+			break;
+		}
+		i = prev;
+	}
+
+	return i;
+}
+
 // NON-CONST iterator implementations (x3)
 
 /** Return the earliest note with time >= t */
@@ -1231,7 +1261,7 @@ template<typename Time>
 typename Sequence<Time>::Notes::iterator
 Sequence<Time>::note_lower_bound (Time t)
 {
-	NotePtr search_note(new Note<Time>(0, t, Time(), 0, 0));
+	NotePtr search_note (make_note (0, t, Time(), 0, 0));
 	typename Sequence<Time>::Notes::iterator i = _notes.lower_bound(search_note);
 	assert(i == _notes.end() || (*i)->time() >= t);
 	return i;
@@ -1293,38 +1323,26 @@ Sequence<Time>::get_notes_by_pitch (Notes& n, NoteOperator op, uint8_t val, int
 		}
 
 		const Pitches& p (pitches (c));
-		NotePtr search_note(new Note<Time>(0, Time(), Time(), val, 0));
-		typename Pitches::const_iterator i;
+
+		/* the first note at val, and the first one above it */
+		const typename Pitches::const_iterator at = pitch_lower_bound (p, val);
+		const typename Pitches::const_iterator above = val < 127 ? pitch_lower_bound (p, val + 1) : p.end();
+
 		switch (op) {
 		case PitchEqual:
-			i = p.lower_bound (search_note);
-			while (i != p.end() && (*i)->note() == val) {
-				n.insert (*i);
-			}
+			n.insert (at, above);
 			break;
 		case PitchLessThan:
-			i = p.upper_bound (search_note);
-			while (i != p.end() && (*i)->note() < val) {
-				n.insert (*i);
-			}
+			n.insert (p.begin(), at);
 			break;
 		case PitchLessThanOrEqual:
-			i = p.upper_bound (search_note);
-			while (i != p.end() && (*i)->note() <= val) {
-				n.insert (*i);
-			}
+			n.insert (p.begin(), above);
 			break;
 		case PitchGreater:
-			i = p.lower_bound (search_note);
-			while (i != p.end() && (*i)->note() > val) {
-				n.insert (*i);
-			}
+			n.insert (above, p.end());
 			break;
 		case PitchGreaterThanOrEqual:
-			i = p.lower_bound (search_note);
-			while (i != p.end() && (*i)->note() >= val) {
-				n.insert (*i);
-			}
+			n.insert (at, p.end());
 			break;
 
 		default:
@@ -293,6 +293,98 @@ CurveTest::ctrlListEval ()
 	CPPUNIT_ASSERT_EQUAL(9.0, cl->unlocked_eval(999.));
 }
 
+void
+CurveTest::ctrlListRandomEval ()
+{
+	boost::shared_ptr<Evoral::ControlList> cl = TestCtrlList();
+
+	cl->set_interpolation (ControlList::Linear);
+
+	/* a saw-tooth with a step (two events at the same time) at every 10th point */
+	for (int i = 0; i < 1000; ++i) {
+		cl->fast_simple_add (i * 10.0, i % 10);
+		if (i % 10 == 9) {
+			cl->fast_simple_add (i * 10.0, 0.0);
+		}
+	}
+
+	/* walk backwards and jump around; every lookup misses the previous segment */
+	for (int i = 9989; i >= 0; i -= 7) {
+		char msg[64];
+		snprintf (msg, 64, "at x=%d", i);
+		const int p = i / 10;
+		double expected;
+		if (i % 10 == 0) {
+			expected = p % 10;
+		} else if (p % 10 == 9) {
+			expected = 0;
+		} else {
+			expected = (p % 10) + (i % 10) / 10.0;
+		}
+		CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE (msg, expected, cl->unlocked_eval (i), 1e-9);
+	}
+
+	CPPUNIT_ASSERT_EQUAL (0.0, cl->unlocked_eval (-1.0));
+	CPPUNIT_ASSERT_EQUAL (0.0, cl->unlocked_eval (1e6));
+
+	/* modifying the list must not leave stale segments behind */
+	CPPUNIT_ASSERT_DOUBLES_EQUAL (3.5, cl->unlocked_eval (35.0), 1e-9);
+	cl->add (35.0, 0.5, false, false);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL (0.5, cl->unlocked_eval (35.0), 1e-9);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL (2.25, cl->unlocked_eval (37.5), 1e-9);
+	cl->clear ();
+	cl->fast_simple_add (0.0, 1.0);
+	cl->fast_simple_add (10.0, 2.0);
+	cl->fast_simple_add (20.0, 4.0);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL (3.0, cl->unlocked_eval (15.0), 1e-9);
+}
+
+void
+CurveTest::multiPointVector ()
+{
+	float vec[301];
+
+	boost::shared_ptr<Evoral::ControlList> cl = TestCtrlList();
+
+	cl->create_curve ();
+	cl->set_interpolation (ControlList::Linear);
+
+	// up, down and a step at x=200
+	cl->fast_simple_add (   0.0 ,   0.0);
+	cl->fast_simple_add ( 100.0 , 100.0);
+	cl->fast_simple_add ( 200.0 ,   0.0);
+	cl->fast_simple_add ( 200.0 ,  50.0);
+	cl->fast_simple_add ( 300.0 ,  50.0);
+
+	cl->curve ().get_vector (0.0, 300.0, vec, 301);
+
+	for (int i = 0; i < 301; ++i) {
+		char msg[64];
+		snprintf (msg, 64, "at x=%d", i);
+		float expected;
+		if (i <= 100) {
+			expected = i;
+		} else if (i < 200) {
+			expected = 200 - i;
+		} else if (i == 200) {
+			/* a control point evaluates to the first event at that time */
+			expected = 0;
+		} else {
+			expected = 50;
+		}
+		CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE (msg, expected, vec[i], 1e-5);
+	}
+
+	/* a vector across several segments must match evaluating every sample on its own */
+	float single[1];
+	cl->curve ().get_vector (50.0, 250.0, vec, 64);
+	for (int i = 0; i < 64; ++i) {
+		double const x = 50.0 + i * (200.0 / 63.0);
+		cl->curve ().get_vector (x, x, single, 1);
+		CPPUNIT_ASSERT_DOUBLES_EQUAL (single[0], vec[i], 1e-4);
+	}
+}
+
 void
 CurveTest::constrainedCubic ()
 {
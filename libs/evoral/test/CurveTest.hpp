@@ -11,8 +11,10 @@ class CurveTest : public CppUnit::TestFixture
 	CPPUNIT_TEST (twoPointLinear);
 	CPPUNIT_TEST (threePointLinear);
 	CPPUNIT_TEST (threePointDiscete);
+	CPPUNIT_TEST (multiPointVector);
 	CPPUNIT_TEST (constrainedCubic);
 	CPPUNIT_TEST (ctrlListEval);
+	CPPUNIT_TEST (ctrlListRandomEval);
 	CPPUNIT_TEST_SUITE_END ();
 
 public:
@@ -21,8 +23,10 @@ public:
 	void twoPointLinear ();
 	void threePointLinear ();
 	void threePointDiscete ();
+	void multiPointVector ();
 	void constrainedCubic ();
 	void ctrlListEval ();
+	void ctrlListRandomEval ();
 
 private:
 	boost::shared_ptr<Evoral::ControlList> TestCtrlList() {
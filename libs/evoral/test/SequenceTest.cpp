@@ -194,3 +194,48 @@ SequenceTest::controlInterpolationTest ()
 		last_value = i->second;
 	}
 }
+
+void
+SequenceTest::pitchIndexTest ()
+{
+	/* test notes are 64 .. 75, plus a second 70 */
+	for (Notes::const_iterator i = test_notes.begin(); i != test_notes.end(); ++i) {
+		CPPUNIT_ASSERT(seq->add_note_unlocked(*i));
+	}
+	boost::shared_ptr< Note<Time> > late = MySequence<Time>::make_note(0, Beats(5000), Beats(100), 70, 64);
+	CPPUNIT_ASSERT(seq->add_note_unlocked(late));
+
+	MySequence<Time>::Notes n;
+	seq->get_notes(n, MySequence<Time>::PitchEqual, 70);
+	CPPUNIT_ASSERT_EQUAL((size_t)2, n.size());
+	n.clear();
+	seq->get_notes(n, MySequence<Time>::PitchLessThan, 70);
+	CPPUNIT_ASSERT_EQUAL((size_t)6, n.size());
+	n.clear();
+	seq->get_notes(n, MySequence<Time>::PitchLessThanOrEqual, 70);
+	CPPUNIT_ASSERT_EQUAL((size_t)8, n.size());
+	n.clear();
+	seq->get_notes(n, MySequence<Time>::PitchGreater, 70);
+	CPPUNIT_ASSERT_EQUAL((size_t)5, n.size());
+	n.clear();
+	seq->get_notes(n, MySequence<Time>::PitchGreaterThanOrEqual, 70);
+	CPPUNIT_ASSERT_EQUAL((size_t)7, n.size());
+
+	/* an identical copy of a note is contained, but not a moved one */
+	CPPUNIT_ASSERT(seq->contains(MySequence<Time>::make_note(*late)));
+	boost::shared_ptr< Note<Time> > moved = MySequence<Time>::make_note(*late);
+	moved->set_time(Beats(4000));
+	CPPUNIT_ASSERT(!seq->contains(moved));
+	CPPUNIT_ASSERT(seq->overlaps(moved, boost::shared_ptr< Note<Time> >()) == false);
+	moved->set_time(Beats(650));
+	CPPUNIT_ASSERT(seq->overlaps(moved, boost::shared_ptr< Note<Time> >()));
+
+	/* removing the lowest and highest notes updates the range */
+	CPPUNIT_ASSERT_EQUAL((uint8_t)64, seq->lowest_note());
+	CPPUNIT_ASSERT_EQUAL((uint8_t)75, seq->highest_note());
+	seq->remove_note_unlocked(test_notes.front());
+	seq->remove_note_unlocked(test_notes.back());
+	CPPUNIT_ASSERT_EQUAL((uint8_t)65, seq->lowest_note());
+	CPPUNIT_ASSERT_EQUAL((uint8_t)74, seq->highest_note());
+	CPPUNIT_ASSERT_EQUAL((size_t)11, seq->notes().size());
+}
@@ -0,0 +1,696 @@
+/*
+    Copyright (C) 2017 Paul Davis
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+*/
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+
+#include <errno.h>
+#include <string.h>
+
+#include <glib.h>
+#include "pbd/gstdio_compat.h"
+
+#ifdef COMPILER_MSVC
+#include <io.h>
+#include "pbd/msvc_pbd.h"
+#else
+#include <unistd.h>
+#endif
+
+#include <glibmm/threads.h>
+
+#include "pbd/compact_memento.h"
+#include "pbd/compose.h"
+#include "pbd/debug.h"
+#include "pbd/error.h"
+#include "pbd/xml++.h"
+
+#include "pbd/i18n.h"
+
+using namespace std;
+using namespace PBD;
+
+/* Encoding of an XMLNode tree:
+ *
+ *   node:   'E' name nprops (name value)[nprops] nchildren node[nchildren]
+ *           'C' name content nprops ... (as above)
+ *
+ * where strings are a uint32_t length followed by that many bytes, and
+ * counts are uint32_t. 'C' marks a content node. Unlike the state file
+ * cache written by XMLWriter this keeps every detail of the tree (blank
+ * and adjacent content, names of content nodes) since it is not trying
+ * to reproduce what libxml2 would read.
+ *
+ * A delta of one encoding against another (the base) is a sequence of
+ *
+ *   'C' offset length   copy length bytes from offset in the base
+ *   'I' length bytes    insert length bytes
+ */
+
+namespace {
+
+struct SpillState {
+	SpillState () : used (0), budget (0), fd (-1), file_end (0), spilled (0), failed (false) {}
+
+	Glib::Threads::Mutex       lock;
+	list<CompactMemento*>      resident; ///< mementos held in memory, oldest first
+	uint64_t                   used;
+	uint64_t                   budget;
+	int                        fd;
+	string                     path;
+	int64_t                    file_end;
+	map<int64_t, int64_t>      holes;    ///< unused space in the file, offset to length
+	uint32_t                   spilled;  ///< number of mementos in the file
+	bool                       failed;   ///< the file could not be created or written
+};
+
+SpillState&
+spill_state ()
+{
+	static SpillState* s = new SpillState;
+	return *s;
+}
+
+/** @return the offset of @a len bytes of the spill file to write to, taken
+ *  from the first hole big enough for them, or from the end of the file.
+ *  Called with the lock held.
+ */
+int64_t
+allocate_space (SpillState& s, int64_t len)
+{
+	for (map<int64_t, int64_t>::iterator h = s.holes.begin (); h != s.holes.end (); ++h) {
+		if (h->second < len) {
+			continue;
+		}
+		int64_t const offset = h->first;
+		int64_t const left = h->second - len;
+		s.holes.erase (h);
+		if (left) {
+			s.holes[offset + len] = left;
+		}
+		return offset;
+	}
+
+	int64_t const offset = s.file_end;
+	s.file_end += len;
+	return offset;
+}
+
+/** Return @a len bytes at @a offset in the spill file to the holes, merging
+ *  them with their neighbours, and shrink the file if they were at its end.
+ *  Called with the lock held.
+ */
+void
+release_space (SpillState& s, int64_t offset, int64_t len)
+{
+	if (len == 0) {
+		return;
+	}
+
+	map<int64_t, int64_t>::iterator next = s.holes.lower_bound (offset);
+
+	if (next != s.holes.end () && offset + len == next->first) {
+		len += next->second;
+		s.holes.erase (next++);
+	}
+
+	if (next != s.holes.begin ()) {
+		map<int64_t, int64_t>::iterator prev = next;
+		--prev;
+		if (prev->first + prev->second == offset) {
+			offset = prev->first;
+			len += prev->second;
+			s.holes.erase (prev);
+		}
+	}
+
+	if (offset + len < s.file_end) {
+		s.holes[offset] = len;
+		return;
+	}
+
+	s.file_end = offset;
+
+#ifdef COMPILER_MSVC
+	int const r = _chsize_s (s.fd, s.file_end);
+#else
+	int const r = ::ftruncate (s.fd, s.file_end);
+#endif
+
+	if (r) {
+		/* harmless; the space is reused or goes with the file */
+		DEBUG_TRACE (DEBUG::UndoHistory, string_compose ("cannot shrink undo history file %1 (%2)\n", s.path, strerror (errno)));
+	}
+}
+
+void
+put (vector<char>& buf, void const * data, size_t len)
+{
+	buf.insert (buf.end(), (char const *) data, (char const *) data + len);
+}
+
+void
+put_uint32 (vector<char>& buf, uint32_t n)
+{
+	put (buf, &n, sizeof (n));
+}
+
+void
+put_string (vector<char>& buf, string const & str)
+{
+	put_uint32 (buf, str.length ());
+	put (buf, str.data (), str.length ());
+}
+
+void
+encode (XMLNode const & node, vector<char>& buf)
+{
+	if (node.is_content ()) {
+		buf.push_back ('C');
+		put_string (buf, node.name ());
+		put_string (buf, node.content ());
+	} else {
+		buf.push_back ('E');
+		put_string (buf, node.name ());
+	}
+
+	XMLPropertyList const & props = node.properties ();
+	put_uint32 (buf, props.size ());
+	for (XMLPropertyConstIterator p = props.begin (); p != props.end (); ++p) {
+		put_string (buf, (*p)->name ());
+		put_string (buf, (*p)->value ());
+	}
+
+	XMLNodeList const & children = node.children ();
+	put_uint32 (buf, children.size ());
+	for (XMLNodeConstIterator c = children.begin (); c != children.end (); ++c) {
+		encode (**c, buf);
+	}
+}
+
+class Reader {
+public:
+	Reader (char const * data, size_t len)
+		: _p (data), _end (data + len) {}
+
+	bool at_end () const { return _p == _end; }
+
+	bool read (void* data, size_t len)
+	{
+		if ((size_t) (_end - _p) < len) {
+			return false;
+		}
+		memcpy (data, _p, len);
+		_p += len;
+		return true;
+	}
+
+	bool read_string (string& str)
+	{
+		uint32_t len;
+		if (!read (&len, sizeof (len)) || (size_t) (_end - _p) < len) {
+			return false;
+		}
+		str.assign (_p, len);
+		_p += len;
+		return true;
+	}
+
+private:
+	char const * _p;
+	char const * _end;
+};
+
+XMLNode*
+decode (Reader& reader)
+{
+	char type;
+	string name;
+	string value;
+	uint32_t n;
+	XMLNode* node;
+
+	if (!reader.read (&type, 1) || !reader.read_string (name)) {
+		return 0;
+	}
+
+	if (type == 'C') {
+		if (!reader.read_string (value)) {
+			return 0;
+		}
+		node = new XMLNode (name, value);
+	} else if (type == 'E') {
+		node = new XMLNode (name);
+	} else {
+		return 0;
+	}
+
+	if (!reader.read (&n, sizeof (n))) {
+		delete node;
+		return 0;
+	}
+
+	while (n--) {
+		if (!reader.read_string (name) || !reader.read_string (value)) {
+			delete node;
+			return 0;
+		}
+		node->set_property (name.c_str (), value);
+	}
+
+	if (!reader.read (&n, sizeof (n))) {
+		delete node;
+		return 0;
+	}
+
+	while (n--) {
+		XMLNode* child = decode (reader);
+		if (!child) {
+			delete node;
+			return 0;
+		}
+		node->add_child_nocopy (*child);
+	}
+
+	return node;
+}
+
+XMLNode*
+decode (vector<char> const & buf)
+{
+	if (buf.empty ()) {
+		return 0;
+	}
+
+	Reader reader (&buf[0], buf.size ());
+	XMLNode* node = decode (reader);
+
+	if (node && !reader.at_end ()) {
+		delete node;
+		return 0;
+	}
+
+	return node;
+}
+
+/* blocks of the base that a delta may refer to */
+static const size_t   delta_block = 32;
+static const uint32_t hash_factor = 16777619;
+
+uint32_t
+block_hash (char const * p)
+{
+	uint32_t h = 0;
+	for (size_t i = 0; i < delta_block; ++i) {
+		h = h * hash_factor + (unsigned char) p[i];
+	}
+	return h;
+}
+
+void
+delta_insert (vector<char>& delta, vector<char> const & target, size_t from, size_t to)
+{
+	if (to > from) {
+		delta.push_back ('I');
+		put_uint32 (delta, to - from);
+		put (delta, &target[from], to - from);
+	}
+}
+
+void
+delta_copy (vector<char>& delta, size_t offset, size_t len)
+{
+	delta.push_back ('C');
+	put_uint32 (delta, offset);
+	put_uint32 (delta, len);
+}
+
+/** Set @a delta to the encoding of @a target as a delta against @a base.
+ *  The base is indexed in fixed blocks, and a rolling hash finds them in
+ *  the target at any offset; each match is then grown as far as it goes
+ *  in both directions.
+ */
+void
+make_delta (vector<char> const & base, vector<char> const & target, vector<char>& delta)
+{
+	/* (hash, offset) of each block of the base, sorted so that the first
+	 * entry for a hash is the earliest block that has it.
+	 */
+	vector<pair<uint32_t, uint32_t> > blocks;
+	blocks.reserve (base.size () / delta_block);
+
+	for (size_t off = 0; off + delta_block <= base.size (); off += delta_block) {
+		blocks.push_back (make_pair (block_hash (&base[off]), (uint32_t) off));
+	}
+
+	sort (blocks.begin (), blocks.end ());
+
+	/* hash_factor ^ (delta_block - 1), to roll the oldest byte out of a hash */
+	uint32_t top = 1;
+	for (size_t i = 1; i < delta_block; ++i) {
+		top *= hash_factor;
+	}
+
+	size_t const size = target.size ();
+	size_t literal = 0; /* start of the bytes which no copy covers yet */
+	size_t i = 0;
+	uint32_t h = (size >= delta_block) ? block_hash (&target[0]) : 0;
+
+	delta.clear ();
+
+	while (i + delta_block <= size) {
+
+		vector<pair<uint32_t, uint32_t> >::const_iterator b = lower_bound (blocks.begin (), blocks.end (), make_pair (h, (uint32_t) 0));
+
+		if (b != blocks.end () && b->first == h && !memcmp (&base[b->second], &target[i], delta_block)) {
+
+			size_t start = b->second;
+			size_t len = delta_block;
+
+			while (i + len < size && start + len < base.size () && base[start + len] == target[i + len]) {
+				++len;
+			}
+
+			size_t back = 0;
+
+			while (i - back > literal && start - back > 0 && base[start - back - 1] == target[i - back - 1]) {
+				++back;
+			}
+
+			delta_insert (delta, target, literal, i - back);
+			delta_copy (delta, start - back, len + back);
+
+			i += len;
+			literal = i;
+
+			if (i + delta_block <= size) {
+				h = block_hash (&target[i]);
+			}
+			continue;
+		}
+
+		if (i + delta_block < size) {
+			h = (h - top * (unsigned char) target[i]) * hash_factor + (unsigned char) target[i + delta_block];
+		}
+		++i;
+	}
+
+	delta_insert (delta, target, literal, size);
+}
+
+bool
+apply_delta (vector<char> const & base, vector<char> const & delta, vector<char>& target)
+{
+	if (delta.empty ()) {
+		return false;
+	}
+
+	Reader reader (&delta[0], delta.size ());
+
+	target.clear ();
+
+	while (!reader.at_end ()) {
+		char type;
+		uint32_t offset;
+		uint32_t len;
+
+		if (!reader.read (&type, 1)) {
+			return false;
+		}
+
+		switch (type) {
+		case 'C':
+			if (!reader.read (&offset, sizeof (offset)) || !reader.read (&len, sizeof (len)) || (size_t) offset + len > base.size ()) {
+				return false;
+			}
+			put (target, &base[offset], len);
+			break;
+		case 'I':
+			if (!reader.read (&len, sizeof (len))) {
+				return false;
+			}
+			target.resize (target.size () + len);
+			if (!reader.read (&target[target.size () - len], len)) {
+				return false;
+			}
+			break;
+		default:
+			return false;
+		}
+	}
+
+	return true;
+}
+
+} // anonymous namespace
+
+CompactMemento::CompactMemento (XMLNode* before, XMLNode* after)
+	: _has_before (before != 0)
+	, _has_after (after != 0)
+	, _before_is_delta (false)
+	, _spill_offset (-1)
+	, _after_size (0)
+	, _before_size (0)
+{
+	if (after) {
+		encode (*after, _after);
+		delete after;
+	}
+
+	if (before) {
+		encode (*before, _before);
+		delete before;
+
+		if (!_after.empty ()) {
+			vector<char> delta;
+			make_delta (_after, _before, delta);
+			if (delta.size () < _before.size ()) {
+				_before.swap (delta);
+				_before_is_delta = true;
+			}
+		}
+	}
+
+	/* vector growth may have left spare capacity */
+	vector<char> (_after).swap (_after);
+	vector<char> (_before).swap (_before);
+
+	SpillState& s (spill_state ());
+	Glib::Threads::Mutex::Lock lm (s.lock);
+
+	_resident = s.resident.insert (s.resident.end (), this);
+	s.used += memory_size ();
+
+	enforce_budget ();
+}
+
+CompactMemento::~CompactMemento ()
+{
+	SpillState& s (spill_state ());
+	Glib::Threads::Mutex::Lock lm (s.lock);
+
+	if (_spill_offset < 0) {
+		s.resident.erase (_resident);
+		s.used -= memory_size ();
+		return;
+	}
+
+	/* our space is reused by later spills, and once nothing is left in
+	 * the file it goes.
+	 */
+
+	if (--s.spilled == 0) {
+		::close (s.fd);
+		::g_unlink (s.path.c_str ());
+		s.fd = -1;
+		s.path.clear ();
+		s.file_end = 0;
+		s.holes.clear ();
+	} else {
+		release_space (s, _spill_offset, _after_size + _before_size);
+	}
+}
+
+void
+CompactMemento::set_memory_budget (uint64_t bytes)
+{
+	SpillState& s (spill_state ());
+	Glib::Threads::Mutex::Lock lm (s.lock);
+
+	s.budget = bytes;
+	enforce_budget ();
+}
+
+uint64_t
+CompactMemento::memory_used ()
+{
+	SpillState& s (spill_state ());
+	Glib::Threads::Mutex::Lock lm (s.lock);
+	return s.used;
+}
+
+uint64_t
+CompactMemento::spill_file_size ()
+{
+	SpillState& s (spill_state ());
+	Glib::Threads::Mutex::Lock lm (s.lock);
+	return s.file_end;
+}
+
+/** Move the oldest mementos to disk until those left in memory fit the
+ *  budget. The newest is always kept in memory. Called with the lock held.
+ */
+void
+CompactMemento::enforce_budget ()
+{
+	SpillState& s (spill_state ());
+
+	while (s.budget && s.used > s.budget && s.resident.size () > 1 && !s.failed) {
+		if (!s.resident.front ()->spill ()) {
+			s.failed = true;
+		}
+	}
+}
+
+/** Write our states to the spill file and release their memory. Called with
+ *  the lock held.
+ */
+bool
+CompactMemento::spill ()
+{
+	SpillState& s (spill_state ());
+
+	if (s.fd < 0) {
+		GError* err = 0;
+		gchar* path = 0;
+
+		s.fd = g_file_open_tmp ("ardour-history-XXXXXX", &path, &err);
+
+		if (s.fd < 0) {
+			warning << string_compose (_("Cannot create a file for old undo history, it will be kept in memory (%1)"), err->message) << endmsg;
+			g_error_free (err);
+			return false;
+		}
+
+		s.path = path;
+		g_free (path);
+
+#ifndef PLATFORM_WINDOWS
+		/* nobody else needs to see it, and it will go if we crash */
+		::g_unlink (s.path.c_str ());
+#endif
+	}
+
+	int64_t const offset = allocate_space (s, _after.size () + _before.size ());
+
+	if (::pwrite (s.fd, _after.empty () ? 0 : &_after[0], _after.size (), offset) != (ssize_t) _after.size ()
+	    || ::pwrite (s.fd, _before.empty () ? 0 : &_before[0], _before.size (), offset + _after.size ()) != (ssize_t) _before.size ()) {
+		warning << string_compose (_("Cannot write old undo history to %1, it will be kept in memory (%2)"), s.path, strerror (errno)) << endmsg;
+		release_space (s, offset, _after.size () + _before.size ());
+		return false;
+	}
+
+	s.resident.erase (_resident);
+	s.used -= memory_size ();
+	++s.spilled;
+
+	_spill_offset = offset;
+	_after_size = _after.size ();
+	_before_size = _before.size ();
+
+	vector<char> ().swap (_after);
+	vector<char> ().swap (_before);
+
+	return true;
+}
+
+/** Copy our encoded states to @a after and @a before (either of which may
+ *  be 0), reading them from the spill file if need be.
+ */
+bool
+CompactMemento::load (vector<char>* after, vector<char>* before) const
+{
+	SpillState& s (spill_state ());
+	Glib::Threads::Mutex::Lock lm (s.lock);
+
+	if (_spill_offset < 0) {
+		if (after) {
+			*after = _after;
+		}
+		if (before) {
+			*before = _before;
+		}
+		return true;
+	}
+
+	if (after) {
+		after->resize (_after_size);
+		if (_after_size && ::pread (s.fd, &(*after)[0], _after_size, _spill_offset) != (ssize_t) _after_size) {
+			error << string_compose (_("Cannot read undo history from %1 (%2)"), s.path, strerror (errno)) << endmsg;
+			return false;
+		}
+	}
+
+	if (before) {
+		before->resize (_before_size);
+		if (_before_size && ::pread (s.fd, &(*before)[0], _before_size, _spill_offset + _after_size) != (ssize_t) _before_size) {
+			error << string_compose (_("Cannot read undo history from %1 (%2)"), s.path, strerror (errno)) << endmsg;
+			return false;
+		}
+	}
+
+	return true;
+}
+
+XMLNode*
+CompactMemento::after () const
+{
+	vector<char> after;
+
+	if (!_has_after || !load (&after, 0)) {
+		return 0;
+	}
+
+	return decode (after);
+}
+
+XMLNode*
+CompactMemento::before () const
+{
+	vector<char> after;
+	vector<char> before;
+
+	if (!_has_before || !load (_before_is_delta ? &after : 0, &before)) {
+		return 0;
+	}
+
+	if (!_before_is_delta) {
+		return decode (before);
+	}
+
+	vector<char> full;
+
+	if (!apply_delta (after, before, full)) {
+		error << _("Undo history is damaged") << endmsg;
+		return 0;
+	}
+
+	return decode (full);
+}
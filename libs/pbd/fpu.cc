@@ -69,6 +69,32 @@ __cpuid(int regs[4], int cpuid_leaf)
 	         "%ecx", "%edx", "memory");
 }
 
+/* as above, for leaves with sub-leaves (passed in %ecx) */
+
+static void
+__cpuidex(int regs[4], int cpuid_leaf, int cpuid_subleaf)
+{
+        asm volatile (
+#if defined(__i386__)
+	        "pushl %%ebx;\n\t"
+#endif
+	        "cpuid;\n\t"
+	        "movl %%eax, (%2);\n\t"
+	        "movl %%ebx, 4(%2);\n\t"
+	        "movl %%ecx, 8(%2);\n\t"
+	        "movl %%edx, 12(%2);\n\t"
+#if defined(__i386__)
+	        "popl %%ebx;\n\t"
+#endif
+	        :"+a" (cpuid_leaf), "+c" (cpuid_subleaf) /* %eax, %ecx clobbered by CPUID */
+	        :"S" (regs)
+	        :
+#if !defined(__i386__)
+	         "%ebx",
+#endif
+	         "%edx", "memory");
+}
+
 #endif /* !PLATFORM_WINDOWS */
 
 #ifndef HAVE_XGETBV // Allow definition by build system
@@ -192,6 +218,24 @@ FPU::FPU ()
 		    ((_xgetbv (_XCR_XFEATURE_ENABLED_MASK) & 0x6) == 0x6)) { /* OS really supports XSAVE */
 			info << _("AVX-capable processor") << endmsg;
 			_flags = Flags (_flags | (HasAVX) );
+
+			if (cpu_info[2] & (1<<12) /* FMA */) {
+				info << _("FMA-capable processor") << endmsg;
+				_flags = Flags (_flags | (HasFMA) );
+			}
+
+			if (num_ids >= 7) {
+				/* the OS must also save the opmask and upper ZMM registers */
+				const bool os_avx512 = (_xgetbv (_XCR_XFEATURE_ENABLED_MASK) & 0xe6) == 0xe6;
+				int ext_info[4];
+
+				__cpuidex (ext_info, 7, 0);
+
+				if (os_avx512 && (ext_info[1] & (1<<16) /* AVX512F */)) {
+					info << _("AVX512F-capable processor") << endmsg;
+					_flags = Flags (_flags | (HasAVX512F) );
+				}
+			}
 		}
 
 		if (cpu_info[3] & (1<<25)) {
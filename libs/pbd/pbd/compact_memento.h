@@ -0,0 +1,100 @@
+/*
+    Copyright (C) 2017 Paul Davis
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+*/
+
+#ifndef __lib_pbd_compact_memento_h__
+#define __lib_pbd_compact_memento_h__
+
+#include <list>
+#include <vector>
+#include <stdint.h>
+
+#include "pbd/libpbd_visibility.h"
+
+class XMLNode;
+
+namespace PBD {
+
+/** The before and after states of a MementoCommand, held compactly.
+ *
+ *  Both states are kept as a binary encoding of their XMLNode trees, and
+ *  the before state is stored as a delta against the after state, which it
+ *  usually differs from in only a few places. The trees that are handed
+ *  back are exact copies of those that were handed in.
+ *
+ *  All CompactMementos together may be given a memory budget; when it is
+ *  exceeded the oldest ones are moved to a temporary file, and read back
+ *  from there when they are needed.
+ */
+class LIBPBD_API CompactMemento
+{
+  public:
+	/** Take the states @a before and @a after, either of which may be 0.
+	 *  Both are deleted once they have been encoded.
+	 */
+	CompactMemento (XMLNode* before, XMLNode* after);
+	~CompactMemento ();
+
+	bool has_before () const { return _has_before; }
+	bool has_after () const { return _has_after; }
+
+	/** @return a new copy of the before state, owned by the caller, or 0
+	 *  if there is none or it could not be read back from disk.
+	 */
+	XMLNode* before () const;
+
+	/** @return a new copy of the after state, owned by the caller, or 0
+	 *  if there is none or it could not be read back from disk.
+	 */
+	XMLNode* after () const;
+
+	/** @return the number of bytes this memento holds in memory */
+	uint64_t memory_size () const { return _after.size() + _before.size(); }
+
+	/** Set the memory, in bytes, that all mementos together may use
+	 *  before old ones are moved to disk; 0 means no limit.
+	 */
+	static void set_memory_budget (uint64_t bytes);
+
+	/** @return the number of bytes that all mementos hold in memory */
+	static uint64_t memory_used ();
+
+	/** @return the size in bytes of the file that old mementos are moved to */
+	static uint64_t spill_file_size ();
+
+  private:
+	std::vector<char> _after;  ///< encoded after state
+	std::vector<char> _before; ///< encoded before state, or a delta against _after
+	bool     _has_before;
+	bool     _has_after;
+	bool     _before_is_delta;
+	int64_t  _spill_offset;    ///< position in the spill file, or -1 if we are in memory
+	uint32_t _after_size;      ///< size of the after state in the spill file
+	uint32_t _before_size;     ///< size of the before state in the spill file
+
+	std::list<CompactMemento*>::iterator _resident; ///< our entry in the list of mementos in memory
+
+	bool load (std::vector<char>* after, std::vector<char>* before) const;
+	bool spill ();
+
+	static void enforce_budget ();
+};
+
+} /* namespace */
+
+#endif /* __lib_pbd_compact_memento_h__ */
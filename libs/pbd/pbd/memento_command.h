@@ -23,8 +23,11 @@
 
 #include <iostream>
 
+#include <boost/scoped_ptr.hpp>
+
 #include "pbd/libpbd_visibility.h"
 #include "pbd/command.h"
+#include "pbd/compact_memento.h"
 #include "pbd/stacktrace.h"
 #include "pbd/xml++.h"
 #include "pbd/demangle.h"
@@ -98,20 +101,23 @@ private:
 /** This command class is initialized with before and after mementos
  * (from Stateful::get_state()), so undo becomes restoring the before
  * memento, and redo is restoring the after memento.
+ *
+ * The mementos are held as a PBD::CompactMemento, which takes ownership
+ * of them.
  */
 template <class obj_T>
 class LIBPBD_TEMPLATE_API MementoCommand : public Command
 {
 public:
 	MementoCommand (obj_T& a_object, XMLNode* a_before, XMLNode* a_after)
-		: _binder (new SimpleMementoCommandBinder<obj_T> (a_object)), before (a_before), after (a_after)
+		: _binder (new SimpleMementoCommandBinder<obj_T> (a_object)), _mementos (a_before, a_after)
 	{
 		/* The binder's object died, so we must die */
 		_binder->DropReferences.connect_same_thread (_binder_death_connection, boost::bind (&MementoCommand::binder_dying, this));
 	}
 
 	MementoCommand (MementoCommandBinder<obj_T>* b, XMLNode* a_before, XMLNode* a_after)
-		: _binder (b), before (a_before), after (a_after)
+		: _binder (b), _mementos (a_before, a_after)
 	{
 		/* The binder's object died, so we must die */
 		_binder->DropReferences.connect_same_thread (_binder_death_connection, boost::bind (&MementoCommand::binder_dying, this));
@@ -119,8 +125,6 @@ public:
 
 	~MementoCommand () {
 		drop_references ();
-		delete before;
-		delete after;
 		delete _binder;
 	}
 
@@ -129,12 +133,14 @@ public:
 	}
 
 	void operator() () {
+		boost::scoped_ptr<XMLNode> after (_mementos.after ());
 		if (after) {
 			_binder->get()->set_state(*after, Stateful::current_state_version);
 		}
 	}
 
 	void undo() {
+		boost::scoped_ptr<XMLNode> before (_mementos.before ());
 		if (before) {
 			_binder->get()->set_state(*before, Stateful::current_state_version);
 		}
@@ -142,9 +148,9 @@ public:
 
 	virtual XMLNode &get_state() {
 		std::string name;
-		if (before && after) {
+		if (_mementos.has_before () && _mementos.has_after ()) {
 			name = "MementoCommand";
-		} else if (before) {
+		} else if (_mementos.has_before ()) {
 			name = "MementoUndoCommand";
 		} else {
 			name = "MementoRedoCommand";
@@ -155,12 +161,14 @@ public:
 
 		node->set_property ("type-name", _binder->type_name ());
 
+		XMLNode* before = _mementos.before ();
 		if (before) {
-			node->add_child_copy(*before);
+			node->add_child_nocopy(*before);
 		}
 
+		XMLNode* after = _mementos.after ();
 		if (after) {
-			node->add_child_copy(*after);
+			node->add_child_nocopy(*after);
 		}
 
 		return *node;
@@ -168,8 +176,7 @@ public:
 
 protected:
 	MementoCommandBinder<obj_T>* _binder;
-	XMLNode* before;
-	XMLNode* after;
+	PBD::CompactMemento _mementos;
 	PBD::ScopedConnection _binder_death_connection;
 };
 
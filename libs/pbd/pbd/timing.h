@@ -161,6 +161,65 @@ private:
 	std::vector<uint64_t> m_elapsed_values;
 };
 
+/**
+ * Lock-free statistics of timing values, e.g. the time spent
+ * in a realtime callback.
+ *
+ * Values are accumulated by a single writer (usually the realtime
+ * thread) calling update(), while any other thread may read the
+ * statistics at the same time. Readers retry when the writer
+ * modified the data while they were copying it (sequence lock),
+ * the writer never waits.
+ *
+ * In addition to min/max/avg, a histogram with power-of-two
+ * sized bins is kept to estimate percentiles.
+ */
+class LIBPBD_API TimingStats
+{
+public:
+	TimingStats ();
+
+	/** Add a value. Realtime safe, must only ever be called from one thread */
+	void update (uint64_t elapsed);
+
+	/** Request to clear the statistics. The data is reset by
+	 * the writer on the next call to update()
+	 */
+	void reset () { g_atomic_int_set (&_reset, 1); }
+
+	/** Get a consistent copy of the statistics
+	 * @return false if no data has been collected
+	 */
+	bool get_stats (uint64_t& min, uint64_t& max, uint64_t& avg, uint64_t& count) const;
+
+	/** @return (over-)estimate of the @a p -th percentile (0..100) of the values */
+	uint64_t percentile (float p) const;
+
+	uint64_t min () const;
+	uint64_t max () const;
+	uint64_t avg () const;
+	uint64_t count () const;
+
+	static const uint32_t n_bins = 32;
+
+private:
+	struct Data {
+		uint64_t min;
+		uint64_t max;
+		uint64_t total;
+		uint64_t count;
+		/* bin n holds values in [2^(n-1), 2^n), bin 0 zero */
+		uint32_t histogram[n_bins];
+	};
+
+	void clear ();
+	void read (Data&) const;
+
+	volatile gint _seq;
+	volatile gint _reset;
+	Data _data;
+};
+
 class LIBPBD_API Timed
 {
 public:
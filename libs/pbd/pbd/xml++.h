@@ -36,6 +36,7 @@
 #include <libxml/tree.h>
 #include <boost/shared_ptr.hpp>
 
+#include <glib.h>
 #include <glibmm/ustring.h>
 
 #include "pbd/string_convert.h"
@@ -87,6 +88,7 @@ public:
 	bool read_and_validate() { return read_internal(true); }
 	bool read_and_validate(const std::string& fn) { set_filename(fn); return read_internal(true); }
 	bool read_buffer(const std::string&, bool to_tree_doc = false);
+	bool read_cache(const std::string& fn, const std::string& cache_fn);
 
 	bool write() const;
 	bool write(const std::string& fn) { set_filename(fn); return write(); }
@@ -121,8 +123,20 @@ public:
 	const std::string& name() const { return _name; }
 
 	bool          is_content() const { return _is_content; }
-	const std::string& content()    const { return _content; }
+	const std::string& content()    const {
+		if (_content.empty() && !_numbers.empty()) {
+			numbers_to_content ();
+		}
+		return _content;
+	}
 	const std::string& set_content(const std::string&);
+
+	/** @return the numbers that a binary cache stored in place of this
+	 *  content node's text, which must have been pairs of numbers, one pair
+	 *  to a line; or an empty list.
+	 */
+	const std::vector<double>& numbers() const { return _numbers; }
+	void set_numbers(std::vector<double>&);
 	XMLNode*      add_content(const std::string& s = std::string());
 
 	const XMLNodeList& children(const std::string& str = std::string()) const;
@@ -192,12 +206,106 @@ public:
 private:
 	std::string         _name;
 	bool                _is_content;
-	std::string         _content;
+	mutable std::string _content;
+	std::vector<double> _numbers;
 	XMLNodeList         _children;
 	XMLPropertyList     _proplist;
 	mutable XMLNodeList _selected_children;
 
 	void clear_lists ();
+	void numbers_to_content () const;
+};
+
+/** Produces XML from a sequence of calls which mirror those used to build
+ *  a tree of XMLNodes: either by writing it to a file as it goes, with the
+ *  same output that XMLTree::write() would give for that tree, but without
+ *  ever holding the whole tree in memory; or by building the tree.
+ *
+ *  An element's properties must be set before anything is added to it,
+ *  and any content must be added before its child elements. Unlike
+ *  XMLNode::set_property(), setting a property twice adds it twice.
+ */
+class LIBPBD_API XMLWriter {
+public:
+	/** Write to @a file, which must be open for writing, and if @a cache is
+	 *  not 0, write a binary copy of the document to it for
+	 *  XMLTree::read_cache().
+	 */
+	XMLWriter (FILE* file, FILE* cache = 0);
+	~XMLWriter ();
+	/** Build a tree of XMLNodes, to be retrieved with root() */
+	XMLWriter ();
+
+	/** @return the root of the tree that has been built, which now belongs
+	 *  to the caller, or 0 if writing to a file.
+	 */
+	XMLNode* root () const { return _root; }
+
+	void start_element (const std::string& name);
+	void end_element ();
+
+	bool set_property (const char* name, const std::string& value);
+
+	bool set_property (const char* name, const char* cstr) {
+		return set_property (name, std::string(cstr));
+	}
+
+	bool set_property (const char* name, const Glib::ustring& ustr)
+	{
+		return set_property (name, ustr.raw ());
+	}
+
+	template<class T>
+	bool set_property (const char* name, const T& value)
+	{
+		std::string str;
+		if (!PBD::to_string<T> (value, str)) {
+			return false;
+		}
+		return set_property(name, str);
+	}
+
+	void add_content (const std::string& s = std::string());
+	void add_child_copy (const XMLNode&);
+	/** Add a complete element, which is deleted once it has been written */
+	void add_child_nocopy (XMLNode&);
+
+	/** @return true if everything has been written successfully */
+	bool good () const;
+
+private:
+	struct Element {
+		Element (const std::string& n, XMLNode* nd, bool f)
+			: name (n), node (nd), start_tag_open (true), format (f), last_child_content (false) {}
+
+		std::string name;
+		XMLNode*    node;
+		bool        start_tag_open; ///< properties may still be written
+		bool        format; ///< children are indented, one per line
+		bool        last_child_content;
+	};
+
+	FILE*                _file;
+	XMLNode*             _root;
+	std::vector<Element> _elements;
+	FILE*                _cache;
+	GChecksum*           _checksum;
+	bool                 _cache_ok;
+
+	void start_child (bool content);
+	void end_child ();
+	void write (const char*, size_t);
+	void write (const std::string& s) { write (s.data (), s.length ()); }
+	void write_escaped (const std::string&, bool attribute);
+	void write_indent (size_t level);
+	void write_node (const XMLNode&, size_t level, bool format);
+
+	void cache_write (const void*, size_t);
+	void cache_record (char type, const std::string&);
+	void cache_property (const std::string& name, const std::string& value);
+	void cache_content (const XMLNode*, const std::string&, bool after_content);
+	void cache_node (const XMLNode&, bool after_content);
+	void cache_end ();
 };
 
 class LIBPBD_API XMLException: public std::exception {
@@ -0,0 +1,227 @@
+#include "compact_memento_test.h"
+
+#include <vector>
+#include <boost/scoped_ptr.hpp>
+
+#include "pbd/compact_memento.h"
+#include "pbd/compose.h"
+#include "pbd/xml++.h"
+
+CPPUNIT_TEST_SUITE_REGISTRATION (CompactMementoTest);
+
+using namespace std;
+using namespace PBD;
+
+namespace {
+
+/** @return something like the state of a playlist with @a n regions, the
+ *  one at @a moved having been moved by @a offset.
+ */
+XMLNode*
+playlist_state (int n, int moved, int offset)
+{
+	XMLNode* node = new XMLNode ("Playlist");
+	node->set_property ("name", "Audio 1.1");
+	node->set_property ("orig-track-id", "1234");
+
+	for (int i = 0; i < n; ++i) {
+		XMLNode* region = node->add_child ("Region");
+		region->set_property ("name", string_compose ("Audio 1.1-%1", i));
+		region->set_property ("position", i * 48000 + (i == moved ? offset : 0));
+		region->set_property ("length", 44100);
+		region->set_property ("id", 10000 + i);
+
+		XMLNode* env = region->add_child ("Envelope");
+		env->add_child_nocopy (*new XMLNode ("events", "0 1\n44100 1\n"));
+	}
+
+	/* things that a file round-trip would not keep */
+	node->add_content ("  ");
+	node->add_content ("adjacent");
+	node->add_child ("Empty")->add_content ();
+
+	return node;
+}
+
+bool
+same_tree (XMLNode const & a, XMLNode const & b)
+{
+	if (a.name () != b.name () || a.is_content () != b.is_content () || a.content () != b.content ()) {
+		return false;
+	}
+
+	XMLPropertyList const & pa = a.properties ();
+	XMLPropertyList const & pb = b.properties ();
+
+	if (pa.size () != pb.size ()) {
+		return false;
+	}
+
+	for (XMLPropertyConstIterator i = pa.begin (), j = pb.begin (); i != pa.end (); ++i, ++j) {
+		if ((*i)->name () != (*j)->name () || (*i)->value () != (*j)->value ()) {
+			return false;
+		}
+	}
+
+	XMLNodeList const & ca = a.children ();
+	XMLNodeList const & cb = b.children ();
+
+	if (ca.size () != cb.size ()) {
+		return false;
+	}
+
+	for (XMLNodeConstIterator i = ca.begin (), j = cb.begin (); i != ca.end (); ++i, ++j) {
+		if (!same_tree (**i, **j)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+} // anonymous namespace
+
+void
+CompactMementoTest::testRoundTrip ()
+{
+	boost::scoped_ptr<XMLNode> before (playlist_state (10, 3, 100));
+	boost::scoped_ptr<XMLNode> after (playlist_state (10, 3, 200));
+
+	CompactMemento m (new XMLNode (*before), new XMLNode (*after));
+
+	boost::scoped_ptr<XMLNode> b (m.before ());
+	boost::scoped_ptr<XMLNode> a (m.after ());
+
+	CPPUNIT_ASSERT (b && a);
+	CPPUNIT_ASSERT (same_tree (*before, *b));
+	CPPUNIT_ASSERT (same_tree (*after, *a));
+	CPPUNIT_ASSERT (!same_tree (*a, *b));
+
+	/* either state may be missing */
+
+	CompactMemento undo_only (new XMLNode (*before), 0);
+	CPPUNIT_ASSERT (undo_only.has_before () && !undo_only.has_after ());
+	CPPUNIT_ASSERT (!undo_only.after ());
+	b.reset (undo_only.before ());
+	CPPUNIT_ASSERT (b && same_tree (*before, *b));
+
+	CompactMemento redo_only (0, new XMLNode (*after));
+	CPPUNIT_ASSERT (!redo_only.has_before () && redo_only.has_after ());
+	CPPUNIT_ASSERT (!redo_only.before ());
+	a.reset (redo_only.after ());
+	CPPUNIT_ASSERT (a && same_tree (*after, *a));
+}
+
+void
+CompactMementoTest::testDelta ()
+{
+	/* moving one region out of a thousand should cost little more than
+	 * holding one state.
+	 */
+
+	CompactMemento both (playlist_state (1000, 500, 100), playlist_state (1000, 500, 200));
+	CompactMemento one (0, playlist_state (1000, 500, 200));
+
+	CPPUNIT_ASSERT (both.memory_size () < one.memory_size () + one.memory_size () / 20);
+
+	/* a change at every region still round-trips */
+
+	XMLNode* before = playlist_state (1000, -1, 0);
+	XMLNode* after = new XMLNode (*before);
+	XMLNodeList const & regions = after->children ("Region");
+	for (XMLNodeConstIterator i = regions.begin (); i != regions.end (); ++i) {
+		(*i)->set_property ("muted", true);
+	}
+
+	boost::scoped_ptr<XMLNode> expected (new XMLNode (*before));
+	CompactMemento m (before, after);
+	boost::scoped_ptr<XMLNode> b (m.before ());
+
+	CPPUNIT_ASSERT (b && same_tree (*expected, *b));
+}
+
+void
+CompactMementoTest::testSpill ()
+{
+	vector<CompactMemento*> mementos;
+	boost::scoped_ptr<XMLNode> before (playlist_state (100, 50, 100));
+	boost::scoped_ptr<XMLNode> after (playlist_state (100, 50, 200));
+
+	uint64_t const used_before = CompactMemento::memory_used ();
+
+	for (int i = 0; i < 10; ++i) {
+		mementos.push_back (new CompactMemento (new XMLNode (*before), new XMLNode (*after)));
+	}
+
+	uint64_t const each = mementos.back ()->memory_size ();
+	CPPUNIT_ASSERT_EQUAL (used_before + 10 * each, CompactMemento::memory_used ());
+
+	/* everything but the newest goes to disk */
+
+	CompactMemento::set_memory_budget (1);
+	CPPUNIT_ASSERT_EQUAL (used_before + each, CompactMemento::memory_used ());
+	CPPUNIT_ASSERT_EQUAL ((uint64_t) 0, mementos.front ()->memory_size ());
+
+	for (vector<CompactMemento*>::iterator i = mementos.begin (); i != mementos.end (); ++i) {
+		boost::scoped_ptr<XMLNode> b ((*i)->before ());
+		boost::scoped_ptr<XMLNode> a ((*i)->after ());
+		CPPUNIT_ASSERT (b && same_tree (*before, *b));
+		CPPUNIT_ASSERT (a && same_tree (*after, *a));
+	}
+
+	CompactMemento::set_memory_budget (0);
+
+	for (vector<CompactMemento*>::iterator i = mementos.begin (); i != mementos.end (); ++i) {
+		delete *i;
+	}
+
+	CPPUNIT_ASSERT_EQUAL (used_before, CompactMemento::memory_used ());
+}
+
+void
+CompactMementoTest::testSpillReuse ()
+{
+	vector<CompactMemento*> mementos;
+	boost::scoped_ptr<XMLNode> before (playlist_state (100, 50, 100));
+	boost::scoped_ptr<XMLNode> after (playlist_state (100, 50, 200));
+
+	CompactMemento::set_memory_budget (1);
+
+	for (int i = 0; i < 10; ++i) {
+		mementos.push_back (new CompactMemento (new XMLNode (*before), new XMLNode (*after)));
+	}
+
+	uint64_t const size = CompactMemento::spill_file_size ();
+	CPPUNIT_ASSERT (size > 0);
+
+	/* dropping and adding mementos, as an undo history of fixed
+	 * depth does, reuses the space of those which were dropped.
+	 */
+
+	for (int i = 0; i < 100; ++i) {
+		delete mementos[1 + (i % 8)];
+		mementos[1 + (i % 8)] = new CompactMemento (new XMLNode (*before), new XMLNode (*after));
+		CPPUNIT_ASSERT (CompactMemento::spill_file_size () <= size);
+	}
+
+	for (vector<CompactMemento*>::iterator i = mementos.begin (); i != mementos.end (); ++i) {
+		boost::scoped_ptr<XMLNode> b ((*i)->before ());
+		boost::scoped_ptr<XMLNode> a ((*i)->after ());
+		CPPUNIT_ASSERT (b && same_tree (*before, *b));
+		CPPUNIT_ASSERT (a && same_tree (*after, *a));
+	}
+
+	/* the file shrinks as its end is freed, leaving only the oldest */
+
+	for (vector<CompactMemento*>::iterator i = mementos.begin () + 1; i != mementos.end (); ++i) {
+		delete *i;
+	}
+
+	CPPUNIT_ASSERT (CompactMemento::spill_file_size () < size);
+
+	CompactMemento::set_memory_budget (0);
+
+	delete mementos.front ();
+
+	CPPUNIT_ASSERT_EQUAL ((uint64_t) 0, CompactMemento::spill_file_size ());
+}
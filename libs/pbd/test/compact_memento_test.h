@@ -0,0 +1,18 @@
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+class CompactMementoTest : public CppUnit::TestFixture
+{
+	CPPUNIT_TEST_SUITE (CompactMementoTest);
+	CPPUNIT_TEST (testRoundTrip);
+	CPPUNIT_TEST (testDelta);
+	CPPUNIT_TEST (testSpill);
+	CPPUNIT_TEST (testSpillReuse);
+	CPPUNIT_TEST_SUITE_END ();
+
+public:
+	void testRoundTrip ();
+	void testDelta ();
+	void testSpill ();
+	void testSpillReuse ();
+};
@@ -0,0 +1,61 @@
+#include "timing_stats_test.h"
+#include "pbd/timing.h"
+
+CPPUNIT_TEST_SUITE_REGISTRATION (TimingStatsTest);
+
+using namespace std;
+using namespace PBD;
+
+void
+TimingStatsTest::testStats ()
+{
+	TimingStats stats;
+	uint64_t min, max, avg, count;
+
+	CPPUNIT_ASSERT (!stats.get_stats (min, max, avg, count));
+	CPPUNIT_ASSERT_EQUAL ((uint64_t) 0, stats.count ());
+
+	stats.update (10);
+	stats.update (20);
+	stats.update (30);
+
+	CPPUNIT_ASSERT (stats.get_stats (min, max, avg, count));
+	CPPUNIT_ASSERT_EQUAL ((uint64_t) 10, min);
+	CPPUNIT_ASSERT_EQUAL ((uint64_t) 30, max);
+	CPPUNIT_ASSERT_EQUAL ((uint64_t) 20, avg);
+	CPPUNIT_ASSERT_EQUAL ((uint64_t) 3, count);
+}
+
+void
+TimingStatsTest::testPercentile ()
+{
+	TimingStats stats;
+
+	/* 99 short runs and one long one */
+	for (int i = 0; i < 99; ++i) {
+		stats.update (5);
+	}
+	stats.update (1000);
+
+	/* 5 is in the [4, 8) bin */
+	CPPUNIT_ASSERT_EQUAL ((uint64_t) 7, stats.percentile (50));
+	CPPUNIT_ASSERT_EQUAL ((uint64_t) 7, stats.percentile (99));
+	/* never more than the max value */
+	CPPUNIT_ASSERT_EQUAL ((uint64_t) 1000, stats.percentile (100));
+}
+
+void
+TimingStatsTest::testReset ()
+{
+	TimingStats stats;
+
+	stats.update (100);
+	stats.reset ();
+
+	/* reset is done by the writer */
+	CPPUNIT_ASSERT_EQUAL ((uint64_t) 1, stats.count ());
+
+	stats.update (3);
+	CPPUNIT_ASSERT_EQUAL ((uint64_t) 1, stats.count ());
+	CPPUNIT_ASSERT_EQUAL ((uint64_t) 3, stats.max ());
+}
@@ -0,0 +1,16 @@
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+class TimingStatsTest : public CppUnit::TestFixture
+{
+	CPPUNIT_TEST_SUITE (TimingStatsTest);
+	CPPUNIT_TEST (testStats);
+	CPPUNIT_TEST (testPercentile);
+	CPPUNIT_TEST (testReset);
+	CPPUNIT_TEST_SUITE_END ();
+
+public:
+	void testStats ();
+	void testPercentile ();
+	void testReset ();
+};
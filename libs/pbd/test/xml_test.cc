@@ -304,3 +304,176 @@ XMLTest::testPerfLargeXMLDocument ()
 
 	test_xml_document ("testPerfLargeXMLDocument", node_options);
 }
+
+static std::string
+read_file (const std::string& path)
+{
+	std::string contents;
+	CPPUNIT_ASSERT (Glib::file_get_contents (path, contents));
+	return contents;
+}
+
+/** Write @a node with an XMLWriter as it would be written while it is
+ *  being generated, one element or piece of content at a time.
+ */
+static void
+write_elements (XMLWriter& writer, const XMLNode& node)
+{
+	writer.start_element (node.name ());
+
+	const XMLPropertyList& props = node.properties ();
+	for (XMLPropertyConstIterator p = props.begin (); p != props.end (); ++p) {
+		writer.set_property ((*p)->name ().c_str (), (*p)->value ());
+	}
+
+	const XMLNodeList& children = node.children ();
+	for (XMLNodeConstIterator c = children.begin (); c != children.end (); ++c) {
+		if ((*c)->is_content ()) {
+			writer.add_content ((*c)->content ());
+		} else if ((*c)->children ().empty ()) {
+			writer.add_child_copy (**c);
+		} else {
+			write_elements (writer, **c);
+		}
+	}
+
+	writer.end_element ();
+}
+
+void
+XMLTest::testXMLWriter ()
+{
+	const string test_output_dir = test_output_directory ("testXMLWriter");
+	const string tree_path = Glib::build_filename (test_output_dir, "tree.xml");
+	const string copy_path = Glib::build_filename (test_output_dir, "copy.xml");
+	const string elements_path = Glib::build_filename (test_output_dir, "elements.xml");
+
+	std::vector<NodeOptions> node_options;
+
+	node_options.push_back (NodeOptions (child_node_name, 8, 2));
+	node_options.push_back (NodeOptions (grandchild_node_name, 4, 16, get_event_content (4)));
+	node_options.push_back (NodeOptions (great_grandchild_node_name, 2, 8));
+
+	XMLTree tree;
+	CPPUNIT_ASSERT (create_xml_doc (tree, node_options));
+
+	/* things that need escaping, in properties and in content */
+	XMLNode* child = tree.root()->add_child ("Escapes");
+	child->set_property ("all", "<tag> & \"quoted\" 'single'\n\r\t\xc3\xa9");
+	child->add_content ("<tag> & \"quoted\"\n\r\t\xe2\x82\xac");
+	tree.root()->add_child ("Empty")->add_content ();
+
+	/* more levels than libxml2 will indent */
+	child = tree.root();
+	for (int n = 0; n < 40; ++n) {
+		child = child->add_child ("Deep");
+	}
+
+	CPPUNIT_ASSERT (tree.write (tree_path));
+
+	FILE* f = g_fopen (copy_path.c_str (), "wb");
+	CPPUNIT_ASSERT (f);
+	{
+		XMLWriter writer (f);
+		writer.add_child_copy (*tree.root ());
+		CPPUNIT_ASSERT (writer.good ());
+	}
+	CPPUNIT_ASSERT (fclose (f) == 0);
+
+	f = g_fopen (elements_path.c_str (), "wb");
+	CPPUNIT_ASSERT (f);
+	{
+		XMLWriter writer (f);
+		write_elements (writer, *tree.root ());
+		CPPUNIT_ASSERT (writer.good ());
+	}
+	CPPUNIT_ASSERT (fclose (f) == 0);
+
+	const std::string expected = read_file (tree_path);
+	CPPUNIT_ASSERT (expected == read_file (copy_path));
+	CPPUNIT_ASSERT (expected == read_file (elements_path));
+
+	/* building a tree instead gives the same tree */
+	XMLWriter builder;
+	write_elements (builder, *tree.root ());
+	XMLNode* root = builder.root ();
+	CPPUNIT_ASSERT (root && *root == *tree.root ());
+	delete root;
+
+	CPPUNIT_ASSERT (g_remove (tree_path.c_str ()) == 0);
+	CPPUNIT_ASSERT (g_remove (copy_path.c_str ()) == 0);
+	CPPUNIT_ASSERT (g_remove (elements_path.c_str ()) == 0);
+}
+
+static const XMLNode*
+find_content (const XMLNode& node)
+{
+	const XMLNodeList& children = node.children ();
+	for (XMLNodeConstIterator c = children.begin (); c != children.end (); ++c) {
+		const XMLNode* content = (*c)->is_content () ? *c : find_content (**c);
+		if (content) {
+			return content;
+		}
+	}
+	return 0;
+}
+
+void
+XMLTest::testXMLCache ()
+{
+	const string test_output_dir = test_output_directory ("testXMLCache");
+	const string xml_path = Glib::build_filename (test_output_dir, "doc.xml");
+	const string cache_path = Glib::build_filename (test_output_dir, "doc.xml.cache");
+
+	std::vector<NodeOptions> node_options;
+
+	node_options.push_back (NodeOptions (child_node_name, 8, 2));
+	node_options.push_back (NodeOptions (grandchild_node_name, 4, 16, get_event_content (4)));
+	node_options.push_back (NodeOptions (great_grandchild_node_name, 2, 8));
+
+	XMLTree tree;
+	CPPUNIT_ASSERT (create_xml_doc (tree, node_options));
+
+	XMLNode* child = tree.root()->add_child ("Escapes");
+	child->set_property ("all", "<tag> & \"quoted\" 'single'\n\r\t\xc3\xa9");
+	child->add_content ("<tag> & \"quoted\"\n\r\t\xe2\x82\xac");
+
+	FILE* f = g_fopen (xml_path.c_str (), "wb");
+	FILE* cache = g_fopen (cache_path.c_str (), "wb");
+	CPPUNIT_ASSERT (f && cache);
+	{
+		XMLWriter writer (f, cache);
+		write_elements (writer, *tree.root ());
+		CPPUNIT_ASSERT (writer.good ());
+	}
+	CPPUNIT_ASSERT (fclose (f) == 0);
+	CPPUNIT_ASSERT (fclose (cache) == 0);
+
+	/* the cache gives the same tree as the XML */
+	XMLTree from_xml;
+	CPPUNIT_ASSERT (from_xml.read (xml_path));
+	XMLTree from_cache;
+	CPPUNIT_ASSERT (from_cache.read_cache (xml_path, cache_path));
+	CPPUNIT_ASSERT (*from_cache.root () == *from_xml.root ());
+
+	/* event content is cached as numbers, which give back the same text */
+	const XMLNode* content = find_content (*from_cache.root ());
+	CPPUNIT_ASSERT (content);
+	CPPUNIT_ASSERT (content->numbers ().size () == 8);
+	CPPUNIT_ASSERT (content->content () == get_event_content (4));
+
+	XMLNode copy (*content);
+	CPPUNIT_ASSERT (copy.numbers () == content->numbers ());
+
+	/* a cache is not used once the XML has changed */
+	f = g_fopen (xml_path.c_str (), "ab");
+	CPPUNIT_ASSERT (f);
+	fputs ("\n", f);
+	CPPUNIT_ASSERT (fclose (f) == 0);
+
+	XMLTree stale;
+	CPPUNIT_ASSERT (!stale.read_cache (xml_path, cache_path));
+
+	CPPUNIT_ASSERT (g_remove (xml_path.c_str ()) == 0);
+	CPPUNIT_ASSERT (g_remove (cache_path.c_str ()) == 0);
+}
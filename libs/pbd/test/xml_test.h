@@ -8,6 +8,8 @@ class XMLTest : public CppUnit::TestFixture
 	CPPUNIT_TEST (testPerfSmallXMLDocument);
 	CPPUNIT_TEST (testPerfMediumXMLDocument);
 	CPPUNIT_TEST (testPerfLargeXMLDocument);
+	CPPUNIT_TEST (testXMLWriter);
+	CPPUNIT_TEST (testXMLCache);
 	CPPUNIT_TEST_SUITE_END ();
 
 public:
@@ -15,4 +17,6 @@ public:
 	void testPerfSmallXMLDocument ();
 	void testPerfMediumXMLDocument ();
 	void testPerfLargeXMLDocument ();
+	void testXMLWriter ();
+	void testXMLCache ();
 };
@@ -19,6 +19,8 @@
 
 #include "pbd/timing.h"
 
+#include <cmath>
+#include <cstring>
 #include <sstream>
 #include <limits>
 
@@ -68,4 +70,129 @@ timing_summary (const std::vector<uint64_t>& values)
 	return oss.str();
 }
 
+TimingStats::TimingStats ()
+	: _seq (0)
+	, _reset (0)
+{
+	clear ();
+}
+
+void
+TimingStats::clear ()
+{
+	_data.min = std::numeric_limits<uint64_t>::max();
+	_data.max = 0;
+	_data.total = 0;
+	_data.count = 0;
+	memset (_data.histogram, 0, sizeof (_data.histogram));
+}
+
+void
+TimingStats::update (uint64_t elapsed)
+{
+	uint32_t bin = 0;
+	for (uint64_t v = elapsed; v > 0 && bin < n_bins - 1; v >>= 1) {
+		++bin;
+	}
+
+	/* an odd sequence number tells readers that the data is being modified */
+	g_atomic_int_inc (&_seq);
+
+	if (g_atomic_int_compare_and_exchange (&_reset, 1, 0)) {
+		clear ();
+	}
+
+	_data.min = std::min (_data.min, elapsed);
+	_data.max = std::max (_data.max, elapsed);
+	_data.total += elapsed;
+	_data.count += 1;
+	_data.histogram[bin] += 1;
+
+	g_atomic_int_inc (&_seq);
+}
+
+void
+TimingStats::read (Data& d) const
+{
+	while (true) {
+		gint const s0 = g_atomic_int_get (&_seq);
+		if (s0 & 1) {
+			continue;
+		}
+		memcpy (&d, &_data, sizeof (Data));
+		if (g_atomic_int_get (&_seq) == s0) {
+			break;
+		}
+	}
+}
+
+bool
+TimingStats::get_stats (uint64_t& min, uint64_t& max, uint64_t& avg, uint64_t& count) const
+{
+	Data d;
+	read (d);
+
+	if (d.count == 0) {
+		return false;
+	}
+
+	min = d.min;
+	max = d.max;
+	avg = d.total / d.count;
+	count = d.count;
+	return true;
+}
+
+uint64_t
+TimingStats::percentile (float p) const
+{
+	Data d;
+	read (d);
+
+	if (d.count == 0) {
+		return 0;
+	}
+
+	uint64_t const target = std::max ((uint64_t) 1, (uint64_t) ceil (d.count * std::min (100.f, std::max (0.f, p)) / 100.f));
+	uint64_t acc = 0;
+
+	for (uint32_t bin = 0; bin < n_bins; ++bin) {
+		acc += d.histogram[bin];
+		if (acc >= target) {
+			/* upper bound of the bin, but not more than the largest value seen */
+			uint64_t const upper = bin == 0 ? 0 : (((uint64_t) 1) << bin) - 1;
+			return std::max (d.min, std::min (d.max, upper));
+		}
+	}
+	return d.max;
+}
+
+uint64_t
+TimingStats::min () const
+{
+	uint64_t min, max, avg, count;
+	return get_stats (min, max, avg, count) ? min : 0;
+}
+
+uint64_t
+TimingStats::max () const
+{
+	uint64_t min, max, avg, count;
+	return get_stats (min, max, avg, count) ? max : 0;
+}
+
+uint64_t
+TimingStats::avg () const
+{
+	uint64_t min, max, avg, count;
+	return get_stats (min, max, avg, count) ? avg : 0;
+}
+
+uint64_t
+TimingStats::count () const
+{
+	uint64_t min, max, avg, count;
+	return get_stats (min, max, avg, count) ? count : 0;
+}
+
 } // namespace PBD
@@ -5,8 +5,12 @@
  * Modified for Ardour and released under the same terms.
  */
 
+#include <algorithm>
+#include <cassert>
+#include <cstring>
 #include <iostream>
 
+#include "pbd/gstdio_compat.h"
 #include "pbd/stacktrace.h"
 #include "pbd/xml++.h"
 
@@ -281,7 +285,14 @@ XMLNode::operator= (const XMLNode& from)
 	clear_lists ();
 
 	_name = from.name ();
-	set_content (from.content ());
+
+	if (from._numbers.empty ()) {
+		set_content (from.content ());
+	} else {
+		std::vector<double> numbers (from._numbers);
+		set_numbers (numbers);
+		_content = from._content;
+	}
 
 	const XMLPropertyList& props = from.properties ();
 
@@ -371,10 +382,34 @@ XMLNode::set_content(const string& c)
 	}
 
 	_content = c;
+	_numbers.clear ();
 
 	return _content;
 }
 
+/** Make this a content node holding @a numbers, which are taken from the
+ *  caller, in place of the text of pairs of numbers.
+ */
+void
+XMLNode::set_numbers (std::vector<double>& numbers)
+{
+	_content.clear ();
+	_numbers.clear ();
+	_numbers.swap (numbers);
+	_is_content = !_numbers.empty ();
+}
+
+void
+XMLNode::numbers_to_content () const
+{
+	for (size_t n = 0; n + 1 < _numbers.size (); n += 2) {
+		_content += PBD::to_string (_numbers[n]);
+		_content += ' ';
+		_content += PBD::to_string (_numbers[n + 1]);
+		_content += '\n';
+	}
+}
+
 XMLNode*
 XMLNode::child (const char* name) const
 {
@@ -811,3 +846,744 @@ XMLNode::dump (ostream& s, string p) const
 		s << p << "</" << _name << ">\n";
 	}
 }
+
+/* XMLWriter: in file mode this follows libxml2's xmlSaveFormatFileEnc()
+ * (with "UTF-8" and formatting on), as used by XMLTree::write(), so that
+ * the two produce identical files.
+ */
+
+/* XMLWriter can also write a binary copy of the document, which
+ * XMLTree::read_cache() can read much faster than libxml2 can parse the XML:
+ *
+ *   header:  xml_cache_magic, uint32_t XML_CACHE_VERSION,
+ *            uint32_t XML_CACHE_BYTE_ORDER, double 0.5
+ *   records: 'E' name        start of an element
+ *            'P' name value  a property of the current element
+ *            'T' text        content
+ *            'N' n x[n]      content which was n/2 pairs of numbers, one pair
+ *                            to a line, as doubles
+ *            'X'             end of the current element
+ *   trailer: 'Z' MD5 digest of the XML document
+ *
+ * Strings are a uint32_t length followed by that many bytes, and numbers are
+ * in the byte order of the machine which wrote them; the header catches
+ * caches written by a machine which differs.
+ */
+
+static const char     xml_cache_magic[8] = { 'A', 'r', 'd', 'X', 'M', 'L', 'c', '\0' };
+static const uint32_t XML_CACHE_VERSION = 1;
+static const uint32_t XML_CACHE_BYTE_ORDER = 0x01020304;
+static const size_t   XML_CACHE_DIGEST_SIZE = 16;
+
+/* libxml2 indents by at most this many levels */
+static const size_t XML_WRITER_MAX_INDENT = 30;
+static const char xml_writer_indent[] = "                                                            ";
+
+XMLWriter::XMLWriter (FILE* file, FILE* cache)
+	: _file (file)
+	, _root (0)
+	, _cache (cache)
+	, _checksum (0)
+	, _cache_ok (true)
+{
+	if (_cache) {
+		_checksum = g_checksum_new (G_CHECKSUM_MD5);
+
+		const uint32_t version = XML_CACHE_VERSION;
+		const uint32_t byte_order = XML_CACHE_BYTE_ORDER;
+		const double   half = 0.5;
+
+		cache_write (xml_cache_magic, sizeof (xml_cache_magic));
+		cache_write (&version, sizeof (version));
+		cache_write (&byte_order, sizeof (byte_order));
+		cache_write (&half, sizeof (half));
+	}
+
+	static const char declaration[] = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
+	write (declaration, sizeof (declaration) - 1);
+}
+
+XMLWriter::XMLWriter ()
+	: _file (0)
+	, _root (0)
+	, _cache (0)
+	, _checksum (0)
+	, _cache_ok (false)
+{
+}
+
+XMLWriter::~XMLWriter ()
+{
+	if (_checksum) {
+		g_checksum_free (_checksum);
+	}
+}
+
+bool
+XMLWriter::good () const
+{
+	return !_file || !ferror (_file);
+}
+
+void
+XMLWriter::write (const char* str, size_t len)
+{
+	fwrite (str, 1, len, _file);
+
+	if (_checksum) {
+		g_checksum_update (_checksum, (const guchar*) str, len);
+	}
+}
+
+void
+XMLWriter::write_indent (size_t level)
+{
+	write (xml_writer_indent, 2 * min (level, XML_WRITER_MAX_INDENT));
+}
+
+void
+XMLWriter::write_escaped (const string& str, bool attribute)
+{
+	const char* const s = str.data ();
+	const size_t len = str.length ();
+	size_t written = 0;
+
+	for (size_t n = 0; n < len; ++n) {
+		const char* entity;
+
+		switch (s[n]) {
+		case '<':  entity = "&lt;"; break;
+		case '>':  entity = "&gt;"; break;
+		case '&':  entity = "&amp;"; break;
+		case '\r': entity = "&#13;"; break;
+		case '"':  entity = attribute ? "&quot;" : 0; break;
+		case '\n': entity = attribute ? "&#10;" : 0; break;
+		case '\t': entity = attribute ? "&#9;" : 0; break;
+		default:   entity = 0; break;
+		}
+
+		if (entity) {
+			write (s + written, n - written);
+			write (entity, strlen (entity));
+			written = n + 1;
+		}
+	}
+
+	write (s + written, len - written);
+}
+
+/** Write @a node, which is at depth @a level of the document
+ *  @param format true if @a node's parent is formatting its children.
+ */
+void
+XMLWriter::write_node (const XMLNode& node, size_t level, bool format)
+{
+	if (node.is_content ()) {
+		write_escaped (node.content (), false);
+		return;
+	}
+
+	write ("<", 1);
+	write (node.name ());
+
+	const XMLPropertyList& props = node.properties ();
+
+	for (XMLPropertyConstIterator p = props.begin (); p != props.end (); ++p) {
+		write (" ", 1);
+		write ((*p)->name ());
+		write ("=\"", 2);
+		write_escaped ((*p)->value (), true);
+		write ("\"", 1);
+	}
+
+	const XMLNodeList& children = node.children ();
+
+	if (children.empty ()) {
+		write ("/>", 2);
+		return;
+	}
+
+	/* any content among the children turns formatting off for all of them */
+
+	for (XMLNodeConstIterator c = children.begin (); format && c != children.end (); ++c) {
+		if ((*c)->is_content ()) {
+			format = false;
+		}
+	}
+
+	write (">", 1);
+
+	if (format) {
+		write ("\n", 1);
+	}
+
+	for (XMLNodeConstIterator c = children.begin (); c != children.end (); ++c) {
+		if (format && !(*c)->is_content ()) {
+			write_indent (level + 1);
+		}
+		write_node (**c, level + 1, format);
+		if (format) {
+			write ("\n", 1);
+		}
+	}
+
+	if (format) {
+		write_indent (level);
+	}
+
+	write ("</", 2);
+	write (node.name ());
+	write (">", 1);
+}
+
+/** Prepare the current element for a child
+ *  @param content true if the child is content rather than an element.
+ */
+void
+XMLWriter::start_child (bool content)
+{
+	if (_elements.empty ()) {
+		return;
+	}
+
+	Element& parent (_elements.back ());
+
+	if (parent.start_tag_open) {
+		parent.start_tag_open = false;
+		if (content) {
+			parent.format = false;
+		}
+		write (">", 1);
+		if (parent.format) {
+			write ("\n", 1);
+		}
+	} else if (content) {
+		/* too late to match XMLTree::write(), which would not have
+		 * indented the elements that came before this; and libxml2 may
+		 * not ignore that indentation when reading, so nor can a cache.
+		 */
+		if (parent.format) {
+			_cache_ok = false;
+		}
+		parent.format = false;
+	}
+
+	if (parent.format && !content) {
+		write_indent (_elements.size ());
+	}
+}
+
+void
+XMLWriter::end_child ()
+{
+	if (_elements.empty ()) {
+		/* end of the root element, and so of the document */
+		write ("\n", 1);
+	} else if (_elements.back ().format) {
+		write ("\n", 1);
+	}
+}
+
+void
+XMLWriter::start_element (const string& name)
+{
+	if (!_file) {
+		XMLNode* node = new XMLNode (name);
+		if (_elements.empty ()) {
+			_root = node;
+		} else {
+			_elements.back ().node->add_child_nocopy (*node);
+		}
+		_elements.push_back (Element (name, node, true));
+		return;
+	}
+
+	start_child (false);
+
+	if (_cache) {
+		if (!_elements.empty ()) {
+			_elements.back ().last_child_content = false;
+		}
+		cache_record ('E', name);
+	}
+
+	_elements.push_back (Element (name, 0, _elements.empty () || _elements.back ().format));
+
+	write ("<", 1);
+	write (name);
+}
+
+void
+XMLWriter::end_element ()
+{
+	assert (!_elements.empty ());
+
+	if (!_file) {
+		_elements.pop_back ();
+		return;
+	}
+
+	const Element& element (_elements.back ());
+
+	if (element.start_tag_open) {
+		write ("/>", 2);
+	} else {
+		if (element.format) {
+			write_indent (_elements.size () - 1);
+		}
+		write ("</", 2);
+		write (element.name);
+		write (">", 1);
+	}
+
+	_elements.pop_back ();
+
+	end_child ();
+
+	if (_cache) {
+		cache_write ("X", 1);
+		if (_elements.empty ()) {
+			cache_end ();
+		}
+	}
+}
+
+bool
+XMLWriter::set_property (const char* name, const string& value)
+{
+	assert (!_elements.empty ());
+
+	if (!_file) {
+		return _elements.back ().node->set_property (name, value);
+	}
+
+	if (!_elements.back ().start_tag_open) {
+		return false;
+	}
+
+	write (" ", 1);
+	write (name, strlen (name));
+	write ("=\"", 2);
+	write_escaped (value, true);
+	write ("\"", 1);
+
+	if (_cache) {
+		cache_property (name, value);
+	}
+
+	return true;
+}
+
+void
+XMLWriter::add_content (const string& s)
+{
+	assert (!_elements.empty ());
+
+	if (!_file) {
+		_elements.back ().node->add_content (s);
+		return;
+	}
+
+	start_child (true);
+	write_escaped (s, false);
+	end_child ();
+
+	if (_cache) {
+		cache_content (0, s, _elements.back ().last_child_content);
+		if (!s.empty ()) {
+			_elements.back ().last_child_content = true;
+		}
+	}
+}
+
+void
+XMLWriter::add_child_copy (const XMLNode& node)
+{
+	if (!_file) {
+		if (_elements.empty ()) {
+			_root = new XMLNode (node);
+		} else {
+			_elements.back ().node->add_child_copy (node);
+		}
+		return;
+	}
+
+	start_child (node.is_content ());
+	write_node (node, _elements.size (), _elements.empty () || _elements.back ().format);
+	end_child ();
+
+	if (_cache) {
+		if (_elements.empty ()) {
+			cache_node (node, false);
+			cache_end ();
+		} else {
+			Element& parent (_elements.back ());
+			cache_node (node, parent.last_child_content);
+			if (!node.is_content ()) {
+				parent.last_child_content = false;
+			} else if (!node.content ().empty ()) {
+				parent.last_child_content = true;
+			}
+		}
+	}
+}
+
+void
+XMLWriter::add_child_nocopy (XMLNode& node)
+{
+	if (!_file) {
+		if (_elements.empty ()) {
+			_root = &node;
+		} else {
+			_elements.back ().node->add_child_nocopy (node);
+		}
+		return;
+	}
+
+	add_child_copy (node);
+	delete &node;
+}
+
+void
+XMLWriter::cache_write (const void* data, size_t len)
+{
+	fwrite (data, 1, len, _cache);
+}
+
+void
+XMLWriter::cache_record (char type, const string& str)
+{
+	const uint32_t len = str.length ();
+	cache_write (&type, 1);
+	cache_write (&len, sizeof (len));
+	cache_write (str.data (), len);
+}
+
+void
+XMLWriter::cache_property (const string& name, const string& value)
+{
+	const uint32_t len = value.length ();
+	cache_record ('P', name);
+	cache_write (&len, sizeof (len));
+	cache_write (value.data (), len);
+}
+
+/** Parse @a str into @a numbers if it is pairs of numbers, one pair to a
+ *  line, which PBD::to_string() would give back exactly.
+ */
+static bool
+parse_number_pairs (const string& str, vector<double>& numbers)
+{
+	const char* p = str.c_str ();
+	const char* const end = p + str.length ();
+	char separator = ' ';
+	string token;
+	string check;
+
+	while (p != end) {
+		const char* q = p;
+		while (q != end && *q != ' ' && *q != '\n') {
+			++q;
+		}
+		if (q == p || q == end || *q != separator) {
+			return false;
+		}
+
+		token.assign (p, q);
+		double d;
+		if (!PBD::string_to_double (token, d) || !PBD::double_to_string (d, check) || check != token) {
+			return false;
+		}
+		numbers.push_back (d);
+
+		separator = (separator == ' ') ? '\n' : ' ';
+		p = q + 1;
+	}
+
+	return !numbers.empty () && separator == ' ';
+}
+
+/** Write the content @a text (of @a node, if it is not 0) to the cache
+ *  @param after_content true if the last thing written to the current
+ *  element was content.
+ */
+void
+XMLWriter::cache_content (const XMLNode* node, const string& text, bool after_content)
+{
+	if (text.empty ()) {
+		/* nothing was written to the XML, so libxml2 will see nothing */
+		return;
+	}
+
+	if (after_content || text.find_first_not_of (" \t\r\n") == string::npos) {
+		/* libxml2 would merge this with the content before it, or
+		 * might drop it as blank: don't try to reproduce that.
+		 */
+		_cache_ok = false;
+		return;
+	}
+
+	vector<double> numbers;
+
+	if (node && !node->numbers ().empty ()) {
+		numbers = node->numbers ();
+	} else if (!parse_number_pairs (text, numbers)) {
+		cache_record ('T', text);
+		return;
+	}
+
+	const uint32_t n = numbers.size ();
+	cache_write ("N", 1);
+	cache_write (&n, sizeof (n));
+	cache_write (&numbers[0], n * sizeof (double));
+}
+
+void
+XMLWriter::cache_node (const XMLNode& node, bool after_content)
+{
+	if (node.is_content ()) {
+		cache_content (&node, node.content (), after_content);
+		return;
+	}
+
+	cache_record ('E', node.name ());
+
+	const XMLPropertyList& props = node.properties ();
+
+	for (XMLPropertyConstIterator p = props.begin (); p != props.end (); ++p) {
+		cache_property ((*p)->name (), (*p)->value ());
+	}
+
+	const XMLNodeList& children = node.children ();
+
+	after_content = false;
+
+	for (XMLNodeConstIterator c = children.begin (); c != children.end (); ++c) {
+		cache_node (**c, after_content);
+		if (!(*c)->is_content ()) {
+			after_content = false;
+		} else if (!(*c)->content ().empty ()) {
+			after_content = true;
+		}
+	}
+
+	cache_write ("X", 1);
+}
+
+/** Finish the cache with the digest of the XML, unless it could not
+ *  reproduce what libxml2 would read from the XML.
+ */
+void
+XMLWriter::cache_end ()
+{
+	if (!_cache_ok) {
+		return;
+	}
+
+	guint8 digest[XML_CACHE_DIGEST_SIZE];
+	gsize len = sizeof (digest);
+	g_checksum_get_digest (_checksum, digest, &len);
+
+	cache_write ("Z", 1);
+	cache_write (digest, len);
+}
+
+namespace {
+
+/** Reads the records of a binary cache written by XMLWriter */
+class XMLCacheReader {
+public:
+	XMLCacheReader (const char* data, size_t len)
+		: _p (data), _end (data + len) {}
+
+	bool at_end () const { return _p == _end; }
+
+	bool read (void* data, size_t len)
+	{
+		if ((size_t) (_end - _p) < len) {
+			return false;
+		}
+		memcpy (data, _p, len);
+		_p += len;
+		return true;
+	}
+
+	bool read_string (string& str)
+	{
+		uint32_t len;
+		if (!read (&len, sizeof (len)) || (size_t) (_end - _p) < len) {
+			return false;
+		}
+		str.assign (_p, len);
+		_p += len;
+		return true;
+	}
+
+private:
+	const char* _p;
+	const char* _end;
+};
+
+} // anonymous namespace
+
+/** Read the tree from @a cache_fn, a binary cache which an XMLWriter wrote
+ *  alongside the XML file @a fn, as long as @a fn has not changed since.
+ *  @return false if the cache is missing, damaged or out of date.
+ */
+bool
+XMLTree::read_cache (const string& fn, const string& cache_fn)
+{
+	_filename = fn;
+
+	delete _root;
+	_root = 0;
+
+	if (_doc) {
+		xmlFreeDoc (_doc);
+		_doc = 0;
+	}
+
+	/* digest of the XML as it is now */
+
+	FILE* f = g_fopen (fn.c_str (), "rb");
+	if (!f) {
+		return false;
+	}
+
+	GChecksum* checksum = g_checksum_new (G_CHECKSUM_MD5);
+	vector<guchar> buffer (1 << 16);
+	size_t n;
+
+	while ((n = fread (&buffer[0], 1, buffer.size (), f)) > 0) {
+		g_checksum_update (checksum, &buffer[0], n);
+	}
+
+	const bool read_error = ferror (f);
+	fclose (f);
+
+	guint8 digest[XML_CACHE_DIGEST_SIZE];
+	gsize digest_len = sizeof (digest);
+	g_checksum_get_digest (checksum, digest, &digest_len);
+	g_checksum_free (checksum);
+
+	if (read_error) {
+		return false;
+	}
+
+	gchar* data;
+	gsize length;
+
+	if (!g_file_get_contents (cache_fn.c_str (), &data, &length, 0)) {
+		return false;
+	}
+
+	const size_t header_size = sizeof (xml_cache_magic) + 2 * sizeof (uint32_t) + sizeof (double);
+	const size_t trailer_size = 1 + XML_CACHE_DIGEST_SIZE;
+
+	if (length < header_size + trailer_size
+	    || data[length - trailer_size] != 'Z'
+	    || memcmp (data + length - XML_CACHE_DIGEST_SIZE, digest, XML_CACHE_DIGEST_SIZE)) {
+		g_free (data);
+		return false;
+	}
+
+	XMLCacheReader reader (data, length - trailer_size);
+
+	char     magic[sizeof (xml_cache_magic)];
+	uint32_t version;
+	uint32_t byte_order;
+	double   half;
+
+	if (!reader.read (magic, sizeof (magic)) || memcmp (magic, xml_cache_magic, sizeof (magic))
+	    || !reader.read (&version, sizeof (version)) || version != XML_CACHE_VERSION
+	    || !reader.read (&byte_order, sizeof (byte_order)) || byte_order != XML_CACHE_BYTE_ORDER
+	    || !reader.read (&half, sizeof (half)) || half != 0.5) {
+		g_free (data);
+		return false;
+	}
+
+	vector<XMLNode*> elements;
+	XMLNode* root = 0;
+	bool ok = true;
+	string name;
+	string value;
+
+	while (ok && !reader.at_end ()) {
+		char type;
+		reader.read (&type, 1);
+
+		switch (type) {
+		case 'E':
+			if (!reader.read_string (name) || (elements.empty () && root)) {
+				ok = false;
+				break;
+			}
+			if (elements.empty ()) {
+				root = new XMLNode (name);
+				elements.push_back (root);
+			} else {
+				XMLNode* node = new XMLNode (name);
+				elements.back ()->add_child_nocopy (*node);
+				elements.push_back (node);
+			}
+			break;
+
+		case 'P':
+			if (elements.empty () || !reader.read_string (name) || !reader.read_string (value)) {
+				ok = false;
+				break;
+			}
+			elements.back ()->set_property (name.c_str (), value);
+			break;
+
+		case 'T':
+			if (elements.empty () || !reader.read_string (value)) {
+				ok = false;
+				break;
+			}
+			/* as readnode() names text nodes */
+			elements.back ()->add_child_nocopy (*new XMLNode ("text", value));
+			break;
+
+		case 'N': {
+			uint32_t count;
+			if (elements.empty () || !reader.read (&count, sizeof (count)) || count == 0) {
+				ok = false;
+				break;
+			}
+			vector<double> numbers (count);
+			if (!reader.read (&numbers[0], count * sizeof (double))) {
+				ok = false;
+				break;
+			}
+			XMLNode* node = new XMLNode ("text");
+			node->set_numbers (numbers);
+			elements.back ()->add_child_nocopy (*node);
+			break;
+		}
+
+		case 'X':
+			if (elements.empty ()) {
+				ok = false;
+				break;
+			}
+			elements.pop_back ();
+			break;
+
+		default:
+			ok = false;
+			break;
+		}
+	}
+
+	g_free (data);
+
+	if (!ok || !root || !elements.empty ()) {
+		delete root;
+		return false;
+	}
+
+	_root = root;
+
+	return true;
+}
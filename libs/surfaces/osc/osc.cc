@@ -627,6 +627,8 @@ OSC::register_callbacks()
 		REGISTER_CALLBACK(serv, "/strip/plugin/list", "i", route_plugin_list);
 		REGISTER_CALLBACK(serv, "/strip/plugin/descriptor", "ii", route_plugin_descriptor);
 		REGISTER_CALLBACK(serv, "/strip/plugin/reset", "ii", route_plugin_reset);
+		REGISTER_CALLBACK(serv, "/strip/timing", "i", route_timing);
+		REGISTER_CALLBACK(serv, "/strip/plugin/timing", "ii", route_plugin_timing);
 
 		/* still not-really-standardized query interface */
 		//REGISTER_CALLBACK (serv, "/ardour/*/#current_value", "", current_value);
@@ -4245,6 +4247,78 @@ OSC::route_plugin_reset (int ssid, int piid, lo_message msg) {
 	return 0;
 }
 
+/* reply: count, min, avg, max, 95th and 99th percentile of the DSP time in usec,
+ * all as int64.  Collecting the data needs to be enabled with the "collect-dsp-timing" preference.
+ */
+static void
+add_timing_stats (lo_message reply, PBD::TimingStats const & stats)
+{
+	uint64_t min, max, avg, count;
+	if (!stats.get_stats (min, max, avg, count)) {
+		min = max = avg = count = 0;
+	}
+	lo_message_add_int64 (reply, count);
+	lo_message_add_int64 (reply, min);
+	lo_message_add_int64 (reply, avg);
+	lo_message_add_int64 (reply, max);
+	lo_message_add_int64 (reply, stats.percentile (95));
+	lo_message_add_int64 (reply, stats.percentile (99));
+}
+
+int
+OSC::route_timing (int ssid, lo_message msg)
+{
+	if (!session) {
+		return -1;
+	}
+
+	boost::shared_ptr<Route> r = boost::dynamic_pointer_cast<Route>(get_strip (ssid, get_address (msg)));
+
+	if (!r) {
+		PBD::error << "OSC: Invalid Remote Control ID '" << ssid << "'" << endmsg;
+		return -1;
+	}
+
+	lo_message reply = lo_message_new ();
+	lo_message_add_int32 (reply, ssid);
+	add_timing_stats (reply, r->timing_stats ());
+
+	lo_send_message (get_address (msg), "/strip/timing", reply);
+	lo_message_free (reply);
+	return 0;
+}
+
+int
+OSC::route_plugin_timing (int ssid, int piid, lo_message msg)
+{
+	if (!session) {
+		return -1;
+	}
+
+	boost::shared_ptr<Route> r = boost::dynamic_pointer_cast<Route>(get_strip (ssid, get_address (msg)));
+
+	if (!r) {
+		PBD::error << "OSC: Invalid Remote Control ID '" << ssid << "'" << endmsg;
+		return -1;
+	}
+
+	boost::shared_ptr<Processor> redi = r->nth_plugin(piid - 1);
+
+	if (!redi) {
+		PBD::error << "OSC: cannot find plugin # " << piid << " for RID '" << ssid << "'" << endmsg;
+		return -1;
+	}
+
+	lo_message reply = lo_message_new ();
+	lo_message_add_int32 (reply, ssid);
+	lo_message_add_int32 (reply, piid);
+	add_timing_stats (reply, redi->timing_stats ());
+
+	lo_send_message (get_address (msg), "/strip/plugin/timing", reply);
+	lo_message_free (reply);
+	return 0;
+}
+
 int
 OSC::route_plugin_parameter (int ssid, int piid, int par, float val, lo_message msg)
 {
@@ -203,6 +203,11 @@ WaveView::set_samples_per_pixel (double samples_per_pixel)
 	if (_props->samples_per_pixel != samples_per_pixel) {
 		begin_change ();
 
+		/* any pending request is for the previous zoom level, stop the
+		 * drawing threads from spending time on it.
+		 */
+		cancel_current_request ();
+
 		_props->samples_per_pixel = samples_per_pixel;
 		_bounding_box_dirty = true;
 
@@ -279,7 +284,24 @@ WaveView::prepare_for_render (Rect const& area) const
 		}
 	}
 
+	if (current_request && !current_request->stopped () &&
+	    current_request->image->props.is_equivalent (required_props)) {
+		// Already queued or being drawn
+		return;
+	}
+
+	WaveViewDrawRequest::Priority priority = WaveViewDrawRequest::Visible;
+
+	if (!draw_rect.intersection (_canvas->visible_area ())) {
+		if (self_rect.intersection (_canvas->visible_area ())) {
+			// Partially visible, the visible part takes precedence
+			return;
+		}
+		priority = WaveViewDrawRequest::Offscreen;
+	}
+
 	boost::shared_ptr<WaveViewDrawRequest> request = create_draw_request (required_props);
+	request->priority = priority;
 
 	queue_draw_request (request);
 }
@@ -340,6 +362,12 @@ WaveView::queue_draw_request (boost::shared_ptr<WaveViewDrawRequest> const& requ
 		return;
 	}
 
+	if (request->priority == WaveViewDrawRequest::Offscreen &&
+	    WaveViewCache::get_instance ()->full ()) {
+		// Pre-rendering would only evict images that are in use
+		return;
+	}
+
 	if (current_request) {
 		current_request->cancel ();
 	}
@@ -366,6 +394,25 @@ WaveView::queue_draw_request (boost::shared_ptr<WaveViewDrawRequest> const& requ
 	}
 }
 
+void
+WaveView::cancel_current_request () const
+{
+	if (!current_request) {
+		return;
+	}
+
+	current_request->cancel ();
+
+	if (!current_request->finished ()) {
+		/* Nothing will finish the image now, don't leave it in the cache
+		 * for other WaveViews to wait on.
+		 */
+		get_cache_group ()->remove_image (current_request->image);
+	}
+
+	current_request.reset ();
+}
+
 void
 WaveView::compute_tips (ARDOUR::PeakData const& peak, WaveView::LineTips& tips,
                         double const effective_height)
@@ -1039,12 +1086,12 @@ WaveView::render (Rect const & area, Cairo::RefPtr<Cairo::Context> context) cons
 	boost::shared_ptr<WaveViewImage> image_to_draw;
 
 	if (current_request) {
-		if (!current_request->image->props.is_equivalent (required_props)) {
+		if (current_request->stopped () ||
+		    !current_request->image->props.is_equivalent (required_props)) {
 			// The WaveView properties may have been updated during recording between
 			// prepare_for_render and render calls and the new required props have
 			// different end sample value.
-			current_request->cancel ();
-			current_request.reset ();
+			cancel_current_request ();
 		} else if (current_request->finished ()) {
 			image_to_draw = current_request->image;
 			current_request.reset ();
@@ -1108,6 +1155,7 @@ WaveView::render (Rect const & area, Cairo::RefPtr<Cairo::Context> context) cons
 		} else {
 			// Defer the rendering to another thread or perhaps render pass if
 			// a thread cannot generate it in time.
+			request->priority = WaveViewDrawRequest::Immediate;
 			queue_draw_request (request);
 			redraw ();
 			return;
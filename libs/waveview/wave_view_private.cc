@@ -139,6 +139,18 @@ WaveViewCacheGroup::add_image (boost::shared_ptr<WaveViewImage> image)
 	_parent_cache.increase_size (image->size_in_bytes ());
 }
 
+void
+WaveViewCacheGroup::remove_image (boost::shared_ptr<WaveViewImage> image)
+{
+	for (ImageCache::iterator it = _cached_images.begin (); it != _cached_images.end (); ++it) {
+		if ((*it) == image) {
+			_parent_cache.decrease_size (image->size_in_bytes ());
+			_cached_images.erase (it);
+			return;
+		}
+	}
+}
+
 boost::shared_ptr<WaveViewImage>
 WaveViewCacheGroup::lookup_image (WaveViewProperties const& props)
 {
@@ -165,6 +177,7 @@ WaveViewCacheGroup::clear_cache ()
 WaveViewCache::WaveViewCache ()
 	: image_cache_size (0)
 	, _image_cache_threshold (100 * 1048576) /* bytes */
+	, _render_size_kb (0)
 {
 
 }
@@ -193,6 +206,18 @@ WaveViewCache::decrease_size (uint64_t bytes)
 	image_cache_size -= bytes;
 }
 
+void
+WaveViewCache::increase_render_size (uint64_t bytes)
+{
+	g_atomic_int_add (&_render_size_kb, (gint)((bytes + 1023) / 1024));
+}
+
+void
+WaveViewCache::decrease_render_size (uint64_t bytes)
+{
+	g_atomic_int_add (&_render_size_kb, -(gint)((bytes + 1023) / 1024));
+}
+
 boost::shared_ptr<WaveViewCacheGroup>
 WaveViewCache::get_cache_group (boost::shared_ptr<ARDOUR::AudioSource> source)
 {
@@ -253,7 +278,9 @@ WaveViewCache::set_image_cache_threshold (uint64_t sz)
 
 /*-------------------------------------------------*/
 
-WaveViewDrawRequest::WaveViewDrawRequest () : stop (0)
+WaveViewDrawRequest::WaveViewDrawRequest ()
+	: priority (Visible)
+	, stop (0)
 {
 
 }
@@ -268,8 +295,14 @@ WaveViewDrawRequestQueue::enqueue (boost::shared_ptr<WaveViewDrawRequest>& reque
 {
 	Glib::Threads::Mutex::Lock lm (_queue_mutex);
 
-	_queue.push_back (request);
-	_cond.broadcast ();
+	if (request) {
+		_queues[request->priority].push_back (request);
+		_cond.signal ();
+	} else {
+		// wake up all threads, a quitting thread may not be the one to dequeue it
+		_queues[WaveViewDrawRequest::Immediate].push_back (request);
+		_cond.broadcast ();
+	}
 }
 
 void
@@ -280,6 +313,17 @@ WaveViewDrawRequestQueue::wake_up ()
 	enqueue (null_ptr);
 }
 
+bool
+WaveViewDrawRequestQueue::empty () const
+{
+	for (int i = 0; i != WaveViewDrawRequest::NumPriorities; ++i) {
+		if (!_queues[i].empty ()) {
+			return false;
+		}
+	}
+	return true;
+}
+
 boost::shared_ptr<WaveViewDrawRequest>
 WaveViewDrawRequestQueue::dequeue (bool block)
 {
@@ -293,7 +337,7 @@ WaveViewDrawRequestQueue::dequeue (bool block)
 
 	// _queue_mutex is always held at this point
 
-	if (_queue.empty()) {
+	if (empty ()) {
 		if (block) {
 			_cond.wait (_queue_mutex);
 		} else {
@@ -304,13 +348,25 @@ WaveViewDrawRequestQueue::dequeue (bool block)
 
 	boost::shared_ptr<WaveViewDrawRequest> req;
 
-	if (!_queue.empty()) {
-		req = _queue.front ();
-		_queue.pop_front ();
-	} else {
-		// Queue empty, returning empty DrawRequest
+	for (int i = 0; i != WaveViewDrawRequest::NumPriorities; ++i) {
+		while (!_queues[i].empty ()) {
+			req = _queues[i].front ();
+			_queues[i].pop_front ();
+
+			if (!req || !req->stopped ()) {
+				_queue_mutex.unlock();
+				return req;
+			}
+
+			// Drop requests that were cancelled while queued, for instance
+			// when the zoom level changed, rather than handing them to a
+			// drawing thread.
+			req.reset ();
+		}
 	}
 
+	// Queue empty, returning empty DrawRequest
+
 	_queue_mutex.unlock();
 
 	return req;
@@ -443,12 +499,21 @@ WaveViewDrawingThread::run ()
 		boost::shared_ptr<WaveViewDrawRequest> req = WaveViewThreads::dequeue_draw_request ();
 
 		if (req && !req->stopped()) {
+			/* the intermediate images used by WaveView::draw_image are
+			 * about the same size as the final image, count them against
+			 * the memory budget shared by all drawing threads.
+			 */
+			uint64_t const render_bytes = req->image->size_in_bytes ();
+			WaveViewCache::get_instance ()->increase_render_size (render_bytes);
+
 			try {
 				WaveView::process_draw_request (req);
 			} catch (...) {
 				/* just in case it was set before the exception, whatever it was */
 				req->image->cairo_image.clear ();
 			}
+
+			WaveViewCache::get_instance ()->decrease_render_size (render_bytes);
 		} else {
 			// null or stopped Request, processing skipped
 		}
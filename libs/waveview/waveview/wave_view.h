@@ -251,6 +251,8 @@ private:
 
 	void queue_draw_request (boost::shared_ptr<WaveViewDrawRequest> const&) const;
 
+	void cancel_current_request () const;
+
 	static void process_draw_request (boost::shared_ptr<WaveViewDrawRequest>);
 
 	boost::shared_ptr<WaveViewCacheGroup> get_cache_group () const;
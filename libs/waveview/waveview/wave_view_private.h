@@ -200,6 +200,17 @@ public: // methods
 struct WaveViewDrawRequest
 {
 public:
+	/**
+	 * Order in which queued requests are handed to the drawing threads,
+	 * requests with a lower value are always processed first.
+	 */
+	enum Priority {
+		Immediate,  ///< the waveview is being rendered without an image
+		Visible,    ///< the waveview intersects the visible canvas area
+		Offscreen,  ///< pre-rendering of a waveview outside the visible area
+		NumPriorities
+	};
+
 	WaveViewDrawRequest ();
 	~WaveViewDrawRequest ();
 
@@ -208,6 +219,7 @@ public:
 	bool finished() { return image->finished(); }
 
 	boost::shared_ptr<WaveViewImage> image;
+	Priority priority;
 
 	bool is_valid () {
 		return (image && image->is_valid());
@@ -233,6 +245,8 @@ public:
 
 	void add_image (boost::shared_ptr<WaveViewImage>);
 
+	void remove_image (boost::shared_ptr<WaveViewImage>);
+
 	bool full () const { return _cached_images.size() > max_size(); }
 
 	static uint32_t max_size () { return 16; }
@@ -258,8 +272,19 @@ public:
 	static WaveViewCache* get_instance ();
 
 	uint64_t image_cache_threshold () const { return _image_cache_threshold; }
+
+	/**
+	 * Set the memory budget shared by the cached images and the images that
+	 * are currently being drawn by the drawing threads.
+	 */
 	void set_image_cache_threshold (uint64_t);
 
+	/**
+	 * @return true if the cached images and the images being drawn exceed the
+	 * image cache threshold.
+	 */
+	bool full () const { return image_cache_size + render_size () > _image_cache_threshold; }
+
 	void clear_cache ();
 
 	boost::shared_ptr<WaveViewCacheGroup> get_cache_group (boost::shared_ptr<ARDOUR::AudioSource>);
@@ -279,13 +304,20 @@ private:
 	uint64_t image_cache_size;
 	uint64_t _image_cache_threshold;
 
+	gint _render_size_kb; /* intended for atomic access */
+
+	uint64_t render_size () const { return (uint64_t)g_atomic_int_get (const_cast<gint*>(&_render_size_kb)) * 1024; }
+
 private:
 	friend class WaveViewCacheGroup;
+	friend class WaveViewDrawingThread;
 
 	void increase_size (uint64_t bytes);
 	void decrease_size (uint64_t bytes);
 
-	bool full () { return image_cache_size > _image_cache_threshold; }
+	// called from the drawing threads
+	void increase_render_size (uint64_t bytes);
+	void decrease_render_size (uint64_t bytes);
 };
 
 class WaveViewDrawRequestQueue
@@ -301,11 +333,15 @@ public:
 
 private:
 
+	bool empty () const;
+
 	mutable Glib::Threads::Mutex _queue_mutex;
 	Glib::Threads::Cond _cond;
 
 	typedef std::deque<boost::shared_ptr<WaveViewDrawRequest> > DrawRequestQueueType;
-	DrawRequestQueueType _queue;
+
+	// one queue per WaveViewDrawRequest::Priority
+	DrawRequestQueueType _queues[WaveViewDrawRequest::NumPriorities];
 };
 
 class WaveViewDrawingThread
@@ -20,6 +20,7 @@ using namespace PBD;
 
 static const char* localedir = LOCALEDIR;
 TestReceiver test_receiver;
+static gint64 session_load_time = 0;
 
 void
 TestReceiver::receive (Transmitter::Channel chn, const char * str)
@@ -146,7 +147,10 @@ static Session * _load_session (string dir, string state)
 		return 0;
 	}
 
+	const gint64 load_start = g_get_monotonic_time ();
 	Session* session = new Session (*engine, dir, state);
+	session_load_time = g_get_monotonic_time () - load_start;
+
 	engine->set_session (session);
 	return session;
 }
@@ -176,6 +180,18 @@ SessionUtils::load_session (string dir, string state, bool exit_at_failure)
 	return s;
 }
 
+void
+SessionUtils::print_load_times (Session *s)
+{
+	Session::LoadTimes const & times (s->load_times ());
+
+	for (Session::LoadTimes::const_iterator t = times.begin(); t != times.end(); ++t) {
+		printf ("%-40s %10.1f ms\n", (t->first + ":").c_str(), t->second / 1000.0);
+	}
+
+	printf ("%-40s %10.1f ms\n", "total:", session_load_time / 1000.0);
+}
+
 void
 SessionUtils::unload_session (Session *s)
 {
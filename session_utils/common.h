@@ -28,6 +28,11 @@ namespace SessionUtils {
 	 */
 	ARDOUR::Session * load_session (std::string dir, std::string state, bool exit_at_failure = true);
 
+	/** print the time taken by each phase of loading a session
+	 * @param s Session returned by load_session()
+	 */
+	void print_load_times (ARDOUR::Session *s);
+
 	/** close session and stop engine
 	 * @param s Session to close (may me NULL)
 	 */
@@ -19,6 +19,8 @@ int main (int argc, char* argv[])
 
 	printf ("SESSION INFO: routes: %lu\n", s->get_routes()->size ());
 
+	SessionUtils::print_load_times (s);
+
 	sleep(2);
 
 	//s->save_state ("");
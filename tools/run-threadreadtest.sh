@@ -8,6 +8,7 @@ interleave=
 needfiles=1
 write_blocksize=262144
 args=
+threads=
 
 if uname -a | grep --silent arwin ; then
     ddmega=m
@@ -20,6 +21,7 @@ while [ $# -gt 1 ] ; do
 	-d) dir=$2; shift; shift ;;
 	-f) filesize=$2; shift; shift ;;
 	-n) numfiles=$2; shift; shift ;;
+	-t) threads=$2; shift; shift ;;
 	-M) args="$args -M"; shift ;;
 	-D) args="$args -D"; shift ;;
 	-R) args="$args -R"; shift ;;
@@ -85,5 +87,18 @@ for bs in $@ ; do
     fi
     
     echo "# Blocksize $bs"
-    ./thread_readtest $args -b $bs -q $dir/testfile_%d
+    if [ x$threads = x ] ; then
+	./thread_readtest $args -b $bs -q $dir/testfile_%d
+    else
+	#
+	# Compare a single reader (what the butler used to do) with
+	# a pool of $threads readers, and report the speedup of the
+	# average bandwidth
+	#
+	serial=`./thread_readtest $args -n 1 -b $bs -q $dir/testfile_%d | tail -1`
+	echo "$serial"
+	parallel=`./thread_readtest $args -n $threads -b $bs -q $dir/testfile_%d | tail -1`
+	echo "$parallel"
+	echo "$serial $parallel" | awk '{ if ($3 > 0) printf ("# Speedup with %d threads: %.2fx\n", '$threads', $8 / $3); }'
+    fi
 done
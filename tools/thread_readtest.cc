@@ -159,7 +159,7 @@ int
 main (int argc, char* argv[])
 {
 	int* files;
-	char optstring[] = "b:DRMl:q";
+	char optstring[] = "b:DRMl:n:q";
 	uint32_t block_size = 64 * 1024 * 4;
 	int max_files = -1;
 	int nthreads = 16;
@@ -178,7 +178,7 @@ main (int argc, char* argv[])
 		{ "mmap", 0, 0, 'M' },
 		{ "noreadahead", 0, 0, 'R' },
 		{ "limit", 1, 0, 'l' },
-		{ "nthreads", 16, 0, 'n' },
+		{ "nthreads", 1, 0, 'n' },
 		{ 0, 0, 0, 0 }
 	};
 